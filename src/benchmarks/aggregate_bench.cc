@@ -0,0 +1,72 @@
+// Window sums over a Map<int, double> of 10^6 elements: iterating the
+// window on a plain map against aggregate() on a map with the
+// SubtreeAggregate<SumOf<double>> policy, for windows of w keys at random
+// positions, and the insert cost the policy adds.
+
+#include <cstdlib>
+#include <random>
+
+#include "../containers/s21_map.h"
+#include "bench_common.h"
+
+// Windows per width, fewer for wide windows so that the scans stay short
+constexpr long kWindowKeys = 10000000;
+constexpr int kMaxWindows = 100000;
+
+using PlainMap = s21::Map<int, double>;
+using SumMap = s21::Map<int, double, s21::HeapNodeAllocator,
+                        s21::SubtreeAggregate<s21::SumOf<double>>>;
+
+template <class MapT>
+double NanosPerInsert(MapT &map, const std::vector<int> &keys) {
+  bench::Timer timer;
+  for (int key : keys) {
+    map.insert(key, key * 0.5);
+  }
+  return timer.Seconds() * 1e9 / keys.size();
+}
+
+template <class WindowSum>
+double NanosPerWindow(std::size_t n, int w, WindowSum window_sum) {
+  std::mt19937 rng(19);
+  std::uniform_int_distribution<int> dist(0, static_cast<int>(n) - w);
+  int windows = static_cast<int>(std::min<long>(kMaxWindows, kWindowKeys / w));
+  bench::Timer timer;
+  double sum = 0;
+  for (int i = 0; i < windows; ++i) {
+    int lo = dist(rng);
+    sum += window_sum(lo, lo + w);
+  }
+  double seconds = timer.Seconds();
+  bench::DoNotOptimize(sum);
+  return seconds * 1e9 / windows;
+}
+
+int main(int argc, char *argv[]) {
+  std::size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+  std::printf("Map<int, double> window sums, %zu elements\n", n);
+  bench::Isolated([n] {
+    std::vector<int> keys = bench::ShuffledKeys(n);
+    PlainMap plain;
+    SumMap sums;
+    double plain_insert = NanosPerInsert(plain, keys);
+    double sums_insert = NanosPerInsert(sums, keys);
+    std::printf("insert      plain %8.1f ns  aggregate policy %8.1f ns\n",
+                plain_insert, sums_insert);
+    for (int w : {10, 1000, 100000}) {
+      double scan = NanosPerWindow(n, w, [&plain](int lo, int hi) {
+        double sum = 0;
+        for (auto it = plain.lower_bound(lo); it != plain.end() && it->key < hi;
+             ++it) {
+          sum += it->value;
+        }
+        return sum;
+      });
+      double aggregate = NanosPerWindow(
+          n, w, [&sums](int lo, int hi) { return sums.aggregate(lo, hi); });
+      std::printf("w = %-7d scan %10.1f ns  aggregate %8.1f ns  (%.1fx)\n", w,
+                  scan, aggregate, scan / aggregate);
+    }
+  });
+  return 0;
+}
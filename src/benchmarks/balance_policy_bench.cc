@@ -0,0 +1,107 @@
+// Balancing policies against each other on a Map<int, int> of 10^6 elements:
+// inserts, lookups and erases of half of the keys, for three access
+// distributions. uniform inserts in random order and looks up random keys,
+// ascending inserts, looks up and erases in key order, zipf inserts in
+// random order and looks up a few hot keys most of the time (Zipf, s = 1),
+// the case splay trees are made for.
+
+#include <cstdlib>
+#include <random>
+
+#include "../containers/s21_map.h"
+#include "bench_common.h"
+
+constexpr std::size_t kQueries = 2000000;
+
+enum class Access { Uniform, Ascending, Zipf };
+
+// Ranks drawn with probability proportional to 1 / (rank + 1), mapped on
+// random keys so that the hot keys are spread over the tree
+std::vector<int> ZipfKeys(std::size_t n) {
+  std::vector<double> cdf(n);
+  double sum = 0;
+  for (std::size_t i = 0; i < n; ++i) {
+    sum += 1.0 / static_cast<double>(i + 1);
+    cdf[i] = sum;
+  }
+  std::vector<int> keys = bench::ShuffledKeys(n, 5);
+  std::mt19937 rng(9);
+  std::uniform_real_distribution<double> dist(0, sum);
+  std::vector<int> queries(kQueries);
+  for (int &query : queries) {
+    std::size_t rank =
+        std::lower_bound(cdf.begin(), cdf.end(), dist(rng)) - cdf.begin();
+    query = keys[std::min(rank, n - 1)];
+  }
+  return queries;
+}
+
+std::vector<int> Queries(Access access, std::size_t n) {
+  if (access == Access::Zipf) {
+    return ZipfKeys(n);
+  }
+  std::vector<int> queries(kQueries);
+  std::mt19937 rng(7);
+  std::uniform_int_distribution<int> dist(0, static_cast<int>(n) - 1);
+  for (std::size_t i = 0; i < kQueries; ++i) {
+    queries[i] =
+        access == Access::Ascending ? static_cast<int>(i % n) : dist(rng);
+  }
+  return queries;
+}
+
+template <class Augment>
+void Run(const char *policy, const char *name, Access access, std::size_t n) {
+  using MapT = s21::Map<int, int, s21::HeapNodeAllocator, Augment>;
+  std::vector<int> keys = access == Access::Ascending ? bench::AscendingKeys(n)
+                                                      : bench::ShuffledKeys(n);
+  std::vector<int> queries = Queries(access, n);
+  MapT map;
+  bench::Timer insert_timer;
+  for (int key : keys) {
+    map.insert(key, key);
+  }
+  double insert_ns = insert_timer.Seconds() * 1e9 / n;
+
+  bench::Timer find_timer;
+  long sum = 0;
+  for (int key : queries) {
+    sum += map.find(key)->value;
+  }
+  double find_ns = find_timer.Seconds() * 1e9 / queries.size();
+  bench::DoNotOptimize(sum);
+
+  bench::Timer erase_timer;
+  for (std::size_t i = 0; i < n / 2; ++i) {
+    map.erase(map.find(keys[i]));
+  }
+  double erase_ns = erase_timer.Seconds() * 1e9 / (n / 2);
+  std::printf("%-6s %-10s %8.1f %8.1f %8.1f\n", policy, name, insert_ns,
+              find_ns, erase_ns);
+}
+
+template <class Augment>
+void RunAll(const char *policy, std::size_t n) {
+  const std::pair<const char *, Access> accesses[] = {
+      {"uniform", Access::Uniform},
+      {"ascending", Access::Ascending},
+      {"zipf", Access::Zipf}};
+  for (auto [name, access] : accesses) {
+    bench::Isolated([policy, name = name, access = access, n] {
+      Run<Augment>(policy, name, access, n);
+    });
+  }
+}
+
+int main(int argc, char *argv[]) {
+  std::size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+  std::printf("Map<int, int> balancing policies, %zu elements, ns per op\n", n);
+  std::printf("%-6s %-10s %8s %8s %8s\n", "policy", "access", "insert", "find",
+              "erase");
+  RunAll<s21::NoAugment>("rb", n);
+  RunAll<s21::AVL<>>("avl", n);
+  RunAll<s21::WAVL<>>("wavl", n);
+  RunAll<s21::Treap<>>("treap", n);
+  RunAll<s21::Splay<>>("splay", n);
+  return 0;
+}
@@ -0,0 +1,79 @@
+// find_batch / contains_batch against a loop of single find calls on a
+// Map<int, int> far larger than the caches (10^7 nodes by default). The map
+// is filled in random order so that neighbouring keys do not share cache
+// lines; half of the looked up keys are misses.
+
+#include <cstdlib>
+#include <random>
+
+#include "../containers/s21_map.h"
+#include "bench_common.h"
+
+constexpr int kQueries = 2000000;
+
+using MapT = s21::Map<int, int>;
+
+std::vector<int> QueryKeys(std::size_t n) {
+  std::mt19937 rng(7);
+  std::uniform_int_distribution<int> dist(0, static_cast<int>(2 * n) - 1);
+  std::vector<int> keys(kQueries);
+  for (int &key : keys) {
+    key = dist(rng);
+  }
+  return keys;
+}
+
+// Keys are inserted as 2 * k, so odd query keys miss
+void Run(std::size_t n) {
+  MapT map;
+  for (int key : bench::ShuffledKeys(n)) {
+    map.insert(2 * key, key);
+  }
+  std::vector<int> keys = QueryKeys(n);
+  std::vector<MapT::iterator> found(keys.size());
+
+  bench::Timer loop_timer;
+  for (std::size_t i = 0; i < keys.size(); ++i) {
+    found[i] = map.find(keys[i]);
+  }
+  double loop_seconds = loop_timer.Seconds();
+  long loop_hits = 0;
+  for (MapT::iterator it : found) {
+    loop_hits += it != map.end();
+  }
+
+  bench::Timer batch_timer;
+  map.find_batch(keys.begin(), keys.end(), found.begin());
+  double batch_seconds = batch_timer.Seconds();
+  long batch_hits = 0;
+  for (MapT::iterator it : found) {
+    batch_hits += it != map.end();
+  }
+
+  std::vector<char> present(keys.size());
+  bench::Timer contains_timer;
+  map.contains_batch(keys.begin(), keys.end(), present.begin());
+  double contains_seconds = contains_timer.Seconds();
+  long contains_hits = 0;
+  for (char hit : present) {
+    contains_hits += hit;
+  }
+  bench::DoNotOptimize(contains_hits);
+
+  std::printf(
+      "%9zu nodes  find loop %6.1f ns/key  find_batch %6.1f ns/key (%.2fx)  "
+      "contains_batch %6.1f ns/key  hits %s\n",
+      n, loop_seconds * 1e9 / keys.size(), batch_seconds * 1e9 / keys.size(),
+      loop_seconds / batch_seconds, contains_seconds * 1e9 / keys.size(),
+      loop_hits == batch_hits && batch_hits == contains_hits ? "match"
+                                                             : "DIFFER");
+}
+
+int main(int argc, char *argv[]) {
+  std::size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10000000;
+  std::printf("Map<int, int> batched lookups, %d random keys\n", kQueries);
+  for (std::size_t size : {n / 100, n / 10, n}) {
+    bench::Isolated([size] { Run(size); });
+  }
+  return 0;
+}
@@ -0,0 +1,73 @@
+#ifndef CPP2_S21_CONTAINERS_2_BENCHMARKS_BENCH_COMMON_H_
+#define CPP2_S21_CONTAINERS_2_BENCHMARKS_BENCH_COMMON_H_
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <numeric>
+#include <random>
+#include <vector>
+
+namespace bench {
+
+class Timer {
+ public:
+  Timer() : start_(std::chrono::steady_clock::now()) {}
+  double Seconds() const {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                         start_)
+        .count();
+  }
+
+ private:
+  std::chrono::steady_clock::time_point start_;
+};
+
+// Resident set size of the current process in bytes
+inline long CurrentRss() {
+  long pages = 0, resident = 0;
+  std::ifstream statm("/proc/self/statm");
+  statm >> pages >> resident;
+  return resident * sysconf(_SC_PAGESIZE);
+}
+
+inline std::vector<int> AscendingKeys(std::size_t n) {
+  std::vector<int> keys(n);
+  std::iota(keys.begin(), keys.end(), 0);
+  return keys;
+}
+
+inline std::vector<int> ShuffledKeys(std::size_t n, unsigned seed = 42) {
+  std::vector<int> keys = AscendingKeys(n);
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(seed));
+  return keys;
+}
+
+// Runs fn in a child process so that every measurement starts from a clean
+// heap and RSS numbers are not polluted by earlier runs
+template <class Fn>
+void Isolated(Fn fn) {
+  std::fflush(stdout);
+  pid_t pid = fork();
+  if (pid == 0) {
+    fn();
+    std::fflush(stdout);
+    _exit(0);
+  }
+  int status = 0;
+  waitpid(pid, &status, 0);
+}
+
+// Keeps the optimizer from dropping the computation of value
+template <class T>
+inline void DoNotOptimize(const T &value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+}  // namespace bench
+
+#endif  // CPP2_S21_CONTAINERS_2_BENCHMARKS_BENCH_COMMON_H_
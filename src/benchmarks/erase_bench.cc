@@ -0,0 +1,39 @@
+// Random erase from Map<int, V> for an 8-byte value and a 1 KB value. Erase
+// relinks nodes instead of moving payloads, so the value size should only
+// show through cache misses and freeing, not through copies. Every value
+// type runs in its own process.
+
+#include <array>
+#include <cstdlib>
+
+#include "../containers/s21_map.h"
+#include "bench_common.h"
+
+using Payload = std::array<char, 1024>;
+
+template <class Value>
+void Run(const char *name, const std::vector<int> &keys,
+         const std::vector<int> &order) {
+  s21::Map<int, Value> map;
+  for (int key : keys) {
+    map.insert(key, Value());
+  }
+  bench::Timer timer;
+  for (int key : order) {
+    map.erase(map.find(key));
+  }
+  double seconds = timer.Seconds();
+  bench::DoNotOptimize(map.size());
+  std::printf("%-8s erase %6.3f s  %6.1f ns/element\n", name, seconds,
+              seconds * 1e9 / order.size());
+}
+
+int main(int argc, char *argv[]) {
+  std::size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200000;
+  std::vector<int> keys = bench::ShuffledKeys(n);
+  std::vector<int> order = bench::ShuffledKeys(n, 7);
+  std::printf("Map<int, V> random erase of %zu elements\n", n);
+  bench::Isolated([&] { Run<long>("8 B", keys, order); });
+  bench::Isolated([&] { Run<Payload>("1 KB", keys, order); });
+  return 0;
+}
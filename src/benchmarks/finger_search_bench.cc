@@ -0,0 +1,82 @@
+// Map::cursor against plain find on a Map<int, int> of 10^6 elements, for
+// lookups that step a few keys away from the previous one, for a sorted
+// insert stream and for random keys, where the finger cannot help.
+
+#include <cstdlib>
+#include <random>
+
+#include "../containers/s21_map.h"
+#include "bench_common.h"
+
+constexpr int kQueries = 4000000;
+
+using MapT = s21::Map<int, int>;
+
+// Random walk over [0, 2n) with steps of at most max_step keys
+std::vector<int> WalkKeys(std::size_t n, int max_step) {
+  std::mt19937 rng(11);
+  std::uniform_int_distribution<int> step(-max_step, max_step);
+  std::vector<int> keys(kQueries);
+  int key = static_cast<int>(n);
+  for (int &query : keys) {
+    key = (key + step(rng) + static_cast<int>(2 * n)) % static_cast<int>(2 * n);
+    query = key;
+  }
+  return keys;
+}
+
+template <class Find>
+double NanosPerFind(const std::vector<int> &keys, Find find) {
+  bench::Timer timer;
+  long sum = 0;
+  for (int key : keys) {
+    sum += find(key);
+  }
+  double seconds = timer.Seconds();
+  bench::DoNotOptimize(sum);
+  return seconds * 1e9 / keys.size();
+}
+
+void Lookups(MapT &map, const char *name, const std::vector<int> &keys) {
+  MapT::cursor cursor(map);
+  double plain = NanosPerFind(
+      keys, [&map](int key) { return map.find(key) != map.end(); });
+  double finger = NanosPerFind(
+      keys, [&](int key) { return cursor.find(key) != map.end(); });
+  std::printf("%-14s find %6.1f ns  cursor %6.1f ns  (%.2fx)\n", name, plain,
+              finger, plain / finger);
+}
+
+int main(int argc, char *argv[]) {
+  std::size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+  std::printf("Map<int, int> finger search, %zu elements\n", n);
+  bench::Isolated([n] {
+    MapT map;
+    for (int key : bench::ShuffledKeys(n)) {
+      map.insert(2 * key, key);
+    }
+    Lookups(map, "steps <= 4", WalkKeys(n, 4));
+    Lookups(map, "steps <= 1000", WalkKeys(n, 1000));
+    std::vector<int> random = bench::ShuffledKeys(2 * n);
+    random.resize(std::min<std::size_t>(random.size(), kQueries));
+    Lookups(map, "random", random);
+  });
+  bench::Isolated([n] {
+    MapT plain, fingered;
+    MapT::cursor cursor(fingered);
+    bench::Timer plain_timer;
+    for (std::size_t i = 0; i < n; ++i) {
+      plain.insert(static_cast<int>(i), 0);
+    }
+    double plain_seconds = plain_timer.Seconds();
+    bench::Timer cursor_timer;
+    for (std::size_t i = 0; i < n; ++i) {
+      cursor.insert(static_cast<int>(i), 0);
+    }
+    double cursor_seconds = cursor_timer.Seconds();
+    std::printf("%-14s insert %6.1f ns  cursor %6.1f ns  (%.2fx)\n",
+                "ascending", plain_seconds * 1e9 / n, cursor_seconds * 1e9 / n,
+                plain_seconds / cursor_seconds);
+  });
+  return 0;
+}
@@ -0,0 +1,51 @@
+// Hinted vs unhinted Map::insert on ascending, descending and random feeds.
+// Ascending feeds hint with end(), descending feeds with the previously
+// inserted element and random feeds with end() (mostly a wrong hint).
+
+#include <cstdlib>
+#include <string>
+
+#include "../containers/s21_map.h"
+#include "bench_common.h"
+
+using IntMap = s21::Map<int, int>;
+
+enum class HintMode { kNone, kEnd, kPrevious };
+
+double InsertsPerSecond(const std::vector<int> &keys, HintMode mode) {
+  IntMap map;
+  bench::Timer timer;
+  IntMap::iterator hint = map.end();
+  for (int key : keys) {
+    if (mode == HintMode::kNone) {
+      map.insert(key, key);
+    } else if (mode == HintMode::kEnd) {
+      map.insert(map.end(), {key, key});
+    } else {
+      hint = map.insert(hint, {key, key});
+    }
+  }
+  double seconds = timer.Seconds();
+  bench::DoNotOptimize(map.size());
+  return keys.size() / seconds;
+}
+
+void Run(const char *feed, const std::vector<int> &keys, HintMode hinted) {
+  double plain = InsertsPerSecond(keys, HintMode::kNone);
+  double with_hint = InsertsPerSecond(keys, hinted);
+  std::printf(
+      "%-11s %12.0f inserts/s unhinted %12.0f inserts/s hinted (x%.2f)\n", feed,
+      plain, with_hint, with_hint / plain);
+}
+
+int main(int argc, char *argv[]) {
+  std::size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+  std::vector<int> ascending = bench::AscendingKeys(n);
+  std::vector<int> descending(ascending.rbegin(), ascending.rend());
+  std::vector<int> random = bench::ShuffledKeys(n);
+  std::printf("hinted insert, Map<int,int>, %zu keys\n", n);
+  Run("ascending", ascending, HintMode::kEnd);
+  Run("descending", descending, HintMode::kPrevious);
+  Run("random", random, HintMode::kEnd);
+  return 0;
+}
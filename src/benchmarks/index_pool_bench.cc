@@ -0,0 +1,51 @@
+// Map<int, int> on the default heap nodes, slab nodes and the 32-bit index
+// pool: node size, heap bytes per element, random insert, random lookup and a
+// full copy. Every storage policy runs in its own process.
+
+#include <cstdlib>
+
+#include "../containers/s21_map.h"
+#include "bench_common.h"
+
+template <template <class> class NodeAlloc>
+void Run(const char *name, const std::vector<int> &keys) {
+  using MapT = s21::Map<int, int, NodeAlloc>;
+  long rss_before = bench::CurrentRss();
+  bench::Timer insert_timer;
+  auto *map = new MapT;
+  for (int key : keys) {
+    map->insert(key, key);
+  }
+  double insert_seconds = insert_timer.Seconds();
+  double bytes =
+      static_cast<double>(bench::CurrentRss() - rss_before) / keys.size();
+
+  bench::Timer find_timer;
+  long sum = 0;
+  for (int key : keys) {
+    sum += map->find(key)->value;
+  }
+  double find_seconds = find_timer.Seconds();
+  bench::DoNotOptimize(sum);
+
+  bench::Timer copy_timer;
+  MapT copy(*map);
+  double copy_seconds = copy_timer.Seconds();
+  bench::DoNotOptimize(copy.size());
+
+  std::printf(
+      "%-6s node %2zu bytes  heap %5.1f bytes/element  insert %6.3f s  "
+      "find %6.3f s  copy %6.3f s\n",
+      name, sizeof(s21::Node<int, int, s21::DefaultNodePolicy<NodeAlloc>>),
+      bytes, insert_seconds, find_seconds, copy_seconds);
+}
+
+int main(int argc, char *argv[]) {
+  std::size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+  std::vector<int> keys = bench::ShuffledKeys(n);
+  std::printf("Map<int, int> storage policies, %zu elements\n", n);
+  bench::Isolated([&keys] { Run<s21::HeapNodeAllocator>("heap", keys); });
+  bench::Isolated([&keys] { Run<s21::SlabNodeAllocator>("slab", keys); });
+  bench::Isolated([&keys] { Run<s21::IndexPoolAllocator>("pool", keys); });
+  return 0;
+}
@@ -0,0 +1,151 @@
+// IntervalMap queries against a linear scan of a vector of 10^6 intervals.
+// Starts are uniform over [0, 10^8); short intervals are at most 1000 long,
+// the mixed layout makes one interval in a hundred up to 10^6 long. Queries
+// are overlaps (the scan stops at the first hit), all overlaps of a window
+// of up to 1000 and stabbing at a point.
+
+#include <cstdlib>
+#include <random>
+
+#include "../containers/s21_interval_map.h"
+#include "bench_common.h"
+
+constexpr int kSpan = 100000000;
+constexpr int kTreeQueries = 200000;
+constexpr int kScanQueries = 200;
+
+struct Interval {
+  int start;
+  int end;
+  int mapped;
+};
+
+std::vector<Interval> Intervals(std::size_t n, bool mixed) {
+  std::mt19937 rng(3);
+  std::uniform_int_distribution<int> start(0, kSpan - 1);
+  std::uniform_int_distribution<int> short_length(1, 1000);
+  std::uniform_int_distribution<int> long_length(1, 1000000);
+  std::vector<Interval> intervals(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    int length = mixed && i % 100 == 0 ? long_length(rng) : short_length(rng);
+    intervals[i].start = start(rng);
+    intervals[i].end = intervals[i].start + length;
+    intervals[i].mapped = static_cast<int>(i);
+  }
+  return intervals;
+}
+
+std::vector<std::pair<int, int>> Windows(int count) {
+  std::mt19937 rng(5);
+  std::uniform_int_distribution<int> start(0, kSpan - 1);
+  std::uniform_int_distribution<int> length(1, 1000);
+  std::vector<std::pair<int, int>> windows(count);
+  for (auto &[lo, hi] : windows) {
+    lo = start(rng);
+    hi = lo + length(rng);
+  }
+  return windows;
+}
+
+// Runs query over every window and returns ns per query; found counts hits
+template <class Query>
+double NanosPerQuery(const std::vector<std::pair<int, int>> &windows,
+                     Query query, long &found) {
+  found = 0;
+  bench::Timer timer;
+  for (auto [lo, hi] : windows) {
+    found += query(lo, hi);
+  }
+  double seconds = timer.Seconds();
+  bench::DoNotOptimize(found);
+  return seconds * 1e9 / windows.size();
+}
+
+void Report(const char *query, double scan_ns, double tree_ns, long scan_hits,
+            long tree_hits) {
+  std::printf(
+      "  %-13s scan %11.1f ns  tree %8.1f ns  (%6.0fx)  hits/query "
+      "%.2f / %.2f\n",
+      query, scan_ns, tree_ns, scan_ns / tree_ns,
+      static_cast<double>(scan_hits) / kScanQueries,
+      static_cast<double>(tree_hits) / kTreeQueries);
+}
+
+void Run(const char *layout, std::size_t n, bool mixed) {
+  std::vector<Interval> intervals = Intervals(n, mixed);
+  s21::IntervalMap<int, int> map;
+  bench::Timer insert_timer;
+  for (const Interval &interval : intervals) {
+    map.insert(interval.start, interval.end, interval.mapped);
+  }
+  std::printf("%s, insert %.1f ns\n", layout, insert_timer.Seconds() * 1e9 / n);
+  std::vector<std::pair<int, int>> tree_windows = Windows(kTreeQueries);
+  std::vector<std::pair<int, int>> scan_windows(
+      tree_windows.begin(), tree_windows.begin() + kScanQueries);
+  long scan_hits = 0, tree_hits = 0;
+
+  double scan_ns = NanosPerQuery(
+      scan_windows,
+      [&intervals](int lo, int hi) {
+        for (const Interval &interval : intervals) {
+          if (interval.start < hi && lo < interval.end) {
+            return 1;
+          }
+        }
+        return 0;
+      },
+      scan_hits);
+  double tree_ns = NanosPerQuery(
+      tree_windows, [&map](int lo, int hi) { return map.overlaps(lo, hi); },
+      tree_hits);
+  Report("overlaps", scan_ns, tree_ns, scan_hits, tree_hits);
+
+  scan_ns = NanosPerQuery(
+      scan_windows,
+      [&intervals](int lo, int hi) {
+        int count = 0;
+        for (const Interval &interval : intervals) {
+          count += interval.start < hi && lo < interval.end;
+        }
+        return count;
+      },
+      scan_hits);
+  tree_ns = NanosPerQuery(
+      tree_windows,
+      [&map](int lo, int hi) {
+        int count = 0;
+        map.for_each_overlap(lo, hi, [&count](int, int, int) { ++count; });
+        return count;
+      },
+      tree_hits);
+  Report("all overlaps", scan_ns, tree_ns, scan_hits, tree_hits);
+
+  scan_ns = NanosPerQuery(
+      scan_windows,
+      [&intervals](int point, int) {
+        int count = 0;
+        for (const Interval &interval : intervals) {
+          count += interval.start <= point && point < interval.end;
+        }
+        return count;
+      },
+      scan_hits);
+  tree_ns = NanosPerQuery(
+      tree_windows,
+      [&map](int point, int) {
+        int count = 0;
+        map.for_each_containing(point, [&count](int, int, int) { ++count; });
+        return count;
+      },
+      tree_hits);
+  Report("stabbing", scan_ns, tree_ns, scan_hits, tree_hits);
+}
+
+int main(int argc, char *argv[]) {
+  std::size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+  std::printf("IntervalMap<int, int> against a linear scan, %zu intervals\n",
+              n);
+  bench::Isolated([n] { Run("short", n, false); });
+  bench::Isolated([n] { Run("mixed", n, true); });
+  return 0;
+}
@@ -0,0 +1,70 @@
+// Moving a sub-map into a large map: the old merge (insert_or_assign every
+// element, then clear the source) against the relinking merge. Values are
+// 64-character strings, so every copy is a heap allocation as well.
+
+#include <cstdlib>
+#include <new>
+#include <string>
+
+#include "../containers/s21_map.h"
+#include "bench_common.h"
+
+namespace {
+
+std::size_t allocations = 0;
+
+}  // namespace
+
+void *operator new(std::size_t size) {
+  ++allocations;
+  if (void *memory = std::malloc(size)) {
+    return memory;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void *memory) noexcept { std::free(memory); }
+void operator delete(void *memory, std::size_t) noexcept { std::free(memory); }
+
+using ShardMap = s21::Map<int, std::string>;
+
+void Fill(ShardMap &map, int first, int step, std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) {
+    map.insert(first + static_cast<int>(i) * step, std::string(64, 'v'));
+  }
+}
+
+template <class MergeFn>
+void Measure(const char *name, std::size_t n, std::size_t moved,
+             MergeFn merge) {
+  ShardMap shard, incoming;
+  Fill(shard, 0, 2, n);
+  Fill(incoming, 1, 2 * static_cast<int>(n / moved), moved);
+  std::size_t before = allocations;
+  bench::Timer timer;
+  merge(shard, incoming);
+  double seconds = timer.Seconds();
+  bench::DoNotOptimize(shard.size());
+  std::printf("  %-8s %9.4f s  %8zu allocations\n", name, seconds,
+              allocations - before);
+}
+
+void Run(std::size_t n, std::size_t moved) {
+  std::printf("merge %zu elements into %zu\n", moved, n);
+  Measure("copy", n, moved, [](ShardMap &shard, ShardMap &incoming) {
+    for (auto it = incoming.begin(); it != incoming.end(); ++it) {
+      shard.insert_or_assign(it->key, it->value);
+    }
+    incoming.clear();
+  });
+  Measure("relink", n, moved,
+          [](ShardMap &shard, ShardMap &incoming) { shard.merge(incoming); });
+}
+
+int main(int argc, char *argv[]) {
+  std::size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+  Run(n, 1000);
+  Run(n, n / 10);
+  Run(n, n);
+  return 0;
+}
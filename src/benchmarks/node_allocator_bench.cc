@@ -0,0 +1,49 @@
+// Heap vs slab node allocation for the tree containers:
+// inserts/sec, clear() time and resident memory.
+
+#include <cstdlib>
+#include <string>
+
+#include "../containers/s21_map.h"
+#include "../containers/s21_set.h"
+#include "bench_common.h"
+
+template <class Container>
+void Run(const char *name, const std::vector<int> &keys) {
+  bench::Isolated([&] {
+    long rss_before = bench::CurrentRss();
+    bench::Timer insert_timer;
+    Container *container = new Container;
+    for (int key : keys) {
+      container->insert(key);
+    }
+    double insert_seconds = insert_timer.Seconds();
+    long rss_after = bench::CurrentRss();
+
+    bench::Timer clear_timer;
+    container->clear();
+    double clear_seconds = clear_timer.Seconds();
+    delete container;
+
+    std::printf("%-22s %12.0f inserts/s %10.2f ms clear %10.1f MiB RSS\n", name,
+                keys.size() / insert_seconds, clear_seconds * 1e3,
+                (rss_after - rss_before) / (1024.0 * 1024.0));
+  });
+}
+
+// Map::insert(key) shim so Map and Set share the loop above
+template <template <class> class NodeAlloc>
+struct IntMap : s21::Map<int, int, NodeAlloc> {
+  void insert(int key) { s21::Map<int, int, NodeAlloc>::insert(key, key); }
+};
+
+int main(int argc, char *argv[]) {
+  std::size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+  std::vector<int> keys = bench::ShuffledKeys(n);
+  std::printf("node allocator, %zu random keys\n", n);
+  Run<IntMap<s21::HeapNodeAllocator>>("Map<int,int> heap", keys);
+  Run<IntMap<s21::SlabNodeAllocator>>("Map<int,int> slab", keys);
+  Run<s21::Set<int, s21::HeapNodeAllocator>>("Set<int> heap", keys);
+  Run<s21::Set<int, s21::SlabNodeAllocator>>("Set<int> slab", keys);
+  return 0;
+}
@@ -0,0 +1,83 @@
+// Scaling of the split/join set algebra and Map::merge on a ThreadPool of 1,
+// 2, 4, 8 and 16 threads. Both operands hold n keys, half of them shared.
+// Building the operands is not timed; every time is the best of kRuns.
+
+#include <algorithm>
+#include <cstdlib>
+#include <thread>
+#include <utility>
+
+#include "../containers/s21_map.h"
+#include "../containers/s21_set.h"
+#include "bench_common.h"
+
+using IntSet = s21::Set<int>;
+using IntMap = s21::Map<int, int>;
+
+constexpr int kRuns = 3;
+
+// lhs holds the keys 0..n-1, rhs the keys n/2..3n/2-1
+template <class Container>
+void Build(std::size_t n, Container &lhs, Container &rhs) {
+  std::vector<int> keys = bench::AscendingKeys(n);
+  lhs.assign_sorted(keys.begin(), keys.end());
+  for (int &key : keys) {
+    key += static_cast<int>(n / 2);
+  }
+  rhs.assign_sorted(keys.begin(), keys.end());
+}
+
+template <class Fn>
+double Time(std::size_t n, Fn fn) {
+  double best = 0;
+  for (int run = 0; run < kRuns; ++run) {
+    IntSet lhs, rhs;
+    Build(n, lhs, rhs);
+    bench::Timer timer;
+    IntSet result = fn(std::move(lhs), std::move(rhs));
+    double seconds = timer.Seconds();
+    bench::DoNotOptimize(result.size());
+    best = run == 0 ? seconds : std::min(best, seconds);
+  }
+  return best;
+}
+
+void Run(std::size_t n, std::size_t threads) {
+  s21::ThreadPool pool(threads);
+  double union_seconds = Time(n, [&pool](IntSet lhs, IntSet rhs) {
+    return set_union(std::move(lhs), std::move(rhs), &pool);
+  });
+  double intersection_seconds = Time(n, [&pool](IntSet lhs, IntSet rhs) {
+    return set_intersection(std::move(lhs), std::move(rhs), &pool);
+  });
+  double difference_seconds = Time(n, [&pool](IntSet lhs, IntSet rhs) {
+    return set_difference(std::move(lhs), std::move(rhs), &pool);
+  });
+  double merge_seconds = 0;
+  for (int run = 0; run < kRuns; ++run) {
+    IntMap map, other;
+    Build(n, map, other);
+    bench::Timer merge_timer;
+    map.merge(other, pool);
+    double seconds = merge_timer.Seconds();
+    bench::DoNotOptimize(map.size());
+    merge_seconds = run == 0 ? seconds : std::min(merge_seconds, seconds);
+  }
+  std::printf(
+      "%2zu threads  union %7.3f s  intersection %7.3f s  difference %7.3f s"
+      "  map merge %7.3f s\n",
+      threads, union_seconds, intersection_seconds, difference_seconds,
+      merge_seconds);
+}
+
+int main(int argc, char *argv[]) {
+  std::size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10000000;
+  std::printf(
+      "Set<int> algebra and Map<int, int> merge, %zu keys per operand, "
+      "%u hardware threads\n",
+      n, std::thread::hardware_concurrency());
+  for (std::size_t threads = 1; threads <= 16; threads *= 2) {
+    Run(n, threads);
+  }
+  return 0;
+}
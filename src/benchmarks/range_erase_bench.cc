@@ -0,0 +1,86 @@
+// Range erase against erasing one element at a time on a Map<int, int> of
+// 10^6 elements: windows of k keys are expired from random positions until
+// half of the map is gone. erase_range erases short windows node by node
+// and splits long ones off, the loop rebalances after every element. Maps
+// filled in random order scatter the nodes over the heap, maps filled in
+// key order keep neighbours together.
+
+#include <cstdlib>
+#include <random>
+
+#include "../containers/s21_map.h"
+#include "bench_common.h"
+
+// Runs of each measurement, the fastest one counts
+constexpr int kRepeats = 3;
+
+using MapT = s21::Map<int, int>;
+
+// Window starts over [0, n), the same for both runs
+std::vector<int> WindowStarts(std::size_t n, std::size_t k) {
+  std::mt19937 rng(13);
+  std::uniform_int_distribution<int> dist(0, static_cast<int>(n) - 1);
+  std::vector<int> starts(n / 2 / k);
+  for (int &start : starts) {
+    start = dist(rng);
+  }
+  return starts;
+}
+
+template <class Erase>
+double NanosPerElement(const std::vector<int> &keys,
+                       const std::vector<int> &starts, std::size_t k,
+                       Erase erase) {
+  MapT map;
+  for (int key : keys) {
+    map.insert(key, key);
+  }
+  std::size_t size = map.size();
+  bench::Timer timer;
+  for (int start : starts) {
+    erase(map, start, start + static_cast<int>(k));
+  }
+  double seconds = timer.Seconds();
+  std::size_t erased = size - map.size();
+  return erased == 0 ? 0 : seconds * 1e9 / erased;
+}
+
+void Loop(MapT &map, int lo, int hi) {
+  for (auto it = map.lower_bound(lo); it != map.end() && it->key < hi;) {
+    auto next = it;
+    ++next;
+    map.erase(it);
+    it = next;
+  }
+}
+
+void Range(MapT &map, int lo, int hi) { map.erase_range(lo, hi); }
+
+// Every run forks, so that both ways start from the same heap
+void Run(const char *layout, bool ascending, std::size_t n) {
+  for (std::size_t k : {4, 64, 128, 256, 1024, 65536}) {
+    std::printf("%-9s k = %-6zu", layout, k);
+    for (auto [name, erase] :
+         {std::make_pair("loop", Loop), std::make_pair("erase_range", Range)}) {
+      bench::Isolated([=, name = name, erase = erase] {
+        std::vector<int> keys =
+            ascending ? bench::AscendingKeys(n) : bench::ShuffledKeys(n);
+        double best = NanosPerElement(keys, WindowStarts(n, k), k, erase);
+        for (int repeat = 1; repeat < kRepeats; ++repeat) {
+          best = std::min(best,
+                          NanosPerElement(keys, WindowStarts(n, k), k, erase));
+        }
+        std::printf("  %s %6.1f ns/element", name, best);
+      });
+    }
+    std::printf("\n");
+  }
+}
+
+int main(int argc, char *argv[]) {
+  std::size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+  std::printf("Map<int, int> range erase, %zu elements\n", n);
+  Run("random", false, n);
+  Run("ascending", true, n);
+  return 0;
+}
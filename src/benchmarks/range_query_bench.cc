@@ -0,0 +1,107 @@
+// lower_bound / upper_bound / equal_range / count on Map and Multiset at
+// 10^6 and 10^7 elements. The linear baseline walks from begin() the way the
+// old implementation did; it only runs a handful of queries because each one
+// costs O(n).
+
+#include <cstdlib>
+#include <random>
+
+#include "../containers/s21_map.h"
+#include "../containers/s21_multiset.h"
+#include "bench_common.h"
+
+constexpr int kQueries = 1000000;
+constexpr int kLinearQueries = 20;
+
+template <class Container>
+typename Container::iterator LinearLowerBound(Container &container, int key) {
+  auto it = container.begin();
+  while (it != container.end() && it->key < key) {
+    ++it;
+  }
+  return it;
+}
+
+std::vector<int> QueryKeys(std::size_t n, int count) {
+  std::mt19937 rng(7);
+  std::uniform_int_distribution<int> dist(0, static_cast<int>(2 * n));
+  std::vector<int> keys(count);
+  for (int &key : keys) {
+    key = dist(rng);
+  }
+  return keys;
+}
+
+template <class Container, class Query>
+double QueriesPerSecond(Container &container, const std::vector<int> &keys,
+                        Query query) {
+  bench::Timer timer;
+  long sum = 0;
+  for (int key : keys) {
+    sum += query(container, key);
+  }
+  double seconds = timer.Seconds();
+  bench::DoNotOptimize(sum);
+  return keys.size() / seconds;
+}
+
+template <class Container>
+void RunQueries(const char *name, Container &container, std::size_t n) {
+  std::vector<int> keys = QueryKeys(n, kQueries);
+  std::vector<int> few(keys.begin(), keys.begin() + kLinearQueries);
+  auto key_of = [&container](typename Container::iterator it) {
+    return it == container.end() ? -1 : it->key;
+  };
+  double lower = QueriesPerSecond(container, keys, [&](Container &c, int k) {
+    return key_of(c.lower_bound(k));
+  });
+  double upper = QueriesPerSecond(container, keys, [&](Container &c, int k) {
+    return key_of(c.upper_bound(k));
+  });
+  double range = QueriesPerSecond(container, keys, [&](Container &c, int k) {
+    return key_of(c.equal_range(k).second);
+  });
+  double count = QueriesPerSecond(
+      container, keys, [](Container &c, int k) { return c.count(k); });
+  double linear = QueriesPerSecond(container, few, [&](Container &c, int k) {
+    return key_of(LinearLowerBound(c, k));
+  });
+  std::printf(
+      "%-8s n=%-9zu lower_bound %10.0f/s upper_bound %10.0f/s "
+      "equal_range %10.0f/s count %10.0f/s linear %8.1f/s (x%.0f)\n",
+      name, n, lower, upper, range, count, linear, lower / linear);
+}
+
+void RunMap(std::size_t n) {
+  // Even keys only, so half the queries miss
+  std::vector<std::pair<int, int>> items(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    items[i] = {static_cast<int>(2 * i), static_cast<int>(i)};
+  }
+  s21::Map<int, int> map;
+  map.assign_sorted(items.begin(), items.end());
+  RunQueries("Map", map, n);
+}
+
+void RunMultiset(std::size_t n) {
+  // Every multiple of eight four times, spanning the same key range as Map
+  std::vector<int> values(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    values[i] = static_cast<int>(i / 4 * 8);
+  }
+  s21::Multiset<int> multiset;
+  multiset.assign_sorted(values.begin(), values.end());
+  RunQueries("Multiset", multiset, n);
+}
+
+int main(int argc, char *argv[]) {
+  std::vector<std::size_t> sizes{1000000, 10000000};
+  if (argc > 1) {
+    sizes = {std::strtoul(argv[1], nullptr, 10)};
+  }
+  for (std::size_t n : sizes) {
+    bench::Isolated([n] { RunMap(n); });
+    bench::Isolated([n] { RunMultiset(n); });
+  }
+  return 0;
+}
@@ -0,0 +1,130 @@
+// RangeSet<uint32_t> against expanding the ranges into a Set<uint32_t>, the
+// allow-list and ID-allocator layout: ranges of 1 to 256 values (128 on
+// average) with a gap of at least one value between them, inserted in
+// random order. Reports bytes per stored value, insert time per range and
+// membership and next-free lookups at random values.
+
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+
+#include "../containers/s21_range_set.h"
+#include "../containers/s21_set.h"
+#include "bench_common.h"
+
+constexpr int kQueries = 1000000;
+
+struct Range {
+  std::uint32_t first;
+  std::uint32_t last;
+};
+
+std::vector<Range> Ranges(std::size_t count, std::uint64_t &values) {
+  std::mt19937 rng(13);
+  std::uniform_int_distribution<std::uint32_t> length(1, 256);
+  std::uniform_int_distribution<std::uint32_t> gap(1, 256);
+  std::vector<Range> ranges(count);
+  std::uint32_t next = 0;
+  values = 0;
+  for (Range &range : ranges) {
+    range.first = next + gap(rng);
+    range.last = range.first + length(rng) - 1;
+    next = range.last + 1;
+    values += range.last - range.first + 1;
+  }
+  std::shuffle(ranges.begin(), ranges.end(), rng);
+  return ranges;
+}
+
+std::vector<std::uint32_t> Probes(std::uint32_t span) {
+  std::mt19937 rng(17);
+  std::uniform_int_distribution<std::uint32_t> dist(0, span);
+  std::vector<std::uint32_t> probes(kQueries);
+  for (std::uint32_t &probe : probes) {
+    probe = dist(rng);
+  }
+  return probes;
+}
+
+// First value at or after probe that values does not hold, by stepping
+std::uint32_t NextFree(const s21::Set<std::uint32_t> &values,
+                       std::uint32_t probe) {
+  for (auto it = values.find(probe); it != values.end() && *it == probe; ++it) {
+    ++probe;
+  }
+  return probe;
+}
+
+void RunRangeSet(const std::vector<Range> &ranges, std::uint64_t values,
+                 const std::vector<std::uint32_t> &probes) {
+  long rss = bench::CurrentRss();
+  s21::RangeSet<std::uint32_t> set;
+  bench::Timer insert_timer;
+  for (const Range &range : ranges) {
+    set.insert(range.first, range.last);
+  }
+  double insert_ns = insert_timer.Seconds() * 1e9 / ranges.size();
+  double bytes = static_cast<double>(bench::CurrentRss() - rss) / values;
+  bench::Timer find_timer;
+  long hits = 0;
+  for (std::uint32_t probe : probes) {
+    hits += set.contains(probe);
+  }
+  double find_ns = find_timer.Seconds() * 1e9 / probes.size();
+  bench::Timer free_timer;
+  long sum = 0;
+  for (std::uint32_t probe : probes) {
+    sum += set.next_free(probe);
+  }
+  double free_ns = free_timer.Seconds() * 1e9 / probes.size();
+  bench::DoNotOptimize(sum);
+  std::printf("%-16s %8.3f B/value %10.1f ns/range %7.1f ns %7.1f ns  %ld\n",
+              "RangeSet", bytes, insert_ns, find_ns, free_ns, hits);
+}
+
+void RunSet(const std::vector<Range> &ranges, std::uint64_t values,
+            const std::vector<std::uint32_t> &probes) {
+  long rss = bench::CurrentRss();
+  s21::Set<std::uint32_t> set;
+  bench::Timer insert_timer;
+  for (const Range &range : ranges) {
+    for (std::uint32_t value = range.first; value <= range.last; ++value) {
+      set.insert(value);
+    }
+  }
+  double insert_ns = insert_timer.Seconds() * 1e9 / ranges.size();
+  double bytes = static_cast<double>(bench::CurrentRss() - rss) / values;
+  bench::Timer find_timer;
+  long hits = 0;
+  for (std::uint32_t probe : probes) {
+    hits += set.contains(probe);
+  }
+  double find_ns = find_timer.Seconds() * 1e9 / probes.size();
+  bench::Timer free_timer;
+  long sum = 0;
+  for (std::uint32_t probe : probes) {
+    sum += NextFree(set, probe);
+  }
+  double free_ns = free_timer.Seconds() * 1e9 / probes.size();
+  bench::DoNotOptimize(sum);
+  std::printf("%-16s %8.3f B/value %10.1f ns/range %7.1f ns %7.1f ns  %ld\n",
+              "Set (expanded)", bytes, insert_ns, find_ns, free_ns, hits);
+}
+
+int main(int argc, char *argv[]) {
+  std::size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 50000;
+  std::uint64_t values = 0;
+  std::vector<Range> ranges = Ranges(count, values);
+  std::uint32_t span = 0;
+  for (const Range &range : ranges) {
+    span = std::max(span, range.last);
+  }
+  std::vector<std::uint32_t> probes = Probes(span);
+  std::printf(
+      "%zu ranges, %llu values; memory, insert, contains, next_free,"
+      " hits\n",
+      count, static_cast<unsigned long long>(values));
+  bench::Isolated([&] { RunRangeSet(ranges, values, probes); });
+  bench::Isolated([&] { RunSet(ranges, values, probes); });
+  return 0;
+}
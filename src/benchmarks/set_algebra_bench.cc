@@ -0,0 +1,79 @@
+// Intersection and union of a Set<int> of n elements with one of m elements:
+// the usual loop (look up every element of the small set in the large one,
+// insert what is kept) against split/join set_intersection and set_union.
+// Building the operands is not timed, freeing what is left of them is: the
+// split/join versions free dropped nodes as they go.
+
+#include <cstdlib>
+#include <utility>
+
+#include "../containers/s21_set.h"
+#include "bench_common.h"
+
+using IntSet = s21::Set<int>;
+
+// The large set holds the even keys, the small one every (n / m)-th key, so
+// about half of the small set is found in the large one
+void Build(std::size_t n, std::size_t m, IntSet &large, IntSet &small) {
+  std::vector<int> keys = bench::AscendingKeys(n);
+  for (int &key : keys) {
+    key *= 2;
+  }
+  large.assign_sorted(keys.begin(), keys.end());
+  keys.resize(m);
+  int step = static_cast<int>(n / m);
+  for (std::size_t i = 0; i < m; ++i) {
+    keys[i] = static_cast<int>(i) * step + static_cast<int>(i % 2);
+  }
+  small.assign_sorted(keys.begin(), keys.end());
+}
+
+template <class Fn>
+double Time(std::size_t n, std::size_t m, Fn fn) {
+  IntSet large, small;
+  Build(n, m, large, small);
+  bench::Timer timer;
+  IntSet result = fn(large, small);
+  large.clear();
+  small.clear();
+  double seconds = timer.Seconds();
+  bench::DoNotOptimize(result.size());
+  return seconds;
+}
+
+void Run(std::size_t n, std::size_t m) {
+  double loop_intersection = Time(n, m, [](IntSet &large, IntSet &small) {
+    IntSet result;
+    for (auto it = small.begin(); it != small.end(); ++it) {
+      if (large.contains(it->key)) {
+        result.insert(it->key);
+      }
+    }
+    return result;
+  });
+  double split_intersection = Time(n, m, [](IntSet &large, IntSet &small) {
+    return set_intersection(std::move(large), std::move(small));
+  });
+  double loop_union = Time(n, m, [](IntSet &large, IntSet &small) {
+    for (auto it = small.begin(); it != small.end(); ++it) {
+      large.insert(it->key);
+    }
+    return std::move(large);
+  });
+  double split_union = Time(n, m, [](IntSet &large, IntSet &small) {
+    return set_union(std::move(large), std::move(small));
+  });
+  std::printf(
+      "m %8zu  intersection loop %8.5f s  split/join %8.5f s  "
+      "union loop %8.5f s  split/join %8.5f s\n",
+      m, loop_intersection, split_intersection, loop_union, split_union);
+}
+
+int main(int argc, char *argv[]) {
+  std::size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+  std::printf("Set<int> algebra, large set of %zu elements\n", n);
+  for (std::size_t m = 10; m <= n; m *= 10) {
+    Run(n, m);
+  }
+  return 0;
+}
@@ -0,0 +1,104 @@
+// Bytes per element of set-like trees before (key stored as key and value,
+// RBTree<Key, Key>) and after (key-only nodes, Multiset<Key>) for int,
+// std::string and a 64-byte struct. Strings are 24 characters long, so each
+// copy of the key owns a heap buffer as well.
+
+#include <cstdlib>
+#include <string>
+
+#include "../containers/s21_multiset.h"
+#include "bench_common.h"
+
+struct Blob64 {
+  long words[8];
+  bool operator<(const Blob64 &other) const {
+    return words[0] < other.words[0];
+  }
+  bool operator==(const Blob64 &other) const {
+    return words[0] == other.words[0];
+  }
+};
+
+template <class Key>
+Key MakeKey(int i);
+
+template <>
+int MakeKey<int>(int i) {
+  return i;
+}
+
+template <>
+std::string MakeKey<std::string>(int i) {
+  std::string key = std::to_string(i);
+  return std::string(24 - key.size(), '0') + key;
+}
+
+template <>
+Blob64 MakeKey<Blob64>(int i) {
+  Blob64 blob{};
+  blob.words[0] = i;
+  return blob;
+}
+
+// Heap bytes per element of fill(keys), measured as RSS growth
+template <class Key, class Fill>
+double BytesPerElement(const std::vector<Key> &keys, Fill fill) {
+  double bytes = 0;
+  int pipe_fds[2];
+  if (pipe(pipe_fds) != 0) {
+    return 0;
+  }
+  bench::Isolated([&] {
+    long before = bench::CurrentRss();
+    fill(keys);
+    double per_element =
+        static_cast<double>(bench::CurrentRss() - before) / keys.size();
+    if (write(pipe_fds[1], &per_element, sizeof(per_element)) < 0) {
+      std::perror("write");
+    }
+  });
+  if (read(pipe_fds[0], &bytes, sizeof(bytes)) < 0) {
+    bytes = 0;
+  }
+  close(pipe_fds[0]);
+  close(pipe_fds[1]);
+  return bytes;
+}
+
+template <class Key>
+void Run(const char *name, std::size_t n) {
+  std::vector<Key> keys;
+  keys.reserve(n);
+  for (int key : bench::ShuffledKeys(n)) {
+    keys.push_back(MakeKey<Key>(key));
+  }
+  double before = BytesPerElement(keys, [](const std::vector<Key> &items) {
+    auto *tree = new s21::RBTree<Key, Key>;
+    for (const Key &key : items) {
+      tree->InsertEqual(key, key);
+    }
+    bench::DoNotOptimize(tree);
+  });
+  double after = BytesPerElement(keys, [](const std::vector<Key> &items) {
+    auto *multiset = new s21::Multiset<Key>;
+    for (const Key &key : items) {
+      multiset->insert(key);
+    }
+    bench::DoNotOptimize(multiset);
+  });
+  std::printf(
+      "%-12s node %3zu -> %3zu bytes   heap %7.1f -> %7.1f bytes/element\n",
+      name, sizeof(s21::Node<Key, Key>), sizeof(s21::Node<Key, s21::NoValue>),
+      before, after);
+}
+
+int main(int argc, char *argv[]) {
+  std::size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+  std::printf("set-like tree node size, %zu elements\n", n);
+  // Each key type gets its own process: memory freed by the previous run
+  // stays resident and would be reused without growing RSS
+  bench::Isolated([n] { Run<int>("int", n); });
+  bench::Isolated([n] { Run<std::string>("std::string", n); });
+  bench::Isolated([n] { Run<Blob64>("64-byte", n); });
+  return 0;
+}
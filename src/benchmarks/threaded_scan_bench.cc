@@ -0,0 +1,91 @@
+// Iteration over a Map<int, int> of 10^6 elements with and without the
+// Threaded node policy: full scans from begin() to end() and back, and
+// partial scans of k elements from a random lower_bound. Maps filled in
+// random order keep in-order neighbours far apart in memory, so both
+// iterators wait on a cache miss per element; maps filled in key order lay
+// the nodes out in scan order and leave the climbs of the plain iterator as
+// the cost.
+
+#include <cstdlib>
+#include <random>
+
+#include "../containers/s21_map.h"
+#include "bench_common.h"
+
+constexpr int kScans = 20;
+constexpr int kRangeQueries = 200000;
+
+template <class MapT>
+MapT Filled(const std::vector<int> &keys) {
+  MapT map;
+  for (int key : keys) {
+    map.insert(key, key);
+  }
+  return map;
+}
+
+template <class MapT>
+double NanosPerFullScanStep(const MapT &map) {
+  bench::Timer timer;
+  long sum = 0;
+  for (int scan = 0; scan < kScans; ++scan) {
+    if (scan % 2 == 0) {
+      for (auto it = map.begin(); it != map.end(); ++it) {
+        sum += it->value;
+      }
+    } else {
+      for (auto it = map.end(); it != map.begin();) {
+        --it;
+        sum += it->value;
+      }
+    }
+  }
+  double seconds = timer.Seconds();
+  bench::DoNotOptimize(sum);
+  return seconds * 1e9 / (static_cast<double>(kScans) * map.size());
+}
+
+template <class MapT>
+double NanosPerRangeQuery(const MapT &map, int k) {
+  std::mt19937 rng(3);
+  std::uniform_int_distribution<int> dist(0, static_cast<int>(map.size()) - 1);
+  bench::Timer timer;
+  long sum = 0;
+  for (int query = 0; query < kRangeQueries; ++query) {
+    auto it = map.lower_bound(dist(rng));
+    for (int step = 0; step < k && it != map.end(); ++step, ++it) {
+      sum += it->value;
+    }
+  }
+  double seconds = timer.Seconds();
+  bench::DoNotOptimize(sum);
+  return seconds * 1e9 / kRangeQueries;
+}
+
+template <class MapT>
+void Run(const char *name, const std::vector<int> &keys) {
+  MapT map = Filled<MapT>(keys);
+  std::printf("%-20s full scan %6.2f ns/element", name,
+              NanosPerFullScanStep(map));
+  for (int k : {1, 10, 100, 1000}) {
+    std::printf("  k=%-4d %8.1f ns", k, NanosPerRangeQuery(map, k));
+  }
+  std::printf("\n");
+}
+
+int main(int argc, char *argv[]) {
+  std::size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+  std::printf("Map<int, int> iteration, %zu elements, range queries of k\n", n);
+  using Threaded = s21::Map<int, int, s21::HeapNodeAllocator, s21::Threaded<>>;
+  bench::Isolated([n] {
+    Run<s21::Map<int, int>>("plain, random", bench::ShuffledKeys(n));
+  });
+  bench::Isolated(
+      [n] { Run<Threaded>("threaded, random", bench::ShuffledKeys(n)); });
+  bench::Isolated([n] {
+    Run<s21::Map<int, int>>("plain, ascending", bench::AscendingKeys(n));
+  });
+  bench::Isolated(
+      [n] { Run<Threaded>("threaded, ascending", bench::AscendingKeys(n)); });
+  return 0;
+}
@@ -0,0 +1,58 @@
+#ifndef CPP2_S21_CONTAINERS_2_CONTAINERS_INDEXLINK_H_
+#define CPP2_S21_CONTAINERS_2_CONTAINERS_INDEXLINK_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace s21 {
+
+// 32-bit link between two objects of the same contiguous pool. It stores the
+// distance from the link to the target in 4-byte units instead of an address,
+// so it needs no pool base to decode and stays valid when the whole pool is
+// moved or copied byte by byte. Reads and writes go through T *, which keeps
+// node code written for raw pointers unchanged.
+template <class T>
+class IndexLink {
+ public:
+  static constexpr std::ptrdiff_t kUnit = 4;
+  // Largest pool span, in bytes, whose links are guaranteed to fit
+  static constexpr std::size_t kMaxSpan =
+      static_cast<std::size_t>(std::numeric_limits<std::int32_t>::max()) *
+      kUnit;
+
+  IndexLink() = default;
+  // A copied distance would be relative to the wrong address
+  IndexLink(const IndexLink &) = delete;
+
+  IndexLink &operator=(const IndexLink &other) { return *this = other.get(); }
+  IndexLink &operator=(T *target) {
+    distance_ = target == nullptr
+                    ? kNull
+                    : static_cast<std::int32_t>(
+                          (reinterpret_cast<char *>(target) - Self()) / kUnit);
+    return *this;
+  }
+
+  T *get() const {
+    return distance_ == kNull
+               ? nullptr
+               : reinterpret_cast<T *>(Self() + distance_ * kUnit);
+  }
+  operator T *() const { return get(); }
+  T *operator->() const { return get(); }
+
+ private:
+  static constexpr std::int32_t kNull =
+      std::numeric_limits<std::int32_t>::min();
+
+  char *Self() const {
+    return const_cast<char *>(reinterpret_cast<const char *>(this));
+  }
+
+  std::int32_t distance_{kNull};
+};
+
+}  // namespace s21
+
+#endif  // CPP2_S21_CONTAINERS_2_CONTAINERS_INDEXLINK_H_
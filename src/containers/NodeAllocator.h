@@ -0,0 +1,292 @@
+#ifndef CPP2_S21_CONTAINERS_2_CONTAINERS_NODEALLOCATOR_H_
+#define CPP2_S21_CONTAINERS_2_CONTAINERS_NODEALLOCATOR_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+#include "IndexLink.h"
+#include "s21_vector.h"
+
+namespace s21 {
+
+// Node allocators hand raw, suitably aligned storage for one tree node to
+// RBTree, which constructs and destroys the nodes itself.
+// kBulkRelease tells the tree that Release() frees every node at once, so
+// clear() does not have to give nodes back one by one.
+// kOwnsHeader allocators also keep the container's sentinel node, in Header(),
+// once they hold any storage; Header() is nullptr before that.
+// kStableNodes is false when growing the storage moves the nodes. The owner
+// asks HasRoom() before it holds node pointers across an allocation. If there
+// is no room, it copies out the arguments that may refer to its own nodes,
+// records its node pointers as offsets from Header(), calls Reserve() and
+// rebuilds them from the new Header().
+// kPortableNodes allocators keep no per-container state, so a node may leave
+// its container (extract, merge) and be freed by any other instance.
+
+// Default policy: every node is a separate heap allocation
+template <class NodeT>
+class HeapNodeAllocator {
+ public:
+  static constexpr bool kBulkRelease = false;
+  static constexpr bool kOwnsHeader = false;
+  static constexpr bool kStableNodes = true;
+  static constexpr bool kPortableNodes = true;
+
+  NodeT *Allocate() {
+    return static_cast<NodeT *>(::operator new(sizeof(NodeT)));
+  }
+  void Deallocate(NodeT *node) noexcept { ::operator delete(node); }
+  void Release() noexcept {}
+  void swap(HeapNodeAllocator &) noexcept {}
+};
+
+// Per-tree arena: nodes are carved out of cache-line-aligned slabs and freed
+// nodes are kept on an intrusive free list for reuse. Release() drops all
+// slabs in O(#slabs).
+template <class NodeT>
+class SlabNodeAllocator {
+ public:
+  static constexpr bool kBulkRelease = true;
+  static constexpr bool kOwnsHeader = false;
+  static constexpr bool kStableNodes = true;
+  static constexpr bool kPortableNodes = false;
+  static constexpr std::size_t kCacheLine = 64;
+
+  SlabNodeAllocator() = default;
+  SlabNodeAllocator(const SlabNodeAllocator &) = delete;
+  SlabNodeAllocator &operator=(const SlabNodeAllocator &) = delete;
+  ~SlabNodeAllocator() { Release(); }
+
+  NodeT *Allocate();
+  void Deallocate(NodeT *node) noexcept;
+  void Release() noexcept;
+  void swap(SlabNodeAllocator &other) noexcept;
+
+  std::size_t slab_count() const { return slab_count_; }
+
+ private:
+  // Free cells reuse the node storage for the free list link
+  union Cell {
+    Cell *next;
+    alignas(NodeT) unsigned char storage[sizeof(NodeT)];
+  };
+  struct Slab {
+    Slab *next;
+  };
+
+  static_assert(alignof(Cell) <= kCacheLine,
+                "Node alignment exceeds the cache line size");
+
+  // The slab header occupies the first cache line, cells start after it
+  static constexpr std::size_t kMinSlabBytes = 16 * 1024;
+  static constexpr std::size_t kCellsPerSlab =
+      (kMinSlabBytes - kCacheLine) / sizeof(Cell) > 8
+          ? (kMinSlabBytes - kCacheLine) / sizeof(Cell)
+          : 8;
+  static constexpr std::size_t kSlabBytes =
+      kCacheLine + kCellsPerSlab * sizeof(Cell);
+
+  void AddSlab();
+
+  Slab *slabs_{nullptr};      // Singly linked list of owned slabs
+  Cell *free_{nullptr};       // Freed cells ready for reuse
+  Cell *bump_{nullptr};       // Next never used cell of the newest slab
+  Cell *bump_end_{nullptr};   // End of the newest slab
+  std::size_t slab_count_{};  // Number of slabs owned
+};
+
+template <class NodeT>
+NodeT *SlabNodeAllocator<NodeT>::Allocate() {
+  Cell *cell;
+  if (free_ != nullptr) {
+    cell = free_;
+    free_ = free_->next;
+  } else {
+    if (bump_ == bump_end_) {
+      AddSlab();
+    }
+    cell = bump_++;
+  }
+  return reinterpret_cast<NodeT *>(cell->storage);
+}
+
+template <class NodeT>
+void SlabNodeAllocator<NodeT>::Deallocate(NodeT *node) noexcept {
+  Cell *cell = reinterpret_cast<Cell *>(node);
+  cell->next = free_;
+  free_ = cell;
+}
+
+template <class NodeT>
+void SlabNodeAllocator<NodeT>::Release() noexcept {
+  while (slabs_ != nullptr) {
+    Slab *next = slabs_->next;
+    ::operator delete (static_cast<void *>(slabs_),
+                       std::align_val_t{kCacheLine});
+    slabs_ = next;
+  }
+  free_ = nullptr;
+  bump_ = nullptr;
+  bump_end_ = nullptr;
+  slab_count_ = 0;
+}
+
+template <class NodeT>
+void SlabNodeAllocator<NodeT>::swap(SlabNodeAllocator &other) noexcept {
+  std::swap(slabs_, other.slabs_);
+  std::swap(free_, other.free_);
+  std::swap(bump_, other.bump_);
+  std::swap(bump_end_, other.bump_end_);
+  std::swap(slab_count_, other.slab_count_);
+}
+
+template <class NodeT>
+void SlabNodeAllocator<NodeT>::AddSlab() {
+  void *memory = ::operator new (kSlabBytes, std::align_val_t{kCacheLine});
+  Slab *slab = static_cast<Slab *>(memory);
+  slab->next = slabs_;
+  slabs_ = slab;
+  ++slab_count_;
+  bump_ = reinterpret_cast<Cell *>(static_cast<unsigned char *>(memory) +
+                                   kCacheLine);
+  bump_end_ = bump_ + kCellsPerSlab;
+}
+
+// Index pool: all nodes of a container live in one s21::vector of cells and
+// link to each other with 32-bit IndexLinks. Cell 0 holds the container's
+// sentinel; the first Reserve() sets it up, so an empty pool owns no memory
+// and Release() frees all of it without allocating. Growing the pool moves
+// every node (a plain byte copy, links are position independent), and copying
+// the pool copies the whole container. Nodes must therefore be trivially
+// copyable apart from their links.
+template <class NodeT>
+class IndexPoolAllocator {
+ public:
+  static constexpr bool kBulkRelease = true;
+  static constexpr bool kOwnsHeader = true;
+  static constexpr bool kStableNodes = false;
+  static constexpr bool kPortableNodes = false;
+
+  IndexPoolAllocator() noexcept = default;
+  IndexPoolAllocator(const IndexPoolAllocator &other) = default;
+  IndexPoolAllocator &operator=(const IndexPoolAllocator &) = delete;
+
+  NodeT *Header() const noexcept {
+    return cells_.size() == 0 ? nullptr : At(0);
+  }
+  NodeT *Allocate();
+  void Deallocate(NodeT *node) noexcept;
+  void Release() noexcept;
+  // Whether count more nodes fit without growing the pool, which moves them
+  bool HasRoom(std::size_t count) const noexcept;
+  void Reserve(std::size_t count);
+  void swap(IndexPoolAllocator &other) noexcept;
+
+  std::size_t capacity() const { return cells_.capacity(); }
+
+ private:
+  struct Cell {
+    alignas(NodeT) unsigned char storage[sizeof(NodeT)];
+  };
+
+  static constexpr std::uint32_t kNoCell = UINT32_MAX;
+  static constexpr std::size_t kMaxCells =
+      IndexLink<NodeT>::kMaxSpan / sizeof(Cell) < kNoCell
+          ? IndexLink<NodeT>::kMaxSpan / sizeof(Cell)
+          : kNoCell;
+
+  NodeT *At(std::size_t index) const noexcept {
+    return reinterpret_cast<NodeT *>(
+        const_cast<unsigned char *>(cells_.data()[index].storage));
+  }
+
+  s21::vector<Cell> cells_;      // Cell 0 is the header
+  std::uint32_t free_{kNoCell};  // Head of the freed cells list
+  std::size_t free_count_{};     // Cells on the free list
+};
+
+template <class NodeT>
+NodeT *IndexPoolAllocator<NodeT>::Allocate() {
+  if (free_ != kNoCell) {
+    NodeT *node = At(free_);
+    std::memcpy(&free_, cells_.data()[free_].storage, sizeof(free_));
+    --free_count_;
+    return node;
+  }
+  Reserve(1);
+  cells_.push_back(Cell());
+  return At(cells_.size() - 1);
+}
+
+// A freed cell keeps the index of the next free cell in its first bytes,
+// written to the raw cell since the node is gone
+template <class NodeT>
+void IndexPoolAllocator<NodeT>::Deallocate(NodeT *node) noexcept {
+  Cell *cell = reinterpret_cast<Cell *>(node);
+  std::memcpy(cell->storage, &free_, sizeof(free_));
+  free_ = static_cast<std::uint32_t>(cell - cells_.data());
+  ++free_count_;
+}
+
+// Drops every node and the header cell
+template <class NodeT>
+void IndexPoolAllocator<NodeT>::Release() noexcept {
+  s21::vector<Cell>().swap(cells_);
+  free_ = kNoCell;
+  free_count_ = 0;
+}
+
+template <class NodeT>
+bool IndexPoolAllocator<NodeT>::HasRoom(std::size_t count) const noexcept {
+  return cells_.size() != 0 &&
+         count <= free_count_ + (cells_.capacity() - cells_.size());
+}
+
+// Makes room for count more nodes without moving them again; an empty pool
+// gets its header cell first
+template <class NodeT>
+void IndexPoolAllocator<NodeT>::Reserve(std::size_t count) {
+  if (HasRoom(count)) {
+    return;
+  }
+  std::size_t used = cells_.size() == 0 ? 1 : cells_.size();
+  std::size_t needed = used + (count > free_count_ ? count - free_count_ : 0);
+  if (needed > kMaxCells) {
+    throw std::length_error("Index pool exceeds the 32-bit link range");
+  }
+  std::size_t grown = cells_.capacity() * 2;
+  if (grown > kMaxCells) {
+    grown = kMaxCells;
+  }
+  cells_.reserve(needed > grown ? needed : grown);
+  if (cells_.size() == 0) {
+    cells_.push_back(Cell());
+  }
+}
+
+template <class NodeT>
+void IndexPoolAllocator<NodeT>::swap(IndexPoolAllocator &other) noexcept {
+  cells_.swap(other.cells_);
+  std::swap(free_, other.free_);
+  std::swap(free_count_, other.free_count_);
+}
+
+// What a storage policy asks of the nodes it stores: index pools need nodes
+// linked with IndexLinks
+template <template <class> class NodeAlloc>
+struct StorageTraits {
+  static constexpr bool kIndexLinks = false;
+};
+
+template <>
+struct StorageTraits<IndexPoolAllocator> {
+  static constexpr bool kIndexLinks = true;
+};
+
+}  // namespace s21
+
+#endif  // CPP2_S21_CONTAINERS_2_CONTAINERS_NODEALLOCATOR_H_
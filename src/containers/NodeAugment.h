@@ -0,0 +1,263 @@
+#ifndef CPP2_S21_CONTAINERS_2_CONTAINERS_NODEAUGMENT_H_
+#define CPP2_S21_CONTAINERS_2_CONTAINERS_NODEAUGMENT_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#include "NodeBalance.h"
+
+namespace s21 {
+
+// Augmentation policies add per-node data derived from the subtree.
+// Node inherits Data, and RBTree calls Update on a node whenever one of its
+// children changes (links, unlinks and rotations), children first.
+// kEnabled is false only for the policy that stores nothing, so the tree can
+// skip the update walks entirely.
+// kPackedColor, kIndexLinks and kThreaded select the node links of
+// NodeTree.h. kAggregate marks a SubtreeAggregate policy, whose nodes derive
+// their data from their own value as well.
+// Balance is the balancing policy of NodeBalance.h, red-black unless one of
+// the balance wrappers at the end of this file picks another.
+
+// Default policy: plain nodes, no extra data
+struct NoAugment {
+  static constexpr bool kEnabled = false;
+  static constexpr bool kSubtreeSize = false;
+  static constexpr bool kPackedColor = false;
+  static constexpr bool kIndexLinks = false;
+  static constexpr bool kThreaded = false;
+  static constexpr bool kAggregate = false;
+  using Balance = RedBlackBalance;
+
+  template <class Key, class Value>
+  struct Data {};
+
+  template <class NodeT>
+  static void Update(NodeT *) noexcept {}
+};
+
+// Order-statistic tree: every node knows the size of its subtree, which
+// gives rank, select and positional moves in O(log n)
+struct OrderStatistic {
+  static constexpr bool kEnabled = true;
+  static constexpr bool kSubtreeSize = true;
+  static constexpr bool kPackedColor = false;
+  static constexpr bool kIndexLinks = false;
+  static constexpr bool kThreaded = false;
+  static constexpr bool kAggregate = false;
+  using Balance = RedBlackBalance;
+
+  template <class Key, class Value>
+  struct Data {
+    std::size_t subtree_size{1};  // Nodes in the subtree rooted here
+  };
+
+  template <class NodeT>
+  static void Update(NodeT *node) noexcept {
+    node->subtree_size = 1 + Size<NodeT>(node->left) + Size<NodeT>(node->right);
+  }
+
+  template <class NodeT>
+  static std::size_t Size(const NodeT *node) noexcept {
+    return node != nullptr ? node->subtree_size : 0;
+  }
+
+  // Position of node in key order, counted from the first node
+  template <class NodeT>
+  static std::size_t Rank(const NodeT *node) noexcept;
+
+  // Node at position k of the subtree, nullptr if k is past its end
+  template <class NodeT>
+  static NodeT *Select(NodeT *node, std::size_t k) noexcept;
+};
+
+template <class NodeT>
+std::size_t OrderStatistic::Rank(const NodeT *node) noexcept {
+  std::size_t rank = Size<NodeT>(node->left);
+  for (; !node->GetParent()->IsHeader(); node = node->GetParent()) {
+    if (node == node->GetParent()->right) {
+      rank += Size<NodeT>(node->GetParent()->left) + 1;
+    }
+  }
+  return rank;
+}
+
+template <class NodeT>
+NodeT *OrderStatistic::Select(NodeT *node, std::size_t k) noexcept {
+  while (node != nullptr) {
+    std::size_t left_size = Size<NodeT>(node->left);
+    if (k < left_size) {
+      node = node->left;
+    } else if (k == left_size) {
+      return node;
+    } else {
+      k -= left_size + 1;
+      node = node->right;
+    }
+  }
+  return nullptr;
+}
+
+// Keeps the data and updates of Base and stores the node color in the low
+// bit of the parent pointer, e.g. PackedColor<> or PackedColor<OrderStatistic>
+template <class Base = NoAugment>
+struct PackedColor : Base {
+  static constexpr bool kPackedColor = true;
+};
+
+// Keeps the data and updates of Base and links the nodes with 32-bit
+// IndexLinks. Nodes of this policy live in an IndexPoolAllocator, which
+// picks it by default.
+template <class Base = NoAugment>
+struct IndexLinked : Base {
+  static constexpr bool kIndexLinks = true;
+};
+
+// Keeps the data and updates of Base and threads the nodes on a list in key
+// order: every iterator step is one pointer load instead of a climb of up to
+// O(log n) parents. Costs two links per node and O(1) more work per insert
+// and erase; set algebra relinks the list in O(n + m).
+template <class Base = NoAugment>
+struct Threaded : Base {
+  static constexpr bool kThreaded = true;
+};
+
+// Keeps the data and updates of Base and caches in every node the monoid
+// aggregate of its subtree, in key order, which gives the aggregate of any
+// key range in O(log n), see RBTree::AggregateRange. A Monoid provides
+//   using type = ...;
+//   static type Identity();
+//   static type Combine(const type &left, const type &right);  // associative
+//   template <class NodeT> static type Lift(const NodeT &node);
+// where Lift gives the aggregate of one element; SumOf, MinOf and MaxOf
+// below lift the mapped value. None of them may throw. Values changed in
+// place leave stale aggregates behind until the tree is told, see
+// Map::refresh.
+template <class Monoid, class Base = NoAugment>
+struct SubtreeAggregate : Base {
+  static constexpr bool kEnabled = true;
+  static constexpr bool kAggregate = true;
+  using monoid_type = Monoid;
+
+  template <class Key, class Value>
+  struct Data : Base::template Data<Key, Value> {
+    typename Monoid::type subtree_aggregate{};  // Aggregate of the subtree
+  };
+
+  template <class NodeT>
+  static void Update(NodeT *node) noexcept {
+    Base::Update(node);
+    node->subtree_aggregate = Monoid::Combine(
+        Monoid::Combine(Aggregate<NodeT>(node->left), Monoid::Lift(*node)),
+        Aggregate<NodeT>(node->right));
+  }
+
+  template <class NodeT>
+  static typename Monoid::type Aggregate(const NodeT *node) noexcept {
+    return node != nullptr ? node->subtree_aggregate : Monoid::Identity();
+  }
+};
+
+// Monoids of mapped values for SubtreeAggregate
+template <class T>
+struct SumOf {
+  using type = T;
+  static type Identity() noexcept { return T(); }
+  static type Combine(const type &left, const type &right) noexcept {
+    return left + right;
+  }
+  template <class NodeT>
+  static type Lift(const NodeT &node) noexcept {
+    return node.value;
+  }
+};
+
+// Identity of MinOf and MaxOf: the value no element can beat
+template <class T>
+struct MinOf {
+  using type = T;
+  static type Identity() noexcept {
+    return std::numeric_limits<T>::has_infinity
+               ? std::numeric_limits<T>::infinity()
+               : std::numeric_limits<T>::max();
+  }
+  static type Combine(const type &left, const type &right) noexcept {
+    return std::min(left, right);
+  }
+  template <class NodeT>
+  static type Lift(const NodeT &node) noexcept {
+    return node.value;
+  }
+};
+
+template <class T>
+struct MaxOf {
+  using type = T;
+  static type Identity() noexcept {
+    return std::numeric_limits<T>::has_infinity
+               ? -std::numeric_limits<T>::infinity()
+               : std::numeric_limits<T>::lowest();
+  }
+  static type Combine(const type &left, const type &right) noexcept {
+    return std::max(left, right);
+  }
+  template <class NodeT>
+  static type Lift(const NodeT &node) noexcept {
+    return node.value;
+  }
+};
+
+// Balance wrappers: they keep the data and updates of Base and rebalance
+// the tree with another policy, e.g. AVL<> or Treap<OrderStatistic>. Split,
+// Join and the split/join set algebra stay red-black only; with the other
+// policies Combine copies, see RBTree::Combine.
+
+// Stores the subtree height, maintained by Update like any derived data
+template <class Base = NoAugment>
+struct AVL : Base {
+  static constexpr bool kEnabled = true;
+  using Balance = AVLBalance;
+
+  template <class Key, class Value>
+  struct Data : Base::template Data<Key, Value> {
+    int height{0};  // Longest path down to a leaf, 0 for a leaf
+  };
+
+  template <class NodeT>
+  static void Update(NodeT *node) noexcept {
+    Base::Update(node);
+    node->height = 1 + std::max(AVLBalance::Height<NodeT>(node->left),
+                                AVLBalance::Height<NodeT>(node->right));
+  }
+};
+
+template <class Base = NoAugment>
+struct WAVL : Base {
+  using Balance = WAVLBalance;
+
+  template <class Key, class Value>
+  struct Data : Base::template Data<Key, Value> {
+    int rank{0};  // WAVL rank, not derived from the children
+  };
+};
+
+template <class Base = NoAugment>
+struct Treap : Base {
+  using Balance = TreapBalance;
+
+  template <class Key, class Value>
+  struct Data : Base::template Data<Key, Value> {
+    std::uint32_t priority{0};  // Heap priority, larger ones closer to the root
+  };
+};
+
+template <class Base = NoAugment>
+struct Splay : Base {
+  using Balance = SplayBalance;
+};
+
+}  // namespace s21
+
+#endif  // CPP2_S21_CONTAINERS_2_CONTAINERS_NODEAUGMENT_H_
@@ -0,0 +1,557 @@
+#ifndef CPP2_S21_CONTAINERS_2_CONTAINERS_NODEBALANCE_H_
+#define CPP2_S21_CONTAINERS_2_CONTAINERS_NODEBALANCE_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace s21 {
+
+enum class Color { Red, Black };
+
+// Balancing policies keep the search tree of RBTree shallow. The node policy
+// picks one through its Balance member (see NodeAugment.h), the tree calls
+// its hooks around every structural change:
+//  Linked(node)                  node was just linked as a leaf (or root)
+//  Unlinking(node)               node, with at most one child, is about to
+//                                be replaced by that child
+//  Unlinked(node, parent, child) it was, parent is the header for the root
+//  SwapTags(a, b) / CopyTag(to, from)
+//                                balance data follows a position, not a key
+//  Built(node, count)            bulk builds made node the root of a
+//                                balanced subtree of count nodes
+//  Accessed(node)                a lookup found node
+// Linked and Unlinked also refresh the augmented data up to the root.
+// kJoinable marks the red-black policy, the only one Split, Join and the
+// split/join Combine work with.
+// The hooks only touch links, so the header stands in for the parent of the
+// root and rotations need no special case for it.
+
+// Refreshes the augmented data of node and all of its ancestors
+template <class Augment, class NodeT>
+void UpdatePath(NodeT *node) noexcept {
+  if constexpr (Augment::kEnabled) {
+    for (; !node->IsHeader(); node = node->GetParent()) {
+      Augment::Update(node);
+    }
+  }
+}
+
+template <class Augment, class NodeT>
+void RotateLeft(NodeT *node) noexcept {
+  NodeT *right_child = node->right;
+  // Promote right child to be the parent of the node
+  right_child->SetParent(node->GetParent());
+  if (node == node->GetParent()->left) {
+    node->GetParent()->left = right_child;
+  } else {
+    node->GetParent()->right = right_child;
+  }
+  // Shift nodes around
+  node->right = right_child->left;
+  if (right_child->left != nullptr) {
+    right_child->left->SetParent(node);
+  }
+  right_child->left = node;
+  node->SetParent(right_child);
+  Augment::Update(node);
+  Augment::Update(right_child);
+}
+
+template <class Augment, class NodeT>
+void RotateRight(NodeT *node) noexcept {
+  NodeT *left_child = node->left;
+  left_child->SetParent(node->GetParent());
+  if (node == node->GetParent()->left) {
+    node->GetParent()->left = left_child;
+  } else {
+    node->GetParent()->right = left_child;
+  }
+  node->left = left_child->right;
+  if (left_child->right != nullptr) {
+    left_child->right->SetParent(node);
+  }
+  left_child->right = node;
+  node->SetParent(left_child);
+  Augment::Update(node);
+  Augment::Update(left_child);
+}
+
+// Rotates node one level up, above its parent
+template <class Augment, class NodeT>
+void RotateUp(NodeT *node) noexcept {
+  NodeT *parent = node->GetParent();
+  if (node == parent->left) {
+    RotateRight<Augment>(parent);
+  } else {
+    RotateLeft<Augment>(parent);
+  }
+}
+
+// Hooks of a policy that needs none of them
+struct BalanceHooks {
+  static constexpr bool kJoinable = false;
+
+  template <class Augment, class NodeT>
+  static void Linked(NodeT *node) noexcept {
+    UpdatePath<Augment>(node->GetParent());
+  }
+  template <class Augment, class NodeT>
+  static void Unlinking(NodeT *) noexcept {}
+  template <class Augment, class NodeT>
+  static void Unlinked(NodeT *, NodeT *parent, NodeT *) noexcept {
+    UpdatePath<Augment>(parent);
+  }
+  template <class NodeT>
+  static void SwapTags(NodeT *, NodeT *) noexcept {}
+  template <class NodeT>
+  static void CopyTag(NodeT *, const NodeT *) noexcept {}
+  template <class NodeT>
+  static void Built(NodeT *, std::size_t) noexcept {}
+  template <class Augment, class NodeT>
+  static void Accessed(NodeT *) noexcept {}
+};
+
+// Red-black tree: one color bit per node, at most 2 rotations per insert and
+// 3 per erase. The color lives in the node links.
+struct RedBlackBalance : BalanceHooks {
+  static constexpr bool kJoinable = true;
+
+  template <class Augment, class NodeT>
+  static void Linked(NodeT *node) noexcept;
+  template <class Augment, class NodeT>
+  static void Unlinking(NodeT *node) noexcept;
+  template <class Augment, class NodeT>
+  static void Unlinked(NodeT *node, NodeT *parent, NodeT *child) noexcept;
+  template <class NodeT>
+  static void SwapTags(NodeT *a, NodeT *b) noexcept {
+    Color color = a->GetColor();
+    a->SetColor(b->GetColor());
+    b->SetColor(color);
+  }
+  template <class NodeT>
+  static void CopyTag(NodeT *to, const NodeT *from) noexcept {
+    to->SetColor(from->GetColor());
+  }
+
+ private:
+  template <class Augment, class NodeT>
+  static void FixDoubleBlack(NodeT *node) noexcept;
+};
+
+template <class Augment, class NodeT>
+void RedBlackBalance::Linked(NodeT *node) noexcept {
+  node->SetColor(Color::Red);
+  UpdatePath<Augment>(node->GetParent());
+  // Fix any violations of the Red-Black Tree properties. The header is
+  // black, so the loop stops at the root.
+  while (node->GetParent()->GetColor() == Color::Red) {
+    NodeT *parent = node->GetParent();
+    NodeT *grandparent = parent->GetParent();
+    if (parent == grandparent->left) {
+      NodeT *uncle = grandparent->right;
+      if (uncle != nullptr && uncle->GetColor() == Color::Red) {
+        // Case 1: Recolor the parent, the sibling, and the grandparent
+        parent->SetColor(Color::Black);
+        uncle->SetColor(Color::Black);
+        grandparent->SetColor(Color::Red);
+        node = grandparent;
+      } else {
+        if (node == parent->right) {
+          // Case 2: Left rotate on the parent
+          node = parent;
+          RotateLeft<Augment>(node);
+          parent = node->GetParent();
+          grandparent = parent->GetParent();
+        }
+        // Case 3: Recolor the parent and grandparent and right rotate on the
+        // grandparent
+        parent->SetColor(Color::Black);
+        grandparent->SetColor(Color::Red);
+        RotateRight<Augment>(grandparent);
+      }
+    } else {
+      NodeT *uncle = grandparent->left;
+      if (uncle != nullptr && uncle->GetColor() == Color::Red) {
+        // Case 1: Recolor the parent, the sibling, and the grandparent
+        parent->SetColor(Color::Black);
+        uncle->SetColor(Color::Black);
+        grandparent->SetColor(Color::Red);
+        node = grandparent;
+      } else {
+        if (node == parent->left) {
+          // Case 2: Right rotate on the parent
+          node = parent;
+          RotateRight<Augment>(node);
+          parent = node->GetParent();
+          grandparent = parent->GetParent();
+        }
+        // Case 3: Recolor the parent and grandparent and left rotate on the
+        // grandparent
+        parent->SetColor(Color::Black);
+        grandparent->SetColor(Color::Red);
+        RotateLeft<Augment>(grandparent);
+      }
+    }
+  }
+  // Only case 1 can leave the root red
+  if (node->GetParent()->IsHeader()) {
+    node->SetColor(Color::Black);
+  }
+}
+
+// A black leaf leaves a hole in the black heights, which is fixed while the
+// leaf still stands in its place
+template <class Augment, class NodeT>
+void RedBlackBalance::Unlinking(NodeT *node) noexcept {
+  if (node->left == nullptr && node->right == nullptr &&
+      !node->GetParent()->IsHeader() && node->GetColor() == Color::Black) {
+    FixDoubleBlack<Augment>(node);
+  }
+}
+
+// The only child of a node is red, and black in its place
+template <class Augment, class NodeT>
+void RedBlackBalance::Unlinked(NodeT *, NodeT *parent, NodeT *child) noexcept {
+  UpdatePath<Augment>(parent);
+  if (child != nullptr) {
+    child->SetColor(Color::Black);
+  }
+}
+
+// Fixing double black violations in the tree
+template <class Augment, class NodeT>
+void RedBlackBalance::FixDoubleBlack(NodeT *node) noexcept {
+  while (!node->GetParent()->IsHeader() && node->GetColor() == Color::Black) {
+    if (node == node->GetParent()->left) {
+      NodeT *sibling = node->GetParent()->right;
+      // Case 1: Sibling is red
+      if (sibling != nullptr && sibling->GetColor() == Color::Red) {
+        sibling->SetColor(Color::Black);
+        node->GetParent()->SetColor(Color::Red);
+        RotateLeft<Augment>(node->GetParent());
+        sibling = node->GetParent()->right;
+      }
+      // Case 2: Sibling's children are black
+      if ((sibling->left == nullptr ||
+           sibling->left->GetColor() == Color::Black) &&
+          (sibling->right == nullptr ||
+           sibling->right->GetColor() == Color::Black)) {
+        sibling->SetColor(Color::Red);
+        node = node->GetParent();
+      } else {
+        // Case 3: Sibling's right child is black
+        if (sibling->right == nullptr ||
+            sibling->right->GetColor() == Color::Black) {
+          sibling->left->SetColor(Color::Black);
+          sibling->SetColor(Color::Red);
+          RotateRight<Augment>(sibling);
+          sibling = node->GetParent()->right;
+        }
+        // Case 4: Sibling's right child is red
+        sibling->SetColor(node->GetParent()->GetColor());
+        node->GetParent()->SetColor(Color::Black);
+        sibling->right->SetColor(Color::Black);
+        RotateLeft<Augment>(node->GetParent());
+        break;
+      }
+    } else {
+      NodeT *sibling = node->GetParent()->left;
+      // Case 1: Sibling is red
+      if (sibling != nullptr && sibling->GetColor() == Color::Red) {
+        sibling->SetColor(Color::Black);
+        node->GetParent()->SetColor(Color::Red);
+        RotateRight<Augment>(node->GetParent());
+        sibling = node->GetParent()->left;
+      }
+      // Case 2: Sibling's children are black
+      if ((sibling->left == nullptr ||
+           sibling->left->GetColor() == Color::Black) &&
+          (sibling->right == nullptr ||
+           sibling->right->GetColor() == Color::Black)) {
+        sibling->SetColor(Color::Red);
+        node = node->GetParent();
+      } else {
+        // Case 3: Sibling's left child is black
+        if (sibling->left == nullptr ||
+            sibling->left->GetColor() == Color::Black) {
+          sibling->right->SetColor(Color::Black);
+          sibling->SetColor(Color::Red);
+          RotateLeft<Augment>(sibling);
+          sibling = node->GetParent()->left;
+        }
+        // Case 4: Sibling's left child is red
+        sibling->SetColor(node->GetParent()->GetColor());
+        node->GetParent()->SetColor(Color::Black);
+        sibling->left->SetColor(Color::Black);
+        RotateRight<Augment>(node->GetParent());
+        break;
+      }
+    }
+  }
+  // A red node or the root absorbs the extra black
+  node->SetColor(Color::Black);
+}
+
+// AVL tree: the heights of the two subtrees of a node differ by at most one.
+// Shallower than red-black (1.44 log n against 2 log n), so lookups visit
+// fewer nodes, paid for by more rotations on erase. The height is derived
+// data kept by the AVL node policy's Update.
+struct AVLBalance : BalanceHooks {
+  template <class Augment, class NodeT>
+  static void Linked(NodeT *node) noexcept {
+    Retrace<Augment>(node->GetParent());
+  }
+  template <class Augment, class NodeT>
+  static void Unlinked(NodeT *, NodeT *parent, NodeT *) noexcept {
+    Retrace<Augment>(parent);
+  }
+  template <class NodeT>
+  static void SwapTags(NodeT *a, NodeT *b) noexcept {
+    std::swap(a->height, b->height);
+  }
+
+  template <class NodeT>
+  static int Height(const NodeT *node) noexcept {
+    return node != nullptr ? node->height : -1;
+  }
+
+ private:
+  template <class Augment, class NodeT>
+  static void Retrace(NodeT *node) noexcept;
+};
+
+// Walks up to the root refreshing the heights and rotates where they drift
+// two apart
+template <class Augment, class NodeT>
+void AVLBalance::Retrace(NodeT *node) noexcept {
+  for (; !node->IsHeader(); node = node->GetParent()) {
+    Augment::Update(node);
+    int balance = Height<NodeT>(node->left) - Height<NodeT>(node->right);
+    if (balance > 1) {
+      NodeT *left = node->left;
+      if (Height<NodeT>(left->left) < Height<NodeT>(left->right)) {
+        RotateLeft<Augment>(left);
+      }
+      RotateRight<Augment>(node);
+      node = node->GetParent();
+    } else if (balance < -1) {
+      NodeT *right = node->right;
+      if (Height<NodeT>(right->right) < Height<NodeT>(right->left)) {
+        RotateRight<Augment>(right);
+      }
+      RotateLeft<Augment>(node);
+      node = node->GetParent();
+    }
+  }
+}
+
+// Weak AVL tree (Haeupler, Sen, Tarjan): every node has a rank, the rank
+// differences to its children are 1 or 2 and leaves have rank 0, a missing
+// child has rank -1. Built by inserts alone it is an AVL tree, erases only
+// demote and rotate at most twice, so erase-heavy loads rotate less than
+// with AVL while the height stays below 2 log n.
+struct WAVLBalance : BalanceHooks {
+  template <class Augment, class NodeT>
+  static void Linked(NodeT *node) noexcept;
+  template <class Augment, class NodeT>
+  static void Unlinked(NodeT *node, NodeT *parent, NodeT *child) noexcept;
+  template <class NodeT>
+  static void SwapTags(NodeT *a, NodeT *b) noexcept {
+    std::swap(a->rank, b->rank);
+  }
+  template <class NodeT>
+  static void CopyTag(NodeT *to, const NodeT *from) noexcept {
+    to->rank = from->rank;
+  }
+  // A balanced build gets rank = height, which has differences of 1 and 2
+  template <class NodeT>
+  static void Built(NodeT *node, std::size_t) noexcept {
+    node->rank =
+        1 + std::max(Rank<NodeT>(node->left), Rank<NodeT>(node->right));
+  }
+
+  template <class NodeT>
+  static int Rank(const NodeT *node) noexcept {
+    return node != nullptr ? node->rank : -1;
+  }
+};
+
+// A new leaf of rank 0 under a leaf is a 0-child: promotions move the
+// violation up until a rotation removes it
+template <class Augment, class NodeT>
+void WAVLBalance::Linked(NodeT *node) noexcept {
+  node->rank = 0;
+  UpdatePath<Augment>(node->GetParent());
+  for (NodeT *parent = node->GetParent();
+       !parent->IsHeader() && parent->rank == node->rank;
+       parent = node->GetParent()) {
+    bool left = node == parent->left;
+    NodeT *sibling = left ? parent->right : parent->left;
+    if (parent->rank - Rank<NodeT>(sibling) == 1) {
+      ++parent->rank;
+      node = parent;
+      continue;
+    }
+    NodeT *inner = left ? node->right : node->left;
+    if (node->rank - Rank<NodeT>(inner) == 2) {
+      RotateUp<Augment>(node);
+      --parent->rank;
+    } else {
+      RotateUp<Augment>(inner);
+      RotateUp<Augment>(inner);
+      ++inner->rank;
+      --node->rank;
+      --parent->rank;
+    }
+    break;
+  }
+}
+
+// Erasing can leave a 3-child or a leaf of rank 1: demotions move the
+// violation up until a rotation removes it
+template <class Augment, class NodeT>
+void WAVLBalance::Unlinked(NodeT *, NodeT *parent, NodeT *child) noexcept {
+  UpdatePath<Augment>(parent);
+  if (parent->IsHeader()) {
+    return;
+  }
+  NodeT *node = child;
+  if (parent->left == nullptr && parent->right == nullptr) {
+    parent->rank = 0;
+    node = parent;
+    parent = node->GetParent();
+  }
+  // node may be nullptr on the first round; the other child is not then
+  while (!parent->IsHeader() && parent->rank - Rank<NodeT>(node) == 3) {
+    bool left = node == parent->left;
+    NodeT *sibling = left ? parent->right : parent->left;
+    if (parent->rank - sibling->rank == 2) {
+      --parent->rank;
+    } else if (sibling->rank - Rank<NodeT>(sibling->left) == 2 &&
+               sibling->rank - Rank<NodeT>(sibling->right) == 2) {
+      --parent->rank;
+      --sibling->rank;
+    } else {
+      NodeT *outer = left ? sibling->right : sibling->left;
+      if (sibling->rank - Rank<NodeT>(outer) == 1) {
+        RotateUp<Augment>(sibling);
+        ++sibling->rank;
+        --parent->rank;
+        if (parent->left == nullptr && parent->right == nullptr) {
+          --parent->rank;
+        }
+      } else {
+        NodeT *inner = left ? sibling->left : sibling->right;
+        RotateUp<Augment>(inner);
+        RotateUp<Augment>(inner);
+        inner->rank += 2;
+        --sibling->rank;
+        parent->rank -= 2;
+      }
+      return;
+    }
+    node = parent;
+    parent = node->GetParent();
+  }
+}
+
+// Treap: a binary search tree on the keys and a max-heap on random
+// priorities, expected depth O(log n) whatever the order of the keys. No
+// rebalancing on erase: the predecessor that takes an erased node's place
+// takes its priority too. Priorities hash the node address, so they need no
+// random state.
+struct TreapBalance : BalanceHooks {
+  template <class Augment, class NodeT>
+  static void Linked(NodeT *node) noexcept {
+    node->priority = Priority(node);
+    UpdatePath<Augment>(node->GetParent());
+    while (!node->GetParent()->IsHeader() &&
+           node->GetParent()->priority < node->priority) {
+      RotateUp<Augment>(node);
+    }
+  }
+  template <class NodeT>
+  static void SwapTags(NodeT *a, NodeT *b) noexcept {
+    std::swap(a->priority, b->priority);
+  }
+  template <class NodeT>
+  static void CopyTag(NodeT *to, const NodeT *from) noexcept {
+    to->priority = from->priority;
+  }
+  // The root of count random priorities holds the largest of them, which is
+  // drawn here, so later inserts meet the priorities a treap built by
+  // inserts would have. The children's priorities cap it from below.
+  template <class NodeT>
+  static void Built(NodeT *node, std::size_t count) noexcept {
+    double unit = static_cast<double>(Priority(node)) / 4294967296.0;
+    auto priority = static_cast<std::uint32_t>(
+        std::pow(unit, 1.0 / static_cast<double>(count)) * 4294967295.0);
+    if (node->left != nullptr && node->left->priority > priority) {
+      priority = node->left->priority;
+    }
+    if (node->right != nullptr && node->right->priority > priority) {
+      priority = node->right->priority;
+    }
+    node->priority = priority;
+  }
+
+ private:
+  template <class NodeT>
+  static std::uint32_t Priority(const NodeT *node) noexcept {
+    // splitmix64 finalizer
+    auto x = static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(node));
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return static_cast<std::uint32_t>((x ^ (x >> 31)) >> 32);
+  }
+};
+
+// Splay tree: every insert and every successful lookup rotates the node to
+// the root, erases splay the parent of the removed node. Amortized O(log n)
+// per operation and hot keys stay near the root, but single operations can
+// take O(n) and lookups restructure the tree: a splay container must not be
+// read from several threads, not even through const methods.
+struct SplayBalance : BalanceHooks {
+  template <class Augment, class NodeT>
+  static void Linked(NodeT *node) noexcept {
+    UpdatePath<Augment>(node->GetParent());
+    Splay<Augment>(node);
+  }
+  template <class Augment, class NodeT>
+  static void Unlinked(NodeT *, NodeT *parent, NodeT *) noexcept {
+    UpdatePath<Augment>(parent);
+    if (!parent->IsHeader()) {
+      Splay<Augment>(parent);
+    }
+  }
+  template <class Augment, class NodeT>
+  static void Accessed(NodeT *node) noexcept {
+    Splay<Augment>(node);
+  }
+
+ private:
+  template <class Augment, class NodeT>
+  static void Splay(NodeT *node) noexcept {
+    while (!node->GetParent()->IsHeader()) {
+      NodeT *parent = node->GetParent();
+      NodeT *grandparent = parent->GetParent();
+      if (grandparent->IsHeader()) {
+        RotateUp<Augment>(node);
+      } else if ((node == parent->left) == (parent == grandparent->left)) {
+        // Zig-zig: the parent goes up first
+        RotateUp<Augment>(parent);
+        RotateUp<Augment>(node);
+      } else {
+        RotateUp<Augment>(node);
+        RotateUp<Augment>(node);
+      }
+    }
+  }
+};
+
+}  // namespace s21
+
+#endif  // CPP2_S21_CONTAINERS_2_CONTAINERS_NODEBALANCE_H_
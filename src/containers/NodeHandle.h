@@ -0,0 +1,89 @@
+#ifndef CPP2_S21_CONTAINERS_2_CONTAINERS_NODEHANDLE_H_
+#define CPP2_S21_CONTAINERS_2_CONTAINERS_NODEHANDLE_H_
+
+#include <type_traits>
+#include <utility>
+
+#include "NodeTree.h"
+
+namespace s21 {
+
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+class RBTree;
+
+// Owns one node taken out of a tree with extract(). The node keeps its key and
+// value and can be inserted into another container of the same type, whatever
+// its comparator, without allocating or copying them. The key may be changed
+// while the node is out of any tree. An empty handle owns nothing.
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment>
+class NodeHandle {
+ public:
+  using key_type = Key;
+  using mapped_type = Value;
+
+  NodeHandle() = default;
+  NodeHandle(const NodeHandle &) = delete;
+  NodeHandle(NodeHandle &&other) noexcept : node_(other.node_) {
+    other.node_ = nullptr;
+  }
+  NodeHandle &operator=(const NodeHandle &) = delete;
+  NodeHandle &operator=(NodeHandle &&other) noexcept;
+  ~NodeHandle() { Reset(); }
+
+  bool empty() const { return node_ == nullptr; }
+  explicit operator bool() const { return node_ != nullptr; }
+
+  key_type &key() const { return node_->key; }
+  template <class V = Value,
+            class = std::enable_if_t<!std::is_same_v<V, NoValue>>>
+  V &mapped() const {
+    return node_->value;
+  }
+
+  void swap(NodeHandle &other) noexcept { std::swap(node_, other.node_); }
+
+ private:
+  template <class, class, template <class> class, class, class>
+  friend class RBTree;
+
+  explicit NodeHandle(Node<Key, Value, Augment> *node) : node_(node) {}
+
+  Node<Key, Value, Augment> *Release() noexcept {
+    Node<Key, Value, Augment> *node = node_;
+    node_ = nullptr;
+    return node;
+  }
+  void Reset() noexcept;
+
+  Node<Key, Value, Augment> *node_{nullptr};
+};
+
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment>
+NodeHandle<Key, Value, NodeAlloc, Augment>
+    &NodeHandle<Key, Value, NodeAlloc, Augment>::operator=(
+        NodeHandle &&other) noexcept {
+  if (this != &other) {
+    Reset();
+    node_ = other.Release();
+  }
+  return *this;
+}
+
+// Only allocators with kPortableNodes hand out handles, any instance of
+// them frees any of their nodes
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment>
+void NodeHandle<Key, Value, NodeAlloc, Augment>::Reset() noexcept {
+  if (node_ != nullptr) {
+    node_->~Node();
+    NodeAlloc<Node<Key, Value, Augment>>().Deallocate(node_);
+    node_ = nullptr;
+  }
+}
+
+}  // namespace s21
+
+#endif  // CPP2_S21_CONTAINERS_2_CONTAINERS_NODEHANDLE_H_
@@ -1,30 +1,161 @@
 #ifndef CPP2_S21_CONTAINERS_2_CONTAINERS_NODETREE_H_
 #define CPP2_S21_CONTAINERS_2_CONTAINERS_NODETREE_H_
 
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "IndexLink.h"
+#include "NodeAugment.h"
+
 namespace s21 {
 
-enum class Color { Red, Black };
+// Links shared by the tree nodes and the header sentinel of RBTree. The
+// header's left child is the root, its right link caches the rightmost node
+// and it is the only link object without a parent.
+// The parent and the color are reached through accessors only, so the tree
+// works the same on either layout below.
+template <class NodeT>
+struct NodeLinks {
+  NodeT *left{nullptr};   // Left child pointer
+  NodeT *right{nullptr};  // Right child pointer
+
+  NodeT *GetParent() const { return parent_; }
+  void SetParent(NodeT *parent) { parent_ = parent; }
+  Color GetColor() const { return color_; }
+  void SetColor(Color color) { color_ = color; }
+  bool IsHeader() const { return parent_ == nullptr; }
+
+ private:
+  NodeT *parent_{nullptr};   // Parent pointer
+  Color color_{Color::Red};  // Node color (Red or Black)
+};
+
+// Compact layout: nodes are at least pointer aligned, so the low bit of the
+// parent pointer is free and holds the color. Saves the padded color word,
+// 8 bytes per node on 64-bit targets.
+template <class NodeT>
+struct PackedNodeLinks {
+  NodeT *left{nullptr};   // Left child pointer
+  NodeT *right{nullptr};  // Right child pointer
+
+  NodeT *GetParent() const {
+    return reinterpret_cast<NodeT *>(parent_and_color_ & ~kBlackBit);
+  }
+  void SetParent(NodeT *parent) {
+    static_assert(alignof(NodeT) > 1, "No spare bit in the parent pointer");
+    parent_and_color_ = reinterpret_cast<std::uintptr_t>(parent) |
+                        (parent_and_color_ & kBlackBit);
+  }
+  Color GetColor() const {
+    return (parent_and_color_ & kBlackBit) != 0 ? Color::Black : Color::Red;
+  }
+  void SetColor(Color color) {
+    parent_and_color_ = (parent_and_color_ & ~kBlackBit) |
+                        (color == Color::Black ? kBlackBit : 0);
+  }
+  bool IsHeader() const { return parent_and_color_ <= kBlackBit; }
+
+ private:
+  static constexpr std::uintptr_t kBlackBit = 1;
+
+  std::uintptr_t parent_and_color_{0};  // Parent pointer | color bit
+};
+
+// Pool layout: 32-bit links relative to the node, 16 bytes for all links
+// instead of 32. The nodes must all live in one IndexPoolAllocator.
+template <class NodeT>
+struct IndexNodeLinks {
+  IndexLink<NodeT> left;   // Left child link
+  IndexLink<NodeT> right;  // Right child link
+
+  NodeT *GetParent() const { return parent_; }
+  void SetParent(NodeT *parent) { parent_ = parent; }
+  Color GetColor() const { return color_; }
+  void SetColor(Color color) { color_ = color; }
+  bool IsHeader() const { return parent_.get() == nullptr; }
+
+ private:
+  IndexLink<NodeT> parent_;  // Parent link
+  Color color_{Color::Red};  // Node color (Red or Black)
+};
+
+// Threaded layout: any of the layouts above plus the in-order neighbours,
+// in the same link type. The nodes and the header form a circular list in
+// key order, the header's next is the first node and its prev the last one,
+// so an iterator step is a single load.
+template <class Links, class Link>
+struct ThreadedNodeLinks : Links {
+  Link next{};  // In-order successor, the header after the last node
+  Link prev{};  // In-order predecessor, the header before the first node
+};
 
-template <class Key, class Value>
-class Node {
+template <class NodeT, class Augment>
+using BaseNodeLinksFor = std::conditional_t<
+    Augment::kIndexLinks, IndexNodeLinks<NodeT>,
+    std::conditional_t<Augment::kPackedColor, PackedNodeLinks<NodeT>,
+                       NodeLinks<NodeT>>>;
+
+// Link layout picked by the node policy
+template <class NodeT, class Augment>
+using NodeLinksFor = std::conditional_t<
+    Augment::kThreaded,
+    ThreadedNodeLinks<
+        BaseNodeLinksFor<NodeT, Augment>,
+        std::conditional_t<Augment::kIndexLinks, IndexLink<NodeT>, NodeT *>>,
+    BaseNodeLinksFor<NodeT, Augment>>;
+
+template <class Key, class Value, class Augment = NoAugment>
+class Node : public Augment::template Data<Key, Value>,
+             public NodeLinksFor<Node<Key, Value, Augment>, Augment> {
  public:
-  Key key;                   // Node key
-  Value value;               // Node value
-  Node<Key, Value> *left;    // Left child pointer
-  Node<Key, Value> *right;   // Right child pointer
-  Node<Key, Value> *parent;  // Parent pointer
-  Color color;               // Node color (Red or Black)
+  using Links = NodeLinksFor<Node, Augment>;
+
+  Key key;      // Node key
+  Value value;  // Node value
 
   bool operator>(const Key &val) const { return this->key > val; }
   bool operator>=(const Key &val) const { return this->key >= val; }
 
-  Node(const Key &key, const Value &value)
-      : key(key),
-        value(value),
-        left(nullptr),
-        right(nullptr),
-        parent(nullptr),
-        color(Color::Red) {}  // Default color is Red
+  // The key comes from the first argument, the value is built in place from
+  // the rest (value-initialized if there are none)
+  template <class K, class... Args>
+  explicit Node(K &&key, Args &&...args)
+      : key(std::forward<K>(key)), value(std::forward<Args>(args)...) {}
+
+  template <class... KeyArgs, class... ValueArgs>
+  Node(std::piecewise_construct_t, std::tuple<KeyArgs...> key_args,
+       std::tuple<ValueArgs...> value_args)
+      : key(std::make_from_tuple<Key>(std::move(key_args))),
+        value(std::make_from_tuple<Value>(std::move(value_args))) {}
+};
+
+// Value type of set-like trees: their nodes hold the key only
+struct NoValue {};
+
+template <class Key, class Augment>
+class Node<Key, NoValue, Augment>
+    : public Augment::template Data<Key, NoValue>,
+      public NodeLinksFor<Node<Key, NoValue, Augment>, Augment> {
+ public:
+  using Links = NodeLinksFor<Node, Augment>;
+
+  Key key;  // Node key
+
+  bool operator>(const Key &val) const { return this->key > val; }
+  bool operator>=(const Key &val) const { return this->key >= val; }
+
+  template <class K>
+  explicit Node(K &&key) : key(std::forward<K>(key)) {}
+
+  template <class K>
+  Node(K &&key, NoValue) : key(std::forward<K>(key)) {}
+
+  // Builds the key in place from any number of arguments
+  template <class... Args>
+  explicit Node(std::in_place_t, Args &&...args)
+      : key(std::forward<Args>(args)...) {}
 };
 
 }  // namespace s21
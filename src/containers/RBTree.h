@@ -1,347 +1,2574 @@
 #ifndef CPP2_S21_CONTAINERS_2_CONTAINERS_RBTREE_H_
 #define CPP2_S21_CONTAINERS_2_CONTAINERS_RBTREE_H_
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
 
+#include "NodeAllocator.h"
+#include "NodeHandle.h"
+#include "ThreadPool.h"
 #include "s21_IteratorTree.h"
+#include "s21_vector.h"
 
 namespace s21 {
 
-template <class Key, class Value>
+// Node policy a storage policy gets unless one is given: index pools store
+// IndexLinked nodes
+template <template <class> class NodeAlloc>
+using DefaultNodePolicy =
+    std::conditional_t<StorageTraits<NodeAlloc>::kIndexLinks, IndexLinked<>,
+                       NoAugment>;
+
+// What Merge does with a node of the other tree whose key is already here
+enum class MergeEqual { KeepBoth, KeepOurs, TakeTheirs };
+
+// Set operations of RBTree::Combine
+enum class SetOperation {
+  Union,
+  Intersection,
+  Difference,
+  SymmetricDifference
+};
+
+template <class Key, class Value,
+          template <class> class NodeAlloc = HeapNodeAllocator,
+          class Augment = DefaultNodePolicy<NodeAlloc>,
+          class Compare = std::less<Key>>
 class RBTree {
+  static_assert(StorageTraits<NodeAlloc>::kIndexLinks == Augment::kIndexLinks,
+                "IndexPoolAllocator needs an IndexLinked node policy and "
+                "IndexLinked nodes need an IndexPoolAllocator");
+
  public:
-  using iterator = RBTreeIterator<Key, Value>;
-  using const_iterator = const RBTreeIterator<Key, Value>;
+  using iterator = RBTreeIterator<Key, Value, Augment>;
+  using const_iterator = const RBTreeIterator<Key, Value, Augment>;
+  using node_allocator = NodeAlloc<Node<Key, Value, Augment>>;
+  using node_type = NodeHandle<Key, Value, NodeAlloc, Augment>;
+  static_assert(node_allocator::kStableNodes ||
+                    (std::is_trivially_copyable_v<Key> &&
+                     std::is_trivially_copyable_v<Value>),
+                "Pooled nodes are moved byte by byte and need trivially "
+                "copyable keys and values");
 
-  RBTree() : root_(nullptr) {}
+  RBTree() { ResetHeader(); }
+  explicit RBTree(const Compare &compare) : compare_(compare) { ResetHeader(); }
+  RBTree(const RBTree &) = delete;
+  RBTree &operator=(const RBTree &) = delete;
 
-  ~RBTree() { DeleteTree(root_); }
+  ~RBTree() { Clear(); }
 
   void Insert(const Key &key, const Value &value);
-  void Erase(Node<Key, Value> *node);
+  // The inserts build the node from key and args, forwarded; the value is
+  // constructed in place from args
+  template <class K, class... Args>
+  std::pair<Node<Key, Value, Augment> *, bool> InsertUnique(K &&key,
+                                                            Args &&...args);
+  template <class K, class... Args>
+  Node<Key, Value, Augment> *InsertEqual(K &&key, Args &&...args);
+  template <class K, class... Args>
+  std::pair<Node<Key, Value, Augment> *, bool> InsertUniqueHint(
+      Node<Key, Value, Augment> *hint, K &&key, Args &&...args);
+  template <class K, class... Args>
+  Node<Key, Value, Augment> *InsertEqualHint(Node<Key, Value, Augment> *hint,
+                                             K &&key, Args &&...args);
+  // Unique insert searching from finger, see LowerBoundFrom
+  template <class K, class... Args>
+  std::pair<Node<Key, Value, Augment> *, bool> InsertUniqueFrom(
+      Node<Key, Value, Augment> *finger, K &&key, Args &&...args);
+  // The emplaces build the node from args first and place it by its key; a
+  // unique emplace destroys it again if the key is already present
+  template <class... Args>
+  std::pair<Node<Key, Value, Augment> *, bool> EmplaceUnique(Args &&...args);
+  template <class... Args>
+  std::pair<Node<Key, Value, Augment> *, bool> EmplaceUniqueHint(
+      Node<Key, Value, Augment> *hint, Args &&...args);
+  template <class... Args>
+  Node<Key, Value, Augment> *EmplaceEqual(Args &&...args);
+  template <class... Args>
+  Node<Key, Value, Augment> *EmplaceEqualHint(Node<Key, Value, Augment> *hint,
+                                              Args &&...args);
+  template <class ForwardIt>
+  std::size_t Assign(ForwardIt first, ForwardIt last, bool unique);
+  template <class ForwardIt>
+  std::size_t AssignSorted(ForwardIt first, ForwardIt last, bool unique);
+  void Clone(const RBTree &other);
+  void Erase(Node<Key, Value, Augment> *node);
+  // Erase the nodes of [first, last) and the nodes with a key in [lo, hi);
+  // return how many
+  std::size_t EraseRange(Node<Key, Value, Augment> *first,
+                         Node<Key, Value, Augment> *last);
+  template <class K>
+  std::size_t EraseKeyRange(const K &lo, const K &hi);
+  node_type Extract(Node<Key, Value, Augment> *node);
+  std::pair<Node<Key, Value, Augment> *, bool> InsertNodeUnique(
+      node_type &handle);
+  Node<Key, Value, Augment> *InsertNodeEqual(node_type &handle);
+  std::size_t Merge(RBTree &other, MergeEqual on_equal, std::size_t size,
+                    std::size_t other_size);
+  void Clear();
   void swap(RBTree &other) noexcept;
+  // Split and join, O(log n); need an allocator with kPortableNodes
+  void Split(const Key &key, RBTree &equal, RBTree &greater);
+  void Join(node_type &pivot, RBTree &right);
+  void Join(RBTree &right);
+  std::size_t Combine(RBTree &other, SetOperation op, bool unique,
+                      ThreadPool *pool = nullptr);
 
-  Node<Key, Value> *GetRoot() const;
-  Node<Key, Value> *Find(Node<Key, Value> *node, const Key &key) const;
-  bool Contains(const Key &key) const;
+  Node<Key, Value, Augment> *GetRoot() const;
+  Node<Key, Value, Augment> *Begin() const;
+  Node<Key, Value, Augment> *End() const;
+  Node<Key, Value, Augment> *Find(Node<Key, Value, Augment> *node,
+                                  const Key &key) const;
+  // The lookups take any K the comparator accepts next to Key; the
+  // containers pass other types only with a transparent comparator
+  template <class K>
+  Node<Key, Value, Augment> *FindKey(const K &key) const;
+  template <class K>
+  bool Contains(const K &key) const;
+  template <class K>
+  Node<Key, Value, Augment> *LowerBound(const K &key) const;
+  template <class K>
+  Node<Key, Value, Augment> *UpperBound(const K &key) const;
+  template <class K>
+  Node<Key, Value, Augment> *LowerBoundFrom(Node<Key, Value, Augment> *finger,
+                                            const K &key) const;
+  template <class K>
+  std::pair<Node<Key, Value, Augment> *, Node<Key, Value, Augment> *>
+  EqualRange(const K &key) const;
+  template <class K>
+  std::size_t Rank(const K &key) const;
+  // Calls fn with every node whose key is in [lo, hi), in key order
+  template <class K, class Fn>
+  void ForEachInRange(const K &lo, const K &hi, Fn &&fn) const;
+  // Monoid aggregate of the nodes with a key in [lo, hi) and the refresh
+  // after a value changed in place; need a SubtreeAggregate node policy
+  template <class K>
+  auto AggregateRange(const K &lo, const K &hi) const;
+  void Refresh(Node<Key, Value, Augment> *node) noexcept;
+  // Looks up every key of [first, last) and calls emit with its FindKey
+  // result, in order
+  template <class ForwardIt, class Emit>
+  void FindBatch(ForwardIt first, ForwardIt last, Emit &&emit) const;
+  Node<Key, Value, Augment> *Select(std::size_t k) const;
+  const Compare &KeyCompare() const { return compare_; }
 
  protected:
-  void DeleteTree(Node<Key, Value> *node);
-  Node<Key, Value> *root_;
+  void DeleteTree(Node<Key, Value, Augment> *node);
+  template <class... Args>
+  Node<Key, Value, Augment> *CreateNode(Args &&...args);
+  void DestroyNode(Node<Key, Value, Augment> *node) noexcept;
+  Node<Key, Value, Augment> *Header() const;
+  // Header sentinel: left is the root, right the rightmost node. Only its
+  // links are ever built, but the tree reaches it as a Node, so it gets the
+  // storage of a whole node, like the header cell of IndexPoolAllocator.
+  struct HeaderCell {
+    alignas(Node<Key, Value, Augment>) unsigned char
+        storage[sizeof(Node<Key, Value, Augment>)];
+  } header_;
+  Node<Key, Value, Augment> *leftmost_;  // First node, the header when empty
+  node_allocator alloc_;
+  Compare compare_;
 
  private:
-  void SetNewNode(Node<Key, Value> *newNode, Node<Key, Value> *parent);
-  void LeftRotate(Node<Key, Value> *node);
-  void RightRotate(Node<Key, Value> *node);
-  void FixUpTree(Node<Key, Value> *node);
-  Node<Key, Value> *FindMax(Node<Key, Value> *node) const;
+  using Balance = typename Augment::Balance;
+
+  void DestroyPayloads(Node<Key, Value, Augment> *node) noexcept;
+  Node<Key, Value, Augment> *MakeRoom(std::size_t count,
+                                      Node<Key, Value, Augment> *node);
+  template <class... Args>
+  static std::pair<Key, Value> Stage(Args &&...args);
+  // Node positions as byte offsets from the header, which survive the pool
+  // moving or being copied; -1 stands for nullptr
+  std::ptrdiff_t HeaderOffset(const Node<Key, Value, Augment> *node) const;
+  Node<Key, Value, Augment> *AtHeaderOffset(std::ptrdiff_t offset) const;
+  void ResetHeader() noexcept;
+  void AdoptRoot() noexcept;
+  void LinkNode(Node<Key, Value, Augment> *newNode,
+                Node<Key, Value, Augment> *parentNode, bool left);
+  template <class K>
+  Node<Key, Value, Augment> *FindUniqueSlot(const K &key,
+                                            Node<Key, Value, Augment> *&parent,
+                                            bool &left) const;
+  template <class K>
+  Node<Key, Value, Augment> *FindUniqueSlotNear(
+      Node<Key, Value, Augment> *hint, const K &key,
+      Node<Key, Value, Augment> *&parent, bool &left) const;
+  template <class K>
+  void FindEqualSlot(const K &key, Node<Key, Value, Augment> *&parent,
+                     bool &left) const;
+  template <class K>
+  void FindEqualSlotNear(Node<Key, Value, Augment> *hint, const K &key,
+                         Node<Key, Value, Augment> *&parent, bool &left) const;
+  std::pair<Node<Key, Value, Augment> *, bool> LinkUnique(
+      Node<Key, Value, Augment> *node);
+  void LinkEqual(Node<Key, Value, Augment> *node);
+  Node<Key, Value, Augment> *Detach(Node<Key, Value, Augment> *node);
+  void SwapWithPredecessor(Node<Key, Value, Augment> *node,
+                           Node<Key, Value, Augment> *pred);
+  void Transplant(Node<Key, Value, Augment> *old_node,
+                  Node<Key, Value, Augment> *node);
+  void TakeNodes(s21::vector<Node<Key, Value, Augment> *> &nodes);
+  static void ResetLinks(Node<Key, Value, Augment> *node) noexcept;
+  // Smallest black height of both operands for which CombineSubtrees forks,
+  // a subtree that high holds at least 2^10 - 1 nodes
+  static constexpr int kParallelGrainHeight = 10;
+  // CombineSubtrees forks only in its top levels, into about this many calls
+  // per pool thread: enough to even out uneven splits, few enough that the
+  // forks cost nothing next to the work, whatever the size of the trees
+  static constexpr std::size_t kParallelCallsPerThread = 4;
+  // Descents FindBatch runs in lockstep: enough cache misses in flight to
+  // hide the memory latency, few enough lanes to stay in L1
+  static constexpr std::size_t kBatchWidth = 16;
+  // Nodes EraseRange erases one by one before it splits off the rest of a
+  // range: the two splits and the join cost about as much as this many erases
+  static constexpr std::size_t kRangeSplitMin = 64;
+  // Bound on the depth of a red-black tree, 2 log2(n + 1)
+  static constexpr int kMaxDepth = 2 * std::numeric_limits<std::size_t>::digits;
+
+  // Detached red-black subtree with a black root, and the number of black
+  // nodes on its paths; an empty subtree has height 0
+  struct Subtree {
+    Node<Key, Value, Augment> *root{nullptr};
+    int height{0};
+  };
+
+  Subtree ReleaseRoot() noexcept;
+  void Install(Subtree tree) noexcept;
+  Subtree JoinSubtrees(Subtree left, Node<Key, Value, Augment> *pivot,
+                       Subtree right) noexcept;
+  Subtree Concat(Subtree left, Subtree right) noexcept;
+  Subtree SplitLast(Subtree tree, Node<Key, Value, Augment> *&last) noexcept;
+  void SplitSubtree(Subtree tree, const Key &key, bool unique, Subtree &less,
+                    Subtree &equal, Subtree &greater) noexcept;
+  void SplitAround(Subtree tree, const bool *left_turns,
+                   Node<Key, Value, Augment> *node, Subtree &less,
+                   Subtree &greater) noexcept;
+  std::size_t CutRange(Node<Key, Value, Augment> *first,
+                       Node<Key, Value, Augment> *last);
+  static void TurnsTo(const Node<Key, Value, Augment> *root,
+                      const Node<Key, Value, Augment> *node,
+                      bool *left_turns) noexcept;
+  Subtree CombineSubtrees(Subtree lhs, Subtree rhs, SetOperation op,
+                          bool unique, std::size_t &dropped, ThreadPool *pool,
+                          int forks);
+  Subtree BuildRun(Node<Key, Value, Augment> **nodes, std::size_t count);
+  std::size_t DropSubtree(Node<Key, Value, Augment> *node) noexcept;
+  std::size_t CombineCopies(RBTree &other, SetOperation op);
+  static Subtree AsSubtree(Node<Key, Value, Augment> *root,
+                           int height) noexcept;
+  static void Expose(Subtree tree, Subtree &left, Subtree &right) noexcept;
+  static Node<Key, Value, Augment> *JoinRight(Node<Key, Value, Augment> *node,
+                                              int height,
+                                              Node<Key, Value, Augment> *pivot,
+                                              Subtree right) noexcept;
+  static Node<Key, Value, Augment> *JoinLeft(Subtree left,
+                                             Node<Key, Value, Augment> *pivot,
+                                             Node<Key, Value, Augment> *node,
+                                             int height) noexcept;
+  static int BlackHeight(const Node<Key, Value, Augment> *node) noexcept;
+  static void CollectSubtree(Node<Key, Value, Augment> *node,
+                             s21::vector<Node<Key, Value, Augment> *> &nodes);
+  static void KeepCounts(SetOperation op, std::size_t ours, std::size_t theirs,
+                         std::size_t *keep_ours, std::size_t *keep_theirs);
+  Node<Key, Value, Augment> *FindMax(Node<Key, Value, Augment> *node) const;
+  static Node<Key, Value, Augment> *Next(Node<Key, Value, Augment> *node);
+  static Node<Key, Value, Augment> *Prev(Node<Key, Value, Augment> *node);
+  static Node<Key, Value, Augment> *Successor(Node<Key, Value, Augment> *node);
+  // Threads of Threaded node policies, no-ops for the others
+  static void Thread(Node<Key, Value, Augment> *prev,
+                     Node<Key, Value, Augment> *next) noexcept;
+  void ThreadEnds() noexcept;
+  void Rethread() noexcept;
+  static void Prefetch(const Node<Key, Value, Augment> *node) noexcept;
+  template <class K>
+  Node<Key, Value, Augment> *LowerBound(Node<Key, Value, Augment> *node,
+                                        Node<Key, Value, Augment> *bound,
+                                        const K &key) const;
+  template <class K>
+  Node<Key, Value, Augment> *UpperBound(Node<Key, Value, Augment> *node,
+                                        Node<Key, Value, Augment> *bound,
+                                        const K &key) const;
+
+  template <class Item>
+  static const Key &ItemKey(const Item &item);
+  template <class Item>
+  static const Value &ItemValue(const Item &item);
+  template <class ForwardIt>
+  std::size_t CountSorted(ForwardIt first, ForwardIt last, bool unique,
+                          bool *sorted) const;
+  template <class ForwardIt>
+  void BuildSorted(ForwardIt first, std::size_t count, bool unique);
+  template <class ForwardIt, class Make>
+  void LinkSorted(ForwardIt first, std::size_t count, bool unique, Make &make);
+  template <class ForwardIt, class Make>
+  Node<Key, Value, Augment> *BuildSubtree(ForwardIt &it, std::size_t count,
+                                          std::size_t depth,
+                                          std::size_t red_depth, bool unique,
+                                          Node<Key, Value, Augment> *&last,
+                                          Make &make);
 };
 
-template <class Key, class Value>
-void RBTree<Key, Value>::DeleteTree(Node<Key, Value> *node) {
-  if (node != nullptr) {
-    DeleteTree(node->left);
-    DeleteTree(node->right);
-    node->left = nullptr;
-    node->right = nullptr;
-    delete node;
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+void RBTree<Key, Value, NodeAlloc, Augment, Compare>::DeleteTree(
+    Node<Key, Value, Augment> *node) {
+  // Rotating left children up turns the subtree into a list without a stack,
+  // a splay tree may be as deep as it is large
+  while (node != nullptr) {
+    Node<Key, Value, Augment> *next = node->left;
+    if (next != nullptr) {
+      node->left = next->right;
+      next->right = node;
+    } else {
+      next = node->right;
+      node->right = nullptr;
+      DestroyNode(node);
+    }
+    node = next;
   }
 }
 
-template <class Key, class Value>
-Node<Key, Value> *RBTree<Key, Value>::GetRoot() const {
-  return root_;
+// Runs the node destructors only, the storage is dropped by the allocator
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+void RBTree<Key, Value, NodeAlloc, Augment, Compare>::DestroyPayloads(
+    Node<Key, Value, Augment> *node) noexcept {
+  while (node != nullptr) {
+    Node<Key, Value, Augment> *next = node->left;
+    if (next != nullptr) {
+      node->left = next->right;
+      next->right = node;
+    } else {
+      next = node->right;
+      node->~Node();
+    }
+    node = next;
+  }
 }
 
-template <class Key, class Value>
-void RBTree<Key, Value>::swap(RBTree &other) noexcept {
-  std::swap(root_, other.root_);
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+void RBTree<Key, Value, NodeAlloc, Augment, Compare>::Clear() {
+  if constexpr (node_allocator::kBulkRelease) {
+    if constexpr (!std::is_trivially_destructible_v<
+                      Node<Key, Value, Augment>>) {
+      DestroyPayloads(Header()->left);
+    }
+    alloc_.Release();
+  } else {
+    DeleteTree(Header()->left);
+  }
+  ResetHeader();
 }
 
-template <class Key, class Value>
-Node<Key, Value> *RBTree<Key, Value>::Find(Node<Key, Value> *node,
-                                           const Key &key) const {
-  while (node != nullptr) {
-    if (key == node->key) {
-      return node;
-    } else if (key < node->key) {
-      node = node->left;
-    } else {
-      node = node->right;
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+void RBTree<Key, Value, NodeAlloc, Augment, Compare>::ResetHeader() noexcept {
+  new (static_cast<typename Node<Key, Value, Augment>::Links *>(Header()))
+      typename Node<Key, Value, Augment>::Links();
+  Header()->left = nullptr;
+  Header()->right = Header();
+  Header()->SetParent(nullptr);
+  Header()->SetColor(Color::Black);
+  leftmost_ = Header();
+  ThreadEnds();
+}
+
+// Points the root back at this tree's header after the links were moved
+// over from another tree
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+void RBTree<Key, Value, NodeAlloc, Augment, Compare>::AdoptRoot() noexcept {
+  if (Header()->left != nullptr) {
+    Header()->left->SetParent(Header());
+  } else {
+    Header()->right = Header();
+    leftmost_ = Header();
+  }
+  ThreadEnds();
+}
+
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+template <class... Args>
+Node<Key, Value, Augment> *
+RBTree<Key, Value, NodeAlloc, Augment, Compare>::CreateNode(Args &&...args) {
+  Node<Key, Value, Augment> *node = alloc_.Allocate();
+  try {
+    new (node) Node<Key, Value, Augment>(std::forward<Args>(args)...);
+  } catch (...) {
+    alloc_.Deallocate(node);
+    throw;
+  }
+  return node;
+}
+
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+void RBTree<Key, Value, NodeAlloc, Augment, Compare>::DestroyNode(
+    Node<Key, Value, Augment> *node) noexcept {
+  node->~Node();
+  alloc_.Deallocate(node);
+}
+
+// Inserts call this before they take node pointers: it makes room for count
+// new nodes so that CreateNode cannot move the nodes while they are held.
+// If the pool has to grow now, leftmost_ and node (a caller's hint, may be
+// nullptr) are rebuilt from their offsets to the header; returns the rebuilt
+// node. The first growth of a pool moves the header of the still empty tree
+// out of header_ into the pool.
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+Node<Key, Value, Augment>
+    *RBTree<Key, Value, NodeAlloc, Augment, Compare>::MakeRoom(
+        std::size_t count, Node<Key, Value, Augment> *node) {
+  if constexpr (!node_allocator::kStableNodes) {
+    if (!alloc_.HasRoom(count)) {
+      bool first = alloc_.Header() == nullptr;
+      std::ptrdiff_t leftmost = HeaderOffset(leftmost_);
+      std::ptrdiff_t at = HeaderOffset(node);
+      alloc_.Reserve(count);
+      if (first) {
+        ResetHeader();
+      } else {
+        leftmost_ = AtHeaderOffset(leftmost);
+      }
+      node = AtHeaderOffset(at);
     }
   }
-  throw std::out_of_range("Key not found");
+  return node;
 }
 
-template <class Key, class Value>
-void RBTree<Key, Value>::Insert(const Key &key, const Value &value) {
-  Node<Key, Value> *newNode = new Node<Key, Value>(key, value);
-  // If the root is null, set the new node as the root and color it black
-  if (root_ == nullptr) {
-    root_ = newNode;
-    root_->color = Color::Black;
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+std::ptrdiff_t RBTree<Key, Value, NodeAlloc, Augment, Compare>::HeaderOffset(
+    const Node<Key, Value, Augment> *node) const {
+  if (node == nullptr) {
+    return -1;
+  }
+  return reinterpret_cast<const char *>(node) -
+         reinterpret_cast<const char *>(Header());
+}
+
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+Node<Key, Value, Augment>
+    *RBTree<Key, Value, NodeAlloc, Augment, Compare>::AtHeaderOffset(
+        std::ptrdiff_t offset) const {
+  if (offset < 0) {
+    return nullptr;
+  }
+  return reinterpret_cast<Node<Key, Value, Augment> *>(
+      reinterpret_cast<char *>(Header()) + offset);
+}
+
+// A pooled insert that is about to grow the pool builds its key and value
+// here first: key and args may refer to a node, and growing the pool frees
+// the storage the nodes move out of. Pooled keys and values are trivially
+// copyable, so they are built in a node on the stack and copied out.
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+template <class... Args>
+std::pair<Key, Value> RBTree<Key, Value, NodeAlloc, Augment, Compare>::Stage(
+    Args &&...args) {
+  Node<Key, Value, Augment> staged(std::forward<Args>(args)...);
+  if constexpr (std::is_same_v<Value, NoValue>) {
+    return std::make_pair(staged.key, NoValue());
   } else {
-    SetNewNode(newNode, root_);
-    newNode->color = Color::Red;
-    // Fix any violations of the Red-Black Tree properties
-    Node<Key, Value> *node = newNode;
-    while (node->parent != nullptr && node->parent->color == Color::Red) {
-      Node<Key, Value> *parent = node->parent;
-      Node<Key, Value> *grandparent = parent->parent;
-      if (parent == grandparent->left) {
-        Node<Key, Value> *uncle = grandparent->right;
-        if (uncle != nullptr && uncle->color == Color::Red) {
-          // Case 1: Recolor the parent, the sibling, and the grandparent
-          parent->color = Color::Black;
-          uncle->color = Color::Black;
-          grandparent->color = Color::Red;
-          node = grandparent;
-        } else {
-          if (node == parent->right) {
-            // Case 2: Left rotate on the parent
-            node = parent;
-            LeftRotate(node);
-            parent = node->parent;
-            grandparent = parent->parent;
-          }
-          // Case 3: Recolor the parent and grandparent and right rotate on the
-          // grandparent
-          parent->color = Color::Black;
-          grandparent->color = Color::Red;
-          RightRotate(grandparent);
-        }
-      } else {
-        Node<Key, Value> *uncle = grandparent->left;
-        if (uncle != nullptr && uncle->color == Color::Red) {
-          // Case 1: Recolor the parent, the sibling, and the grandparent
-          parent->color = Color::Black;
-          uncle->color = Color::Black;
-          grandparent->color = Color::Red;
-          node = grandparent;
-        } else {
-          if (node == parent->left) {
-            // Case 2: Right rotate on the parent
-            node = parent;
-            RightRotate(node);
-            parent = node->parent;
-            grandparent = parent->parent;
-          }
-          // Case 3: Recolor the parent and grandparent and left rotate on the
-          // grandparent
-          parent->color = Color::Black;
-          grandparent->color = Color::Red;
-          LeftRotate(grandparent);
-        }
+    return std::make_pair(staged.key, staged.value);
+  }
+}
+
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+Node<Key, Value, Augment>
+    *RBTree<Key, Value, NodeAlloc, Augment, Compare>::GetRoot() const {
+  return Header()->left;
+}
+
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+Node<Key, Value, Augment>
+    *RBTree<Key, Value, NodeAlloc, Augment, Compare>::Begin() const {
+  return leftmost_;
+}
+
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+Node<Key, Value, Augment>
+    *RBTree<Key, Value, NodeAlloc, Augment, Compare>::End() const {
+  return Header();
+}
+
+// The header is only ever used through its links, in storage sized for a
+// node. Allocators that move their nodes keep it next to them once they hold
+// any storage; until then an empty tree keeps it in header_ as well.
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+Node<Key, Value, Augment>
+    *RBTree<Key, Value, NodeAlloc, Augment, Compare>::Header() const {
+  if constexpr (node_allocator::kOwnsHeader) {
+    if (Node<Key, Value, Augment> *header = alloc_.Header()) {
+      return header;
+    }
+  }
+  return reinterpret_cast<Node<Key, Value, Augment> *>(
+      const_cast<unsigned char *>(header_.storage));
+}
+
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+void RBTree<Key, Value, NodeAlloc, Augment, Compare>::swap(
+    RBTree &other) noexcept {
+  // Headers kept by the allocators move with them
+  if constexpr (!node_allocator::kOwnsHeader) {
+    std::swap(Header()->left, other.Header()->left);
+    std::swap(Header()->right, other.Header()->right);
+  }
+  std::swap(leftmost_, other.leftmost_);
+  alloc_.swap(other.alloc_);
+  std::swap(compare_, other.compare_);
+  AdoptRoot();
+  other.AdoptRoot();
+}
+
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+Node<Key, Value, Augment>
+    *RBTree<Key, Value, NodeAlloc, Augment, Compare>::Find(
+        Node<Key, Value, Augment> *node, const Key &key) const {
+  node = LowerBound(node, nullptr, key);
+  if (node == nullptr || compare_(key, node->key)) {
+    throw std::out_of_range("Key not found");
+  }
+  return node;
+}
+
+// Lookup for the containers: the first node holding key, End() on a miss.
+// One comparison per level and no exception, misses cost as much as hits.
+// A splay tree moves the node it finds to the root.
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+template <class K>
+Node<Key, Value, Augment> *
+RBTree<Key, Value, NodeAlloc, Augment, Compare>::FindKey(const K &key) const {
+  Node<Key, Value, Augment> *node = LowerBound(key);
+  if (node == End() || compare_(key, node->key)) {
+    return End();
+  }
+  Balance::template Accessed<Augment>(node);
+  return node;
+}
+
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+void RBTree<Key, Value, NodeAlloc, Augment, Compare>::Insert(
+    const Key &key, const Value &value) {
+  InsertEqual(key, value);
+}
+
+// Descends with one comparison per level to where key would be linked and
+// sets parent and left for LinkNode. The only node that can hold key then is
+// the in-order predecessor of that slot; it is returned if it does, nullptr
+// otherwise.
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+template <class K>
+Node<Key, Value, Augment>
+    *RBTree<Key, Value, NodeAlloc, Augment, Compare>::FindUniqueSlot(
+        const K &key, Node<Key, Value, Augment> *&parent, bool &left) const {
+  FindEqualSlot(key, parent, left);
+  Node<Key, Value, Augment> *prev = parent;
+  if (left) {
+    if (parent == leftmost_) {
+      return nullptr;
+    }
+    prev = Prev(parent);
+  }
+  return prev != nullptr && !compare_(prev->key, key) ? prev : nullptr;
+}
+
+// One descent: returns the node holding key, or links a new node built from
+// key and args at the position where the search ended. A key of another type
+// is converted first, so the search compares what the node will hold.
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+template <class K, class... Args>
+std::pair<Node<Key, Value, Augment> *, bool>
+RBTree<Key, Value, NodeAlloc, Augment, Compare>::InsertUnique(K &&key,
+                                                              Args &&...args) {
+  if constexpr (!std::is_same_v<std::decay_t<K>, Key>) {
+    return InsertUnique(Key(std::forward<K>(key)), std::forward<Args>(args)...);
+  } else {
+    if constexpr (!node_allocator::kStableNodes) {
+      if (!alloc_.HasRoom(1)) {
+        std::pair<Key, Value> staged =
+            Stage(std::forward<K>(key), std::forward<Args>(args)...);
+        MakeRoom(1, nullptr);
+        return InsertUnique(std::move(staged.first), std::move(staged.second));
       }
     }
-    root_->color = Color::Black;
+    MakeRoom(1, nullptr);
+    Node<Key, Value, Augment> *parent;
+    bool left;
+    Node<Key, Value, Augment> *node = FindUniqueSlot(key, parent, left);
+    if (node != nullptr) {
+      return std::make_pair(node, false);
+    }
+    node = CreateNode(std::forward<K>(key), std::forward<Args>(args)...);
+    LinkNode(node, parent, left);
+    return std::make_pair(node, true);
   }
 }
 
-template <class Key, class Value>
-void RBTree<Key, Value>::SetNewNode(Node<Key, Value> *newNode,
-                                    Node<Key, Value> *parent) {
-  if (newNode->key < parent->key) {
-    if (parent->left == nullptr) {
-      // Set newNode as left child of parent
-      parent->left = newNode;
-      newNode->parent = parent;
-    } else {
-      // Recursively call SetNewNode with the left child of parent
-      SetNewNode(newNode, parent->left);
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+template <class... Args>
+std::pair<Node<Key, Value, Augment> *, bool>
+RBTree<Key, Value, NodeAlloc, Augment, Compare>::EmplaceUnique(Args &&...args) {
+  if constexpr (!node_allocator::kStableNodes) {
+    if (!alloc_.HasRoom(1)) {
+      std::pair<Key, Value> staged = Stage(std::forward<Args>(args)...);
+      MakeRoom(1, nullptr);
+      return EmplaceUnique(std::move(staged.first), std::move(staged.second));
     }
+  }
+  MakeRoom(1, nullptr);
+  Node<Key, Value, Augment> *node = CreateNode(std::forward<Args>(args)...);
+  Node<Key, Value, Augment> *parent;
+  bool left;
+  Node<Key, Value, Augment> *here = FindUniqueSlot(node->key, parent, left);
+  if (here != nullptr) {
+    DestroyNode(node);
+    return std::make_pair(here, false);
+  }
+  LinkNode(node, parent, left);
+  return std::make_pair(node, true);
+}
+
+// finger may move with the other nodes while room is made for the new one
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+template <class K, class... Args>
+std::pair<Node<Key, Value, Augment> *, bool>
+RBTree<Key, Value, NodeAlloc, Augment, Compare>::InsertUniqueFrom(
+    Node<Key, Value, Augment> *finger, K &&key, Args &&...args) {
+  if constexpr (!std::is_same_v<std::decay_t<K>, Key>) {
+    return InsertUniqueFrom(finger, Key(std::forward<K>(key)),
+                            std::forward<Args>(args)...);
   } else {
-    if (parent->right == nullptr) {
-      parent->right = newNode;
-      newNode->parent = parent;
-    } else {
-      SetNewNode(newNode, parent->right);
+    if constexpr (!node_allocator::kStableNodes) {
+      if (!alloc_.HasRoom(1)) {
+        std::pair<Key, Value> staged =
+            Stage(std::forward<K>(key), std::forward<Args>(args)...);
+        finger = MakeRoom(1, finger);
+        return InsertUniqueFrom(finger, std::move(staged.first),
+                                std::move(staged.second));
+      }
+    }
+    finger = MakeRoom(1, finger);
+    Node<Key, Value, Augment> *bound = LowerBoundFrom(finger, key);
+    if (bound != End() && !compare_(key, bound->key)) {
+      return std::make_pair(bound, false);
+    }
+    return InsertUniqueHint(bound, std::forward<K>(key),
+                            std::forward<Args>(args)...);
+  }
+}
+
+// Equal keys go to the right, so duplicates keep their insertion order
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+template <class K, class... Args>
+Node<Key, Value, Augment> *
+RBTree<Key, Value, NodeAlloc, Augment, Compare>::InsertEqual(K &&key,
+                                                             Args &&...args) {
+  if constexpr (!std::is_same_v<std::decay_t<K>, Key>) {
+    return InsertEqual(Key(std::forward<K>(key)), std::forward<Args>(args)...);
+  } else {
+    if constexpr (!node_allocator::kStableNodes) {
+      if (!alloc_.HasRoom(1)) {
+        std::pair<Key, Value> staged =
+            Stage(std::forward<K>(key), std::forward<Args>(args)...);
+        MakeRoom(1, nullptr);
+        return InsertEqual(std::move(staged.first), std::move(staged.second));
+      }
+    }
+    MakeRoom(1, nullptr);
+    Node<Key, Value, Augment> *parent;
+    bool left;
+    FindEqualSlot(key, parent, left);
+    Node<Key, Value, Augment> *node =
+        CreateNode(std::forward<K>(key), std::forward<Args>(args)...);
+    LinkNode(node, parent, left);
+    return node;
+  }
+}
+
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+template <class... Args>
+Node<Key, Value, Augment> *
+RBTree<Key, Value, NodeAlloc, Augment, Compare>::EmplaceEqual(Args &&...args) {
+  if constexpr (!node_allocator::kStableNodes) {
+    if (!alloc_.HasRoom(1)) {
+      std::pair<Key, Value> staged = Stage(std::forward<Args>(args)...);
+      MakeRoom(1, nullptr);
+      return EmplaceEqual(std::move(staged.first), std::move(staged.second));
+    }
+  }
+  MakeRoom(1, nullptr);
+  Node<Key, Value, Augment> *node = CreateNode(std::forward<Args>(args)...);
+  Node<Key, Value, Augment> *parent;
+  bool left;
+  FindEqualSlot(node->key, parent, left);
+  LinkNode(node, parent, left);
+  return node;
+}
+
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+template <class K, class... Args>
+std::pair<Node<Key, Value, Augment> *, bool>
+RBTree<Key, Value, NodeAlloc, Augment, Compare>::InsertUniqueHint(
+    Node<Key, Value, Augment> *hint, K &&key, Args &&...args) {
+  if constexpr (!std::is_same_v<std::decay_t<K>, Key>) {
+    return InsertUniqueHint(hint, Key(std::forward<K>(key)),
+                            std::forward<Args>(args)...);
+  } else {
+    if constexpr (!node_allocator::kStableNodes) {
+      if (!alloc_.HasRoom(1)) {
+        std::pair<Key, Value> staged =
+            Stage(std::forward<K>(key), std::forward<Args>(args)...);
+        hint = MakeRoom(1, hint);
+        return InsertUniqueHint(hint, std::move(staged.first),
+                                std::move(staged.second));
+      }
+    }
+    hint = MakeRoom(1, hint);
+    Node<Key, Value, Augment> *parent;
+    bool left;
+    Node<Key, Value, Augment> *node =
+        FindUniqueSlotNear(hint, key, parent, left);
+    if (node != nullptr) {
+      return std::make_pair(node, false);
+    }
+    node = CreateNode(std::forward<K>(key), std::forward<Args>(args)...);
+    LinkNode(node, parent, left);
+    return std::make_pair(node, true);
+  }
+}
+
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+template <class... Args>
+std::pair<Node<Key, Value, Augment> *, bool>
+RBTree<Key, Value, NodeAlloc, Augment, Compare>::EmplaceUniqueHint(
+    Node<Key, Value, Augment> *hint, Args &&...args) {
+  if constexpr (!node_allocator::kStableNodes) {
+    if (!alloc_.HasRoom(1)) {
+      std::pair<Key, Value> staged = Stage(std::forward<Args>(args)...);
+      hint = MakeRoom(1, hint);
+      return EmplaceUniqueHint(hint, std::move(staged.first),
+                               std::move(staged.second));
+    }
+  }
+  hint = MakeRoom(1, hint);
+  Node<Key, Value, Augment> *node = CreateNode(std::forward<Args>(args)...);
+  Node<Key, Value, Augment> *parent;
+  bool left;
+  Node<Key, Value, Augment> *here =
+      FindUniqueSlotNear(hint, node->key, parent, left);
+  if (here != nullptr) {
+    DestroyNode(node);
+    return std::make_pair(here, false);
+  }
+  LinkNode(node, parent, left);
+  return std::make_pair(node, true);
+}
+
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+template <class K, class... Args>
+Node<Key, Value, Augment>
+    *RBTree<Key, Value, NodeAlloc, Augment, Compare>::InsertEqualHint(
+        Node<Key, Value, Augment> *hint, K &&key, Args &&...args) {
+  if constexpr (!std::is_same_v<std::decay_t<K>, Key>) {
+    return InsertEqualHint(hint, Key(std::forward<K>(key)),
+                           std::forward<Args>(args)...);
+  } else {
+    if constexpr (!node_allocator::kStableNodes) {
+      if (!alloc_.HasRoom(1)) {
+        std::pair<Key, Value> staged =
+            Stage(std::forward<K>(key), std::forward<Args>(args)...);
+        hint = MakeRoom(1, hint);
+        return InsertEqualHint(hint, std::move(staged.first),
+                               std::move(staged.second));
+      }
+    }
+    hint = MakeRoom(1, hint);
+    Node<Key, Value, Augment> *parent;
+    bool left;
+    FindEqualSlotNear(hint, key, parent, left);
+    Node<Key, Value, Augment> *node =
+        CreateNode(std::forward<K>(key), std::forward<Args>(args)...);
+    LinkNode(node, parent, left);
+    return node;
+  }
+}
+
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+template <class... Args>
+Node<Key, Value, Augment>
+    *RBTree<Key, Value, NodeAlloc, Augment, Compare>::EmplaceEqualHint(
+        Node<Key, Value, Augment> *hint, Args &&...args) {
+  if constexpr (!node_allocator::kStableNodes) {
+    if (!alloc_.HasRoom(1)) {
+      std::pair<Key, Value> staged = Stage(std::forward<Args>(args)...);
+      hint = MakeRoom(1, hint);
+      return EmplaceEqualHint(hint, std::move(staged.first),
+                              std::move(staged.second));
+    }
+  }
+  hint = MakeRoom(1, hint);
+  Node<Key, Value, Augment> *node = CreateNode(std::forward<Args>(args)...);
+  Node<Key, Value, Augment> *parent;
+  bool left;
+  FindEqualSlotNear(hint, node->key, parent, left);
+  LinkNode(node, parent, left);
+  return node;
+}
+
+// Hinted search: hint is the node the key should go right before (the header
+// or nullptr stand for end()). When the hint is right only the hint and its
+// neighbour are compared, otherwise it falls back to a full descent.
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+template <class K>
+Node<Key, Value, Augment>
+    *RBTree<Key, Value, NodeAlloc, Augment, Compare>::FindUniqueSlotNear(
+        Node<Key, Value, Augment> *hint, const K &key,
+        Node<Key, Value, Augment> *&parent, bool &left) const {
+  if (hint == nullptr || hint->IsHeader()) {
+    // The header's right link is the header itself when the tree is empty
+    Node<Key, Value, Augment> *max = Header()->right;
+    if (!max->IsHeader() && compare_(max->key, key)) {
+      parent = max;
+      left = false;
+      return nullptr;
+    }
+  } else if (compare_(key, hint->key)) {
+    Node<Key, Value, Augment> *prev = hint == leftmost_ ? Header() : Prev(hint);
+    if (prev->IsHeader() || compare_(prev->key, key)) {
+      // The new node goes between prev and hint, one of them has a free slot
+      left = hint->left == nullptr;
+      parent = left ? hint : prev;
+      return nullptr;
+    }
+  } else if (compare_(hint->key, key)) {
+    Node<Key, Value, Augment> *next = Next(hint);
+    if (next->IsHeader() || compare_(key, next->key)) {
+      left = hint->right != nullptr;
+      parent = left ? next : hint;
+      return nullptr;
     }
+  } else {
+    return hint;
+  }
+  return FindUniqueSlot(key, parent, left);
+}
+
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+template <class K>
+void RBTree<Key, Value, NodeAlloc, Augment, Compare>::FindEqualSlot(
+    const K &key, Node<Key, Value, Augment> *&parent, bool &left) const {
+  parent = nullptr;
+  left = false;
+  for (Node<Key, Value, Augment> *node = Header()->left; node != nullptr;
+       node = left ? node->left : node->right) {
+    parent = node;
+    left = compare_(key, node->key);
   }
 }
 
-template <class Key, class Value>
-bool RBTree<Key, Value>::Contains(const Key &key) const {
-  Node<Key, Value> *node = root_;
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+template <class K>
+void RBTree<Key, Value, NodeAlloc, Augment, Compare>::FindEqualSlotNear(
+    Node<Key, Value, Augment> *hint, const K &key,
+    Node<Key, Value, Augment> *&parent, bool &left) const {
+  if (hint == nullptr || hint->IsHeader()) {
+    Node<Key, Value, Augment> *max = Header()->right;
+    if (!max->IsHeader() && !compare_(key, max->key)) {
+      parent = max;
+      left = false;
+      return;
+    }
+  } else if (!compare_(hint->key, key)) {
+    Node<Key, Value, Augment> *prev = hint == leftmost_ ? Header() : Prev(hint);
+    if (prev->IsHeader() || !compare_(key, prev->key)) {
+      left = hint->left == nullptr;
+      parent = left ? hint : prev;
+      return;
+    }
+  } else {
+    Node<Key, Value, Augment> *next = Next(hint);
+    if (next->IsHeader() || !compare_(next->key, key)) {
+      left = hint->right != nullptr;
+      parent = left ? next : hint;
+      return;
+    }
+  }
+  FindEqualSlot(key, parent, left);
+}
+
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+void RBTree<Key, Value, NodeAlloc, Augment, Compare>::LinkNode(
+    Node<Key, Value, Augment> *newNode, Node<Key, Value, Augment> *parentNode,
+    bool left) {
+  // An empty tree gets the new node as its root
+  if (parentNode == nullptr) {
+    Header()->left = newNode;
+    Header()->right = newNode;
+    leftmost_ = newNode;
+    newNode->SetParent(Header());
+    Thread(Header(), newNode);
+    Thread(newNode, Header());
+  } else if (left) {
+    parentNode->left = newNode;
+    if (parentNode == leftmost_) {
+      leftmost_ = newNode;
+    }
+    newNode->SetParent(parentNode);
+    if constexpr (Augment::kThreaded) {
+      Thread(parentNode->prev, newNode);
+      Thread(newNode, parentNode);
+    }
+  } else {
+    parentNode->right = newNode;
+    if (parentNode == Header()->right) {
+      Header()->right = newNode;
+    }
+    newNode->SetParent(parentNode);
+    if constexpr (Augment::kThreaded) {
+      Thread(newNode, parentNode->next);
+      Thread(parentNode, newNode);
+    }
+  }
+  // The aggregate of a fresh or relinked leaf is its own value
+  if constexpr (Augment::kAggregate) {
+    Augment::Update(newNode);
+  }
+  Balance::template Linked<Augment>(newNode);
+}
+
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+template <class K>
+bool RBTree<Key, Value, NodeAlloc, Augment, Compare>::Contains(
+    const K &key) const {
+  return FindKey(key) != End();
+}
+
+// First node whose key is not less than key, End() if there is none
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+template <class K>
+Node<Key, Value, Augment> *RBTree<Key, Value, NodeAlloc, Augment,
+                                  Compare>::LowerBound(const K &key) const {
+  return LowerBound(Header()->left, Header(), key);
+}
+
+// First node whose key is greater than key, End() if there is none
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+template <class K>
+Node<Key, Value, Augment> *RBTree<Key, Value, NodeAlloc, Augment,
+                                  Compare>::UpperBound(const K &key) const {
+  return UpperBound(Header()->left, Header(), key);
+}
+
+// Finger search: the lower bound of key, searched from finger (a node of
+// this tree) instead of from the root. It climbs from finger to the lowest
+// ancestor whose subtree spans key and descends from there, comparing only
+// at the ancestors that bound that range. For most pairs that costs
+// O(log d) for a key d elements away; two neighbours split high up in the
+// tree cost a plain search. The header or nullptr start a plain search.
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+template <class K>
+Node<Key, Value, Augment>
+    *RBTree<Key, Value, NodeAlloc, Augment, Compare>::LowerBoundFrom(
+        Node<Key, Value, Augment> *finger, const K &key) const {
+  if (finger == nullptr || finger->IsHeader()) {
+    return LowerBound(key);
+  }
+  Node<Key, Value, Augment> *node = finger;
+  Node<Key, Value, Augment> *bound = Header();
+  if (compare_(finger->key, key)) {
+    // Ancestors left behind on the right are less than finger; the first
+    // one on the left not less than key caps the range
+    for (Node<Key, Value, Augment> *parent = node->GetParent();
+         !parent->IsHeader(); node = parent, parent = node->GetParent()) {
+      if (node == parent->left && !compare_(parent->key, key)) {
+        bound = parent;
+        break;
+      }
+    }
+  } else {
+    // finger itself is not less than key, so the subtree holding finger and
+    // the first ancestor less than key holds the answer
+    for (Node<Key, Value, Augment> *parent = node->GetParent();
+         !parent->IsHeader(); node = parent, parent = node->GetParent()) {
+      if (node == parent->right && compare_(parent->key, key)) {
+        break;
+      }
+    }
+  }
+  return LowerBound(node, bound, key);
+}
+
+// Both bounds with a shared descent down to the first node equal to key
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+template <class K>
+std::pair<Node<Key, Value, Augment> *, Node<Key, Value, Augment> *>
+RBTree<Key, Value, NodeAlloc, Augment, Compare>::EqualRange(
+    const K &key) const {
+  Node<Key, Value, Augment> *node = Header()->left;
+  Node<Key, Value, Augment> *bound = Header();
   while (node != nullptr) {
-    if (key == node->key) {
-      return true;
-    } else if (key < node->key) {
+    if (compare_(node->key, key)) {
+      node = node->right;
+    } else if (compare_(key, node->key)) {
+      bound = node;
       node = node->left;
     } else {
+      return std::make_pair(LowerBound(node->left, node, key),
+                            UpperBound(node->right, bound, key));
+    }
+  }
+  return std::make_pair(bound, bound);
+}
+
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+template <class K>
+Node<Key, Value, Augment>
+    *RBTree<Key, Value, NodeAlloc, Augment, Compare>::LowerBound(
+        Node<Key, Value, Augment> *node, Node<Key, Value, Augment> *bound,
+        const K &key) const {
+  while (node != nullptr) {
+    if (compare_(node->key, key)) {
       node = node->right;
+    } else {
+      bound = node;
+      node = node->left;
     }
   }
-  return false;
+  return bound;
 }
 
-template <class Key, class Value>
-void RBTree<Key, Value>::LeftRotate(Node<Key, Value> *node) {
-  Node<Key, Value> *rightChild = node->right;
-  // Promote right child to be the parent of the node
-  rightChild->parent = node->parent;
-  if (node->parent == nullptr) {
-    root_ = rightChild;
-  } else if (node == node->parent->left) {
-    node->parent->left = rightChild;
-  } else {
-    node->parent->right = rightChild;
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+template <class K>
+Node<Key, Value, Augment>
+    *RBTree<Key, Value, NodeAlloc, Augment, Compare>::UpperBound(
+        Node<Key, Value, Augment> *node, Node<Key, Value, Augment> *bound,
+        const K &key) const {
+  while (node != nullptr) {
+    if (compare_(key, node->key)) {
+      bound = node;
+      node = node->left;
+    } else {
+      node = node->right;
+    }
   }
-  // Shift nodes around
-  node->right = rightChild->left;
-  if (rightChild->left != nullptr) {
-    rightChild->left->parent = node;
+  return bound;
+}
+
+// Number of nodes with a key less than key, needs the OrderStatistic policy
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+template <class K>
+std::size_t RBTree<Key, Value, NodeAlloc, Augment, Compare>::Rank(
+    const K &key) const {
+  static_assert(Augment::kSubtreeSize,
+                "Rank needs the OrderStatistic node policy");
+  std::size_t rank = 0;
+  Node<Key, Value, Augment> *node = Header()->left;
+  while (node != nullptr) {
+    if (compare_(node->key, key)) {
+      rank += Augment::Size(node->left) + 1;
+      node = node->right;
+    } else {
+      node = node->left;
+    }
   }
-  rightChild->left = node;
-  node->parent = rightChild;
+  return rank;
 }
 
-template <class Key, class Value>
-void RBTree<Key, Value>::RightRotate(Node<Key, Value> *node) {
-  Node<Key, Value> *leftChild = node->left;
-  leftChild->parent = node->parent;
-  if (node->parent == nullptr) {
-    root_ = leftChild;
-  } else if (node == node->parent->left) {
-    node->parent->left = leftChild;
-  } else {
-    node->parent->right = leftChild;
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+template <class K, class Fn>
+void RBTree<Key, Value, NodeAlloc, Augment, Compare>::ForEachInRange(
+    const K &lo, const K &hi, Fn &&fn) const {
+  if (!compare_(lo, hi)) {
+    return;
   }
-  node->left = leftChild->right;
-  if (leftChild->right != nullptr) {
-    leftChild->right->parent = node;
+  for (Node<Key, Value, Augment> *node = LowerBound(lo);
+       node != Header() && compare_(node->key, hi); node = Next(node)) {
+    fn(*node);
   }
-  leftChild->right = node;
-  node->parent = leftChild;
 }
 
-template <class Key, class Value>
-void RBTree<Key, Value>::Erase(Node<Key, Value> *node) {
-  // Case 1: Node has no children
-  if (node->left == nullptr && node->right == nullptr) {
-    if (node == root_) {
-      root_ = nullptr;
+// Descends to the highest node inside the range; from there the left and
+// the right boundary paths add up the subtrees that lie wholly inside, in
+// key order. O(log n).
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+template <class K>
+auto RBTree<Key, Value, NodeAlloc, Augment, Compare>::AggregateRange(
+    const K &lo, const K &hi) const {
+  static_assert(Augment::kAggregate,
+                "AggregateRange needs a SubtreeAggregate node policy");
+  using Monoid = typename Augment::monoid_type;
+  if (!compare_(lo, hi)) {
+    return Monoid::Identity();
+  }
+  Node<Key, Value, Augment> *split = Header()->left;
+  while (split != nullptr &&
+         (compare_(split->key, lo) || !compare_(split->key, hi))) {
+    split = compare_(split->key, lo) ? split->right : split->left;
+  }
+  if (split == nullptr) {
+    return Monoid::Identity();
+  }
+  typename Monoid::type left = Monoid::Identity();
+  for (Node<Key, Value, Augment> *node = split->left; node != nullptr;) {
+    if (compare_(node->key, lo)) {
+      node = node->right;
+    } else {
+      left = Monoid::Combine(
+          Monoid::Combine(
+              Monoid::Lift(*node),
+              Augment::template Aggregate<Node<Key, Value, Augment>>(
+                  node->right)),
+          left);
+      node = node->left;
+    }
+  }
+  typename Monoid::type right = Monoid::Identity();
+  for (Node<Key, Value, Augment> *node = split->right; node != nullptr;) {
+    if (compare_(node->key, hi)) {
+      right = Monoid::Combine(
+          right, Monoid::Combine(
+                     Augment::template Aggregate<Node<Key, Value, Augment>>(
+                         node->left),
+                     Monoid::Lift(*node)));
+      node = node->right;
     } else {
-      if (node->color == Color::Black) {
-        FixUpTree(node);
+      node = node->left;
+    }
+  }
+  return Monoid::Combine(Monoid::Combine(left, Monoid::Lift(*split)), right);
+}
+
+// Recomputes the aggregates on the path from node up to the root
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+void RBTree<Key, Value, NodeAlloc, Augment, Compare>::Refresh(
+    Node<Key, Value, Augment> *node) noexcept {
+  static_assert(Augment::kAggregate,
+                "Refresh needs a SubtreeAggregate node policy");
+  UpdatePath<Augment>(node);
+}
+
+// Group prefetching: the keys go in groups of kBatchWidth lower bound
+// descents that take one level each per round and prefetch the child they
+// visit next. A lone find waits for one miss per level; here the misses of
+// a whole group overlap.
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+template <class ForwardIt, class Emit>
+void RBTree<Key, Value, NodeAlloc, Augment, Compare>::FindBatch(
+    ForwardIt first, ForwardIt last, Emit &&emit) const {
+  using K = std::remove_reference_t<decltype(*first)>;
+  const K *keys[kBatchWidth];
+  Node<Key, Value, Augment> *nodes[kBatchWidth];
+  Node<Key, Value, Augment> *bounds[kBatchWidth];
+  Prefetch(Header()->left);
+  while (first != last) {
+    std::size_t count = 0;
+    for (; count < kBatchWidth && first != last; ++count, ++first) {
+      keys[count] = &*first;
+      nodes[count] = Header()->left;
+      bounds[count] = Header();
+    }
+    for (bool active = true; active;) {
+      active = false;
+      for (std::size_t i = 0; i < count; ++i) {
+        Node<Key, Value, Augment> *node = nodes[i];
+        if (node == nullptr) {
+          continue;
+        }
+        if (compare_(node->key, *keys[i])) {
+          node = node->right;
+        } else {
+          bounds[i] = node;
+          node = node->left;
+        }
+        if (node != nullptr) {
+          Prefetch(node);
+          active = true;
+        }
+        nodes[i] = node;
       }
-      if (node->parent->left == node) {
-        node->parent->left = nullptr;
-      } else {
-        node->parent->right = nullptr;
+    }
+    for (std::size_t i = 0; i < count; ++i) {
+      Node<Key, Value, Augment> *bound = bounds[i];
+      emit(bound != End() && !compare_(*keys[i], bound->key) ? bound : End());
+    }
+  }
+}
+
+// Node at position k in key order, End() if k is not less than the size
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+Node<Key, Value, Augment> *
+RBTree<Key, Value, NodeAlloc, Augment, Compare>::Select(std::size_t k) const {
+  static_assert(Augment::kSubtreeSize,
+                "Select needs the OrderStatistic node policy");
+  Node<Key, Value, Augment> *node = Augment::Select(Header()->left, k);
+  return node != nullptr ? node : Header();
+}
+
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+void RBTree<Key, Value, NodeAlloc, Augment, Compare>::Erase(
+    Node<Key, Value, Augment> *node) {
+  if (node->left != nullptr && node->right != nullptr) {
+    // Node has two children: it trades places with its predecessor, which
+    // has at most one child. No payload moves, so every other node keeps
+    // its key, value and iterators.
+    SwapWithPredecessor(node, FindMax(node->left));
+  }
+  DestroyNode(Detach(node));
+}
+
+// The first nodes are erased one by one. Once a range turns out longer, the
+// rest is cut out with two splits at its ends, dropped as one subtree and
+// the remaining parts joined back: O(log n + k) either way, without a
+// rebalancing per node for long ranges. Balancing policies other than
+// red-black always erase node by node.
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+std::size_t RBTree<Key, Value, NodeAlloc, Augment, Compare>::EraseRange(
+    Node<Key, Value, Augment> *first, Node<Key, Value, Augment> *last) {
+  std::size_t count = 0;
+  for (; first != last; ++count) {
+    if constexpr (Balance::kJoinable) {
+      if (count == kRangeSplitMin) {
+        return count + CutRange(first, last);
       }
     }
-    delete node;
-    return;
+    Node<Key, Value, Augment> *next = Next(first);
+    Erase(first);
+    first = next;
+  }
+  return count;
+}
+
+// As EraseRange; only a long range pays for the descent to its end
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+template <class K>
+std::size_t RBTree<Key, Value, NodeAlloc, Augment, Compare>::EraseKeyRange(
+    const K &lo, const K &hi) {
+  if (!compare_(lo, hi)) {
+    return 0;
+  }
+  std::size_t count = 0;
+  Node<Key, Value, Augment> *node = LowerBound(lo);
+  for (; node != Header() && compare_(node->key, hi); ++count) {
+    if constexpr (Balance::kJoinable) {
+      if (count == kRangeSplitMin) {
+        return count + CutRange(node, LowerBound(hi));
+      }
+    }
+    Node<Key, Value, Augment> *next = Next(node);
+    Erase(node);
+    node = next;
+  }
+  return count;
+}
+
+// Splits the tree around first and around last, drops first and the part
+// between them and joins the rest back with last as the pivot
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+std::size_t RBTree<Key, Value, NodeAlloc, Augment, Compare>::CutRange(
+    Node<Key, Value, Augment> *first, Node<Key, Value, Augment> *last) {
+  if constexpr (Augment::kThreaded) {
+    Thread(first->prev, last);
+  }
+  bool left_turns[kMaxDepth];
+  Subtree less, rest, range, greater;
+  Subtree whole = ReleaseRoot();
+  TurnsTo(whole.root, first, left_turns);
+  SplitAround(whole, left_turns, first, less, rest);
+  DestroyNode(first);
+  if (last->IsHeader()) {
+    Install(less);
+    return DropSubtree(rest.root) + 1;
+  }
+  TurnsTo(rest.root, last, left_turns);
+  SplitAround(rest, left_turns, last, range, greater);
+  Install(JoinSubtrees(less, last, greater));
+  return DropSubtree(range.root) + 1;
+}
+
+// Unlinks a node with at most one child and rebalances. The node itself is
+// left to the caller, its links are stale.
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+Node<Key, Value, Augment>
+    *RBTree<Key, Value, NodeAlloc, Augment, Compare>::Detach(
+        Node<Key, Value, Augment> *node) {
+  if (node == leftmost_) {
+    leftmost_ = Next(node);
+  }
+  if (node == Header()->right) {
+    Header()->right = Prev(node);
   }
+  if constexpr (Augment::kThreaded) {
+    Thread(node->prev, node->next);
+  }
+  Balance::template Unlinking<Augment>(node);
+  // The header's left link is the root, so the root needs no special case
+  Node<Key, Value, Augment> *child = node->left ? node->left : node->right;
+  Node<Key, Value, Augment> *parent = node->GetParent();
+  if (parent->left == node) {
+    parent->left = child;
+  } else {
+    parent->right = child;
+  }
+  if (child != nullptr) {
+    child->SetParent(parent);
+  }
+  Balance::template Unlinked<Augment>(node, parent, child);
+  return node;
+}
+
+// Takes node out of the tree without touching its key and value: a node with
+// two children first trades places with its predecessor
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+typename RBTree<Key, Value, NodeAlloc, Augment, Compare>::node_type
+RBTree<Key, Value, NodeAlloc, Augment, Compare>::Extract(
+    Node<Key, Value, Augment> *node) {
+  static_assert(node_allocator::kPortableNodes,
+                "Nodes of this allocator cannot leave their tree");
+  if (node->left != nullptr && node->right != nullptr) {
+    SwapWithPredecessor(node, FindMax(node->left));
+  }
+  return node_type(Detach(node));
+}
 
-  // Case 2: Node has one child
-  if (node->left == nullptr || node->right == nullptr) {
-    Node<Key, Value> *child = node->left ? node->left : node->right;
-    if (node == root_) {
-      root_ = child;
-      root_->parent = nullptr;
-      root_->color = Color::Black;
+// Exchanges the places of node, which has two children, and its in-order
+// predecessor pred. Links and balance data move, keys and values stay.
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+void RBTree<Key, Value, NodeAlloc, Augment, Compare>::SwapWithPredecessor(
+    Node<Key, Value, Augment> *node, Node<Key, Value, Augment> *pred) {
+  Node<Key, Value, Augment> *parent = node->GetParent();
+  Node<Key, Value, Augment> *left = node->left;
+  Node<Key, Value, Augment> *right = node->right;
+  Node<Key, Value, Augment> *pred_parent = pred->GetParent();
+  Node<Key, Value, Augment> *pred_left = pred->left;
+  Balance::SwapTags(node, pred);
+  // The header's left link is the root, so the root needs no special case
+  if (parent->left == node) {
+    parent->left = pred;
+  } else {
+    parent->right = pred;
+  }
+  pred->SetParent(parent);
+  pred->right = right;
+  right->SetParent(pred);
+  if (pred == left) {
+    pred->left = node;
+    node->SetParent(pred);
+  } else {
+    pred->left = left;
+    left->SetParent(pred);
+    pred_parent->right = node;
+    node->SetParent(pred_parent);
+  }
+  node->left = pred_left;
+  if (pred_left != nullptr) {
+    pred_left->SetParent(node);
+  }
+  node->right = nullptr;
+}
+
+// Puts node, which is not in any tree, in the place of old_node
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+void RBTree<Key, Value, NodeAlloc, Augment, Compare>::Transplant(
+    Node<Key, Value, Augment> *old_node, Node<Key, Value, Augment> *node) {
+  Node<Key, Value, Augment> *parent = old_node->GetParent();
+  if (parent->left == old_node) {
+    parent->left = node;
+  } else {
+    parent->right = node;
+  }
+  node->SetParent(parent);
+  Balance::CopyTag(node, old_node);
+  if constexpr (Augment::kThreaded) {
+    Thread(old_node->prev, node);
+    Thread(node, old_node->next);
+  }
+  node->left = old_node->left;
+  node->right = old_node->right;
+  if (node->left != nullptr) {
+    node->left->SetParent(node);
+  }
+  if (node->right != nullptr) {
+    node->right->SetParent(node);
+  }
+  if (leftmost_ == old_node) {
+    leftmost_ = node;
+  }
+  if (Header()->right == old_node) {
+    Header()->right = node;
+  }
+  if constexpr (Augment::kAggregate) {
+    UpdatePath<Augment>(node);
+  } else {
+    Augment::Update(node);
+  }
+}
+
+// Links an extracted node; an empty handle or a key that is already here
+// leaves the handle as it is
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+std::pair<Node<Key, Value, Augment> *, bool>
+RBTree<Key, Value, NodeAlloc, Augment, Compare>::InsertNodeUnique(
+    node_type &handle) {
+  static_assert(node_allocator::kPortableNodes,
+                "Nodes of this allocator cannot enter another tree");
+  if (handle.empty()) {
+    return std::make_pair(End(), false);
+  }
+  ResetLinks(handle.node_);
+  auto result = LinkUnique(handle.node_);
+  if (result.second) {
+    handle.Release();
+  }
+  return result;
+}
+
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+Node<Key, Value, Augment> *RBTree<Key, Value, NodeAlloc, Augment,
+                                  Compare>::InsertNodeEqual(node_type &handle) {
+  static_assert(node_allocator::kPortableNodes,
+                "Nodes of this allocator cannot enter another tree");
+  if (handle.empty()) {
+    return End();
+  }
+  Node<Key, Value, Augment> *node = handle.Release();
+  ResetLinks(node);
+  LinkEqual(node);
+  return node;
+}
+
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+void RBTree<Key, Value, NodeAlloc, Augment, Compare>::ResetLinks(
+    Node<Key, Value, Augment> *node) noexcept {
+  node->left = nullptr;
+  node->right = nullptr;
+  node->SetColor(Color::Red);
+  Augment::Update(node);
+}
+
+// Links a detached node at the end of its search path, unless a node with
+// the same key is already there; that node is returned then
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+std::pair<Node<Key, Value, Augment> *, bool>
+RBTree<Key, Value, NodeAlloc, Augment, Compare>::LinkUnique(
+    Node<Key, Value, Augment> *node) {
+  Node<Key, Value, Augment> *parent;
+  bool left;
+  Node<Key, Value, Augment> *current = FindUniqueSlot(node->key, parent, left);
+  if (current != nullptr) {
+    return std::make_pair(current, false);
+  }
+  LinkNode(node, parent, left);
+  return std::make_pair(node, true);
+}
+
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+void RBTree<Key, Value, NodeAlloc, Augment, Compare>::LinkEqual(
+    Node<Key, Value, Augment> *node) {
+  Node<Key, Value, Augment> *parent;
+  bool left;
+  FindEqualSlot(node->key, parent, left);
+  LinkNode(node, parent, left);
+}
+
+// Moves every node out of the tree, in key order, and leaves it empty
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+void RBTree<Key, Value, NodeAlloc, Augment, Compare>::TakeNodes(
+    s21::vector<Node<Key, Value, Augment> *> &nodes) {
+  for (Node<Key, Value, Augment> *node = Begin(); node != End();
+       node = Next(node)) {
+    nodes.push_back(node);
+  }
+  ResetHeader();
+}
+
+// Moves all elements of other into this tree and leaves other empty; returns
+// how many elements this tree gained. size and other_size are the element
+// counts of both trees. Nodes are relinked when the allocator lets them
+// travel, otherwise the elements are copied. A small other is inserted one
+// by one, a large one is merged with this tree in key order and the result
+// is linked into a balanced tree in O(n + m).
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+std::size_t RBTree<Key, Value, NodeAlloc, Augment, Compare>::Merge(
+    RBTree &other, MergeEqual on_equal, std::size_t size,
+    std::size_t other_size) {
+  if (this == &other || other.Header()->left == nullptr) {
+    return 0;
+  }
+  // Other's elements come in key order, so their descents share most of
+  // their path and relinking every node only pays off for about a quarter of
+  // this tree. A copying rebuild also allocates the n nodes of this tree.
+  bool rebuild = node_allocator::kPortableNodes
+                     ? other_size * 4 >= size
+                     : other_size * std::log2(size + 1) >= size;
+  bool unique = on_equal != MergeEqual::KeepBoth;
+  if (rebuild) {
+    // For equal keys the node to keep goes first
+    bool theirs_first = on_equal == MergeEqual::TakeTheirs;
+    s21::vector<Node<Key, Value, Augment> *> merged;
+    std::size_t ours = 0;
+    Node<Key, Value, Augment> *lhs = Begin(), *rhs = other.Begin();
+    while (lhs != End() || rhs != other.End()) {
+      bool take_rhs =
+          lhs == End() ||
+          (rhs != other.End() && (theirs_first ? !compare_(lhs->key, rhs->key)
+                                               : compare_(rhs->key, lhs->key)));
+      if (take_rhs) {
+        merged.push_back(rhs);
+        rhs = Next(rhs);
+      } else {
+        merged.push_back(lhs);
+        lhs = Next(lhs);
+        ++ours;
+      }
+    }
+    if constexpr (node_allocator::kPortableNodes) {
+      ResetHeader();
+      other.ResetHeader();
+      Node<Key, Value, Augment> **nodes = merged.data();
+      std::size_t kept = 0;
+      for (std::size_t i = 0; i < merged.size(); ++i) {
+        if (unique && kept != 0 &&
+            !compare_(nodes[kept - 1]->key, nodes[i]->key)) {
+          DestroyNode(nodes[i]);
+        } else {
+          nodes[kept++] = nodes[i];
+        }
+      }
+      auto adopt = [](Node<Key, Value, Augment> *node) { return node; };
+      LinkSorted(nodes, kept, false, adopt);
+      return kept - ours;
     } else {
-      if (node->parent->left == node) {
-        node->parent->left = child;
+      RBTree tree(compare_);
+      std::size_t count =
+          tree.AssignSorted(merged.begin(), merged.end(), unique);
+      swap(tree);
+      other.Clear();
+      return count - ours;
+    }
+  }
+  std::size_t added = 0;
+  if constexpr (node_allocator::kPortableNodes) {
+    s21::vector<Node<Key, Value, Augment> *> theirs;
+    other.TakeNodes(theirs);
+    for (Node<Key, Value, Augment> *node : theirs) {
+      ResetLinks(node);
+      if (!unique) {
+        LinkEqual(node);
+        ++added;
+        continue;
+      }
+      auto [here, inserted] = LinkUnique(node);
+      if (inserted) {
+        ++added;
+      } else if (on_equal == MergeEqual::TakeTheirs) {
+        Transplant(here, node);
+        DestroyNode(here);
       } else {
-        node->parent->right = child;
+        DestroyNode(node);
       }
-      child->parent = node->parent;
-      if (node->color == Color::Black) {
-        if (child->color == Color::Red) {
-          child->color = Color::Black;
+    }
+  } else {
+    // Nodes cannot leave their allocator, the elements are copied over
+    for (Node<Key, Value, Augment> *node = other.Begin(); node != other.End();
+         node = Next(node)) {
+      if (!unique) {
+        InsertEqual(node->key, ItemValue(*node));
+        ++added;
+        continue;
+      }
+      auto [here, inserted] = InsertUnique(node->key, ItemValue(*node));
+      if (inserted) {
+        ++added;
+      } else if constexpr (!std::is_same_v<Value, NoValue>) {
+        if (on_equal == MergeEqual::TakeTheirs) {
+          here->value = node->value;
         }
       }
     }
-    delete node;
-    return;
+    other.Clear();
   }
-  // Case 3: Node has two children
-  Node<Key, Value> *predecessor = FindMax(node->left);
-  std::swap(node->key, predecessor->key);
-  std::swap(node->value, predecessor->value);
-  Erase(predecessor);
+  return added;
 }
 
-template <class Key, class Value>
-Node<Key, Value> *RBTree<Key, Value>::FindMax(Node<Key, Value> *node) const {
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+Node<Key, Value, Augment>
+    *RBTree<Key, Value, NodeAlloc, Augment, Compare>::FindMax(
+        Node<Key, Value, Augment> *node) const {
   while (node->right != nullptr) {
     node = node->right;
   }
   return node;
 }
 
-// Fixing double black violations in the tree
-template <class Key, class Value>
-void RBTree<Key, Value>::FixUpTree(Node<Key, Value> *node) {
-  while (node != root_ && node->color == Color::Black) {
-    if (node == node->parent->left) {
-      Node<Key, Value> *sibling = node->parent->right;
-      // Case 1: Sibling is red
-      if (sibling != nullptr && sibling->color == Color::Red) {
-        sibling->color = Color::Black;
-        node->parent->color = Color::Red;
-        LeftRotate(node->parent);
-        sibling = node->parent->right;
+// In-order successor, the header after the last node
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+Node<Key, Value, Augment>
+    *RBTree<Key, Value, NodeAlloc, Augment, Compare>::Next(
+        Node<Key, Value, Augment> *node) {
+  if constexpr (Augment::kThreaded) {
+    return node->next;
+  } else {
+    return Successor(node);
+  }
+}
+
+// Successor found through the child and parent links, for trees whose
+// threads are not set up yet
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+Node<Key, Value, Augment>
+    *RBTree<Key, Value, NodeAlloc, Augment, Compare>::Successor(
+        Node<Key, Value, Augment> *node) {
+  if (node->right != nullptr) {
+    node = node->right;
+    while (node->left != nullptr) {
+      node = node->left;
+    }
+    return node;
+  }
+  while (!node->GetParent()->IsHeader() && node == node->GetParent()->right) {
+    node = node->GetParent();
+  }
+  return node->GetParent();
+}
+
+// In-order predecessor, the header before the first node
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+Node<Key, Value, Augment>
+    *RBTree<Key, Value, NodeAlloc, Augment, Compare>::Prev(
+        Node<Key, Value, Augment> *node) {
+  if constexpr (Augment::kThreaded) {
+    return node->prev;
+  }
+  if (node->left != nullptr) {
+    node = node->left;
+    while (node->right != nullptr) {
+      node = node->right;
+    }
+    return node;
+  }
+  while (!node->GetParent()->IsHeader() && node == node->GetParent()->left) {
+    node = node->GetParent();
+  }
+  return node->GetParent();
+}
+
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+void RBTree<Key, Value, NodeAlloc, Augment, Compare>::Thread(
+    Node<Key, Value, Augment> *prev, Node<Key, Value, Augment> *next) noexcept {
+  if constexpr (Augment::kThreaded) {
+    prev->next = next;
+    next->prev = prev;
+  }
+}
+
+// Closes the thread list through the header after the first or the last
+// node changed wholesale
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+void RBTree<Key, Value, NodeAlloc, Augment, Compare>::ThreadEnds() noexcept {
+  Thread(Header(), leftmost_);
+  Thread(Header()->right, Header());
+}
+
+// Threads all nodes again in key order, O(n)
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+void RBTree<Key, Value, NodeAlloc, Augment, Compare>::Rethread() noexcept {
+  if constexpr (Augment::kThreaded) {
+    Node<Key, Value, Augment> *prev = Header();
+    for (Node<Key, Value, Augment> *node = leftmost_; node != Header();
+         node = Successor(node)) {
+      Thread(prev, node);
+      prev = node;
+    }
+    Thread(prev, Header());
+  }
+}
+
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+void RBTree<Key, Value, NodeAlloc, Augment, Compare>::Prefetch(
+    const Node<Key, Value, Augment> *node) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+  __builtin_prefetch(node);
+#else
+  (void)node;
+#endif
+}
+
+// Moves the elements equal to key into equal and the greater ones into
+// greater, this tree keeps the smaller ones
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+void RBTree<Key, Value, NodeAlloc, Augment, Compare>::Split(const Key &key,
+                                                            RBTree &equal,
+                                                            RBTree &greater) {
+  static_assert(node_allocator::kPortableNodes,
+                "Split moves nodes between trees");
+  static_assert(Balance::kJoinable, "Split needs the red-black balance");
+  equal.Clear();
+  greater.Clear();
+  Subtree less_part, equal_part, greater_part;
+  SplitSubtree(ReleaseRoot(), key, false, less_part, equal_part, greater_part);
+  Install(less_part);
+  equal.Install(equal_part);
+  greater.Install(greater_part);
+}
+
+// Appends pivot and then the elements of right, which is left empty. Throws
+// std::invalid_argument unless the keys stay in order.
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+void RBTree<Key, Value, NodeAlloc, Augment, Compare>::Join(node_type &pivot,
+                                                           RBTree &right) {
+  static_assert(node_allocator::kPortableNodes,
+                "Join moves nodes between trees");
+  static_assert(Balance::kJoinable, "Join needs the red-black balance");
+  if (pivot.empty()) {
+    Join(right);
+    return;
+  }
+  Node<Key, Value, Augment> *node = pivot.node_;
+  if (this == &right ||
+      (Header()->left != nullptr &&
+       compare_(node->key, Header()->right->key)) ||
+      (right.Header()->left != nullptr &&
+       compare_(right.leftmost_->key, node->key))) {
+    throw std::invalid_argument("Joined keys are not in order");
+  }
+  pivot.Release();
+  if constexpr (Augment::kThreaded) {
+    Thread(Header()->right, node);
+    Thread(node, right.leftmost_);
+  }
+  Subtree left_part = ReleaseRoot();
+  Install(JoinSubtrees(left_part, node, right.ReleaseRoot()));
+}
+
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+void RBTree<Key, Value, NodeAlloc, Augment, Compare>::Join(RBTree &right) {
+  static_assert(node_allocator::kPortableNodes,
+                "Join moves nodes between trees");
+  static_assert(Balance::kJoinable, "Join needs the red-black balance");
+  if (this == &right ||
+      (Header()->left != nullptr && right.Header()->left != nullptr &&
+       compare_(right.leftmost_->key, Header()->right->key))) {
+    throw std::invalid_argument("Joined keys are not in order");
+  }
+  if constexpr (Augment::kThreaded) {
+    Thread(Header()->right, right.leftmost_);
+  }
+  Subtree left_part = ReleaseRoot();
+  Install(Concat(left_part, right.ReleaseRoot()));
+}
+
+// Turns this tree into op(this, other) and leaves other empty; returns how
+// many elements of both were dropped. Runs of equal keys keep as many
+// elements as std::set_union and friends would. Nodes are split off and
+// joined back in O(m log(n / m + 1)) when the allocator lets them travel,
+// otherwise, and for balancing policies other than red-black, both trees
+// are merged into a copy in O(n + m). With a pool the split/join recursion
+// runs on its threads.
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+std::size_t RBTree<Key, Value, NodeAlloc, Augment, Compare>::Combine(
+    RBTree &other, SetOperation op, bool unique, ThreadPool *pool) {
+  if (this == &other) {
+    if (op == SetOperation::Union || op == SetOperation::Intersection) {
+      return 0;
+    }
+    std::size_t dropped = DropSubtree(ReleaseRoot().root);
+    return dropped;
+  }
+  if constexpr (node_allocator::kPortableNodes && Balance::kJoinable) {
+    std::size_t dropped = 0;
+    int forks = 0;
+    if (pool != nullptr && pool->size() > 1) {
+      while ((std::size_t{1} << forks) <
+             pool->size() * kParallelCallsPerThread) {
+        ++forks;
       }
-      // Case 2: Sibling's children are black
-      if ((sibling->left == nullptr || sibling->left->color == Color::Black) &&
-          (sibling->right == nullptr ||
-           sibling->right->color == Color::Black)) {
-        sibling->color = Color::Red;
-        node = node->parent;
-      } else {
-        // Case 3: Sibling's right child is black
-        if (sibling->right == nullptr ||
-            sibling->right->color == Color::Black) {
-          sibling->left->color = Color::Black;
-          sibling->color = Color::Red;
-          RightRotate(sibling);
-          sibling = node->parent->right;
-        }
-        // Case 4: Sibling's right child is red
-        sibling->color = node->parent->color;
-        node->parent->color = Color::Black;
-        sibling->right->color = Color::Black;
-        LeftRotate(node->parent);
-        node = root_;
+    }
+    Subtree lhs = ReleaseRoot();
+    Subtree result = CombineSubtrees(lhs, other.ReleaseRoot(), op, unique,
+                                     dropped, pool, forks);
+    Install(result);
+    Rethread();
+    return dropped;
+  } else {
+    return CombineCopies(other, op);
+  }
+}
+
+// Takes all nodes out of the tree and leaves it empty
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+typename RBTree<Key, Value, NodeAlloc, Augment, Compare>::Subtree
+RBTree<Key, Value, NodeAlloc, Augment, Compare>::ReleaseRoot() noexcept {
+  Subtree tree{Header()->left, BlackHeight(Header()->left)};
+  ResetHeader();
+  return tree;
+}
+
+// Makes tree the contents of this empty tree
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+void RBTree<Key, Value, NodeAlloc, Augment, Compare>::Install(
+    Subtree tree) noexcept {
+  if (tree.root == nullptr) {
+    return;
+  }
+  Header()->left = tree.root;
+  tree.root->SetParent(Header());
+  leftmost_ = tree.root;
+  while (leftmost_->left != nullptr) {
+    leftmost_ = leftmost_->left;
+  }
+  Header()->right = FindMax(tree.root);
+  ThreadEnds();
+}
+
+// A subtree root may be red; it is recolored, which adds a black level
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+typename RBTree<Key, Value, NodeAlloc, Augment, Compare>::Subtree
+RBTree<Key, Value, NodeAlloc, Augment, Compare>::AsSubtree(
+    Node<Key, Value, Augment> *root, int height) noexcept {
+  if (root != nullptr && root->GetColor() == Color::Red) {
+    root->SetColor(Color::Black);
+    ++height;
+  }
+  return Subtree{root, height};
+}
+
+// Detaches the root of a non-empty tree from its two subtrees
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+void RBTree<Key, Value, NodeAlloc, Augment, Compare>::Expose(
+    Subtree tree, Subtree &left, Subtree &right) noexcept {
+  Node<Key, Value, Augment> *root = tree.root;
+  left = AsSubtree(root->left, tree.height - 1);
+  right = AsSubtree(root->right, tree.height - 1);
+  root->left = nullptr;
+  root->right = nullptr;
+}
+
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+int RBTree<Key, Value, NodeAlloc, Augment, Compare>::BlackHeight(
+    const Node<Key, Value, Augment> *node) noexcept {
+  int height = 0;
+  for (; node != nullptr; node = node->left) {
+    if (node->GetColor() == Color::Black) {
+      ++height;
+    }
+  }
+  return height;
+}
+
+// Join of left, pivot and right, whose keys are in this order: the shorter
+// tree is hung into the taller one at the level of its black height and at
+// most one rotation per level fixes a red-red pair on the way back. Costs
+// O(difference of the black heights).
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+typename RBTree<Key, Value, NodeAlloc, Augment, Compare>::Subtree
+RBTree<Key, Value, NodeAlloc, Augment, Compare>::JoinSubtrees(
+    Subtree left, Node<Key, Value, Augment> *pivot, Subtree right) noexcept {
+  if (left.height > right.height) {
+    return AsSubtree(JoinRight(left.root, left.height, pivot, right),
+                     left.height);
+  }
+  if (left.height < right.height) {
+    return AsSubtree(JoinLeft(left, pivot, right.root, right.height),
+                     right.height);
+  }
+  pivot->left = left.root;
+  pivot->right = right.root;
+  if (left.root != nullptr) {
+    left.root->SetParent(pivot);
+  }
+  if (right.root != nullptr) {
+    right.root->SetParent(pivot);
+  }
+  pivot->SetColor(Color::Black);
+  Augment::Update(pivot);
+  return Subtree{pivot, left.height + 1};
+}
+
+// Walks down the right spine of node, a subtree of the given black height,
+// to a black node as high as right and puts pivot with both there
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+Node<Key, Value, Augment>
+    *RBTree<Key, Value, NodeAlloc, Augment, Compare>::JoinRight(
+        Node<Key, Value, Augment> *node, int height,
+        Node<Key, Value, Augment> *pivot, Subtree right) noexcept {
+  bool black = node == nullptr || node->GetColor() == Color::Black;
+  if (black && height == right.height) {
+    pivot->left = node;
+    pivot->right = right.root;
+    if (node != nullptr) {
+      node->SetParent(pivot);
+    }
+    if (right.root != nullptr) {
+      right.root->SetParent(pivot);
+    }
+    pivot->SetColor(Color::Red);
+    Augment::Update(pivot);
+    return pivot;
+  }
+  Node<Key, Value, Augment> *child =
+      JoinRight(node->right, black ? height - 1 : height, pivot, right);
+  node->right = child;
+  child->SetParent(node);
+  if (black && child->GetColor() == Color::Red && child->right != nullptr &&
+      child->right->GetColor() == Color::Red) {
+    child->right->SetColor(Color::Black);
+    node->right = child->left;
+    if (child->left != nullptr) {
+      child->left->SetParent(node);
+    }
+    child->left = node;
+    node->SetParent(child);
+    Augment::Update(node);
+    Augment::Update(child);
+    return child;
+  }
+  Augment::Update(node);
+  return node;
+}
+
+// Mirror image of JoinRight along the left spine of node
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+Node<Key, Value, Augment>
+    *RBTree<Key, Value, NodeAlloc, Augment, Compare>::JoinLeft(
+        Subtree left, Node<Key, Value, Augment> *pivot,
+        Node<Key, Value, Augment> *node, int height) noexcept {
+  bool black = node == nullptr || node->GetColor() == Color::Black;
+  if (black && height == left.height) {
+    pivot->left = left.root;
+    pivot->right = node;
+    if (left.root != nullptr) {
+      left.root->SetParent(pivot);
+    }
+    if (node != nullptr) {
+      node->SetParent(pivot);
+    }
+    pivot->SetColor(Color::Red);
+    Augment::Update(pivot);
+    return pivot;
+  }
+  Node<Key, Value, Augment> *child =
+      JoinLeft(left, pivot, node->left, black ? height - 1 : height);
+  node->left = child;
+  child->SetParent(node);
+  if (black && child->GetColor() == Color::Red && child->left != nullptr &&
+      child->left->GetColor() == Color::Red) {
+    child->left->SetColor(Color::Black);
+    node->left = child->right;
+    if (child->right != nullptr) {
+      child->right->SetParent(node);
+    }
+    child->right = node;
+    node->SetParent(child);
+    Augment::Update(node);
+    Augment::Update(child);
+    return child;
+  }
+  Augment::Update(node);
+  return node;
+}
+
+// Join without a pivot: the last node of left serves as one
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+typename RBTree<Key, Value, NodeAlloc, Augment, Compare>::Subtree
+RBTree<Key, Value, NodeAlloc, Augment, Compare>::Concat(
+    Subtree left, Subtree right) noexcept {
+  if (left.root == nullptr) {
+    return right;
+  }
+  if (right.root == nullptr) {
+    return left;
+  }
+  Node<Key, Value, Augment> *last;
+  Subtree rest = SplitLast(left, last);
+  return JoinSubtrees(rest, last, right);
+}
+
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+typename RBTree<Key, Value, NodeAlloc, Augment, Compare>::Subtree
+RBTree<Key, Value, NodeAlloc, Augment, Compare>::SplitLast(
+    Subtree tree, Node<Key, Value, Augment> *&last) noexcept {
+  Node<Key, Value, Augment> *root = tree.root;
+  Subtree left, right;
+  Expose(tree, left, right);
+  if (right.root == nullptr) {
+    last = root;
+    return left;
+  }
+  Subtree rest = SplitLast(right, last);
+  return JoinSubtrees(left, root, rest);
+}
+
+// Splits tree into the keys less than, equal to and greater than key by
+// joining the pieces along the search path back together. Without unique
+// equal keys may sit on both sides of a node, so both sides are split.
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+void RBTree<Key, Value, NodeAlloc, Augment, Compare>::SplitSubtree(
+    Subtree tree, const Key &key, bool unique, Subtree &less, Subtree &equal,
+    Subtree &greater) noexcept {
+  if (tree.root == nullptr) {
+    less = equal = greater = Subtree();
+    return;
+  }
+  Node<Key, Value, Augment> *root = tree.root;
+  Subtree left, right, middle;
+  Expose(tree, left, right);
+  if (compare_(root->key, key)) {
+    SplitSubtree(right, key, unique, middle, equal, greater);
+    less = JoinSubtrees(left, root, middle);
+  } else if (compare_(key, root->key)) {
+    SplitSubtree(left, key, unique, less, equal, middle);
+    greater = JoinSubtrees(middle, root, right);
+  } else if (unique) {
+    less = left;
+    greater = right;
+    equal = JoinSubtrees(Subtree(), root, Subtree());
+  } else {
+    Subtree left_equal, right_equal;
+    SplitSubtree(left, key, false, less, left_equal, middle);
+    SplitSubtree(right, key, false, middle, right_equal, greater);
+    equal = JoinSubtrees(left_equal, root, right_equal);
+  }
+}
+
+// Splits tree around one of its nodes, which is left on its own: less gets
+// the nodes before it, greater the ones after. left_turns holds the way down
+// from the root to node, see TurnsTo; equal keys do not matter.
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+void RBTree<Key, Value, NodeAlloc, Augment, Compare>::SplitAround(
+    Subtree tree, const bool *left_turns, Node<Key, Value, Augment> *node,
+    Subtree &less, Subtree &greater) noexcept {
+  Node<Key, Value, Augment> *root = tree.root;
+  Subtree left, right, middle;
+  Expose(tree, left, right);
+  if (root == node) {
+    less = left;
+    greater = right;
+  } else if (*left_turns) {
+    SplitAround(left, left_turns + 1, node, less, middle);
+    greater = JoinSubtrees(middle, root, right);
+  } else {
+    SplitAround(right, left_turns + 1, node, middle, greater);
+    less = JoinSubtrees(left, root, middle);
+  }
+}
+
+// Stores for each step from root down to node whether it goes left
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+void RBTree<Key, Value, NodeAlloc, Augment, Compare>::TurnsTo(
+    const Node<Key, Value, Augment> *root,
+    const Node<Key, Value, Augment> *node, bool *left_turns) noexcept {
+  int depth = 0;
+  for (const Node<Key, Value, Augment> *up = node; up != root;
+       up = up->GetParent()) {
+    ++depth;
+  }
+  for (; node != root; node = node->GetParent()) {
+    left_turns[--depth] = node == node->GetParent()->left;
+  }
+}
+
+// Divide and conquer on the root key of the lower tree: both trees are split
+// by it, the smaller and the greater parts are combined recursively and
+// joined back around the equal keys that stay
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+typename RBTree<Key, Value, NodeAlloc, Augment, Compare>::Subtree
+RBTree<Key, Value, NodeAlloc, Augment, Compare>::CombineSubtrees(
+    Subtree lhs, Subtree rhs, SetOperation op, bool unique,
+    std::size_t &dropped, ThreadPool *pool, int forks) {
+  if (lhs.root == nullptr || rhs.root == nullptr) {
+    if (op == SetOperation::Intersection) {
+      dropped += DropSubtree(lhs.root) + DropSubtree(rhs.root);
+      return Subtree();
+    }
+    if (op == SetOperation::Difference) {
+      dropped += DropSubtree(rhs.root);
+      return lhs;
+    }
+    return lhs.root != nullptr ? lhs : rhs;
+  }
+  const Key &key = (lhs.height <= rhs.height ? lhs : rhs).root->key;
+  Subtree lhs_less, lhs_equal, lhs_greater, rhs_less, rhs_equal, rhs_greater;
+  SplitSubtree(lhs, key, unique, lhs_less, lhs_equal, lhs_greater);
+  SplitSubtree(rhs, key, unique, rhs_less, rhs_equal, rhs_greater);
+  Subtree less, greater;
+  // The two halves share no nodes; below the grain the fork costs more than
+  // the work it spreads, and each level down doubles the calls forked
+  if (forks > 0 && lhs.height >= kParallelGrainHeight &&
+      rhs.height >= kParallelGrainHeight) {
+    std::size_t greater_dropped = 0;
+    pool->Invoke(
+        [&] {
+          less = CombineSubtrees(lhs_less, rhs_less, op, unique, dropped, pool,
+                                 forks - 1);
+        },
+        [&] {
+          greater = CombineSubtrees(lhs_greater, rhs_greater, op, unique,
+                                    greater_dropped, pool, forks - 1);
+        });
+    dropped += greater_dropped;
+  } else {
+    less = CombineSubtrees(lhs_less, rhs_less, op, unique, dropped, nullptr, 0);
+    greater = CombineSubtrees(lhs_greater, rhs_greater, op, unique, dropped,
+                              nullptr, 0);
+  }
+  if (unique) {
+    Node<Key, Value, Augment> *own = lhs_equal.root;
+    Node<Key, Value, Augment> *match = rhs_equal.root;
+    std::size_t keep_own, keep_match;
+    KeepCounts(op, own != nullptr, match != nullptr, &keep_own, &keep_match);
+    Node<Key, Value, Augment> *kept =
+        keep_own != 0 ? own : (keep_match != 0 ? match : nullptr);
+    for (Node<Key, Value, Augment> *node : {own, match}) {
+      if (node != nullptr && node != kept) {
+        DestroyNode(node);
+        ++dropped;
       }
+    }
+    return kept != nullptr ? JoinSubtrees(less, kept, greater)
+                           : Concat(less, greater);
+  }
+  s21::vector<Node<Key, Value, Augment> *> ours, theirs, kept;
+  CollectSubtree(lhs_equal.root, ours);
+  CollectSubtree(rhs_equal.root, theirs);
+  std::size_t keep_ours, keep_theirs;
+  KeepCounts(op, ours.size(), theirs.size(), &keep_ours, &keep_theirs);
+  for (std::size_t i = 0; i < ours.size(); ++i) {
+    if (i < keep_ours) {
+      kept.push_back(ours.data()[i]);
     } else {
-      Node<Key, Value> *sibling = node->parent->left;
-      // Case 1: Sibling is red
-      if (sibling != nullptr && sibling->color == Color::Red) {
-        sibling->color = Color::Black;
-        node->parent->color = Color::Red;
-        RightRotate(node->parent);
-        sibling = node->parent->left;
-      }
-      // Case 2: Sibling's children are black
-      if ((sibling->left == nullptr || sibling->left->color == Color::Black) &&
-          (sibling->right == nullptr ||
-           sibling->right->color == Color::Black)) {
-        sibling->color = Color::Red;
-        node = node->parent;
-      } else {
-        // Case 3: Sibling's left child is black
-        if (sibling->left == nullptr || sibling->left->color == Color::Black) {
-          sibling->right->color = Color::Black;
-          sibling->color = Color::Red;
-          LeftRotate(sibling);
-          sibling = node->parent->left;
-        }
-        // Case 4: Sibling's left child is red
-        sibling->color = node->parent->color;
-        node->parent->color = Color::Black;
-        sibling->left->color = Color::Black;
-        RightRotate(node->parent);
-        node = root_;
-      }
+      DestroyNode(ours.data()[i]);
+      ++dropped;
+    }
+  }
+  for (std::size_t i = 0; i < theirs.size(); ++i) {
+    if (i < keep_theirs) {
+      kept.push_back(theirs.data()[i]);
+    } else {
+      DestroyNode(theirs.data()[i]);
+      ++dropped;
+    }
+  }
+  if (kept.empty()) {
+    return Concat(less, greater);
+  }
+  Subtree run = BuildRun(kept.data(), kept.size() - 1);
+  return JoinSubtrees(Concat(less, run), kept.data()[kept.size() - 1], greater);
+}
+
+// Balanced subtree of count detached nodes in key order
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+typename RBTree<Key, Value, NodeAlloc, Augment, Compare>::Subtree
+RBTree<Key, Value, NodeAlloc, Augment, Compare>::BuildRun(
+    Node<Key, Value, Augment> **nodes, std::size_t count) {
+  if (count == 0) {
+    return Subtree();
+  }
+  std::size_t red_depth = 0;
+  while ((count >> (red_depth + 1)) != 0) {
+    ++red_depth;
+  }
+  Node<Key, Value, Augment> *last = nullptr;
+  auto adopt = [](Node<Key, Value, Augment> *node) { return node; };
+  Node<Key, Value, Augment> *root =
+      BuildSubtree(nodes, count, 0, red_depth, false, last, adopt);
+  root->SetColor(Color::Black);
+  return Subtree{root, BlackHeight(root)};
+}
+
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+std::size_t RBTree<Key, Value, NodeAlloc, Augment, Compare>::DropSubtree(
+    Node<Key, Value, Augment> *node) noexcept {
+  std::size_t count = 0;
+  for (Node<Key, Value, Augment> *next; node != nullptr; node = next) {
+    next = node->left;
+    if (next != nullptr) {
+      node->left = next->right;
+      next->right = node;
+    } else {
+      next = node->right;
+      DestroyNode(node);
+      ++count;
     }
   }
-  // Set root to black
-  node->color = Color::Black;
+  return count;
+}
+
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+void RBTree<Key, Value, NodeAlloc, Augment, Compare>::CollectSubtree(
+    Node<Key, Value, Augment> *node,
+    s21::vector<Node<Key, Value, Augment> *> &nodes) {
+  if (node != nullptr) {
+    CollectSubtree(node->left, nodes);
+    nodes.push_back(node);
+    CollectSubtree(node->right, nodes);
+  }
+}
+
+// How many of ours and theirs equal elements the result keeps
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+void RBTree<Key, Value, NodeAlloc, Augment, Compare>::KeepCounts(
+    SetOperation op, std::size_t ours, std::size_t theirs,
+    std::size_t *keep_ours, std::size_t *keep_theirs) {
+  std::size_t only_ours = ours > theirs ? ours - theirs : 0;
+  std::size_t only_theirs = theirs > ours ? theirs - ours : 0;
+  *keep_ours = ours;
+  *keep_theirs = 0;
+  if (op == SetOperation::Union) {
+    *keep_theirs = only_theirs;
+  } else if (op == SetOperation::Intersection) {
+    *keep_ours = ours - only_ours;
+  } else if (op == SetOperation::Difference) {
+    *keep_ours = only_ours;
+  } else {
+    *keep_ours = only_ours;
+    *keep_theirs = only_theirs;
+  }
+}
+
+// Combine for allocators whose nodes stay put: both trees are walked in key
+// order and the kept elements are copied into a new tree
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+std::size_t RBTree<Key, Value, NodeAlloc, Augment, Compare>::CombineCopies(
+    RBTree &other, SetOperation op) {
+  s21::vector<Node<Key, Value, Augment> *> kept;
+  std::size_t seen = 0;
+  Node<Key, Value, Augment> *lhs = Begin(), *rhs = other.Begin();
+  while (lhs != End() || rhs != other.End()) {
+    bool from_lhs =
+        rhs == other.End() || (lhs != End() && !compare_(rhs->key, lhs->key));
+    const Key &key = from_lhs ? lhs->key : rhs->key;
+    Node<Key, Value, Augment> *own = lhs, *match = rhs;
+    std::size_t ours = 0, theirs = 0;
+    for (; lhs != End() && !compare_(key, lhs->key); lhs = Next(lhs)) {
+      ++ours;
+    }
+    for (; rhs != other.End() && !compare_(key, rhs->key); rhs = Next(rhs)) {
+      ++theirs;
+    }
+    std::size_t keep_ours, keep_theirs;
+    KeepCounts(op, ours, theirs, &keep_ours, &keep_theirs);
+    for (; keep_ours != 0; --keep_ours, own = Next(own)) {
+      kept.push_back(own);
+    }
+    for (; keep_theirs != 0; --keep_theirs, match = Next(match)) {
+      kept.push_back(match);
+    }
+    seen += ours + theirs;
+  }
+  RBTree tree(compare_);
+  tree.AssignSorted(kept.begin(), kept.end(), false);
+  swap(tree);
+  other.Clear();
+  return seen - kept.size();
+}
+
+// Items of a bulk build are key/value pairs, bare keys (sets), tree nodes
+// or pointers to any of these. Key-only trees take no value from them.
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+template <class Item>
+const Key &RBTree<Key, Value, NodeAlloc, Augment, Compare>::ItemKey(
+    const Item &item) {
+  if constexpr (std::is_pointer_v<Item>) {
+    return ItemKey(*item);
+  } else if constexpr (std::is_base_of_v<Node<Key, Value, Augment>, Item>) {
+    return item.key;
+  } else if constexpr (std::is_same_v<Item, Key>) {
+    return item;
+  } else {
+    return item.first;
+  }
+}
+
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+template <class Item>
+const Value &RBTree<Key, Value, NodeAlloc, Augment, Compare>::ItemValue(
+    const Item &item) {
+  if constexpr (std::is_same_v<Value, NoValue>) {
+    static constexpr NoValue kNone{};
+    return kNone;
+  } else if constexpr (std::is_pointer_v<Item>) {
+    return ItemValue(*item);
+  } else if constexpr (std::is_base_of_v<Node<Key, Value, Augment>, Item>) {
+    return item.value;
+  } else if constexpr (std::is_same_v<Item, Key>) {
+    return item;
+  } else {
+    return item.second;
+  }
+}
+
+// Number of items a build keeps (equal keys collapse to the first one when
+// unique) and whether the range is ordered by key
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+template <class ForwardIt>
+std::size_t RBTree<Key, Value, NodeAlloc, Augment, Compare>::CountSorted(
+    ForwardIt first, ForwardIt last, bool unique, bool *sorted) const {
+  *sorted = true;
+  if (!(first != last)) {
+    return 0;
+  }
+  std::size_t count = 1;
+  ForwardIt prev = first;
+  for (++first; first != last; ++first, ++prev) {
+    if (compare_(ItemKey(*first), ItemKey(*prev))) {
+      *sorted = false;
+    } else if (!unique || compare_(ItemKey(*prev), ItemKey(*first))) {
+      ++count;
+    }
+  }
+  return count;
+}
+
+// Replaces the contents with a copy of other. Pooled trees copy their pool
+// in one go, the others rebuild from the ordered nodes in O(n).
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+void RBTree<Key, Value, NodeAlloc, Augment, Compare>::Clone(
+    const RBTree &other) {
+  compare_ = other.compare_;
+  if constexpr (node_allocator::kStableNodes) {
+    AssignSorted(iterator(other.Begin()), iterator(other.End()), false);
+  } else {
+    Clear();
+    node_allocator copy(other.alloc_);
+    alloc_.swap(copy);
+    leftmost_ = AtHeaderOffset(other.HeaderOffset(other.leftmost_));
+  }
+}
+
+// Replaces the contents with a range ordered by key in O(n). Throws
+// std::invalid_argument if the range is not sorted.
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+template <class ForwardIt>
+std::size_t RBTree<Key, Value, NodeAlloc, Augment, Compare>::AssignSorted(
+    ForwardIt first, ForwardIt last, bool unique) {
+  bool sorted;
+  std::size_t count = CountSorted(first, last, unique, &sorted);
+  if (!sorted) {
+    throw std::invalid_argument("Range is not sorted by key");
+  }
+  BuildSorted(first, count, unique);
+  return count;
+}
+
+// Replaces the contents with any range: sorted input is built directly,
+// anything else is stable-sorted through a buffer of item pointers first
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+template <class ForwardIt>
+std::size_t RBTree<Key, Value, NodeAlloc, Augment, Compare>::Assign(
+    ForwardIt first, ForwardIt last, bool unique) {
+  bool sorted;
+  std::size_t count = CountSorted(first, last, unique, &sorted);
+  if (sorted) {
+    BuildSorted(first, count, unique);
+    return count;
+  }
+  using Item = std::remove_reference_t<decltype(*first)>;
+  s21::vector<Item *> items;
+  for (; first != last; ++first) {
+    items.push_back(&*first);
+  }
+  std::stable_sort(items.begin(), items.end(), [this](Item *lhs, Item *rhs) {
+    return compare_(ItemKey(*lhs), ItemKey(*rhs));
+  });
+  count = CountSorted(items.begin(), items.end(), unique, &sorted);
+  BuildSorted(items.begin(), count, unique);
+  return count;
+}
+
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+template <class ForwardIt>
+void RBTree<Key, Value, NodeAlloc, Augment, Compare>::BuildSorted(
+    ForwardIt first, std::size_t count, bool unique) {
+  Clear();
+  if (count == 0) {
+    return;
+  }
+  MakeRoom(count, nullptr);
+  auto create = [this](const auto &item) {
+    return CreateNode(ItemKey(item), ItemValue(item));
+  };
+  LinkSorted(first, count, unique, create);
+}
+
+// Links the next count items, turned into nodes by make, as a balanced tree
+// into the empty tree
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+template <class ForwardIt, class Make>
+void RBTree<Key, Value, NodeAlloc, Augment, Compare>::LinkSorted(
+    ForwardIt first, std::size_t count, bool unique, Make &make) {
+  if (count == 0) {
+    return;
+  }
+  // Every level above the deepest one is full, so coloring the deepest
+  // level red gives all paths the same number of black nodes
+  std::size_t red_depth = 0;
+  while ((count >> (red_depth + 1)) != 0) {
+    ++red_depth;
+  }
+  Node<Key, Value, Augment> *last = nullptr;
+  Node<Key, Value, Augment> *root =
+      BuildSubtree(first, count, 0, red_depth, unique, last, make);
+  root->SetColor(Color::Black);
+  Header()->left = root;
+  root->SetParent(Header());
+  Header()->right = last;
+  leftmost_ = root;
+  while (leftmost_->left != nullptr) {
+    leftmost_ = leftmost_->left;
+  }
+  ThreadEnds();
+}
+
+// Builds the subtree of the next count items in order; last is the node
+// created just before, used to skip repeated keys when unique
+template <class Key, class Value, template <class> class NodeAlloc,
+          class Augment, class Compare>
+template <class ForwardIt, class Make>
+Node<Key, Value, Augment> *
+RBTree<Key, Value, NodeAlloc, Augment, Compare>::BuildSubtree(
+    ForwardIt &it, std::size_t count, std::size_t depth, std::size_t red_depth,
+    bool unique, Node<Key, Value, Augment> *&last, Make &make) {
+  if (count == 0) {
+    return nullptr;
+  }
+  std::size_t left_count = (count - 1) / 2;
+  Node<Key, Value, Augment> *left =
+      BuildSubtree(it, left_count, depth + 1, red_depth, unique, last, make);
+  if (unique && last != nullptr) {
+    while (!compare_(last->key, ItemKey(*it))) {
+      ++it;
+    }
+  }
+  Node<Key, Value, Augment> *node;
+  try {
+    node = make(*it);
+  } catch (...) {
+    DeleteTree(left);
+    throw;
+  }
+  ++it;
+  if (last != nullptr) {
+    Thread(last, node);
+  }
+  last = node;
+  node->left = left;
+  if (left != nullptr) {
+    left->SetParent(node);
+  }
+  node->SetColor(depth == red_depth ? Color::Red : Color::Black);
+  try {
+    node->right = BuildSubtree(it, count - left_count - 1, depth + 1, red_depth,
+                               unique, last, make);
+  } catch (...) {
+    DeleteTree(node);
+    throw;
+  }
+  if (node->right != nullptr) {
+    node->right->SetParent(node);
+  }
+  Augment::Update(node);
+  Balance::Built(node, count);
+  return node;
 }
 
 }  // namespace s21
@@ -0,0 +1,154 @@
+#ifndef CPP2_S21_CONTAINERS_2_CONTAINERS_THREADPOOL_H_
+#define CPP2_S21_CONTAINERS_2_CONTAINERS_THREADPOOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace s21 {
+
+// Fork-join pool for the divide and conquer algorithms of the containers.
+// Invoke runs two calls in parallel: the first on the calling thread, the
+// second on whichever thread takes it first. A thread waiting for its second
+// call runs other queued calls meanwhile, so nested Invokes never block the
+// pool. The size counts the calling thread: a pool of 1 runs everything
+// inline.
+class ThreadPool {
+ public:
+  explicit ThreadPool(
+      std::size_t threads = std::thread::hardware_concurrency());
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+  ~ThreadPool();
+
+  std::size_t size() const { return workers_.size() + 1; }
+
+  // Returns once both calls finished, then rethrows the exception of the
+  // first one that threw
+  template <class First, class Second>
+  void Invoke(First &&first, Second &&second);
+
+ private:
+  struct Task {
+    std::function<void()> run;
+    std::exception_ptr error;
+    std::atomic<bool> done{false};
+  };
+
+  void Push(Task *task);
+  bool RunOne();
+  void Wait(Task &task);
+  void Work();
+  static void Run(Task *task) noexcept;
+
+  std::vector<std::thread> workers_;
+  std::vector<Task *> queue_;  // Newest task last, taken from the back
+  std::mutex mutex_;
+  std::condition_variable ready_;
+  bool stopping_{false};
+};
+
+inline ThreadPool::ThreadPool(std::size_t threads) {
+  for (std::size_t i = 1; i < threads; ++i) {
+    workers_.push_back(std::thread(&ThreadPool::Work, this));
+  }
+}
+
+inline ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  ready_.notify_all();
+  for (std::thread &worker : workers_) {
+    worker.join();
+  }
+}
+
+template <class First, class Second>
+void ThreadPool::Invoke(First &&first, Second &&second) {
+  if (workers_.empty()) {
+    first();
+    second();
+    return;
+  }
+  Task task;
+  task.run = [&second] { second(); };
+  Push(&task);
+  try {
+    first();
+  } catch (...) {
+    // The task lives in this frame, it has to finish before unwinding
+    Wait(task);
+    throw;
+  }
+  Wait(task);
+  if (task.error) {
+    std::rethrow_exception(task.error);
+  }
+}
+
+inline void ThreadPool::Push(Task *task) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    queue_.push_back(task);
+  }
+  ready_.notify_one();
+}
+
+// Runs one queued task on the calling thread, false if there was none
+inline bool ThreadPool::RunOne() {
+  Task *task;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (queue_.empty()) {
+      return false;
+    }
+    task = queue_.back();
+    queue_.pop_back();
+  }
+  Run(task);
+  return true;
+}
+
+inline void ThreadPool::Wait(Task &task) {
+  while (!task.done.load(std::memory_order_acquire)) {
+    if (!RunOne()) {
+      std::this_thread::yield();
+    }
+  }
+}
+
+inline void ThreadPool::Work() {
+  for (;;) {
+    Task *task;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      ready_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+      if (queue_.empty()) {
+        return;
+      }
+      task = queue_.back();
+      queue_.pop_back();
+    }
+    Run(task);
+  }
+}
+
+inline void ThreadPool::Run(Task *task) noexcept {
+  try {
+    task->run();
+  } catch (...) {
+    task->error = std::current_exception();
+  }
+  task->done.store(true, std::memory_order_release);
+}
+
+}  // namespace s21
+
+#endif  // CPP2_S21_CONTAINERS_2_CONTAINERS_THREADPOOL_H_
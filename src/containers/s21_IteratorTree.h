@@ -1,149 +1,222 @@
 #ifndef CPP2_S21_CONTAINERS_2_CONTAINERS_S21_ITERATORTREE_H_
 #define CPP2_S21_CONTAINERS_2_CONTAINERS_S21_ITERATORTREE_H_
 
+#include <cstddef>
+#include <iterator>
 #include <stdexcept>
 
 #include "NodeTree.h"
 
 namespace s21 {
 
-template <class Key, class Value>
+template <class Key, class Value, class Augment = NoAugment>
 class RBTreeIterator {
  public:
   using key_type = Key;
   using value_type = Value;
-  typedef Node<key_type, value_type> Nodes;
+  typedef Node<key_type, value_type, Augment> Nodes;
+  using iterator_category = std::bidirectional_iterator_tag;
+  using difference_type = std::ptrdiff_t;
+  using pointer = Nodes *;
+  using reference = Nodes &;
 
   RBTreeIterator(Nodes *node = nullptr);
-  RBTreeIterator<Key, Value> &operator++();
-  RBTreeIterator<Key, Value> operator++(int);
-  RBTreeIterator<Key, Value> &operator--();
-  RBTreeIterator<Key, Value> operator--(int);
-  Node<Key, Value> &operator*() const;
+  RBTreeIterator<Key, Value, Augment> &operator++();
+  RBTreeIterator<Key, Value, Augment> operator++(int);
+  RBTreeIterator<Key, Value, Augment> &operator--();
+  RBTreeIterator<Key, Value, Augment> operator--(int);
+  RBTreeIterator<Key, Value, Augment> &operator+=(std::ptrdiff_t n);
+  RBTreeIterator<Key, Value, Augment> &operator-=(std::ptrdiff_t n);
+  RBTreeIterator<Key, Value, Augment> operator+(std::ptrdiff_t n) const;
+  RBTreeIterator<Key, Value, Augment> operator-(std::ptrdiff_t n) const;
+  Node<Key, Value, Augment> &operator*() const;
   Nodes *operator->() const;
-  bool operator==(const RBTreeIterator<Key, Value> &other) const;
-  bool operator!=(const RBTreeIterator<Key, Value> &other) const;
+  bool operator==(const RBTreeIterator<Key, Value, Augment> &other) const;
+  bool operator!=(const RBTreeIterator<Key, Value, Augment> &other) const;
   explicit operator bool() const;
-  Node<Key, Value> *current() const;
+  Node<Key, Value, Augment> *current() const;
 
  private:
   Nodes *current_{nullptr};
 };
 
-template <class Key, class Value>
-RBTreeIterator<Key, Value>::RBTreeIterator(Nodes *node) : current_(node) {}
+template <class Key, class Value, class Augment>
+RBTreeIterator<Key, Value, Augment>::RBTreeIterator(Nodes *node)
+    : current_(node) {}
 
-template <class Key, class Value>
-Node<Key, Value> *RBTreeIterator<Key, Value>::current() const {
+template <class Key, class Value, class Augment>
+Node<Key, Value, Augment> *RBTreeIterator<Key, Value, Augment>::current()
+    const {
   return current_;
 }
 
-template <class Key, class Value>
-RBTreeIterator<Key, Value> &RBTreeIterator<Key, Value>::operator++() {
-  if (!current_) {
+// end() is the header sentinel of the tree; moving past it throws
+template <class Key, class Value, class Augment>
+RBTreeIterator<Key, Value, Augment>
+    &RBTreeIterator<Key, Value, Augment>::operator++() {
+  if (!current_ || current_->IsHeader()) {
     throw std::out_of_range("Iterator has gone out of bounds");
   }
-  if (current_->right) {
+  if constexpr (Augment::kThreaded) {
+    current_ = current_->next;
+  } else if (current_->right) {
     current_ = current_->right;
     while (current_->left) {
       current_ = current_->left;
     }
   } else {
-    if (!current_->parent) {
-      current_ = nullptr;
-    } else {
-      Node<Key, Value> *p = current_->parent;
-      while (p && current_ == p->right) {
-        current_ = p;
-        p = p->parent;
-      }
+    // The root is the left child of the header, so the climb stops there
+    // after the last node
+    Node<Key, Value, Augment> *p = current_->GetParent();
+    while (!p->IsHeader() && current_ == p->right) {
       current_ = p;
+      p = p->GetParent();
     }
+    current_ = p;
   }
   return *this;
 }
 
-template <class Key, class Value>
-RBTreeIterator<Key, Value> RBTreeIterator<Key, Value>::operator++(int) {
-  RBTreeIterator<Key, Value> temp(*this);
+template <class Key, class Value, class Augment>
+RBTreeIterator<Key, Value, Augment>
+RBTreeIterator<Key, Value, Augment>::operator++(int) {
+  RBTreeIterator<Key, Value, Augment> temp(*this);
   ++(*this);
   return temp;
 }
 
-template <class Key, class Value>
-RBTreeIterator<Key, Value> &RBTreeIterator<Key, Value>::operator--() {
+template <class Key, class Value, class Augment>
+RBTreeIterator<Key, Value, Augment>
+    &RBTreeIterator<Key, Value, Augment>::operator--() {
   if (current_ == nullptr) {
     return *this;
   }
-  if (current_->left != nullptr) {
+  Nodes *node = current_;
+  if constexpr (Augment::kThreaded) {
+    // The header threads to the last node, the first node to the header
+    node = node->prev;
+  } else if (node->IsHeader()) {
+    // The header caches the rightmost node, itself when the tree is empty
+    node = node->right;
+  } else if (node->left != nullptr) {
     // find the rightmost(biggest) node in the left subtree
-    current_ = current_->left;
-    while (current_->right != nullptr) {
-      current_ = current_->right;
+    node = node->left;
+    while (node->right != nullptr) {
+      node = node->right;
     }
   } else {
     // find the nearest ancestor whose right child is also an ancestor
-    while (current_->parent != nullptr && current_ == current_->parent->left) {
-      current_ = current_->parent;
+    while (!node->GetParent()->IsHeader() && node == node->GetParent()->left) {
+      node = node->GetParent();
     }
-    current_ = current_->parent;
+    node = node->GetParent();
   }
 
-  if (current_ == nullptr) {
+  if (node->IsHeader()) {
     throw std::out_of_range("Iterator has gone out of bounds");
   }
-
+  current_ = node;
   return *this;
 }
 
-template <class Key, class Value>
-RBTreeIterator<Key, Value> RBTreeIterator<Key, Value>::operator--(int) {
-  RBTreeIterator<Key, Value> temp(*this);
+template <class Key, class Value, class Augment>
+RBTreeIterator<Key, Value, Augment>
+RBTreeIterator<Key, Value, Augment>::operator--(int) {
+  RBTreeIterator<Key, Value, Augment> temp(*this);
   --(*this);
   return temp;
 }
 
-template <class Key, class Value>
-Node<Key, Value> &RBTreeIterator<Key, Value>::operator*() const {
+// Positional moves take O(log n) and need the OrderStatistic node policy.
+// end() sits at position size(), so moving right past the last element
+// gives end().
+template <class Key, class Value, class Augment>
+RBTreeIterator<Key, Value, Augment>
+    &RBTreeIterator<Key, Value, Augment>::operator+=(std::ptrdiff_t n) {
+  static_assert(Augment::kSubtreeSize,
+                "Positional moves need the OrderStatistic node policy");
+  if (current_ == nullptr) {
+    throw std::out_of_range("Iterator has gone out of bounds");
+  }
+  Nodes *header = current_;
+  while (!header->IsHeader()) {
+    header = header->GetParent();
+  }
+  std::size_t size = Augment::Size(header->left);
+  std::size_t rank = current_ == header ? size : Augment::Rank(current_);
+  std::size_t steps = n < 0 ? std::size_t{0} - n : n;
+  if (n < 0 ? steps > rank : steps > size - rank) {
+    throw std::out_of_range("Iterator has gone out of bounds");
+  }
+  rank = n < 0 ? rank - steps : rank + steps;
+  current_ = rank == size ? header : Augment::Select(header->left, rank);
+  return *this;
+}
+
+template <class Key, class Value, class Augment>
+RBTreeIterator<Key, Value, Augment>
+    &RBTreeIterator<Key, Value, Augment>::operator-=(std::ptrdiff_t n) {
+  return *this += -n;
+}
+
+template <class Key, class Value, class Augment>
+RBTreeIterator<Key, Value, Augment>
+RBTreeIterator<Key, Value, Augment>::operator+(std::ptrdiff_t n) const {
+  RBTreeIterator<Key, Value, Augment> temp(*this);
+  return temp += n;
+}
+
+template <class Key, class Value, class Augment>
+RBTreeIterator<Key, Value, Augment>
+RBTreeIterator<Key, Value, Augment>::operator-(std::ptrdiff_t n) const {
+  RBTreeIterator<Key, Value, Augment> temp(*this);
+  return temp -= n;
+}
+
+template <class Key, class Value, class Augment>
+Node<Key, Value, Augment> &RBTreeIterator<Key, Value, Augment>::operator*()
+    const {
   return *current_;
 }
 
-template <class Key, class Value>
-Node<Key, Value> *RBTreeIterator<Key, Value>::operator->() const {
+template <class Key, class Value, class Augment>
+Node<Key, Value, Augment> *RBTreeIterator<Key, Value, Augment>::operator->()
+    const {
   return current_;
 }
 
-template <class Key, class Value>
-bool RBTreeIterator<Key, Value>::operator==(
-    const RBTreeIterator<Key, Value> &other) const {
-  if (current_ == nullptr && other.current_ == nullptr) {
-    return true;
-  } else if (current_ == nullptr || other.current_ == nullptr) {
-    return false;
-  } else {
-    return current_->key == other.current_->key;
-  }
+template <class Key, class Value, class Augment>
+bool RBTreeIterator<Key, Value, Augment>::operator==(
+    const RBTreeIterator<Key, Value, Augment> &other) const {
+  return current_ == other.current_;
 }
 
-template <typename Key, typename Value>
-bool operator==(const Node<Key, Value> &lhs, const Node<Key, Value> &rhs) {
+template <typename Key, typename Value, typename Augment>
+bool operator==(const Node<Key, Value, Augment> &lhs,
+                const Node<Key, Value, Augment> &rhs) {
   return lhs.key == rhs.key;
 }
 
-template <typename Key>
-bool operator==(const Node<Key, Key> &lhs, const Key &rhs) {
+template <typename Key, typename Augment>
+bool operator==(const Node<Key, Key, Augment> &lhs, const Key &rhs) {
+  return lhs.key == rhs;
+}
+
+template <typename Key, typename Augment>
+bool operator==(const Node<Key, NoValue, Augment> &lhs, const Key &rhs) {
   return lhs.key == rhs;
 }
 
-template <class Key, class Value>
-bool RBTreeIterator<Key, Value>::operator!=(
-    const RBTreeIterator<Key, Value> &other) const {
+template <class Key, class Value, class Augment>
+bool RBTreeIterator<Key, Value, Augment>::operator!=(
+    const RBTreeIterator<Key, Value, Augment> &other) const {
   return !(*this == other);
 }
 
-template <class Key, class Value>
-RBTreeIterator<Key, Value>::operator bool() const {
-  return current_ != nullptr;
+// False for end() and for a default-constructed iterator
+template <class Key, class Value, class Augment>
+RBTreeIterator<Key, Value, Augment>::operator bool() const {
+  return current_ != nullptr && !current_->IsHeader();
 }
 
 }  // namespace s21
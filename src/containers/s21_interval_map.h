@@ -0,0 +1,315 @@
+#ifndef CPP2_S21_CONTAINERS_2_CONTAINERS_S21_INTERVAL_MAP_H_
+#define CPP2_S21_CONTAINERS_2_CONTAINERS_S21_INTERVAL_MAP_H_
+
+#include <stdexcept>
+
+#include "RBTree.h"
+
+namespace s21 {
+
+// Value of an IntervalMap node; the start of the interval is the node key
+template <class T, class V>
+struct IntervalValue {
+  T end;
+  V mapped;
+};
+
+// Monoid of interval ends for SubtreeAggregate: no interval of a subtree
+// ends after the aggregate of the subtree
+template <class T>
+struct MaxEndOf : MaxOf<T> {
+  template <class NodeT>
+  static T Lift(const NodeT &node) noexcept {
+    return node.value.end;
+  }
+};
+
+// Half-open intervals [start, end), each with a mapped value, in a tree
+// ordered by start. Equal and overlapping intervals may coexist. Every node
+// keeps the largest end of its subtree, so queries skip the subtrees that
+// end before the query range begins. T is ordered by operator< and needs
+// std::numeric_limits, whose lowest value is the end of an empty subtree.
+//
+// Iterators visit the intervals by start: it->key is the start,
+// it->value.end the end and it->value.mapped the value. The end of a stored
+// interval must not be changed in place; erase and insert it again.
+template <typename T, typename V,
+          template <class> class NodeAlloc = HeapNodeAllocator,
+          class Base = DefaultNodePolicy<NodeAlloc>>
+class IntervalMap {
+ public:
+  using key_type = T;
+  using mapped_type = V;
+  using value_type = IntervalValue<T, V>;
+  using size_type = std::size_t;
+  using node_policy = SubtreeAggregate<MaxEndOf<T>, Base>;
+  using iterator =
+      typename RBTree<T, value_type, NodeAlloc, node_policy>::iterator;
+  using const_iterator =
+      typename RBTree<T, value_type, NodeAlloc, node_policy>::const_iterator;
+
+  IntervalMap() = default;
+  IntervalMap(const IntervalMap &other);
+  IntervalMap &operator=(const IntervalMap &other);
+  IntervalMap(IntervalMap &&other) noexcept;
+  IntervalMap &operator=(IntervalMap &&other) noexcept;
+  ~IntervalMap() = default;
+
+  // Throws std::invalid_argument unless start < end
+  iterator insert(const T &start, const T &end, const V &value);
+  iterator insert(const T &start, const T &end, V &&value);
+  void erase(iterator it);
+  // Removes one interval equal to [start, end); returns 0 if there is none
+  size_type erase(const T &start, const T &end);
+  iterator find(const T &start, const T &end) const;
+
+  // Overlap query: the interval with the smallest start among those that
+  // overlap [lo, hi), end() if there is none; O(log n). An empty [lo, hi)
+  // overlaps nothing.
+  iterator find_overlap(const T &lo, const T &hi) const;
+  bool overlaps(const T &lo, const T &hi) const;
+  // All-overlaps and stabbing queries: fn(start, end, mapped) is called for
+  // every interval that overlaps [lo, hi), or that contains point, in start
+  // order. The walk visits the reported nodes, their ancestors and one path
+  // to where the starts pass hi: O(log n + k) for k intervals that lie close
+  // together, O(log n + k log(n / k)) when they are spread over the tree.
+  template <typename Fn>
+  void for_each_overlap(const T &lo, const T &hi, Fn fn) const;
+  template <typename Fn>
+  void for_each_containing(const T &point, Fn fn) const;
+
+  iterator begin() const;
+  iterator end() const;
+  size_type size() const;
+  bool empty() const;
+  void clear();
+  void swap(IntervalMap &other);
+
+ private:
+  using NodeT = Node<T, value_type, node_policy>;
+
+  static T MaxEnd(const NodeT *node) noexcept;
+  // Leftmost node of the subtree of node, pruned to the subtrees that end
+  // after lo; node itself must end after lo
+  static NodeT *DescendLeft(NodeT *node, const T &lo) noexcept;
+  // Visits the nodes that end after lo in start order while starts_before
+  // holds for their start
+  template <typename StartsBefore, typename Fn>
+  void VisitEndingAfter(const T &lo, StartsBefore starts_before, Fn &fn) const;
+
+  RBTree<T, value_type, NodeAlloc, node_policy> tree_;
+  size_type size_{};
+};
+
+template <typename T, typename V, template <class> class NodeAlloc, class Base>
+IntervalMap<T, V, NodeAlloc, Base>::IntervalMap(const IntervalMap &other)
+    : size_(other.size_) {
+  tree_.Clone(other.tree_);
+}
+
+template <typename T, typename V, template <class> class NodeAlloc, class Base>
+IntervalMap<T, V, NodeAlloc, Base>
+    &IntervalMap<T, V, NodeAlloc, Base>::operator=(const IntervalMap &other) {
+  if (this != &other) {
+    IntervalMap copy(other);
+    swap(copy);
+  }
+  return *this;
+}
+
+template <typename T, typename V, template <class> class NodeAlloc, class Base>
+IntervalMap<T, V, NodeAlloc, Base>::IntervalMap(IntervalMap &&other) noexcept {
+  swap(other);
+}
+
+template <typename T, typename V, template <class> class NodeAlloc, class Base>
+IntervalMap<T, V, NodeAlloc, Base> &
+IntervalMap<T, V, NodeAlloc, Base>::operator=(IntervalMap &&other) noexcept {
+  clear();
+  swap(other);
+  return *this;
+}
+
+template <typename T, typename V, template <class> class NodeAlloc, class Base>
+typename IntervalMap<T, V, NodeAlloc, Base>::iterator
+IntervalMap<T, V, NodeAlloc, Base>::insert(const T &start, const T &end,
+                                           const V &value) {
+  return insert(start, end, V(value));
+}
+
+template <typename T, typename V, template <class> class NodeAlloc, class Base>
+typename IntervalMap<T, V, NodeAlloc, Base>::iterator
+IntervalMap<T, V, NodeAlloc, Base>::insert(const T &start, const T &end,
+                                           V &&value) {
+  if (!(start < end)) {
+    throw std::invalid_argument("IntervalMap needs start < end");
+  }
+  NodeT *node = tree_.InsertEqual(start, value_type{end, std::move(value)});
+  ++size_;
+  return iterator(node);
+}
+
+template <typename T, typename V, template <class> class NodeAlloc, class Base>
+void IntervalMap<T, V, NodeAlloc, Base>::erase(iterator it) {
+  if (it == end()) {
+    throw std::out_of_range(
+        "The element to be erased does not exist in IntervalMap");
+  }
+  tree_.Erase(it.current());
+  --size_;
+}
+
+template <typename T, typename V, template <class> class NodeAlloc, class Base>
+typename IntervalMap<T, V, NodeAlloc, Base>::size_type
+IntervalMap<T, V, NodeAlloc, Base>::erase(const T &start, const T &end) {
+  iterator it = find(start, end);
+  if (it == this->end()) {
+    return 0;
+  }
+  erase(it);
+  return 1;
+}
+
+// O(log n + m) for m intervals that share the start
+template <typename T, typename V, template <class> class NodeAlloc, class Base>
+typename IntervalMap<T, V, NodeAlloc, Base>::iterator
+IntervalMap<T, V, NodeAlloc, Base>::find(const T &start, const T &end) const {
+  for (iterator it(tree_.LowerBound(start));
+       it != this->end() && !(start < it->key); ++it) {
+    if (!(it->value.end < end) && !(end < it->value.end)) {
+      return it;
+    }
+  }
+  return this->end();
+}
+
+// The left subtree holds the smaller starts. Once node starts before hi, so
+// does all of its left subtree, and any of those intervals that ends after
+// lo overlaps: the left subtree then has an overlap exactly when its
+// largest end passes lo, and the descent never has to come back.
+template <typename T, typename V, template <class> class NodeAlloc, class Base>
+typename IntervalMap<T, V, NodeAlloc, Base>::iterator
+IntervalMap<T, V, NodeAlloc, Base>::find_overlap(const T &lo,
+                                                 const T &hi) const {
+  NodeT *node = lo < hi ? tree_.GetRoot() : nullptr;
+  while (node != nullptr) {
+    if (!(node->key < hi)) {
+      node = node->left;
+    } else if (lo < MaxEnd(node->left)) {
+      node = node->left;
+    } else if (lo < node->value.end) {
+      return iterator(node);
+    } else {
+      node = node->right;
+    }
+  }
+  return end();
+}
+
+template <typename T, typename V, template <class> class NodeAlloc, class Base>
+bool IntervalMap<T, V, NodeAlloc, Base>::overlaps(const T &lo,
+                                                  const T &hi) const {
+  return find_overlap(lo, hi) != end();
+}
+
+template <typename T, typename V, template <class> class NodeAlloc, class Base>
+template <typename Fn>
+void IntervalMap<T, V, NodeAlloc, Base>::for_each_overlap(const T &lo,
+                                                          const T &hi,
+                                                          Fn fn) const {
+  if (lo < hi) {
+    VisitEndingAfter(
+        lo, [&hi](const T &start) { return start < hi; }, fn);
+  }
+}
+
+template <typename T, typename V, template <class> class NodeAlloc, class Base>
+template <typename Fn>
+void IntervalMap<T, V, NodeAlloc, Base>::for_each_containing(const T &point,
+                                                             Fn fn) const {
+  VisitEndingAfter(
+      point, [&point](const T &start) { return !(point < start); }, fn);
+}
+
+template <typename T, typename V, template <class> class NodeAlloc, class Base>
+typename IntervalMap<T, V, NodeAlloc, Base>::iterator
+IntervalMap<T, V, NodeAlloc, Base>::begin() const {
+  return iterator(tree_.Begin());
+}
+
+template <typename T, typename V, template <class> class NodeAlloc, class Base>
+typename IntervalMap<T, V, NodeAlloc, Base>::iterator
+IntervalMap<T, V, NodeAlloc, Base>::end() const {
+  return iterator(tree_.End());
+}
+
+template <typename T, typename V, template <class> class NodeAlloc, class Base>
+typename IntervalMap<T, V, NodeAlloc, Base>::size_type
+IntervalMap<T, V, NodeAlloc, Base>::size() const {
+  return size_;
+}
+
+template <typename T, typename V, template <class> class NodeAlloc, class Base>
+bool IntervalMap<T, V, NodeAlloc, Base>::empty() const {
+  return size_ == 0;
+}
+
+template <typename T, typename V, template <class> class NodeAlloc, class Base>
+void IntervalMap<T, V, NodeAlloc, Base>::clear() {
+  tree_.Clear();
+  size_ = 0;
+}
+
+template <typename T, typename V, template <class> class NodeAlloc, class Base>
+void IntervalMap<T, V, NodeAlloc, Base>::swap(IntervalMap &other) {
+  std::swap(size_, other.size_);
+  tree_.swap(other.tree_);
+}
+
+template <typename T, typename V, template <class> class NodeAlloc, class Base>
+T IntervalMap<T, V, NodeAlloc, Base>::MaxEnd(const NodeT *node) noexcept {
+  return node_policy::template Aggregate<NodeT>(node);
+}
+
+template <typename T, typename V, template <class> class NodeAlloc, class Base>
+typename IntervalMap<T, V, NodeAlloc, Base>::NodeT *
+IntervalMap<T, V, NodeAlloc, Base>::DescendLeft(NodeT *node,
+                                                const T &lo) noexcept {
+  while (lo < MaxEnd(node->left)) {
+    node = node->left;
+  }
+  return node;
+}
+
+// In-order walk over the tree without the subtrees that end by lo, which
+// are never entered. Parent links take the walk back up, so it needs no
+// stack with any balancing policy.
+template <typename T, typename V, template <class> class NodeAlloc, class Base>
+template <typename StartsBefore, typename Fn>
+void IntervalMap<T, V, NodeAlloc, Base>::VisitEndingAfter(
+    const T &lo, StartsBefore starts_before, Fn &fn) const {
+  NodeT *node = tree_.GetRoot();
+  if (node == nullptr || !(lo < MaxEnd(node))) {
+    return;
+  }
+  node = DescendLeft(node, lo);
+  while (!node->IsHeader() && starts_before(node->key)) {
+    if (lo < node->value.end) {
+      fn(node->key, node->value.end, node->value.mapped);
+    }
+    if (lo < MaxEnd(node->right)) {
+      node = DescendLeft(node->right, lo);
+    } else {
+      NodeT *parent = node->GetParent();
+      while (!parent->IsHeader() && node == parent->right) {
+        node = parent;
+        parent = node->GetParent();
+      }
+      node = parent;
+    }
+  }
+}
+
+}  // namespace s21
+
+#endif  // CPP2_S21_CONTAINERS_2_CONTAINERS_S21_INTERVAL_MAP_H_
@@ -6,9 +6,13 @@
 #include <iostream>
 #include <utility>
 
+#include "NodeAllocator.h"
 #include "s21_vector.h"
 
-template <typename T>
+// NodeAlloc is the storage policy of the nodes (see NodeAllocator.h). With
+// s21::IndexPoolAllocator the nodes sit in one pool and link with 32-bit
+// IndexLinks; insertions may then move them, which invalidates iterators.
+template <typename T, template <class> class NodeAlloc = s21::HeapNodeAllocator>
 class list {
  public:
   using value_type = T;
@@ -19,17 +23,24 @@ class list {
  private:
   class listNode {
    public:
+    using Link = std::conditional_t<s21::StorageTraits<NodeAlloc>::kIndexLinks,
+                                    s21::IndexLink<listNode>, listNode *>;
+
     T data_;
-    listNode *p_next_;
-    listNode *p_prev_;
+    Link p_next_;
+    Link p_prev_;
 
     explicit listNode(const T &data = T(), listNode *p_next = nullptr,
                       listNode *p_prev = nullptr)
-        : data_(data), p_next_(p_next), p_prev_(p_prev) {}
+        : data_(data) {
+      p_next_ = p_next;
+      p_prev_ = p_prev;
+    }
     explicit listNode(listNode *p_next, listNode *p_prev = nullptr,
                       T &&data = T())
-        : data_(std::forward<T>(data)), p_next_(nullptr), p_prev_(p_prev) {
+        : data_(std::forward<T>(data)) {
       p_next_ = p_next;
+      p_prev_ = p_prev;
     }
 
     ~listNode() {
@@ -37,7 +48,11 @@ class list {
       p_prev_ = nullptr;
     }
   };
-  using Node = list<T>::listNode;
+  using Node = list<T, NodeAlloc>::listNode;
+  using node_allocator = NodeAlloc<Node>;
+  static_assert(node_allocator::kStableNodes || std::is_trivially_copyable_v<T>,
+                "Pooled nodes are moved byte by byte and need a trivially "
+                "copyable value type");
 
  public:
   class ListIterator {
@@ -47,19 +62,20 @@ class list {
    public:
     ListIterator() : p_node_(nullptr) {}
     ListIterator(Node *ptr) : p_node_(ptr) {}
-    ListIterator(const list<T>::ListIterator &other) : p_node_(other.p_node_) {}
+    ListIterator(const list<T, NodeAlloc>::ListIterator &other)
+        : p_node_(other.p_node_) {}
     ~ListIterator() { p_node_ = nullptr; }
 
-    ListIterator &operator=(const list<T>::ListIterator &other);
+    ListIterator &operator=(const list<T, NodeAlloc>::ListIterator &other);
     T &operator*() const;
     ListIterator &operator++();
     ListIterator &operator--();
-    bool operator==(const list<T>::ListIterator &other);
-    bool operator!=(const list<T>::ListIterator &other);
+    bool operator==(const list<T, NodeAlloc>::ListIterator &other);
+    bool operator!=(const list<T, NodeAlloc>::ListIterator &other);
 
     friend class list;
   };
-  using iterator = list<T>::ListIterator;
+  using iterator = list<T, NodeAlloc>::ListIterator;
   friend class ListIterator;
 
   class ListConstIterator {
@@ -68,33 +84,35 @@ class list {
 
    public:
     ListConstIterator() {}
-    ListConstIterator(const list<T>::ListIterator &other) : iter_(other) {}
-    ListConstIterator(const list<T>::ListConstIterator &other)
+    ListConstIterator(const list<T, NodeAlloc>::ListIterator &other)
+        : iter_(other) {}
+    ListConstIterator(const list<T, NodeAlloc>::ListConstIterator &other)
         : iter_(other.iter_) {}
     ~ListConstIterator() {}
 
-    ListConstIterator &operator=(const list<T>::ListIterator &other);
-    ListConstIterator &operator=(const list<T>::ListConstIterator &other);
+    ListConstIterator &operator=(const list<T, NodeAlloc>::ListIterator &other);
+    ListConstIterator &operator=(
+        const list<T, NodeAlloc>::ListConstIterator &other);
     T operator*() const { return T(*iter_); }
     ListConstIterator &operator++();
     ListConstIterator &operator--();
-    bool operator==(const list<T>::ListIterator &other);
-    bool operator==(const list<T>::ListConstIterator &other);
-    bool operator!=(const list<T>::ListIterator &other);
-    bool operator!=(const list<T>::ListConstIterator &other);
+    bool operator==(const list<T, NodeAlloc>::ListIterator &other);
+    bool operator==(const list<T, NodeAlloc>::ListConstIterator &other);
+    bool operator!=(const list<T, NodeAlloc>::ListIterator &other);
+    bool operator!=(const list<T, NodeAlloc>::ListConstIterator &other);
 
     friend class list;
   };
-  using const_iterator = list<T>::ListConstIterator;
+  using const_iterator = list<T, NodeAlloc>::ListConstIterator;
 
   // Constructors
   list();
   explicit list(size_type n);
   explicit list(std::initializer_list<T> const &items);
-  list(const list<T> &l);
-  list(list<T> &&l);
+  list(const list<T, NodeAlloc> &l);
+  list(list<T, NodeAlloc> &&l);
   ~list();
-  list &operator=(list<T> &&l);
+  list &operator=(list<T, NodeAlloc> &&l);
 
   const_reference front();
   const_reference back();
@@ -136,86 +154,95 @@ class list {
   Node *p_head_;
   Node *p_back_;
   Node *p_fantome_;
+  node_allocator alloc_;
 
   iterator PositionToInsert(const_reference value, const iterator &last_sorted);
+  Node *CreateNode(const_reference value);
+  void DestroyNode(Node *node) noexcept;
+  Node *CreateFantome();
+  void DestroyFantome() noexcept;
+  Node *MakeRoom(size_type count, Node *node);
+  // Node positions as byte offsets from the pool's header cell, which
+  // survive the pool moving or being copied; -1 stands for nullptr
+  static std::ptrdiff_t HeaderOffset(const node_allocator &alloc,
+                                     const Node *node);
+  static Node *AtHeaderOffset(const node_allocator &alloc,
+                              std::ptrdiff_t offset);
 };
 
-template <typename T>
-list<T>::list() : size_(0), p_head_(nullptr), p_back_(nullptr) {
-  p_fantome_ = new Node();
+template <typename T, template <class> class NodeAlloc>
+list<T, NodeAlloc>::list() : size_(0), p_head_(nullptr), p_back_(nullptr) {
+  p_fantome_ = CreateFantome();
 }
 
-template <typename T>
-list<T>::list(size_type n) : list() {
+template <typename T, template <class> class NodeAlloc>
+list<T, NodeAlloc>::list(size_type n) : list() {
   for (size_t i = 0; i < n; ++i) {
     push_back(T());
   }
 }
 
-template <typename T>
-list<T>::list(std::initializer_list<value_type> const &items) : list() {
+template <typename T, template <class> class NodeAlloc>
+list<T, NodeAlloc>::list(std::initializer_list<value_type> const &items)
+    : list() {
   for (const auto &element : items) {
     push_back(element);
   }
 }
 
-template <typename T>
-list<T>::list(const list<T> &l) : list() {
-  const_iterator it = l.cbegin();
-  for (size_t i = 0; i < l.size() && it != l.cend(); ++i, ++it) {
-    push_back(*it);
+template <typename T, template <class> class NodeAlloc>
+list<T, NodeAlloc>::list(const list<T, NodeAlloc> &l) : list() {
+  if constexpr (node_allocator::kStableNodes) {
+    const_iterator it = l.cbegin();
+    for (size_t i = 0; i < l.size() && it != l.cend(); ++i, ++it) {
+      push_back(*it);
+    }
+  } else {
+    // Pooled nodes are copied in one go, their links stay valid
+    node_allocator copy(l.alloc_);
+    alloc_.swap(copy);
+    size_ = l.size_;
+    p_head_ = AtHeaderOffset(alloc_, HeaderOffset(l.alloc_, l.p_head_));
+    p_back_ = AtHeaderOffset(alloc_, HeaderOffset(l.alloc_, l.p_back_));
+    p_fantome_ = alloc_.Header();
   }
 }
 
-template <typename T>
-list<T>::list(list<T> &&l)
-    : size_(l.size_),
-      p_head_(l.p_head_),
-      p_back_(l.p_back_),
-      p_fantome_(l.p_fantome_) {
-  l.size_ = 0;
-  l.p_head_ = nullptr;
-  l.p_back_ = nullptr;
-  l.p_fantome_ = new Node();
+template <typename T, template <class> class NodeAlloc>
+list<T, NodeAlloc>::list(list<T, NodeAlloc> &&l) : list() {
+  swap(l);
 }
 
-template <typename T>
-list<T>::~list() {
+template <typename T, template <class> class NodeAlloc>
+list<T, NodeAlloc>::~list() {
   clear();
-  delete p_fantome_;
+  DestroyFantome();
   p_fantome_ = nullptr;
 }
 
-template <typename T>
-list<T> &list<T>::operator=(list<T> &&l) {
-  if (this->p_head_ != l.p_head_) {
+template <typename T, template <class> class NodeAlloc>
+list<T, NodeAlloc> &list<T, NodeAlloc>::operator=(list<T, NodeAlloc> &&l) {
+  if (this != &l) {
     clear();
-    p_head_ = l.p_head_;
-    l.p_head_ = nullptr;
-    p_back_ = l.p_back_;
-    l.p_back_ = nullptr;
-    p_fantome_->p_prev_ = p_back_;
-    l.p_fantome_->p_prev_ = nullptr;
-    size_ = l.size_;
-    l.size_ = 0;
+    swap(l);
   }
   return *this;
 }
 
-template <typename T>
-typename list<T>::const_reference list<T>::front() {
+template <typename T, template <class> class NodeAlloc>
+typename list<T, NodeAlloc>::const_reference list<T, NodeAlloc>::front() {
   iterator it = this->begin();
   return *it;
 }
 
-template <typename T>
-typename list<T>::const_reference list<T>::back() {
+template <typename T, template <class> class NodeAlloc>
+typename list<T, NodeAlloc>::const_reference list<T, NodeAlloc>::back() {
   iterator it = this->end();
   return *(--it);
 }
 
-template <typename T>
-typename list<T>::iterator list<T>::begin() const {
+template <typename T, template <class> class NodeAlloc>
+typename list<T, NodeAlloc>::iterator list<T, NodeAlloc>::begin() const {
   iterator it;
   if (size_ == 0) {
     it = this->end();
@@ -225,33 +252,33 @@ typename list<T>::iterator list<T>::begin() const {
   return it;
 }
 
-template <typename T>
-typename list<T>::iterator list<T>::end() const {
+template <typename T, template <class> class NodeAlloc>
+typename list<T, NodeAlloc>::iterator list<T, NodeAlloc>::end() const {
   iterator it(this->p_fantome_);
   return it;
 }
 
-template <typename T>
-bool list<T>::empty() const {
+template <typename T, template <class> class NodeAlloc>
+bool list<T, NodeAlloc>::empty() const {
   return size() == 0;
 }
 
-template <typename T>
-typename list<T>::size_type list<T>::size() const {
+template <typename T, template <class> class NodeAlloc>
+typename list<T, NodeAlloc>::size_type list<T, NodeAlloc>::size() const {
   return size_;
 }
 
-template <typename T>
-typename list<T>::size_type list<T>::max_size() const {
+template <typename T, template <class> class NodeAlloc>
+typename list<T, NodeAlloc>::size_type list<T, NodeAlloc>::max_size() const {
   return ((powl(2, 64) / sizeof(Node)) / 2);
 }
 
-template <typename T>
-void list<T>::clear() {
+template <typename T, template <class> class NodeAlloc>
+void list<T, NodeAlloc>::clear() {
   Node *tmp;
   for (size_t i = size_; i > 0; --i) {
     tmp = p_back_->p_prev_;
-    delete p_back_;
+    DestroyNode(p_back_);
     p_back_ = tmp;
   }
   if (p_fantome_ != nullptr) {
@@ -262,9 +289,19 @@ void list<T>::clear() {
   size_ = 0;
 }
 
-template <typename T>
-typename list<T>::iterator list<T>::insert(list<T>::iterator pos,
-                                           list<T>::const_reference value) {
+template <typename T, template <class> class NodeAlloc>
+typename list<T, NodeAlloc>::iterator list<T, NodeAlloc>::insert(
+    list<T, NodeAlloc>::iterator pos,
+    list<T, NodeAlloc>::const_reference value) {
+  if constexpr (!node_allocator::kStableNodes) {
+    if (!alloc_.HasRoom(1)) {
+      // value may be an element, and growing the pool frees the old cells
+      T staged(value);
+      pos.p_node_ = MakeRoom(1, pos.p_node_);
+      return insert(pos, staged);
+    }
+  }
+  pos.p_node_ = MakeRoom(1, pos.p_node_);
   if (pos == this->end()) {
     push_back(value);
     --pos;
@@ -272,7 +309,7 @@ typename list<T>::iterator list<T>::insert(list<T>::iterator pos,
     push_front(value);
     --pos;
   } else {
-    Node *new_node = new Node(value);
+    Node *new_node = CreateNode(value);
     Node *prev = pos.p_node_->p_prev_;
     prev->p_next_ = new_node;
     new_node->p_prev_ = prev;
@@ -284,8 +321,8 @@ typename list<T>::iterator list<T>::insert(list<T>::iterator pos,
   return pos;
 }
 
-template <typename T>
-void list<T>::erase(list<T>::iterator pos) {
+template <typename T, template <class> class NodeAlloc>
+void list<T, NodeAlloc>::erase(list<T, NodeAlloc>::iterator pos) {
   if (pos == this->end()) {
     throw std::invalid_argument("Invalid pointer");
   }
@@ -299,20 +336,30 @@ void list<T>::erase(list<T>::iterator pos) {
     iterator pos_next = ++iterator(pos);
     pos_prev.p_node_->p_next_ = pos_next.p_node_;
     pos_next.p_node_->p_prev_ = pos_prev.p_node_;
-    delete pos.p_node_;
+    DestroyNode(pos.p_node_);
     --size_;
   }
 }
 
-template <typename T>
-void list<T>::push_back(const_reference value) {
+template <typename T, template <class> class NodeAlloc>
+void list<T, NodeAlloc>::push_back(const_reference value) {
+  if constexpr (!node_allocator::kStableNodes) {
+    if (!alloc_.HasRoom(1)) {
+      // value may be an element, and growing the pool frees the old cells
+      T staged(value);
+      MakeRoom(1, nullptr);
+      push_back(staged);
+      return;
+    }
+  }
+  MakeRoom(1, nullptr);
   if (size_ == 0) {
-    p_head_ = new Node(value);
+    p_head_ = CreateNode(value);
     p_back_ = p_head_;
     p_back_->p_next_ = p_fantome_;
     p_fantome_->p_prev_ = p_back_;
   } else {
-    Node *tmp = new Node(value);
+    Node *tmp = CreateNode(value);
     tmp->p_next_ = p_fantome_;
     tmp->p_prev_ = p_back_;
     p_back_->p_next_ = tmp;
@@ -322,17 +369,17 @@ void list<T>::push_back(const_reference value) {
   ++size_;
 }
 
-template <typename T>
-void list<T>::pop_back() {
+template <typename T, template <class> class NodeAlloc>
+void list<T, NodeAlloc>::pop_back() {
   if (!empty()) {
     if (size_ == 1) {
-      delete p_head_;
+      DestroyNode(p_head_);
       p_head_ = nullptr;
       p_back_ = nullptr;
       p_fantome_->p_prev_ = nullptr;
     } else {
       p_back_ = p_back_->p_prev_;
-      delete p_back_->p_next_;
+      DestroyNode(p_back_->p_next_);
       p_back_->p_next_ = p_fantome_;
       p_fantome_->p_prev_ = p_back_;
     }
@@ -340,25 +387,35 @@ void list<T>::pop_back() {
   }
 }
 
-template <typename T>
-void list<T>::pop_front() {
+template <typename T, template <class> class NodeAlloc>
+void list<T, NodeAlloc>::pop_front() {
   if (!empty()) {
     if (size_ == 1) {
       pop_back();
     } else {
       p_head_ = p_head_->p_next_;
-      delete p_head_->p_prev_;
+      DestroyNode(p_head_->p_prev_);
       --size_;
     }
   }
 }
 
-template <typename T>
-void list<T>::push_front(const_reference value) {
+template <typename T, template <class> class NodeAlloc>
+void list<T, NodeAlloc>::push_front(const_reference value) {
+  if constexpr (!node_allocator::kStableNodes) {
+    if (!alloc_.HasRoom(1)) {
+      // value may be an element, and growing the pool frees the old cells
+      T staged(value);
+      MakeRoom(1, nullptr);
+      push_front(staged);
+      return;
+    }
+  }
+  MakeRoom(1, nullptr);
   if (size_ == 0) {
     push_back(value);
   } else {
-    Node *tmp = new Node(value);
+    Node *tmp = CreateNode(value);
     tmp->p_next_ = p_head_;
     p_head_->p_prev_ = tmp;
     p_head_ = tmp;
@@ -366,17 +423,30 @@ void list<T>::push_front(const_reference value) {
   }
 }
 
-template <typename T>
-void list<T>::swap(list &other) {
+template <typename T, template <class> class NodeAlloc>
+void list<T, NodeAlloc>::swap(list &other) {
   if (this != &other) {
-    list tmp = std::move(*this);
-    *this = std::move(other);
-    other = std::move(tmp);
+    std::swap(size_, other.size_);
+    std::swap(p_head_, other.p_head_);
+    std::swap(p_back_, other.p_back_);
+    std::swap(p_fantome_, other.p_fantome_);
+    alloc_.swap(other.alloc_);
   }
 }
 
-template <typename T>
-void list<T>::merge(list &other) {
+template <typename T, template <class> class NodeAlloc>
+void list<T, NodeAlloc>::merge(list &other) {
+  if constexpr (!node_allocator::kStableNodes) {
+    // Nodes cannot leave their pool, so the values are copied over
+    if (this != &other && other.empty() == false) {
+      MakeRoom(other.size_, nullptr);
+      for (iterator it = other.begin(); it != other.end(); ++it) {
+        push_back(*it);
+      }
+      other.clear();
+    }
+    return;
+  }
   if (this != &other && other.empty() == false) {
     this->p_back_->p_next_ = other.p_head_;
     other.p_head_->p_prev_ = this->p_back_;
@@ -392,11 +462,20 @@ void list<T>::merge(list &other) {
   }
 }
 
-template <typename T>
-void list<T>::splice(const_iterator pos, list &other) {
+template <typename T, template <class> class NodeAlloc>
+void list<T, NodeAlloc>::splice(const_iterator pos, list &other) {
   if (other.empty()) {
     return;
   }
+  if constexpr (!node_allocator::kStableNodes) {
+    // Nodes cannot leave their pool, so the values are copied over
+    iterator at(MakeRoom(other.size_, pos.iter_.p_node_));
+    for (iterator it = other.begin(); it != other.end(); ++it) {
+      insert(at, *it);
+    }
+    other.clear();
+    return;
+  }
   if (pos == this->begin()) {
     this->p_head_->p_prev_ = other.p_back_;
     other.p_back_->p_next_ = this->p_head_;
@@ -416,8 +495,8 @@ void list<T>::splice(const_iterator pos, list &other) {
   other.p_fantome_->p_prev_ = nullptr;
 }
 
-template <typename T>
-void list<T>::reverse() {
+template <typename T, template <class> class NodeAlloc>
+void list<T, NodeAlloc>::reverse() {
   if (size_ > 1) {
     for (iterator prev_it(begin()), it(++begin());;) {
       prev_it.p_node_->p_next_ = prev_it.p_node_->p_prev_;
@@ -438,8 +517,8 @@ void list<T>::reverse() {
   }
 }
 
-template <typename T>
-void list<T>::unique() {
+template <typename T, template <class> class NodeAlloc>
+void list<T, NodeAlloc>::unique() {
   if (size_ > 1) {
     for (iterator it = begin(), it_next = ++begin(); it_next != end();) {
       if (*it == *it_next) {
@@ -454,8 +533,8 @@ void list<T>::unique() {
   }
 }
 
-template <typename T>
-void list<T>::sort() {
+template <typename T, template <class> class NodeAlloc>
+void list<T, NodeAlloc>::sort() {
   if (size_ <= 1) {
     return;
   }
@@ -478,9 +557,10 @@ void list<T>::sort() {
   p_back_ = last_sorted.p_node_;
 }
 
-template <typename T>
-typename list<T>::iterator list<T>::PositionToInsert(
-    const list<T>::value_type &value, const list<T>::iterator &last_sorted) {
+template <typename T, template <class> class NodeAlloc>
+typename list<T, NodeAlloc>::iterator list<T, NodeAlloc>::PositionToInsert(
+    const list<T, NodeAlloc>::value_type &value,
+    const list<T, NodeAlloc>::iterator &last_sorted) {
   iterator pos;
   if (value > *last_sorted) {
     pos = last_sorted;
@@ -492,10 +572,11 @@ typename list<T>::iterator list<T>::PositionToInsert(
   return pos;
 }
 
-template <typename T>
+template <typename T, template <class> class NodeAlloc>
 template <typename... Args>
-typename list<T>::iterator list<T>::emplace(const_iterator pos,
-                                            Args &&...args) {
+typename list<T, NodeAlloc>::iterator list<T, NodeAlloc>::emplace(
+    const_iterator pos, Args &&...args) {
+  pos.iter_.p_node_ = MakeRoom(sizeof...(Args), pos.iter_.p_node_);
   list new_list;
   iterator before = pos.iter_;
   --before;
@@ -505,9 +586,9 @@ typename list<T>::iterator list<T>::emplace(const_iterator pos,
   return before;
 }
 
-template <typename T>
+template <typename T, template <class> class NodeAlloc>
 template <typename... Args>
-void list<T>::emplace_back(Args &&...args) {
+void list<T, NodeAlloc>::emplace_back(Args &&...args) {
   s21::vector<T> temp{args...};
   auto it = temp.begin();
   for (; it != temp.end(); ++it) {
@@ -515,9 +596,9 @@ void list<T>::emplace_back(Args &&...args) {
   }
 }
 
-template <typename T>
+template <typename T, template <class> class NodeAlloc>
 template <typename... Args>
-void list<T>::emplace_front(Args &&...args) {
+void list<T, NodeAlloc>::emplace_front(Args &&...args) {
   s21::vector<T> temp{args...};
   auto it = temp.begin();
   for (; it != temp.end(); ++it) {
@@ -525,8 +606,91 @@ void list<T>::emplace_front(Args &&...args) {
   }
 }
 
-template <typename T>
-typename list<T>::ListIterator &list<T>::ListIterator::operator++() {
+template <typename T, template <class> class NodeAlloc>
+typename list<T, NodeAlloc>::Node *list<T, NodeAlloc>::CreateNode(
+    const_reference value) {
+  Node *node = alloc_.Allocate();
+  try {
+    new (node) Node(value);
+  } catch (...) {
+    alloc_.Deallocate(node);
+    throw;
+  }
+  return node;
+}
+
+template <typename T, template <class> class NodeAlloc>
+void list<T, NodeAlloc>::DestroyNode(Node *node) noexcept {
+  node->~Node();
+  alloc_.Deallocate(node);
+}
+
+// The sentinel lives in the allocator when it keeps one, next to the nodes.
+// An empty pool has no header cell yet, Reserve sets it up.
+template <typename T, template <class> class NodeAlloc>
+typename list<T, NodeAlloc>::Node *list<T, NodeAlloc>::CreateFantome() {
+  if constexpr (node_allocator::kOwnsHeader) {
+    alloc_.Reserve(0);
+    return new (alloc_.Header()) Node();
+  } else {
+    return CreateNode(T());
+  }
+}
+
+template <typename T, template <class> class NodeAlloc>
+void list<T, NodeAlloc>::DestroyFantome() noexcept {
+  if constexpr (node_allocator::kOwnsHeader) {
+    p_fantome_->~Node();
+  } else {
+    DestroyNode(p_fantome_);
+  }
+}
+
+// Called before an insertion holds node pointers: makes room for count nodes
+// so that CreateNode cannot move them. If the pool has to grow now, the
+// list's own pointers and node (may be nullptr) are rebuilt from their
+// offsets to the header cell; returns the rebuilt node.
+template <typename T, template <class> class NodeAlloc>
+typename list<T, NodeAlloc>::Node *list<T, NodeAlloc>::MakeRoom(size_type count,
+                                                                Node *node) {
+  if constexpr (!node_allocator::kStableNodes) {
+    if (!alloc_.HasRoom(count)) {
+      std::ptrdiff_t head = HeaderOffset(alloc_, p_head_);
+      std::ptrdiff_t back = HeaderOffset(alloc_, p_back_);
+      std::ptrdiff_t at = HeaderOffset(alloc_, node);
+      alloc_.Reserve(count);
+      p_head_ = AtHeaderOffset(alloc_, head);
+      p_back_ = AtHeaderOffset(alloc_, back);
+      p_fantome_ = alloc_.Header();
+      node = AtHeaderOffset(alloc_, at);
+    }
+  }
+  return node;
+}
+
+template <typename T, template <class> class NodeAlloc>
+std::ptrdiff_t list<T, NodeAlloc>::HeaderOffset(const node_allocator &alloc,
+                                                const Node *node) {
+  if (node == nullptr) {
+    return -1;
+  }
+  return reinterpret_cast<const char *>(node) -
+         reinterpret_cast<const char *>(alloc.Header());
+}
+
+template <typename T, template <class> class NodeAlloc>
+typename list<T, NodeAlloc>::Node *list<T, NodeAlloc>::AtHeaderOffset(
+    const node_allocator &alloc, std::ptrdiff_t offset) {
+  if (offset < 0) {
+    return nullptr;
+  }
+  return reinterpret_cast<Node *>(reinterpret_cast<char *>(alloc.Header()) +
+                                  offset);
+}
+
+template <typename T, template <class> class NodeAlloc>
+typename list<T, NodeAlloc>::ListIterator &
+list<T, NodeAlloc>::ListIterator::operator++() {
   if (p_node_->p_next_ != nullptr) {
     p_node_ = p_node_->p_next_;
   } else {
@@ -537,14 +701,16 @@ typename list<T>::ListIterator &list<T>::ListIterator::operator++() {
   return *this;
 }
 
-template <typename T>
-typename list<T>::ListConstIterator &list<T>::ListConstIterator::operator++() {
+template <typename T, template <class> class NodeAlloc>
+typename list<T, NodeAlloc>::ListConstIterator &
+list<T, NodeAlloc>::ListConstIterator::operator++() {
   ++iter_;
   return *this;
 }
 
-template <typename T>
-typename list<T>::ListIterator &list<T>::ListIterator::operator--() {
+template <typename T, template <class> class NodeAlloc>
+typename list<T, NodeAlloc>::ListIterator &
+list<T, NodeAlloc>::ListIterator::operator--() {
   if (p_node_->p_prev_ != nullptr) {
     p_node_ = p_node_->p_prev_;
   } else {
@@ -555,62 +721,67 @@ typename list<T>::ListIterator &list<T>::ListIterator::operator--() {
   return *this;
 }
 
-template <typename T>
-typename list<T>::ListConstIterator &list<T>::ListConstIterator::operator--() {
+template <typename T, template <class> class NodeAlloc>
+typename list<T, NodeAlloc>::ListConstIterator &
+list<T, NodeAlloc>::ListConstIterator::operator--() {
   --iter_;
   return *this;
 }
 
-template <typename T>
-typename list<T>::ListIterator &list<T>::ListIterator::operator=(
-    const list<T>::ListIterator &other) {
+template <typename T, template <class> class NodeAlloc>
+typename list<T, NodeAlloc>::ListIterator &
+list<T, NodeAlloc>::ListIterator::operator=(
+    const list<T, NodeAlloc>::ListIterator &other) {
   p_node_ = other.p_node_;
   return *this;
 }
 
-template <typename T>
-typename list<T>::ListConstIterator &list<T>::ListConstIterator::operator=(
-    const list<T>::ListIterator &other) {
+template <typename T, template <class> class NodeAlloc>
+typename list<T, NodeAlloc>::ListConstIterator &
+list<T, NodeAlloc>::ListConstIterator::operator=(
+    const list<T, NodeAlloc>::ListIterator &other) {
   this->iter_ = other;
   return *this;
 }
 
-template <typename T>
-T &list<T>::ListIterator::operator*() const {
+template <typename T, template <class> class NodeAlloc>
+T &list<T, NodeAlloc>::ListIterator::operator*() const {
   return p_node_->data_;
 }
 
-template <typename T>
-bool list<T>::ListIterator::operator==(const list<T>::ListIterator &other) {
+template <typename T, template <class> class NodeAlloc>
+bool list<T, NodeAlloc>::ListIterator::operator==(
+    const list<T, NodeAlloc>::ListIterator &other) {
   return p_node_ == other.p_node_;
 }
 
-template <typename T>
-bool list<T>::ListConstIterator::operator==(
-    const list<T>::ListIterator &other) {
+template <typename T, template <class> class NodeAlloc>
+bool list<T, NodeAlloc>::ListConstIterator::operator==(
+    const list<T, NodeAlloc>::ListIterator &other) {
   return this->iter_ == other;
 }
 
-template <typename T>
-bool list<T>::ListConstIterator::operator==(
-    const list<T>::ListConstIterator &other) {
+template <typename T, template <class> class NodeAlloc>
+bool list<T, NodeAlloc>::ListConstIterator::operator==(
+    const list<T, NodeAlloc>::ListConstIterator &other) {
   return this->iter_ == other.iter_;
 }
 
-template <typename T>
-bool list<T>::ListIterator::operator!=(const list<T>::ListIterator &other) {
+template <typename T, template <class> class NodeAlloc>
+bool list<T, NodeAlloc>::ListIterator::operator!=(
+    const list<T, NodeAlloc>::ListIterator &other) {
   return p_node_ != other.p_node_;
 }
 
-template <typename T>
-bool list<T>::ListConstIterator::operator!=(
-    const list<T>::ListIterator &other) {
+template <typename T, template <class> class NodeAlloc>
+bool list<T, NodeAlloc>::ListConstIterator::operator!=(
+    const list<T, NodeAlloc>::ListIterator &other) {
   return this->iter_ != other;
 }
 
-template <typename T>
-bool list<T>::ListConstIterator::operator!=(
-    const list<T>::ListConstIterator &other) {
+template <typename T, template <class> class NodeAlloc>
+bool list<T, NodeAlloc>::ListConstIterator::operator!=(
+    const list<T, NodeAlloc>::ListConstIterator &other) {
   return this->iter_ != other.iter_;
 }
 
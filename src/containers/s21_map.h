@@ -6,8 +6,11 @@
 
 namespace s21 {
 
-template <typename Key, typename T>
-class Map : public RBTree<Key, T> {
+template <typename Key, typename T,
+          template <class> class NodeAlloc = HeapNodeAllocator,
+          class Augment = DefaultNodePolicy<NodeAlloc>,
+          class Compare = std::less<Key>>
+class Map : public RBTree<Key, T, NodeAlloc, Augment, Compare> {
  public:
   using key_type = Key;
   using mapped_type = T;
@@ -15,18 +18,26 @@ class Map : public RBTree<Key, T> {
   using value_type = std::pair<const key_type, mapped_type>;
   using reference = value_type &;
   using const_reference = const value_type &;
-  using iterator = typename s21::RBTree<key_type, mapped_type>::iterator;
-  using const_iterator =
-      typename s21::RBTree<key_type, mapped_type>::const_iterator;
+  using iterator = typename s21::RBTree<key_type, mapped_type, NodeAlloc,
+                                        Augment, Compare>::iterator;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_iterator = typename s21::RBTree<key_type, mapped_type, NodeAlloc,
+                                              Augment, Compare>::const_iterator;
   using allocator_type = std::allocator<value_type>;
+  using key_compare = Compare;
+  using node_type = typename s21::RBTree<key_type, mapped_type, NodeAlloc,
+                                         Augment, Compare>::node_type;
 
   Map();
+  explicit Map(const key_compare &compare);
   explicit Map(std::initializer_list<value_type> const &items);
+  template <typename ForwardIt>
+  Map(ForwardIt first, ForwardIt last);
   Map(const Map &other);
   Map(Map &&other) noexcept;
   ~Map();
-  Map<key_type, mapped_type> &operator=(
-      Map<key_type, mapped_type> &&other) noexcept;
+  Map<key_type, mapped_type, NodeAlloc, Augment, Compare> &operator=(
+      Map<key_type, mapped_type, NodeAlloc, Augment, Compare> &&other) noexcept;
 
   size_type size() const;
   size_type max_size();
@@ -36,120 +47,422 @@ class Map : public RBTree<Key, T> {
   bool empty() const;
 
   allocator_type get_allocator() const;
+  key_compare key_comp() const;
 
   mapped_type &at(const key_type &key) const;
   mapped_type &operator[](const key_type &key);
+  mapped_type &operator[](key_type &&key);
 
   void erase(iterator it);
+  // Range erase and visit in O(log n + k) for k elements; the key ranges
+  // are [lo, hi). fn is called with the key and the value of each element.
+  iterator erase(iterator first, iterator last);
+  size_type erase_range(const key_type &lo, const key_type &hi);
+  template <typename Fn>
+  void for_each_in_range(const key_type &lo, const key_type &hi, Fn fn) const;
+  node_type extract(iterator it);
+  node_type extract(const key_type &key);
   bool contains(const key_type &key) const;
   iterator find(const key_type &key) const;
 
   iterator begin() const;
   iterator end() const;
+  reverse_iterator rbegin() const;
+  reverse_iterator rend() const;
   iterator lower_bound(const key_type &val) const;
   iterator upper_bound(const key_type &val) const;
-  std::pair<typename Map<key_type, mapped_type>::iterator,
-            typename Map<key_type, mapped_type>::iterator>
+  std::pair<typename Map<key_type, mapped_type, NodeAlloc, Augment,
+                         Compare>::iterator,
+            typename Map<key_type, mapped_type, NodeAlloc, Augment,
+                         Compare>::iterator>
   equal_range(const key_type &key) const;
 
+  // Lookups by any type the comparator orders against key_type, without
+  // building a key; only with a comparator that defines is_transparent
+  template <typename K, typename C = Compare,
+            typename = typename C::is_transparent>
+  iterator find(const K &key) const;
+  template <typename K, typename C = Compare,
+            typename = typename C::is_transparent>
+  bool contains(const K &key) const;
+  template <typename K, typename C = Compare,
+            typename = typename C::is_transparent>
+  size_type count(const K &key) const;
+  template <typename K, typename C = Compare,
+            typename = typename C::is_transparent>
+  iterator lower_bound(const K &key) const;
+  template <typename K, typename C = Compare,
+            typename = typename C::is_transparent>
+  iterator upper_bound(const K &key) const;
+  template <typename K, typename C = Compare,
+            typename = typename C::is_transparent>
+  std::pair<iterator, iterator> equal_range(const K &key) const;
+
+  // Batched lookups for many keys at once: the descents run interleaved so
+  // their cache misses overlap. One result per key of [first, last) goes to
+  // out, find_batch writes iterators (end() on a miss) and contains_batch
+  // bools; both return the end of the output.
+  template <typename ForwardIt, typename OutputIt>
+  OutputIt find_batch(ForwardIt first, ForwardIt last, OutputIt out) const;
+  template <typename ForwardIt, typename OutputIt>
+  OutputIt contains_batch(ForwardIt first, ForwardIt last, OutputIt out) const;
+
+  // Order statistics, O(log n); need the OrderStatistic node policy
+  size_type rank(const key_type &key) const;
+  iterator select(size_type k) const;
+  size_type count_range(const key_type &lo, const key_type &hi) const;
+
+  // Monoid aggregate of the values with a key in [lo, hi), O(log n); needs a
+  // SubtreeAggregate node policy. Values written in place through
+  // operator[], at() or an iterator need a refresh of their element before
+  // the next aggregate; insert_or_assign refreshes by itself.
+  auto aggregate(const key_type &lo, const key_type &hi) const;
+  void refresh(iterator it);
+
   std::pair<iterator, bool> insert(const_reference value);
+  std::pair<iterator, bool> insert(value_type &&value);
   std::pair<iterator, bool> insert(const key_type &key,
                                    const mapped_type &value);
-  std::pair<iterator, bool> insert_or_assign(const key_type &key,
-                                             const mapped_type &value);
+  iterator insert(iterator hint, const_reference value);
+  iterator insert(iterator hint, value_type &&value);
+  std::pair<iterator, bool> insert(node_type &&node);
+  template <typename M>
+  std::pair<iterator, bool> insert_or_assign(const key_type &key, M &&value);
+  template <typename M>
+  std::pair<iterator, bool> insert_or_assign(key_type &&key, M &&value);
+
+  // Build the value in the node from args if key is missing; nothing is
+  // moved from key or args otherwise
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(const key_type &key, Args &&...args);
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(key_type &&key, Args &&...args);
+  // Builds the key and the value in the node from the two argument tuples
+  template <typename... KeyArgs, typename... ValueArgs>
+  std::pair<iterator, bool> emplace(std::piecewise_construct_t,
+                                    std::tuple<KeyArgs...> key_args,
+                                    std::tuple<ValueArgs...> value_args);
 
   void merge(Map &other);
+  void merge(Map &other, ThreadPool &pool);
+
+  // Algebra of whole maps in O(m log(n / m + 1)) for m <= n elements.
+  // The operands are consumed: pass them with std::move to reuse their
+  // nodes instead of copying them. With a pool, large operands are combined
+  // on its threads. Keys found in both maps keep the value
+  // of lhs. Balancing policies other than red-black merge into a copy in
+  // O(n + m).
+  friend Map set_union(Map lhs, Map rhs, ThreadPool *pool = nullptr) {
+    lhs.Combine(rhs, SetOperation::Union, pool);
+    return lhs;
+  }
+  friend Map set_intersection(Map lhs, Map rhs, ThreadPool *pool = nullptr) {
+    lhs.Combine(rhs, SetOperation::Intersection, pool);
+    return lhs;
+  }
+  friend Map set_difference(Map lhs, Map rhs, ThreadPool *pool = nullptr) {
+    lhs.Combine(rhs, SetOperation::Difference, pool);
+    return lhs;
+  }
+  friend Map set_symmetric_difference(Map lhs, Map rhs,
+                                      ThreadPool *pool = nullptr) {
+    lhs.Combine(rhs, SetOperation::SymmetricDifference, pool);
+    return lhs;
+  }
+
+  class cursor;
+
+  template <typename ForwardIt>
+  void assign_sorted(ForwardIt first, ForwardIt last);
   template <typename... Args>
   s21::vector<std::pair<iterator, bool>> emplace(Args &&...args);
+  template <typename... Args>
+  iterator emplace_hint(iterator hint, Args &&...args);
 
  private:
-  RBTree<key_type, mapped_type> tree_;
+  RBTree<key_type, mapped_type, NodeAlloc, Augment, Compare> tree_;
   size_type size_{};
-  using s21::RBTree<key_type, mapped_type>::root_;
+
+  void Combine(Map &other, SetOperation op, ThreadPool *pool);
+
+  template <typename Pair>
+  struct IsPair : std::false_type {};
+  template <typename First, typename Second>
+  struct IsPair<std::pair<First, Second>> : std::true_type {};
+
+  // Calls emplace with the node constructor arguments for one element: a
+  // single pair is split into its key and its value, a single argument of
+  // another type is converted to value_type first
+  template <typename Emplace, typename... Args>
+  static auto EmplaceSplit(Emplace emplace, Args &&...args);
 };
 
-template <typename key_type, typename mapped_type>
-Map<key_type, mapped_type>::Map() : tree_{}, size_{} {}
+// Finger into a map for lookups that land near the previous one. A cursor
+// remembers the element its last call reached and starts the next search
+// there, climbing only as far as the key needs: O(log d) for most keys d
+// elements away instead of O(log n). Searches through the map itself are
+// unaffected. The cursor follows the rules of an iterator to the finger:
+// erasing that element, clear() or swap() invalidate it until reset().
+template <typename Key, typename T, template <class> class NodeAlloc,
+          class Augment, class Compare>
+class Map<Key, T, NodeAlloc, Augment, Compare>::cursor {
+ public:
+  explicit cursor(Map &map) : map_(&map), finger_(map.tree_.End()) {}
 
-template <typename key_type, typename mapped_type>
-Map<key_type, mapped_type>::Map(std::initializer_list<value_type> const &items)
-    : tree_{}, size_{} {
-  for (const auto &item : items) {
-    insert(item);
+  iterator find(const key_type &key) {
+    iterator it = lower_bound(key);
+    return it != map_->end() && !map_->key_comp()(key, it->key) ? it
+                                                                : map_->end();
+  }
+  iterator lower_bound(const key_type &key) {
+    Node<key_type, mapped_type, Augment> *node =
+        map_->tree_.LowerBoundFrom(finger_, key);
+    if (node != map_->tree_.End()) {
+      finger_ = node;
+    }
+    return iterator(node);
+  }
+  std::pair<iterator, bool> insert(const key_type &key,
+                                   const mapped_type &value) {
+    auto [node, inserted] = map_->tree_.InsertUniqueFrom(finger_, key, value);
+    if (inserted) {
+      ++map_->size_;
+    }
+    finger_ = node;
+    return std::make_pair(iterator(node), inserted);
   }
+  std::pair<iterator, bool> insert(const_reference value) {
+    return insert(value.first, value.second);
+  }
+
+  // The element the next search starts from, end() before the first one
+  iterator position() const { return iterator(finger_); }
+  void reset() { finger_ = map_->tree_.End(); }
+
+ private:
+  Map *map_;
+  Node<key_type, mapped_type, Augment> *finger_;
+};
+
+template <typename key_type, typename mapped_type,
+          template <class> class NodeAlloc, class Augment, class Compare>
+Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::Map()
+    : tree_{}, size_{} {}
+
+template <typename key_type, typename mapped_type,
+          template <class> class NodeAlloc, class Augment, class Compare>
+Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::Map(
+    const key_compare &compare)
+    : RBTree<key_type, mapped_type, NodeAlloc, Augment, Compare>(compare),
+      tree_(compare),
+      size_{} {}
+
+template <typename key_type, typename mapped_type,
+          template <class> class NodeAlloc, class Augment, class Compare>
+Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::Map(
+    std::initializer_list<value_type> const &items)
+    : Map(items.begin(), items.end()) {}
+
+// Sorted ranges are linked in O(n), other ranges are sorted first. The
+// first of several equal keys wins, as with repeated insert().
+template <typename key_type, typename mapped_type,
+          template <class> class NodeAlloc, class Augment, class Compare>
+template <typename ForwardIt>
+Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::Map(ForwardIt first,
+                                                             ForwardIt last)
+    : tree_{}, size_{} {
+  size_ = tree_.Assign(first, last, true);
 }
 
-template <typename key_type, typename mapped_type>
-Map<key_type, mapped_type>::Map(const Map<key_type, mapped_type> &other) {
-  for (const auto &pair : other) {
-    insert(pair.key, pair.value);
-  }
+template <typename key_type, typename mapped_type,
+          template <class> class NodeAlloc, class Augment, class Compare>
+Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::Map(
+    const Map<key_type, mapped_type, NodeAlloc, Augment, Compare> &other)
+    : RBTree<key_type, mapped_type, NodeAlloc, Augment, Compare>(
+          other.tree_.KeyCompare()),
+      tree_(other.tree_.KeyCompare()) {
+  tree_.Clone(other.tree_);
+  size_ = other.size_;
 }
 
-template <typename key_type, typename mapped_type>
-Map<key_type, mapped_type>::Map(Map<key_type, mapped_type> &&other) noexcept {
+template <typename key_type, typename mapped_type,
+          template <class> class NodeAlloc, class Augment, class Compare>
+Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::Map(
+    Map<key_type, mapped_type, NodeAlloc, Augment, Compare> &&other) noexcept
+    : RBTree<key_type, mapped_type, NodeAlloc, Augment, Compare>(
+          other.tree_.KeyCompare()),
+      tree_(other.tree_.KeyCompare()) {
   clear();
   swap(other);
 }
 
-template <typename key_type, typename mapped_type>
-Map<key_type, mapped_type> &Map<key_type, mapped_type>::operator=(
-    Map<key_type, mapped_type> &&other) noexcept {
+template <typename key_type, typename mapped_type,
+          template <class> class NodeAlloc, class Augment, class Compare>
+Map<key_type, mapped_type, NodeAlloc, Augment, Compare> &
+Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::operator=(
+    Map<key_type, mapped_type, NodeAlloc, Augment, Compare> &&other) noexcept {
   clear();
   swap(other);
   return *this;
 }
 
-template <typename key_type, typename mapped_type>
-Map<key_type, mapped_type>::~Map() {}
+template <typename key_type, typename mapped_type,
+          template <class> class NodeAlloc, class Augment, class Compare>
+Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::~Map() {}
+
+template <typename key_type, typename mapped_type,
+          template <class> class NodeAlloc, class Augment, class Compare>
+std::pair<
+    typename Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::iterator,
+    bool>
+Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::insert(
+    const_reference value) {
+  return insert(value.first, value.second);
+}
+
+// The key of a value_type is const and gets copied, the value is moved
+template <typename key_type, typename mapped_type,
+          template <class> class NodeAlloc, class Augment, class Compare>
+std::pair<
+    typename Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::iterator,
+    bool>
+Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::insert(
+    value_type &&value) {
+  return try_emplace(value.first, std::move(value.second));
+}
 
-template <typename key_type, typename mapped_type>
-std::pair<typename Map<key_type, mapped_type>::iterator, bool>
-Map<key_type, mapped_type>::insert(const_reference value) {
-  std::pair<iterator, bool> result;
-  value_type item{value};
-  if (!contains(item.first)) {
-    tree_.Insert(item.first, item.second);
-    result.second = true;
+template <typename key_type, typename mapped_type,
+          template <class> class NodeAlloc, class Augment, class Compare>
+std::pair<
+    typename Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::iterator,
+    bool>
+Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::insert(
+    const key_type &key, const mapped_type &value) {
+  auto [node, inserted] = tree_.InsertUnique(key, value);
+  if (inserted) {
     ++size_;
-  } else {
-    result.second = false;
   }
-  result.first = find(item.first);
-  return result;
+  return std::make_pair(iterator(node), inserted);
 }
 
-template <class key_type, class mapped_type>
-std::pair<typename Map<key_type, mapped_type>::iterator, bool>
-Map<key_type, mapped_type>::insert(const key_type &key,
-                                   const mapped_type &value) {
-  std::pair<iterator, bool> result;
-  if (!contains(key)) {
-    tree_.Insert(key, value);
+// Amortized O(1) when value belongs right before hint
+template <typename key_type, typename mapped_type,
+          template <class> class NodeAlloc, class Augment, class Compare>
+typename Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::iterator
+Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::insert(
+    iterator hint, const_reference value) {
+  auto [node, inserted] =
+      tree_.InsertUniqueHint(hint.current(), value.first, value.second);
+  if (inserted) {
     ++size_;
-    result.second = true;
-  } else {
-    result.second = false;
   }
-  result.first = find(key);
+  return iterator(node);
+}
+
+template <typename key_type, typename mapped_type,
+          template <class> class NodeAlloc, class Augment, class Compare>
+typename Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::iterator
+Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::insert(
+    iterator hint, value_type &&value) {
+  auto [node, inserted] = tree_.InsertUniqueHint(hint.current(), value.first,
+                                                 std::move(value.second));
+  if (inserted) {
+    ++size_;
+  }
+  return iterator(node);
+}
+
+template <typename key_type, typename mapped_type,
+          template <class> class NodeAlloc, class Augment, class Compare>
+template <typename M>
+std::pair<
+    typename Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::iterator,
+    bool>
+Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::insert_or_assign(
+    const key_type &key, M &&value) {
+  // try_emplace leaves value alone unless it inserts
+  auto result = try_emplace(key, std::forward<M>(value));
+  if (!result.second) {
+    result.first->value = std::forward<M>(value);
+    if constexpr (Augment::kAggregate) {
+      tree_.Refresh(result.first.current());
+    }
+  }
   return result;
 }
 
-template <typename key_type, typename mapped_type>
-std::pair<typename Map<key_type, mapped_type>::iterator, bool>
-Map<key_type, mapped_type>::insert_or_assign(const key_type &key,
-                                             const mapped_type &value) {
-  if (contains(key)) {
-    at(key) = value;
-    return std::make_pair(find(key), false);
-  } else {
-    insert(std::make_pair(key, value));
-    return std::make_pair(find(key), true);
+template <typename key_type, typename mapped_type,
+          template <class> class NodeAlloc, class Augment, class Compare>
+template <typename M>
+std::pair<
+    typename Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::iterator,
+    bool>
+Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::insert_or_assign(
+    key_type &&key, M &&value) {
+  auto result = try_emplace(std::move(key), std::forward<M>(value));
+  if (!result.second) {
+    result.first->value = std::forward<M>(value);
+    if constexpr (Augment::kAggregate) {
+      tree_.Refresh(result.first.current());
+    }
   }
+  return result;
 }
 
-template <typename key_type, typename mapped_type>
-void Map<key_type, mapped_type>::erase(iterator it) {
+template <typename key_type, typename mapped_type,
+          template <class> class NodeAlloc, class Augment, class Compare>
+template <typename... Args>
+std::pair<
+    typename Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::iterator,
+    bool>
+Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::try_emplace(
+    const key_type &key, Args &&...args) {
+  auto [node, inserted] = tree_.InsertUnique(key, std::forward<Args>(args)...);
+  if (inserted) {
+    ++size_;
+  }
+  return std::make_pair(iterator(node), inserted);
+}
+
+template <typename key_type, typename mapped_type,
+          template <class> class NodeAlloc, class Augment, class Compare>
+template <typename... Args>
+std::pair<
+    typename Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::iterator,
+    bool>
+Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::try_emplace(
+    key_type &&key, Args &&...args) {
+  auto [node, inserted] =
+      tree_.InsertUnique(std::move(key), std::forward<Args>(args)...);
+  if (inserted) {
+    ++size_;
+  }
+  return std::make_pair(iterator(node), inserted);
+}
+
+// The key is only known once the node is built: a node with a key already
+// present is destroyed again
+template <typename key_type, typename mapped_type,
+          template <class> class NodeAlloc, class Augment, class Compare>
+template <typename... KeyArgs, typename... ValueArgs>
+std::pair<
+    typename Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::iterator,
+    bool>
+Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::emplace(
+    std::piecewise_construct_t, std::tuple<KeyArgs...> key_args,
+    std::tuple<ValueArgs...> value_args) {
+  auto [node, inserted] = tree_.EmplaceUnique(
+      std::piecewise_construct, std::move(key_args), std::move(value_args));
+  if (inserted) {
+    ++size_;
+  }
+  return std::make_pair(iterator(node), inserted);
+}
+
+template <typename key_type, typename mapped_type,
+          template <class> class NodeAlloc, class Augment, class Compare>
+void Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::erase(
+    iterator it) {
   if (it != end()) {
     tree_.Erase(it.current());
     --size_;
@@ -158,90 +471,182 @@ void Map<key_type, mapped_type>::erase(iterator it) {
   }
 }
 
-template <typename key_type, typename mapped_type>
-typename Map<key_type, mapped_type>::iterator Map<key_type, mapped_type>::find(
-    const key_type &key) const {
-  Node<key_type, mapped_type> *current = tree_.GetRoot();
-  while (current) {
-    if (current->key == key) {
-      return iterator(current);
-    } else if (current->key < key) {
-      current = current->right;
-    } else {
-      current = current->left;
-    }
-  }
-  return end();
+// Returns last, which stays valid
+template <typename key_type, typename mapped_type,
+          template <class> class NodeAlloc, class Augment, class Compare>
+typename Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::iterator
+Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::erase(iterator first,
+                                                               iterator last) {
+  size_ -= tree_.EraseRange(first.current(), last.current());
+  return last;
 }
 
-template <typename key_type, typename mapped_type>
-bool Map<key_type, mapped_type>::contains(const key_type &key) const {
-  return tree_.Contains(key);
+template <typename key_type, typename mapped_type,
+          template <class> class NodeAlloc, class Augment, class Compare>
+typename Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::size_type
+Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::erase_range(
+    const key_type &lo, const key_type &hi) {
+  std::size_t erased = tree_.EraseKeyRange(lo, hi);
+  size_ -= erased;
+  return erased;
 }
 
-template <typename key_type, typename mapped_type>
-typename Map<key_type, mapped_type>::iterator
-Map<key_type, mapped_type>::begin() const {
-  if (tree_.GetRoot() == nullptr) {
-    return iterator(tree_.GetRoot());
+template <typename key_type, typename mapped_type,
+          template <class> class NodeAlloc, class Augment, class Compare>
+template <typename Fn>
+void Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::for_each_in_range(
+    const key_type &lo, const key_type &hi, Fn fn) const {
+  tree_.ForEachInRange(lo, hi,
+                       [&fn](Node<key_type, mapped_type, Augment> &node) {
+                         fn(node.key, node.value);
+                       });
+}
+
+template <typename key_type, typename mapped_type,
+          template <class> class NodeAlloc, class Augment, class Compare>
+typename Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::node_type
+Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::extract(iterator it) {
+  if (it == end()) {
+    throw std::out_of_range(
+        "The element to be extracted does not exist in Map");
   }
-  Node<key_type, mapped_type> *leftmost = tree_.GetRoot();
-  while (leftmost->left != nullptr) {
-    leftmost = leftmost->left;
+  --size_;
+  return tree_.Extract(it.current());
+}
+
+// Empty handle if there is no such key
+template <typename key_type, typename mapped_type,
+          template <class> class NodeAlloc, class Augment, class Compare>
+typename Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::node_type
+Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::extract(
+    const key_type &key) {
+  iterator it = find(key);
+  return it != end() ? extract(it) : node_type();
+}
+
+// Links the node of an extracted element without copying it. If the key is
+// already present the node stays in node.
+template <typename key_type, typename mapped_type,
+          template <class> class NodeAlloc, class Augment, class Compare>
+std::pair<
+    typename Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::iterator,
+    bool>
+Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::insert(
+    node_type &&node) {
+  auto [here, inserted] = tree_.InsertNodeUnique(node);
+  if (inserted) {
+    ++size_;
   }
+  return std::make_pair(iterator(here), inserted);
+}
+
+template <typename key_type, typename mapped_type,
+          template <class> class NodeAlloc, class Augment, class Compare>
+typename Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::iterator
+Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::find(
+    const key_type &key) const {
+  return iterator(tree_.FindKey(key));
+}
+
+template <typename key_type, typename mapped_type,
+          template <class> class NodeAlloc, class Augment, class Compare>
+bool Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::contains(
+    const key_type &key) const {
+  return tree_.Contains(key);
+}
+
+template <typename key_type, typename mapped_type,
+          template <class> class NodeAlloc, class Augment, class Compare>
+typename Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::iterator
+Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::begin() const {
+  return iterator(tree_.Begin());
+}
+
+template <typename key_type, typename mapped_type,
+          template <class> class NodeAlloc, class Augment, class Compare>
+typename Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::iterator
+Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::end() const {
+  return iterator(tree_.End());
+}
 
-  return iterator(leftmost);
+// O(1): the header caches the rightmost node
+template <typename key_type, typename mapped_type,
+          template <class> class NodeAlloc, class Augment, class Compare>
+typename Map<key_type, mapped_type, NodeAlloc, Augment,
+             Compare>::reverse_iterator
+Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::rbegin() const {
+  return reverse_iterator(end());
 }
 
-template <typename key_type, typename mapped_type>
-typename Map<key_type, mapped_type>::iterator Map<key_type, mapped_type>::end()
-    const {
-  return iterator(nullptr);
+template <typename key_type, typename mapped_type,
+          template <class> class NodeAlloc, class Augment, class Compare>
+typename Map<key_type, mapped_type, NodeAlloc, Augment,
+             Compare>::reverse_iterator
+Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::rend() const {
+  return reverse_iterator(begin());
 }
 
-template <typename key_type, typename mapped_type>
-typename Map<key_type, mapped_type>::allocator_type
-Map<key_type, mapped_type>::get_allocator() const {
+template <typename key_type, typename mapped_type,
+          template <class> class NodeAlloc, class Augment, class Compare>
+typename Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::allocator_type
+Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::get_allocator() const {
   return allocator_type();
 }
 
-template <typename key_type, typename mapped_type>
-typename Map<key_type, mapped_type>::size_type
-Map<key_type, mapped_type>::count(const key_type &key) const {
+template <typename key_type, typename mapped_type,
+          template <class> class NodeAlloc, class Augment, class Compare>
+typename Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::key_compare
+Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::key_comp() const {
+  return tree_.KeyCompare();
+}
+
+template <typename key_type, typename mapped_type,
+          template <class> class NodeAlloc, class Augment, class Compare>
+typename Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::size_type
+Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::count(
+    const key_type &key) const {
   return find(key) != end() ? 1 : 0;
 }
 
-template <typename key_type, typename mapped_type>
-typename Map<key_type, mapped_type>::size_type
-Map<key_type, mapped_type>::size() const {
+template <typename key_type, typename mapped_type,
+          template <class> class NodeAlloc, class Augment, class Compare>
+typename Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::size_type
+Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::size() const {
   return size_;
 }
 
-template <class key_type, class mapped_type>
-std::size_t Map<key_type, mapped_type>::max_size() {
-  return SIZE_MAX / (sizeof(Node<key_type, mapped_type>) * 2);
+template <class key_type, class mapped_type, template <class> class NodeAlloc,
+          class Augment, class Compare>
+std::size_t
+Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::max_size() {
+  return SIZE_MAX / (sizeof(Node<key_type, mapped_type, Augment>) * 2);
 }
 
-template <typename key_type, typename mapped_type>
-bool Map<key_type, mapped_type>::empty() const {
+template <typename key_type, typename mapped_type,
+          template <class> class NodeAlloc, class Augment, class Compare>
+bool Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::empty() const {
   return size_ == 0;
 }
 
-template <typename key_type, typename mapped_type>
-void Map<key_type, mapped_type>::clear() {
-  s21::RBTree<key_type, mapped_type>::DeleteTree(root_);
+template <typename key_type, typename mapped_type,
+          template <class> class NodeAlloc, class Augment, class Compare>
+void Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::clear() {
+  tree_.Clear();
   size_ = 0;
-  root_ = nullptr;
 }
 
-template <typename key_type, typename mapped_type>
-void Map<key_type, mapped_type>::swap(Map<key_type, mapped_type> &other) {
+template <typename key_type, typename mapped_type,
+          template <class> class NodeAlloc, class Augment, class Compare>
+void Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::swap(
+    Map<key_type, mapped_type, NodeAlloc, Augment, Compare> &other) {
   std::swap(size_, other.size_);
   tree_.swap(other.tree_);
 }
 
-template <typename key_type, typename mapped_type>
-mapped_type &Map<key_type, mapped_type>::at(const key_type &key) const {
+template <typename key_type, typename mapped_type,
+          template <class> class NodeAlloc, class Augment, class Compare>
+mapped_type &Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::at(
+    const key_type &key) const {
   auto it = find(key);
   if (it == end()) {
     throw std::out_of_range("key not found in Map");
@@ -249,74 +654,277 @@ mapped_type &Map<key_type, mapped_type>::at(const key_type &key) const {
   return it->value;
 }
 
-template <typename key_type, typename mapped_type>
-mapped_type &Map<key_type, mapped_type>::operator[](const key_type &key) {
-  if (contains(key)) {
-    return at(key);
-  } else {
-    auto [it, inserted] = insert(std::make_pair(key, mapped_type{}));
-    return it->value;
+template <typename key_type, typename mapped_type,
+          template <class> class NodeAlloc, class Augment, class Compare>
+mapped_type &Map<key_type, mapped_type, NodeAlloc, Augment,
+                 Compare>::operator[](const key_type &key) {
+  auto [node, inserted] = tree_.InsertUnique(key);
+  if (inserted) {
+    ++size_;
   }
+  return node->value;
 }
 
-template <class key_type, class mapped_type>
-void Map<key_type, mapped_type>::merge(Map<key_type, mapped_type> &other) {
-  iterator it_begin = other.begin();
-  iterator it_end = other.end();
-  while (it_begin != it_end) {
-    if (!contains(it_begin.current()->key)) {
-      insert(it_begin.current()->key, it_begin.current()->value);
-    } else {
-      at(it_begin.current()->key) = it_begin.current()->value;
-    }
-    ++it_begin;
+template <typename key_type, typename mapped_type,
+          template <class> class NodeAlloc, class Augment, class Compare>
+mapped_type &Map<key_type, mapped_type, NodeAlloc, Augment,
+                 Compare>::operator[](key_type &&key) {
+  auto [node, inserted] = tree_.InsertUnique(std::move(key));
+  if (inserted) {
+    ++size_;
   }
-  other.clear();
+  return node->value;
 }
 
-template <typename key_type, typename mapped_type>
-typename Map<key_type, mapped_type>::iterator
-Map<key_type, mapped_type>::lower_bound(const key_type &val) const {
-  auto it = begin();
-  while (it != end() && it->key < val) {
-    ++it;
+template <typename key_type, typename mapped_type,
+          template <class> class NodeAlloc, class Augment, class Compare>
+void Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::merge(
+    Map<key_type, mapped_type, NodeAlloc, Augment, Compare> &other) {
+  if (this == &other) {
+    return;
   }
-  return it;
+  // Values of other win for equal keys. The nodes of other are relinked,
+  // not copied, unless the allocator keeps them.
+  size_ += tree_.Merge(other.tree_, MergeEqual::TakeTheirs, size_, other.size_);
+  other.size_ = 0;
 }
 
-template <typename key_type, typename mapped_type>
-typename Map<key_type, mapped_type>::iterator
-Map<key_type, mapped_type>::upper_bound(const key_type &val) const {
-  auto it = begin();
-  while (it != end() && it->key <= val) {
-    ++it;
+// Merge as a split/join union on the threads of pool. The trees trade places
+// first, so the union keeps the values of other for equal keys.
+template <typename key_type, typename mapped_type,
+          template <class> class NodeAlloc, class Augment, class Compare>
+void Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::merge(
+    Map<key_type, mapped_type, NodeAlloc, Augment, Compare> &other,
+    ThreadPool &pool) {
+  if (this == &other) {
+    return;
   }
-  return it;
+  swap(other);
+  Combine(other, SetOperation::Union, &pool);
+}
+
+template <typename key_type, typename mapped_type,
+          template <class> class NodeAlloc, class Augment, class Compare>
+void Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::Combine(
+    Map<key_type, mapped_type, NodeAlloc, Augment, Compare> &other,
+    SetOperation op, ThreadPool *pool) {
+  size_ = size_ + other.size_ - tree_.Combine(other.tree_, op, true, pool);
+  other.size_ = 0;
+}
+
+template <typename key_type, typename mapped_type,
+          template <class> class NodeAlloc, class Augment, class Compare>
+typename Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::iterator
+Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::lower_bound(
+    const key_type &val) const {
+  return iterator(tree_.LowerBound(val));
+}
+
+template <typename key_type, typename mapped_type,
+          template <class> class NodeAlloc, class Augment, class Compare>
+typename Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::iterator
+Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::upper_bound(
+    const key_type &val) const {
+  return iterator(tree_.UpperBound(val));
+}
+
+template <typename key_type, typename mapped_type,
+          template <class> class NodeAlloc, class Augment, class Compare>
+std::pair<
+    typename Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::iterator,
+    typename Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::iterator>
+Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::equal_range(
+    const key_type &key) const {
+  auto [lower, upper] = tree_.EqualRange(key);
+  return std::make_pair(iterator(lower), iterator(upper));
+}
+
+template <typename key_type, typename mapped_type,
+          template <class> class NodeAlloc, class Augment, class Compare>
+template <typename K, typename C, typename>
+typename Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::iterator
+Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::find(
+    const K &key) const {
+  return iterator(tree_.FindKey(key));
+}
+
+template <typename key_type, typename mapped_type,
+          template <class> class NodeAlloc, class Augment, class Compare>
+template <typename K, typename C, typename>
+bool Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::contains(
+    const K &key) const {
+  return tree_.Contains(key);
 }
 
-template <typename key_type, typename mapped_type>
-std::pair<typename Map<key_type, mapped_type>::iterator,
-          typename Map<key_type, mapped_type>::iterator>
-Map<key_type, mapped_type>::equal_range(const key_type &key) const {
-  iterator lower = lower_bound(key);
-  iterator upper = upper_bound(key);
-  return std::make_pair(lower, upper);
+template <typename key_type, typename mapped_type,
+          template <class> class NodeAlloc, class Augment, class Compare>
+template <typename K, typename C, typename>
+typename Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::size_type
+Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::count(
+    const K &key) const {
+  return contains(key) ? 1 : 0;
 }
 
-template <class key_type, class mapped_type>
+template <typename key_type, typename mapped_type,
+          template <class> class NodeAlloc, class Augment, class Compare>
+template <typename K, typename C, typename>
+typename Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::iterator
+Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::lower_bound(
+    const K &key) const {
+  return iterator(tree_.LowerBound(key));
+}
+
+template <typename key_type, typename mapped_type,
+          template <class> class NodeAlloc, class Augment, class Compare>
+template <typename K, typename C, typename>
+typename Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::iterator
+Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::upper_bound(
+    const K &key) const {
+  return iterator(tree_.UpperBound(key));
+}
+
+template <typename key_type, typename mapped_type,
+          template <class> class NodeAlloc, class Augment, class Compare>
+template <typename K, typename C, typename>
+std::pair<
+    typename Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::iterator,
+    typename Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::iterator>
+Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::equal_range(
+    const K &key) const {
+  auto [lower, upper] = tree_.EqualRange(key);
+  return std::make_pair(iterator(lower), iterator(upper));
+}
+
+template <typename key_type, typename mapped_type,
+          template <class> class NodeAlloc, class Augment, class Compare>
+template <typename ForwardIt, typename OutputIt>
+OutputIt Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::find_batch(
+    ForwardIt first, ForwardIt last, OutputIt out) const {
+  tree_.FindBatch(first, last, [&out](auto *node) { *out++ = iterator(node); });
+  return out;
+}
+
+template <typename key_type, typename mapped_type,
+          template <class> class NodeAlloc, class Augment, class Compare>
+template <typename ForwardIt, typename OutputIt>
+OutputIt Map<key_type, mapped_type, NodeAlloc, Augment,
+             Compare>::contains_batch(ForwardIt first, ForwardIt last,
+                                      OutputIt out) const {
+  tree_.FindBatch(first, last,
+                  [this, &out](auto *node) { *out++ = node != tree_.End(); });
+  return out;
+}
+
+template <class key_type, class mapped_type, template <class> class NodeAlloc,
+          class Augment, class Compare>
 template <class... Args>
-s21::vector<std::pair<typename Map<key_type, mapped_type>::iterator, bool>>
-Map<key_type, mapped_type>::emplace(Args &&...args) {
-  std::initializer_list<value_type> argsVector{std::forward<Args>(args)...};
+s21::vector<std::pair<
+    typename Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::iterator,
+    bool>>
+Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::emplace(
+    Args &&...args) {
   s21::vector<std::pair<iterator, bool>> result;
-  std::pair<iterator, bool> element;
-  for (value_type value : argsVector) {
-    element = insert(value);
-    result.push_back(element);
-  }
+  [[maybe_unused]] auto emplace_one = [this](auto &&...parts) {
+    auto [node, inserted] =
+        tree_.EmplaceUnique(std::forward<decltype(parts)>(parts)...);
+    if (inserted) {
+      ++size_;
+    }
+    return std::make_pair(iterator(node), inserted);
+  };
+  (result.push_back(EmplaceSplit(emplace_one, std::forward<Args>(args))), ...);
   return result;
 }
 
+template <typename key_type, typename mapped_type,
+          template <class> class NodeAlloc, class Augment, class Compare>
+template <typename... Args>
+typename Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::iterator
+Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::emplace_hint(
+    iterator hint, Args &&...args) {
+  auto emplace_one = [this, &hint](auto &&...parts) {
+    auto [node, inserted] = tree_.EmplaceUniqueHint(
+        hint.current(), std::forward<decltype(parts)>(parts)...);
+    if (inserted) {
+      ++size_;
+    }
+    return iterator(node);
+  };
+  return EmplaceSplit(emplace_one, std::forward<Args>(args)...);
+}
+
+template <typename key_type, typename mapped_type,
+          template <class> class NodeAlloc, class Augment, class Compare>
+template <typename Emplace, typename... Args>
+auto Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::EmplaceSplit(
+    Emplace emplace, Args &&...args) {
+  if constexpr (sizeof...(Args) != 1) {
+    return emplace(std::forward<Args>(args)...);
+  } else if constexpr (IsPair<std::decay_t<Args>...>::value) {
+    return emplace(
+        std::piecewise_construct,
+        std::forward_as_tuple(std::get<0>(std::forward<Args>(args))...),
+        std::forward_as_tuple(std::get<1>(std::forward<Args>(args))...));
+  } else {
+    return EmplaceSplit(emplace, value_type(std::forward<Args>(args)...));
+  }
+}
+
+// Replaces the contents with a range sorted by key in O(n). Throws
+// std::invalid_argument if the range is not sorted, leaving it empty.
+template <typename key_type, typename mapped_type,
+          template <class> class NodeAlloc, class Augment, class Compare>
+template <typename ForwardIt>
+void Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::assign_sorted(
+    ForwardIt first, ForwardIt last) {
+  clear();
+  size_ = tree_.AssignSorted(first, last, true);
+}
+
+// Number of elements with a key less than key
+template <typename key_type, typename mapped_type,
+          template <class> class NodeAlloc, class Augment, class Compare>
+typename Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::size_type
+Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::rank(
+    const key_type &key) const {
+  return tree_.Rank(key);
+}
+
+// Element at position k in key order, end() if k >= size()
+template <typename key_type, typename mapped_type,
+          template <class> class NodeAlloc, class Augment, class Compare>
+typename Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::iterator
+Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::select(
+    size_type k) const {
+  return iterator(tree_.Select(k));
+}
+
+// Number of elements with a key in [lo, hi)
+template <typename key_type, typename mapped_type,
+          template <class> class NodeAlloc, class Augment, class Compare>
+typename Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::size_type
+Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::count_range(
+    const key_type &lo, const key_type &hi) const {
+  return tree_.KeyCompare()(lo, hi) ? tree_.Rank(hi) - tree_.Rank(lo) : 0;
+}
+
+template <typename key_type, typename mapped_type,
+          template <class> class NodeAlloc, class Augment, class Compare>
+auto Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::aggregate(
+    const key_type &lo, const key_type &hi) const {
+  return tree_.AggregateRange(lo, hi);
+}
+
+template <typename key_type, typename mapped_type,
+          template <class> class NodeAlloc, class Augment, class Compare>
+void Map<key_type, mapped_type, NodeAlloc, Augment, Compare>::refresh(
+    iterator it) {
+  if (it == end()) {
+    throw std::out_of_range("The element to refresh does not exist in Map");
+  }
+  tree_.Refresh(it.current());
+}
+
 }  //  namespace s21
 
 #endif  // CPP2_S21_CONTAINERS_2_CONTAINERS_S21_MAP_H_
@@ -6,20 +6,30 @@
 
 namespace s21 {
 
-template <typename Key>
-class Multiset : public RBTree<Key, Key> {
+template <typename Key, template <class> class NodeAlloc = HeapNodeAllocator,
+          class Augment = DefaultNodePolicy<NodeAlloc>,
+          class Compare = std::less<Key>>
+class Multiset : public RBTree<Key, NoValue, NodeAlloc, Augment, Compare> {
  public:
   using key_type = Key;
   using value_type = Key;
   using size_type = std::size_t;
   using const_reference = const Key &;
   using reference = Key &;
-  using const_iterator =
-      typename s21::RBTree<key_type, value_type>::const_iterator;
-  using iterator = typename s21::RBTree<key_type, value_type>::iterator;
+  using const_iterator = typename s21::RBTree<key_type, NoValue, NodeAlloc,
+                                              Augment, Compare>::const_iterator;
+  using iterator = typename s21::RBTree<key_type, NoValue, NodeAlloc, Augment,
+                                        Compare>::iterator;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using key_compare = Compare;
+  using node_type = typename s21::RBTree<key_type, NoValue, NodeAlloc, Augment,
+                                         Compare>::node_type;
 
   Multiset() = default;
+  explicit Multiset(const key_compare &compare);
   explicit Multiset(std::initializer_list<value_type> const &items);
+  template <typename ForwardIt>
+  Multiset(ForwardIt first, ForwardIt last);
   Multiset(const Multiset &ms);
   Multiset &operator=(const Multiset &other);
   Multiset(Multiset &&ms) noexcept;
@@ -27,69 +37,175 @@ class Multiset : public RBTree<Key, Key> {
   ~Multiset() = default;
 
   iterator insert(const_reference value);
+  iterator insert(value_type &&value);
+  iterator insert(iterator hint, const_reference value);
+  iterator insert(iterator hint, value_type &&value);
   iterator find(const_reference value) const;
   iterator begin() const;
   iterator end() const;
-  void erase(const_reference value);
+  reverse_iterator rbegin() const;
+  reverse_iterator rend() const;
+  // Removes one element equal to value; returns 0 if there is none
+  size_type erase(const_reference value);
+  // Range erase and visit in O(log n + k) for k elements; the key ranges
+  // are [lo, hi). fn is called with each key.
+  iterator erase(iterator first, iterator last);
+  size_type erase_range(const key_type &lo, const key_type &hi);
+  template <typename Fn>
+  void for_each_in_range(const key_type &lo, const key_type &hi, Fn fn) const;
+  node_type extract(iterator it);
+  node_type extract(const_reference value);
+  iterator insert(node_type &&node);
 
   int size() const;
   void clear();
   bool empty() const;
   size_type max_size();
-  void swap(Multiset<Key> &other);
+  void swap(Multiset<Key, NodeAlloc, Augment, Compare> &other);
   bool contains(const_reference value) const;
   int count(const_reference value) const;
+  key_compare key_comp() const;
 
   void merge(Multiset &other);
-  iterator lower_bound(const_reference key);
-  iterator upper_bound(const_reference key);
 
-  std::pair<typename Multiset<value_type>::iterator,
-            typename Multiset<value_type>::iterator>
-  equal_range(const_reference key);
+  // Algebra of whole multisets in O(m log(n / m + 1)) for m <= n elements.
+  // The operands are consumed: pass them with std::move to reuse their
+  // nodes instead of copying them. With a pool, large operands are combined
+  // on its threads. Equal elements are counted the way std::set_union and
+  // friends count them. Balancing policies other than red-black merge into
+  // a copy in O(n + m).
+  friend Multiset set_union(Multiset lhs, Multiset rhs,
+                            ThreadPool *pool = nullptr) {
+    lhs.Combine(rhs, SetOperation::Union, pool);
+    return lhs;
+  }
+  friend Multiset set_intersection(Multiset lhs, Multiset rhs,
+                                   ThreadPool *pool = nullptr) {
+    lhs.Combine(rhs, SetOperation::Intersection, pool);
+    return lhs;
+  }
+  friend Multiset set_difference(Multiset lhs, Multiset rhs,
+                                 ThreadPool *pool = nullptr) {
+    lhs.Combine(rhs, SetOperation::Difference, pool);
+    return lhs;
+  }
+  friend Multiset set_symmetric_difference(Multiset lhs, Multiset rhs,
+                                           ThreadPool *pool = nullptr) {
+    lhs.Combine(rhs, SetOperation::SymmetricDifference, pool);
+    return lhs;
+  }
+
+  template <typename ForwardIt>
+  void assign_sorted(ForwardIt first, ForwardIt last);
+  iterator lower_bound(const_reference key) const;
+  iterator upper_bound(const_reference key) const;
+
+  std::pair<
+      typename Multiset<value_type, NodeAlloc, Augment, Compare>::iterator,
+      typename Multiset<value_type, NodeAlloc, Augment, Compare>::iterator>
+  equal_range(const_reference key) const;
+
+  // Lookups by any type the comparator orders against key_type, without
+  // building a key; only with a comparator that defines is_transparent
+  template <typename K, typename C = Compare,
+            typename = typename C::is_transparent>
+  iterator find(const K &key) const;
+  template <typename K, typename C = Compare,
+            typename = typename C::is_transparent>
+  bool contains(const K &key) const;
+  template <typename K, typename C = Compare,
+            typename = typename C::is_transparent>
+  int count(const K &key) const;
+  template <typename K, typename C = Compare,
+            typename = typename C::is_transparent>
+  iterator lower_bound(const K &key) const;
+  template <typename K, typename C = Compare,
+            typename = typename C::is_transparent>
+  iterator upper_bound(const K &key) const;
+  template <typename K, typename C = Compare,
+            typename = typename C::is_transparent>
+  std::pair<iterator, iterator> equal_range(const K &key) const;
+
+  // Order statistics, O(log n); need the OrderStatistic node policy
+  size_type rank(const key_type &key) const;
+  iterator select(size_type k) const;
+  size_type count_range(const key_type &lo, const key_type &hi) const;
 
   template <typename... Args>
   s21::vector<std::pair<iterator, bool>> emplace(Args &&...args);
+  template <typename... Args>
+  iterator emplace_hint(iterator hint, Args &&...args);
 
  private:
-  RBTree<key_type, value_type> tree_;
-  using s21::RBTree<key_type, value_type>::root_;
+  RBTree<key_type, NoValue, NodeAlloc, Augment, Compare> tree_;
   size_type size_{};
+
+  void Combine(Multiset &other, SetOperation op, ThreadPool *pool);
+  template <typename K>
+  int CountEqual(const K &key) const;
 };
 
-template <class value_type>
-Multiset<value_type>::Multiset(const Multiset<value_type> &ms) {
-  for (iterator it = ms.begin(); it != ms.end(); ++it) {
-    insert((*it).key);
-  }
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+Multiset<value_type, NodeAlloc, Augment, Compare>::Multiset(
+    const key_compare &compare)
+    : RBTree<value_type, NoValue, NodeAlloc, Augment, Compare>(compare),
+      tree_(compare) {}
+
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+Multiset<value_type, NodeAlloc, Augment, Compare>::Multiset(
+    const Multiset<value_type, NodeAlloc, Augment, Compare> &ms)
+    : RBTree<value_type, NoValue, NodeAlloc, Augment, Compare>(
+          ms.tree_.KeyCompare()),
+      tree_(ms.tree_.KeyCompare()) {
+  tree_.Clone(ms.tree_);
+  size_ = ms.size_;
 }
 
-template <class value_type>
-Multiset<value_type>::Multiset(const std::initializer_list<value_type> &items) {
-  for (const auto &item : items) {
-    insert(item);
-  }
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+Multiset<value_type, NodeAlloc, Augment, Compare>::Multiset(
+    const std::initializer_list<value_type> &items)
+    : Multiset(items.begin(), items.end()) {}
+
+// Sorted ranges are linked in O(n), other ranges are sorted first
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+template <typename ForwardIt>
+Multiset<value_type, NodeAlloc, Augment, Compare>::Multiset(ForwardIt first,
+                                                            ForwardIt last) {
+  size_ = tree_.Assign(first, last, false);
 }
 
-template <class value_type>
-Multiset<value_type> &Multiset<value_type>::operator=(
-    const Multiset<value_type> &other) {
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+Multiset<value_type, NodeAlloc, Augment, Compare>
+    &Multiset<value_type, NodeAlloc, Augment, Compare>::operator=(
+        const Multiset<value_type, NodeAlloc, Augment, Compare> &other) {
   if (this != &other) {
-    Multiset<value_type> temp(other);
+    Multiset<value_type, NodeAlloc, Augment, Compare> temp(other);
     swap(temp);
   }
   return *this;
 }
 
-template <class value_type>
-Multiset<value_type>::Multiset(Multiset<value_type> &&ms) noexcept {
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+Multiset<value_type, NodeAlloc, Augment, Compare>::Multiset(
+    Multiset<value_type, NodeAlloc, Augment, Compare> &&ms) noexcept
+    : RBTree<value_type, NoValue, NodeAlloc, Augment, Compare>(
+          ms.tree_.KeyCompare()),
+      tree_(ms.tree_.KeyCompare()) {
   swap(ms);
   ms.clear();
 }
 
-template <class value_type>
-Multiset<value_type> s21::Multiset<value_type>::operator=(
-    Multiset<value_type> &&ms) {
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+Multiset<value_type, NodeAlloc, Augment, Compare>
+s21::Multiset<value_type, NodeAlloc, Augment, Compare>::operator=(
+    Multiset<value_type, NodeAlloc, Augment, Compare> &&ms) {
   if (this != &ms) {
     swap(ms);
     ms.clear();
@@ -97,147 +213,418 @@ Multiset<value_type> s21::Multiset<value_type>::operator=(
   return *this;
 }
 
-template <class value_type>
-void Multiset<value_type>::clear() {
-  s21::RBTree<value_type, value_type>::DeleteTree(root_);
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+void Multiset<value_type, NodeAlloc, Augment, Compare>::clear() {
+  tree_.Clear();
   size_ = 0;
-  root_ = nullptr;
 }
 
-template <typename value_type>
-void Multiset<value_type>::swap(Multiset<value_type> &other) {
+template <typename value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+void Multiset<value_type, NodeAlloc, Augment, Compare>::swap(
+    Multiset<value_type, NodeAlloc, Augment, Compare> &other) {
   tree_.swap(other.tree_);
   std::swap(size_, other.size_);
 }
 
-template <class value_type>
-typename Multiset<value_type>::iterator Multiset<value_type>::insert(
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+typename Multiset<value_type, NodeAlloc, Augment, Compare>::iterator
+Multiset<value_type, NodeAlloc, Augment, Compare>::insert(
     const_reference value) {
-  tree_.Insert(value, value);
+  iterator result(tree_.InsertEqual(value, NoValue()));
+  ++size_;
+  return result;
+}
+
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+typename Multiset<value_type, NodeAlloc, Augment, Compare>::iterator
+Multiset<value_type, NodeAlloc, Augment, Compare>::insert(value_type &&value) {
+  iterator result(tree_.InsertEqual(std::move(value), NoValue()));
+  ++size_;
+  return result;
+}
+
+// Amortized O(1) when value belongs right before hint
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+typename Multiset<value_type, NodeAlloc, Augment, Compare>::iterator
+Multiset<value_type, NodeAlloc, Augment, Compare>::insert(
+    iterator hint, const value_type &value) {
+  iterator result(tree_.InsertEqualHint(hint.current(), value, NoValue()));
   ++size_;
-  iterator result = find(value);
   return result;
 }
 
-template <class value_type>
-void Multiset<value_type>::erase(const_reference value) {
-  Node<value_type, value_type> *node = tree_.Find(tree_.GetRoot(), value);
-  if (node != nullptr) {
-    tree_.Erase(node);
-    --size_;
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+typename Multiset<value_type, NodeAlloc, Augment, Compare>::iterator
+Multiset<value_type, NodeAlloc, Augment, Compare>::insert(iterator hint,
+                                                          value_type &&value) {
+  iterator result(
+      tree_.InsertEqualHint(hint.current(), std::move(value), NoValue()));
+  ++size_;
+  return result;
+}
+
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+typename Multiset<value_type, NodeAlloc, Augment, Compare>::node_type
+Multiset<value_type, NodeAlloc, Augment, Compare>::extract(iterator it) {
+  if (it == end()) {
+    throw std::out_of_range(
+        "The element to be extracted does not exist in Multiset");
   }
+  --size_;
+  return tree_.Extract(it.current());
 }
 
-template <class value_type>
-int Multiset<value_type>::size() const {
+// Takes the first of the equal elements, empty handle if there is none
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+typename Multiset<value_type, NodeAlloc, Augment, Compare>::node_type
+Multiset<value_type, NodeAlloc, Augment, Compare>::extract(
+    const_reference value) {
+  Node<value_type, NoValue, Augment> *node = tree_.LowerBound(value);
+  if (node->IsHeader() || tree_.KeyCompare()(value, node->key)) {
+    return node_type();
+  }
+  return extract(iterator(node));
+}
+
+// Links the node of an extracted element after its equals, without copying
+// it; end() for an empty handle
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+typename Multiset<value_type, NodeAlloc, Augment, Compare>::iterator
+Multiset<value_type, NodeAlloc, Augment, Compare>::insert(node_type &&node) {
+  bool linked = !node.empty();
+  iterator result(tree_.InsertNodeEqual(node));
+  if (linked) {
+    ++size_;
+  }
+  return result;
+}
+
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+typename Multiset<value_type, NodeAlloc, Augment, Compare>::size_type
+Multiset<value_type, NodeAlloc, Augment, Compare>::erase(
+    const_reference value) {
+  Node<value_type, NoValue, Augment> *node = tree_.FindKey(value);
+  if (node == tree_.End()) {
+    return 0;
+  }
+  tree_.Erase(node);
+  --size_;
+  return 1;
+}
+
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+int Multiset<value_type, NodeAlloc, Augment, Compare>::size() const {
   return size_;
 }
 
-template <class value_type>
-bool Multiset<value_type>::empty() const {
-  return (root_ == nullptr && size_ == 0);
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+bool Multiset<value_type, NodeAlloc, Augment, Compare>::empty() const {
+  return size_ == 0;
 }
 
-template <class value_type>
-std::size_t Multiset<value_type>::max_size() {
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+std::size_t Multiset<value_type, NodeAlloc, Augment, Compare>::max_size() {
   return SIZE_MAX / ((sizeof(size_t) * 5) * 2);
 }
 
-template <class value_type>
-bool Multiset<value_type>::contains(const_reference value) const {
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+bool Multiset<value_type, NodeAlloc, Augment, Compare>::contains(
+    const_reference value) const {
   return tree_.Contains(value);
 }
 
-template <typename value_type>
-int Multiset<value_type>::count(const_reference value) const {
+template <typename value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+int Multiset<value_type, NodeAlloc, Augment, Compare>::count(
+    const_reference value) const {
+  return CountEqual(value);
+}
+
+// Elements in the equal range of key, counted by rank when the nodes keep
+// subtree sizes
+template <typename value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+template <typename K>
+int Multiset<value_type, NodeAlloc, Augment, Compare>::CountEqual(
+    const K &key) const {
+  auto [lower, upper] = tree_.EqualRange(key);
+  if constexpr (Augment::kSubtreeSize) {
+    // Positions of the bounds, end() sits at size()
+    size_type first = lower->IsHeader() ? size_ : Augment::Rank(lower);
+    size_type last = upper->IsHeader() ? size_ : Augment::Rank(upper);
+    return static_cast<int>(last - first);
+  }
   int count = 0;
-  for (iterator it = begin(); it != end(); ++it) {
-    if (it->key == value) {
-      ++count;
-    }
+  for (iterator it(lower); it.current() != upper; ++it) {
+    ++count;
   }
   return count;
 }
 
-template <class value_type>
-typename Multiset<value_type>::iterator Multiset<value_type>::begin() const {
-  Node<key_type, value_type> *node = tree_.GetRoot();
-  while (node != nullptr && node->left != nullptr) {
-    node = node->left;
-  }
-  return iterator(node);
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+typename Multiset<value_type, NodeAlloc, Augment, Compare>::iterator
+Multiset<value_type, NodeAlloc, Augment, Compare>::begin() const {
+  return iterator(tree_.Begin());
 }
 
-template <class value_type>
-typename Multiset<value_type>::iterator Multiset<value_type>::end() const {
-  return iterator(nullptr);
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+typename Multiset<value_type, NodeAlloc, Augment, Compare>::iterator
+Multiset<value_type, NodeAlloc, Augment, Compare>::end() const {
+  return iterator(tree_.End());
 }
 
-template <class value_type>
-typename Multiset<value_type>::iterator Multiset<value_type>::find(
+// O(1): the header caches the rightmost node
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+typename Multiset<value_type, NodeAlloc, Augment, Compare>::reverse_iterator
+Multiset<value_type, NodeAlloc, Augment, Compare>::rbegin() const {
+  return reverse_iterator(end());
+}
+
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+typename Multiset<value_type, NodeAlloc, Augment, Compare>::reverse_iterator
+Multiset<value_type, NodeAlloc, Augment, Compare>::rend() const {
+  return reverse_iterator(begin());
+}
+
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+typename Multiset<value_type, NodeAlloc, Augment, Compare>::iterator
+Multiset<value_type, NodeAlloc, Augment, Compare>::find(
     const_reference value) const {
-  return iterator(tree_.Find(tree_.GetRoot(), value));
+  return iterator(tree_.FindKey(value));
+}
+
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+typename Multiset<value_type, NodeAlloc, Augment, Compare>::key_compare
+Multiset<value_type, NodeAlloc, Augment, Compare>::key_comp() const {
+  return tree_.KeyCompare();
+}
+
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+template <typename K, typename C, typename>
+typename Multiset<value_type, NodeAlloc, Augment, Compare>::iterator
+Multiset<value_type, NodeAlloc, Augment, Compare>::find(const K &key) const {
+  return iterator(tree_.FindKey(key));
+}
+
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+template <typename K, typename C, typename>
+bool Multiset<value_type, NodeAlloc, Augment, Compare>::contains(
+    const K &key) const {
+  return tree_.Contains(key);
+}
+
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+template <typename K, typename C, typename>
+int Multiset<value_type, NodeAlloc, Augment, Compare>::count(
+    const K &key) const {
+  return CountEqual(key);
+}
+
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+template <typename K, typename C, typename>
+typename Multiset<value_type, NodeAlloc, Augment, Compare>::iterator
+Multiset<value_type, NodeAlloc, Augment, Compare>::lower_bound(
+    const K &key) const {
+  return iterator(tree_.LowerBound(key));
 }
 
-template <class value_type>
-void Multiset<value_type>::merge(Multiset<value_type> &other) {
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+template <typename K, typename C, typename>
+typename Multiset<value_type, NodeAlloc, Augment, Compare>::iterator
+Multiset<value_type, NodeAlloc, Augment, Compare>::upper_bound(
+    const K &key) const {
+  return iterator(tree_.UpperBound(key));
+}
+
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+template <typename K, typename C, typename>
+std::pair<typename Multiset<value_type, NodeAlloc, Augment, Compare>::iterator,
+          typename Multiset<value_type, NodeAlloc, Augment, Compare>::iterator>
+Multiset<value_type, NodeAlloc, Augment, Compare>::equal_range(
+    const K &key) const {
+  auto [lower, upper] = tree_.EqualRange(key);
+  return std::make_pair(iterator(lower), iterator(upper));
+}
+
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+void Multiset<value_type, NodeAlloc, Augment, Compare>::merge(
+    Multiset<value_type, NodeAlloc, Augment, Compare> &other) {
   if (this == &other) {
     return;
   }
-  for (auto it = other.begin(); it != other.end(); ++it) {
-    insert(it->key);
-  }
-  other.clear();
+  // The nodes of other are relinked, not copied, unless the allocator keeps
+  // them; equal keys of other go after the ones of this multiset.
+  size_ += tree_.Merge(other.tree_, MergeEqual::KeepBoth, size_, other.size_);
+  other.size_ = 0;
 }
 
-template <class value_type>
-typename Multiset<value_type>::iterator Multiset<value_type>::lower_bound(
-    const_reference key) {
-  iterator it = begin();
-  iterator it_end = end();
-  while (it != it_end) {
-    if (*it >= key) {
-      return it;
-    }
-    ++it;
-  }
-  return it_end;
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+void Multiset<value_type, NodeAlloc, Augment, Compare>::Combine(
+    Multiset<value_type, NodeAlloc, Augment, Compare> &other, SetOperation op,
+    ThreadPool *pool) {
+  size_ = size_ + other.size_ - tree_.Combine(other.tree_, op, false, pool);
+  other.size_ = 0;
 }
 
-template <class value_type>
-typename Multiset<value_type>::iterator Multiset<value_type>::upper_bound(
-    const_reference key) {
-  iterator it = begin();
-  iterator it_end = end();
-  while (it != it_end && !(*it > key)) {
-    ++it;
-  }
-  return it;
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+typename Multiset<value_type, NodeAlloc, Augment, Compare>::iterator
+Multiset<value_type, NodeAlloc, Augment, Compare>::lower_bound(
+    const_reference key) const {
+  return iterator(tree_.LowerBound(key));
+}
+
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+typename Multiset<value_type, NodeAlloc, Augment, Compare>::iterator
+Multiset<value_type, NodeAlloc, Augment, Compare>::upper_bound(
+    const_reference key) const {
+  return iterator(tree_.UpperBound(key));
 }
 
-template <class value_type>
-std::pair<typename Multiset<value_type>::iterator,
-          typename Multiset<value_type>::iterator>
-Multiset<value_type>::equal_range(const_reference key) {
-  return std::make_pair(lower_bound(key), upper_bound(key));
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+std::pair<typename Multiset<value_type, NodeAlloc, Augment, Compare>::iterator,
+          typename Multiset<value_type, NodeAlloc, Augment, Compare>::iterator>
+Multiset<value_type, NodeAlloc, Augment, Compare>::equal_range(
+    const_reference key) const {
+  auto [lower, upper] = tree_.EqualRange(key);
+  return std::make_pair(iterator(lower), iterator(upper));
 }
 
-template <typename value_type>
+template <typename value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
 template <typename... Args>
-s21::vector<std::pair<typename Multiset<value_type>::iterator, bool>>
-Multiset<value_type>::emplace(Args &&...args) {
+s21::vector<std::pair<
+    typename Multiset<value_type, NodeAlloc, Augment, Compare>::iterator, bool>>
+Multiset<value_type, NodeAlloc, Augment, Compare>::emplace(Args &&...args) {
   s21::vector<std::pair<iterator, bool>> result;
-  std::pair<iterator, bool> element;
-  s21::vector<typename Multiset<value_type>::key_type> argsVector{
-      std::forward<Args>(args)...};
-  for (auto &item : argsVector) {
-    element.first = insert(item);
-    element.second = true;
-    result.push_back(element);
-  }
+  // Every argument builds the key of one node in place, an
+  // initializer_list argument inserts each of its elements
+  [[maybe_unused]] auto emplace_one = [this, &result](auto &&arg) {
+    using Arg = decltype(arg);
+    if constexpr (std::is_same_v<std::decay_t<Arg>,
+                                 std::initializer_list<value_type>>) {
+      for (const value_type &item : arg) {
+        result.push_back(std::make_pair(insert(item), true));
+      }
+    } else {
+      iterator it(tree_.EmplaceEqual(std::in_place, std::forward<Arg>(arg)));
+      ++size_;
+      result.push_back(std::make_pair(it, true));
+    }
+  };
+  (emplace_one(std::forward<Args>(args)), ...);
   return result;
 }
 
+template <typename value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+template <typename... Args>
+typename Multiset<value_type, NodeAlloc, Augment, Compare>::iterator
+Multiset<value_type, NodeAlloc, Augment, Compare>::emplace_hint(
+    iterator hint, Args &&...args) {
+  iterator result(tree_.EmplaceEqualHint(hint.current(), std::in_place,
+                                         std::forward<Args>(args)...));
+  ++size_;
+  return result;
+}
+
+// Replaces the contents with a range sorted by key in O(n). Throws
+// std::invalid_argument if the range is not sorted, leaving it empty.
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+template <typename ForwardIt>
+void Multiset<value_type, NodeAlloc, Augment, Compare>::assign_sorted(
+    ForwardIt first, ForwardIt last) {
+  clear();
+  size_ = tree_.AssignSorted(first, last, false);
+}
+
+// Number of elements with a key less than key
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+typename Multiset<value_type, NodeAlloc, Augment, Compare>::size_type
+Multiset<value_type, NodeAlloc, Augment, Compare>::rank(
+    const value_type &key) const {
+  return tree_.Rank(key);
+}
+
+// Element at position k in key order, end() if k >= size()
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+typename Multiset<value_type, NodeAlloc, Augment, Compare>::iterator
+Multiset<value_type, NodeAlloc, Augment, Compare>::select(size_type k) const {
+  return iterator(tree_.Select(k));
+}
+
+// Number of elements with a key in [lo, hi)
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+typename Multiset<value_type, NodeAlloc, Augment, Compare>::size_type
+Multiset<value_type, NodeAlloc, Augment, Compare>::count_range(
+    const value_type &lo, const value_type &hi) const {
+  return tree_.KeyCompare()(lo, hi) ? tree_.Rank(hi) - tree_.Rank(lo) : 0;
+}
+
+// Returns last, which stays valid
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+typename Multiset<value_type, NodeAlloc, Augment, Compare>::iterator
+Multiset<value_type, NodeAlloc, Augment, Compare>::erase(iterator first,
+                                                         iterator last) {
+  size_ -= tree_.EraseRange(first.current(), last.current());
+  return last;
+}
+
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+typename Multiset<value_type, NodeAlloc, Augment, Compare>::size_type
+Multiset<value_type, NodeAlloc, Augment, Compare>::erase_range(
+    const value_type &lo, const value_type &hi) {
+  std::size_t erased = tree_.EraseKeyRange(lo, hi);
+  size_ -= erased;
+  return erased;
+}
+
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+template <typename Fn>
+void Multiset<value_type, NodeAlloc, Augment, Compare>::for_each_in_range(
+    const value_type &lo, const value_type &hi, Fn fn) const {
+  tree_.ForEachInRange(lo, hi, [&fn](Node<value_type, NoValue, Augment> &node) {
+    fn(node.key);
+  });
+}
+
 }  // namespace s21
 
 #endif  // CPP2_S21_CONTAINERS_2_CONTAINERS_S21_MULTISET_H_
@@ -0,0 +1,295 @@
+#ifndef CPP2_S21_CONTAINERS_2_CONTAINERS_S21_RANGE_SET_H_
+#define CPP2_S21_CONTAINERS_2_CONTAINERS_S21_RANGE_SET_H_
+
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+#include "RBTree.h"
+
+namespace s21 {
+
+// Set of integers stored as disjoint closed ranges [first, last], one tree
+// node per range keyed by its first value: memory grows with the number of
+// ranges, not with the number of values. Inserts merge with the ranges they
+// overlap or touch, erases cut and split them, so two stored ranges always
+// have a gap between them. The ranges are closed so that they can reach
+// std::numeric_limits<T>::max().
+//
+// Iterators visit the ranges in order: it->key is the first value of a
+// range and it->value its last. size() counts ranges, not values. Insert,
+// erase, membership and next_free run in O(log n) for n ranges, plus
+// O(log n + m) for the m ranges an insert or erase swallows, each of which
+// was inserted once.
+template <typename T, template <class> class NodeAlloc = HeapNodeAllocator,
+          class Augment = DefaultNodePolicy<NodeAlloc>>
+class RangeSet {
+  static_assert(std::is_integral_v<T>, "RangeSet holds integral values");
+
+ public:
+  using value_type = T;
+  using size_type = std::size_t;
+  using iterator = typename RBTree<T, T, NodeAlloc, Augment>::iterator;
+  using const_iterator =
+      typename RBTree<T, T, NodeAlloc, Augment>::const_iterator;
+
+  RangeSet() = default;
+  RangeSet(const RangeSet &other);
+  RangeSet &operator=(const RangeSet &other);
+  RangeSet(RangeSet &&other) noexcept;
+  RangeSet &operator=(RangeSet &&other) noexcept;
+  ~RangeSet() = default;
+
+  // Adds [first, last] and returns the range that now holds it; throws
+  // std::invalid_argument if last < first
+  iterator insert(const T &first, const T &last);
+  iterator insert(const T &value);
+  // Removes [first, last], splitting a range that reaches past both ends;
+  // throws std::invalid_argument if last < first
+  void erase(const T &first, const T &last);
+  void erase(const T &value);
+
+  // The range that holds value, end() if there is none
+  iterator find(const T &value) const;
+  bool contains(const T &value) const;
+  // Whether every value of [first, last] is in the set
+  bool contains(const T &first, const T &last) const;
+  // Smallest value not below value that is not in the set; throws
+  // std::out_of_range if all of them are
+  T next_free(const T &value) const;
+
+  iterator begin() const;
+  iterator end() const;
+  size_type size() const;
+  bool empty() const;
+  void clear();
+  void swap(RangeSet &other);
+
+ private:
+  using NodeT = Node<T, T, Augment>;
+
+  // Last range that starts at or before value, nullptr if there is none
+  NodeT *Floor(const T &value) const;
+  // Whether a range ending at last overlaps or touches one starting at
+  // first, without overflowing at the ends of T
+  static bool Touches(const T &last, const T &first) noexcept;
+  // Gives a stored range new bounds; the new first value must keep the
+  // node between its neighbours
+  void Reshape(NodeT *node, const T &first, const T &last) noexcept;
+
+  RBTree<T, T, NodeAlloc, Augment> tree_;
+  size_type size_{};
+};
+
+template <typename T, template <class> class NodeAlloc, class Augment>
+RangeSet<T, NodeAlloc, Augment>::RangeSet(const RangeSet &other)
+    : size_(other.size_) {
+  tree_.Clone(other.tree_);
+}
+
+template <typename T, template <class> class NodeAlloc, class Augment>
+RangeSet<T, NodeAlloc, Augment> &RangeSet<T, NodeAlloc, Augment>::operator=(
+    const RangeSet &other) {
+  if (this != &other) {
+    RangeSet copy(other);
+    swap(copy);
+  }
+  return *this;
+}
+
+template <typename T, template <class> class NodeAlloc, class Augment>
+RangeSet<T, NodeAlloc, Augment>::RangeSet(RangeSet &&other) noexcept {
+  swap(other);
+}
+
+template <typename T, template <class> class NodeAlloc, class Augment>
+RangeSet<T, NodeAlloc, Augment> &RangeSet<T, NodeAlloc, Augment>::operator=(
+    RangeSet &&other) noexcept {
+  clear();
+  swap(other);
+  return *this;
+}
+
+// The ranges that start after first and touch [first, last] form one run.
+// If the range before them touches too, it grows over the run; otherwise
+// the first range of the run is reused. The rest of the run is erased in
+// one EraseRange.
+template <typename T, template <class> class NodeAlloc, class Augment>
+typename RangeSet<T, NodeAlloc, Augment>::iterator
+RangeSet<T, NodeAlloc, Augment>::insert(const T &first, const T &last) {
+  if (last < first) {
+    throw std::invalid_argument("RangeSet needs first <= last");
+  }
+  NodeT *node = Floor(first);
+  T merged_first = first;
+  T merged_last = last;
+  if (node != nullptr && Touches(node->value, first)) {
+    merged_first = node->key;
+    merged_last = std::max(node->value, last);
+  } else {
+    node = nullptr;
+  }
+  iterator run(tree_.UpperBound(first));
+  iterator run_end = run;
+  while (run_end != end() && Touches(merged_last, run_end->key)) {
+    merged_last = std::max(merged_last, run_end->value);
+    ++run_end;
+  }
+  if (node == nullptr && run != run_end) {
+    node = run.current();
+    ++run;
+  }
+  size_ -= tree_.EraseRange(run.current(), run_end.current());
+  if (node == nullptr) {
+    ++size_;
+    return iterator(
+        tree_.InsertUniqueHint(run_end.current(), merged_first, merged_last)
+            .first);
+  }
+  Reshape(node, merged_first, merged_last);
+  return iterator(node);
+}
+
+template <typename T, template <class> class NodeAlloc, class Augment>
+typename RangeSet<T, NodeAlloc, Augment>::iterator
+RangeSet<T, NodeAlloc, Augment>::insert(const T &value) {
+  return insert(value, value);
+}
+
+template <typename T, template <class> class NodeAlloc, class Augment>
+void RangeSet<T, NodeAlloc, Augment>::erase(const T &first, const T &last) {
+  if (last < first) {
+    throw std::invalid_argument("RangeSet needs first <= last");
+  }
+  NodeT *node = Floor(first);
+  if (node != nullptr && node->key < first && !(node->value < first)) {
+    T node_last = node->value;
+    Reshape(node, node->key, first - 1);
+    if (last < node_last) {
+      iterator next(node);
+      ++next;
+      tree_.InsertUniqueHint(next.current(), last + 1, node_last);
+      ++size_;
+      return;
+    }
+  }
+  iterator run(tree_.LowerBound(first));
+  iterator run_end = run;
+  while (run_end != end() && !(last < run_end->key)) {
+    if (last < run_end->value) {
+      // Reaches past last: keeps its tail and ends the run
+      Reshape(run_end.current(), last + 1, run_end->value);
+      break;
+    }
+    ++run_end;
+  }
+  size_ -= tree_.EraseRange(run.current(), run_end.current());
+}
+
+template <typename T, template <class> class NodeAlloc, class Augment>
+void RangeSet<T, NodeAlloc, Augment>::erase(const T &value) {
+  erase(value, value);
+}
+
+template <typename T, template <class> class NodeAlloc, class Augment>
+typename RangeSet<T, NodeAlloc, Augment>::iterator
+RangeSet<T, NodeAlloc, Augment>::find(const T &value) const {
+  NodeT *node = Floor(value);
+  if (node == nullptr || node->value < value) {
+    return end();
+  }
+  return iterator(node);
+}
+
+template <typename T, template <class> class NodeAlloc, class Augment>
+bool RangeSet<T, NodeAlloc, Augment>::contains(const T &value) const {
+  return find(value) != end();
+}
+
+// Stored ranges never touch, so a covered [first, last] lies in one range
+template <typename T, template <class> class NodeAlloc, class Augment>
+bool RangeSet<T, NodeAlloc, Augment>::contains(const T &first,
+                                               const T &last) const {
+  iterator it = find(first);
+  return it != end() && !(it->value < last);
+}
+
+// A range is followed by a gap, so the value after it is free unless the
+// range runs to the end of T
+template <typename T, template <class> class NodeAlloc, class Augment>
+T RangeSet<T, NodeAlloc, Augment>::next_free(const T &value) const {
+  iterator it = find(value);
+  if (it == end()) {
+    return value;
+  }
+  if (it->value == std::numeric_limits<T>::max()) {
+    throw std::out_of_range("No free value left in RangeSet");
+  }
+  return it->value + 1;
+}
+
+template <typename T, template <class> class NodeAlloc, class Augment>
+typename RangeSet<T, NodeAlloc, Augment>::iterator
+RangeSet<T, NodeAlloc, Augment>::begin() const {
+  return iterator(tree_.Begin());
+}
+
+template <typename T, template <class> class NodeAlloc, class Augment>
+typename RangeSet<T, NodeAlloc, Augment>::iterator
+RangeSet<T, NodeAlloc, Augment>::end() const {
+  return iterator(tree_.End());
+}
+
+template <typename T, template <class> class NodeAlloc, class Augment>
+typename RangeSet<T, NodeAlloc, Augment>::size_type
+RangeSet<T, NodeAlloc, Augment>::size() const {
+  return size_;
+}
+
+template <typename T, template <class> class NodeAlloc, class Augment>
+bool RangeSet<T, NodeAlloc, Augment>::empty() const {
+  return size_ == 0;
+}
+
+template <typename T, template <class> class NodeAlloc, class Augment>
+void RangeSet<T, NodeAlloc, Augment>::clear() {
+  tree_.Clear();
+  size_ = 0;
+}
+
+template <typename T, template <class> class NodeAlloc, class Augment>
+void RangeSet<T, NodeAlloc, Augment>::swap(RangeSet &other) {
+  std::swap(size_, other.size_);
+  tree_.swap(other.tree_);
+}
+
+template <typename T, template <class> class NodeAlloc, class Augment>
+typename RangeSet<T, NodeAlloc, Augment>::NodeT *
+RangeSet<T, NodeAlloc, Augment>::Floor(const T &value) const {
+  iterator it(tree_.UpperBound(value));
+  if (it == begin()) {
+    return nullptr;
+  }
+  --it;
+  return it.current();
+}
+
+template <typename T, template <class> class NodeAlloc, class Augment>
+bool RangeSet<T, NodeAlloc, Augment>::Touches(const T &last,
+                                              const T &first) noexcept {
+  return !(last < first) || last + 1 == first;
+}
+
+template <typename T, template <class> class NodeAlloc, class Augment>
+void RangeSet<T, NodeAlloc, Augment>::Reshape(NodeT *node, const T &first,
+                                              const T &last) noexcept {
+  node->key = first;
+  node->value = last;
+  if constexpr (Augment::kAggregate) {
+    tree_.Refresh(node);
+  }
+}
+
+}  // namespace s21
+
+#endif  // CPP2_S21_CONTAINERS_2_CONTAINERS_S21_RANGE_SET_H_
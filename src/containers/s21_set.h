@@ -6,20 +6,30 @@
 
 namespace s21 {
 
-template <typename Key>
-class Set : public RBTree<Key, Key> {
+template <typename Key, template <class> class NodeAlloc = HeapNodeAllocator,
+          class Augment = DefaultNodePolicy<NodeAlloc>,
+          class Compare = std::less<Key>>
+class Set : public RBTree<Key, NoValue, NodeAlloc, Augment, Compare> {
  public:
   using key_type = Key;
   using value_type = Key;
   using size_type = std::size_t;
   using const_reference = const Key &;
   using reference = Key &;
-  using const_iterator =
-      typename s21::RBTree<key_type, value_type>::const_iterator;
-  using iterator = typename s21::RBTree<key_type, value_type>::iterator;
+  using const_iterator = typename s21::RBTree<key_type, NoValue, NodeAlloc,
+                                              Augment, Compare>::const_iterator;
+  using iterator = typename s21::RBTree<key_type, NoValue, NodeAlloc, Augment,
+                                        Compare>::iterator;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using key_compare = Compare;
+  using node_type = typename s21::RBTree<key_type, NoValue, NodeAlloc, Augment,
+                                         Compare>::node_type;
 
   Set() = default;
+  explicit Set(const key_compare &compare);
   explicit Set(std::initializer_list<value_type> const &items);
+  template <typename ForwardIt>
+  Set(ForwardIt first, ForwardIt last);
   Set(const Set &s);
   Set &operator=(const Set &other);
   Set(Set &&s) noexcept;
@@ -27,58 +37,155 @@ class Set : public RBTree<Key, Key> {
   ~Set() = default;
 
   std::pair<iterator, bool> insert(const value_type &value);
-  void erase(const_reference value);
+  std::pair<iterator, bool> insert(value_type &&value);
+  iterator insert(iterator hint, const value_type &value);
+  iterator insert(iterator hint, value_type &&value);
+  // Returns the number of removed elements, 0 or 1
+  size_type erase(const_reference value);
+  // Range erase and visit in O(log n + k) for k elements; the key ranges
+  // are [lo, hi). fn is called with each key.
+  iterator erase(iterator first, iterator last);
+  size_type erase_range(const key_type &lo, const key_type &hi);
+  template <typename Fn>
+  void for_each_in_range(const key_type &lo, const key_type &hi, Fn fn) const;
+  node_type extract(iterator it);
+  node_type extract(const_reference value);
+  std::pair<iterator, bool> insert(node_type &&node);
   int size() const;
   void clear();
   bool empty() const;
   size_type max_size();
-  void swap(Set<Key> &other);
+  void swap(Set<Key, NodeAlloc, Augment, Compare> &other);
   bool contains(const_reference value) const;
   iterator find(const_reference value) const;
+  key_compare key_comp() const;
+
+  // Lookups by any type the comparator orders against key_type, without
+  // building a key; only with a comparator that defines is_transparent
+  template <typename K, typename C = Compare,
+            typename = typename C::is_transparent>
+  iterator find(const K &key) const;
+  template <typename K, typename C = Compare,
+            typename = typename C::is_transparent>
+  bool contains(const K &key) const;
+
+  // Batched lookups for many keys at once: the descents run interleaved so
+  // their cache misses overlap. One result per key of [first, last) goes to
+  // out, find_batch writes iterators (end() on a miss) and contains_batch
+  // bools; both return the end of the output.
+  template <typename ForwardIt, typename OutputIt>
+  OutputIt find_batch(ForwardIt first, ForwardIt last, OutputIt out) const;
+  template <typename ForwardIt, typename OutputIt>
+  OutputIt contains_batch(ForwardIt first, ForwardIt last, OutputIt out) const;
+
+  // Order statistics, O(log n); need the OrderStatistic node policy
+  size_type rank(const key_type &key) const;
+  iterator select(size_type k) const;
+  size_type count_range(const key_type &lo, const key_type &hi) const;
   iterator begin() const;
   iterator end() const;
+  reverse_iterator rbegin() const;
+  reverse_iterator rend() const;
   void merge(Set &other);
 
+  // Algebra of whole sets in O(m log(n / m + 1)) for m <= n elements.
+  // The operands are consumed: pass them with std::move to reuse their
+  // nodes instead of copying them. With a pool, large operands are combined
+  // on its threads. Balancing policies other than red-black merge into a
+  // copy in O(n + m).
+  friend Set set_union(Set lhs, Set rhs, ThreadPool *pool = nullptr) {
+    lhs.Combine(rhs, SetOperation::Union, pool);
+    return lhs;
+  }
+  friend Set set_intersection(Set lhs, Set rhs, ThreadPool *pool = nullptr) {
+    lhs.Combine(rhs, SetOperation::Intersection, pool);
+    return lhs;
+  }
+  friend Set set_difference(Set lhs, Set rhs, ThreadPool *pool = nullptr) {
+    lhs.Combine(rhs, SetOperation::Difference, pool);
+    return lhs;
+  }
+  friend Set set_symmetric_difference(Set lhs, Set rhs,
+                                      ThreadPool *pool = nullptr) {
+    lhs.Combine(rhs, SetOperation::SymmetricDifference, pool);
+    return lhs;
+  }
+
+  template <typename ForwardIt>
+  void assign_sorted(ForwardIt first, ForwardIt last);
+
   template <typename... Args>
   s21::vector<std::pair<iterator, bool>> emplace(Args &&...args);
+  template <typename... Args>
+  iterator emplace_hint(iterator hint, Args &&...args);
 
  private:
-  RBTree<key_type, value_type> tree_;
-  using s21::RBTree<key_type, value_type>::root_;
+  RBTree<key_type, NoValue, NodeAlloc, Augment, Compare> tree_;
   size_type size_{};
+
+  void Combine(Set &other, SetOperation op, ThreadPool *pool);
 };
 
-template <class value_type>
-Set<value_type>::Set(const Set<value_type> &s) {
-  for (iterator it = s.begin(); it != s.end(); ++it) {
-    insert((*it).key);
-  }
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+Set<value_type, NodeAlloc, Augment, Compare>::Set(const key_compare &compare)
+    : RBTree<value_type, NoValue, NodeAlloc, Augment, Compare>(compare),
+      tree_(compare) {}
+
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+Set<value_type, NodeAlloc, Augment, Compare>::Set(
+    const Set<value_type, NodeAlloc, Augment, Compare> &s)
+    : RBTree<value_type, NoValue, NodeAlloc, Augment, Compare>(
+          s.tree_.KeyCompare()),
+      tree_(s.tree_.KeyCompare()) {
+  tree_.Clone(s.tree_);
+  size_ = s.size_;
 }
 
-template <class value_type>
-Set<value_type>::Set(const std::initializer_list<value_type> &items) {
-  for (const auto &item : items) {
-    insert(item);
-  }
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+Set<value_type, NodeAlloc, Augment, Compare>::Set(
+    const std::initializer_list<value_type> &items)
+    : Set(items.begin(), items.end()) {}
+
+// Sorted ranges are linked in O(n), other ranges are sorted first
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+template <typename ForwardIt>
+Set<value_type, NodeAlloc, Augment, Compare>::Set(ForwardIt first,
+                                                  ForwardIt last) {
+  size_ = tree_.Assign(first, last, true);
 }
 
-template <class value_type>
-Set<value_type> &Set<value_type>::operator=(const Set<value_type> &other) {
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+Set<value_type, NodeAlloc, Augment, Compare>
+    &Set<value_type, NodeAlloc, Augment, Compare>::operator=(
+        const Set<value_type, NodeAlloc, Augment, Compare> &other) {
   if (this != &other) {
-    Set<value_type> temp(other);
+    Set<value_type, NodeAlloc, Augment, Compare> temp(other);
     swap(temp);
   }
   return *this;
 }
 
-template <class value_type>
-Set<value_type>::Set(Set<value_type> &&s) noexcept {
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+Set<value_type, NodeAlloc, Augment, Compare>::Set(
+    Set<value_type, NodeAlloc, Augment, Compare> &&s) noexcept
+    : RBTree<value_type, NoValue, NodeAlloc, Augment, Compare>(
+          s.tree_.KeyCompare()),
+      tree_(s.tree_.KeyCompare()) {
   swap(s);
   s.clear();
 }
 
-template <class value_type>
-Set<value_type> Set<value_type>::operator=(Set<value_type> &&s) {
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+Set<value_type, NodeAlloc, Augment, Compare>
+Set<value_type, NodeAlloc, Augment, Compare>::operator=(
+    Set<value_type, NodeAlloc, Augment, Compare> &&s) {
   if (this != &s) {
     swap(s);
     s.clear();
@@ -86,106 +193,356 @@ Set<value_type> Set<value_type>::operator=(Set<value_type> &&s) {
   return *this;
 }
 
-template <class value_type>
-void Set<value_type>::clear() {
-  s21::RBTree<value_type, value_type>::DeleteTree(root_);
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+void Set<value_type, NodeAlloc, Augment, Compare>::clear() {
+  tree_.Clear();
   size_ = 0;
-  root_ = nullptr;
 }
 
-template <typename value_type>
-void Set<value_type>::swap(Set<value_type> &other) {
+template <typename value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+void Set<value_type, NodeAlloc, Augment, Compare>::swap(
+    Set<value_type, NodeAlloc, Augment, Compare> &other) {
   tree_.swap(other.tree_);
   std::swap(size_, other.size_);
 }
 
-template <class value_type>
-std::pair<typename Set<value_type>::iterator, bool> Set<value_type>::insert(
-    const value_type &value) {
-  std::pair<iterator, bool> result;
-  if (!contains(value)) {
-    tree_.Insert(value, value);
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+std::pair<typename Set<value_type, NodeAlloc, Augment, Compare>::iterator, bool>
+Set<value_type, NodeAlloc, Augment, Compare>::insert(const value_type &value) {
+  auto [node, inserted] = tree_.InsertUnique(value);
+  if (inserted) {
+    ++size_;
+  }
+  return std::make_pair(iterator(node), inserted);
+}
+
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+std::pair<typename Set<value_type, NodeAlloc, Augment, Compare>::iterator, bool>
+Set<value_type, NodeAlloc, Augment, Compare>::insert(value_type &&value) {
+  auto [node, inserted] = tree_.InsertUnique(std::move(value));
+  if (inserted) {
+    ++size_;
+  }
+  return std::make_pair(iterator(node), inserted);
+}
+
+// Amortized O(1) when value belongs right before hint
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+typename Set<value_type, NodeAlloc, Augment, Compare>::iterator
+Set<value_type, NodeAlloc, Augment, Compare>::insert(iterator hint,
+                                                     const value_type &value) {
+  auto [node, inserted] =
+      tree_.InsertUniqueHint(hint.current(), value, NoValue());
+  if (inserted) {
+    ++size_;
+  }
+  return iterator(node);
+}
+
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+typename Set<value_type, NodeAlloc, Augment, Compare>::iterator
+Set<value_type, NodeAlloc, Augment, Compare>::insert(iterator hint,
+                                                     value_type &&value) {
+  auto [node, inserted] =
+      tree_.InsertUniqueHint(hint.current(), std::move(value), NoValue());
+  if (inserted) {
+    ++size_;
+  }
+  return iterator(node);
+}
+
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+typename Set<value_type, NodeAlloc, Augment, Compare>::node_type
+Set<value_type, NodeAlloc, Augment, Compare>::extract(iterator it) {
+  if (it == end()) {
+    throw std::out_of_range(
+        "The element to be extracted does not exist in Set");
+  }
+  --size_;
+  return tree_.Extract(it.current());
+}
+
+// Empty handle if there is no such element
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+typename Set<value_type, NodeAlloc, Augment, Compare>::node_type
+Set<value_type, NodeAlloc, Augment, Compare>::extract(const_reference value) {
+  Node<value_type, NoValue, Augment> *node = tree_.LowerBound(value);
+  if (node->IsHeader() || tree_.KeyCompare()(value, node->key)) {
+    return node_type();
+  }
+  return extract(iterator(node));
+}
+
+// Links the node of an extracted element without copying it. If the element
+// is already present the node stays in node.
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+std::pair<typename Set<value_type, NodeAlloc, Augment, Compare>::iterator, bool>
+Set<value_type, NodeAlloc, Augment, Compare>::insert(node_type &&node) {
+  auto [here, inserted] = tree_.InsertNodeUnique(node);
+  if (inserted) {
     ++size_;
-    result.second = true;
-  } else {
-    result.second = false;
   }
-  result.first = find(value);
-  return result;
+  return std::make_pair(iterator(here), inserted);
 }
 
-template <class value_type>
-void Set<value_type>::erase(const_reference value) {
-  Node<value_type, value_type> *node = tree_.Find(tree_.GetRoot(), value);
-  if (node != nullptr) {
-    tree_.Erase(node);
-    --size_;
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+typename Set<value_type, NodeAlloc, Augment, Compare>::size_type
+Set<value_type, NodeAlloc, Augment, Compare>::erase(const_reference value) {
+  Node<value_type, NoValue, Augment> *node = tree_.FindKey(value);
+  if (node == tree_.End()) {
+    return 0;
   }
+  tree_.Erase(node);
+  --size_;
+  return 1;
 }
 
-template <typename value_type>
-int Set<value_type>::size() const {
+template <typename value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+int Set<value_type, NodeAlloc, Augment, Compare>::size() const {
   return size_;
 }
 
-template <typename value_type>
-bool Set<value_type>::empty() const {
+template <typename value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+bool Set<value_type, NodeAlloc, Augment, Compare>::empty() const {
   return size_ == 0;
 }
 
-template <class value_type>
-typename Set<value_type>::iterator Set<value_type>::find(
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+typename Set<value_type, NodeAlloc, Augment, Compare>::iterator
+Set<value_type, NodeAlloc, Augment, Compare>::find(
     const_reference value) const {
-  return iterator(tree_.Find(tree_.GetRoot(), value));
+  return iterator(tree_.FindKey(value));
+}
+
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+typename Set<value_type, NodeAlloc, Augment, Compare>::key_compare
+Set<value_type, NodeAlloc, Augment, Compare>::key_comp() const {
+  return tree_.KeyCompare();
+}
+
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+template <typename K, typename C, typename>
+typename Set<value_type, NodeAlloc, Augment, Compare>::iterator
+Set<value_type, NodeAlloc, Augment, Compare>::find(const K &key) const {
+  return iterator(tree_.FindKey(key));
+}
+
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+template <typename K, typename C, typename>
+bool Set<value_type, NodeAlloc, Augment, Compare>::contains(
+    const K &key) const {
+  return tree_.Contains(key);
 }
 
-template <typename value_type>
-bool Set<value_type>::contains(const_reference value) const {
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+template <typename ForwardIt, typename OutputIt>
+OutputIt Set<value_type, NodeAlloc, Augment, Compare>::find_batch(
+    ForwardIt first, ForwardIt last, OutputIt out) const {
+  tree_.FindBatch(first, last, [&out](auto *node) { *out++ = iterator(node); });
+  return out;
+}
+
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+template <typename ForwardIt, typename OutputIt>
+OutputIt Set<value_type, NodeAlloc, Augment, Compare>::contains_batch(
+    ForwardIt first, ForwardIt last, OutputIt out) const {
+  tree_.FindBatch(first, last,
+                  [this, &out](auto *node) { *out++ = node != tree_.End(); });
+  return out;
+}
+
+template <typename value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+bool Set<value_type, NodeAlloc, Augment, Compare>::contains(
+    const_reference value) const {
   return tree_.Contains(value);
 }
 
-template <class value_type>
-typename Set<value_type>::iterator Set<value_type>::begin() const {
-  Node<key_type, value_type> *node = tree_.GetRoot();
-  while (node != nullptr && node->left != nullptr) {
-    node = node->left;
-  }
-  return iterator(node);
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+typename Set<value_type, NodeAlloc, Augment, Compare>::iterator
+Set<value_type, NodeAlloc, Augment, Compare>::begin() const {
+  return iterator(tree_.Begin());
+}
+
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+typename Set<value_type, NodeAlloc, Augment, Compare>::iterator
+Set<value_type, NodeAlloc, Augment, Compare>::end() const {
+  return iterator(tree_.End());
+}
+
+// O(1): the header caches the rightmost node
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+typename Set<value_type, NodeAlloc, Augment, Compare>::reverse_iterator
+Set<value_type, NodeAlloc, Augment, Compare>::rbegin() const {
+  return reverse_iterator(end());
 }
 
-template <class value_type>
-typename Set<value_type>::iterator Set<value_type>::end() const {
-  return iterator(nullptr);
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+typename Set<value_type, NodeAlloc, Augment, Compare>::reverse_iterator
+Set<value_type, NodeAlloc, Augment, Compare>::rend() const {
+  return reverse_iterator(begin());
 }
 
-template <class value_type>
-std::size_t Set<value_type>::max_size() {
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+std::size_t Set<value_type, NodeAlloc, Augment, Compare>::max_size() {
   return SIZE_MAX / ((sizeof(size_t) * 5) * 2);
 }
 
-template <class value_type>
-void Set<value_type>::merge(Set<value_type> &other) {
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+void Set<value_type, NodeAlloc, Augment, Compare>::merge(
+    Set<value_type, NodeAlloc, Augment, Compare> &other) {
   if (this == &other) {
     return;
   }
-  for (auto it = other.begin(); it != other.end(); ++it) {
-    insert(it->key);
-  }
-  other.clear();
+  // The nodes of other are relinked, not copied, unless the allocator keeps
+  // them; for equal keys the element of this set is kept.
+  size_ += tree_.Merge(other.tree_, MergeEqual::KeepOurs, size_, other.size_);
+  other.size_ = 0;
 }
 
-template <typename value_type>
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+void Set<value_type, NodeAlloc, Augment, Compare>::Combine(
+    Set<value_type, NodeAlloc, Augment, Compare> &other, SetOperation op,
+    ThreadPool *pool) {
+  size_ = size_ + other.size_ - tree_.Combine(other.tree_, op, true, pool);
+  other.size_ = 0;
+}
+
+template <typename value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
 template <typename... Args>
-s21::vector<std::pair<typename Set<value_type>::iterator, bool>>
-Set<value_type>::emplace(Args &&...args) {
-  s21::vector<value_type> argsVector{std::forward<Args>(args)...};
+s21::vector<std::pair<
+    typename Set<value_type, NodeAlloc, Augment, Compare>::iterator, bool>>
+Set<value_type, NodeAlloc, Augment, Compare>::emplace(Args &&...args) {
   s21::vector<std::pair<iterator, bool>> results;
-  for (const auto &arg : argsVector) {
-    results.push_back(insert(arg));
-  }
+  // Every argument builds the key of one node in place, an
+  // initializer_list argument inserts each of its elements
+  [[maybe_unused]] auto emplace_one = [this, &results](auto &&arg) {
+    using Arg = decltype(arg);
+    if constexpr (std::is_same_v<std::decay_t<Arg>,
+                                 std::initializer_list<value_type>>) {
+      for (const value_type &item : arg) {
+        results.push_back(insert(item));
+      }
+    } else {
+      auto [node, inserted] =
+          tree_.EmplaceUnique(std::in_place, std::forward<Arg>(arg));
+      if (inserted) {
+        ++size_;
+      }
+      results.push_back(std::make_pair(iterator(node), inserted));
+    }
+  };
+  (emplace_one(std::forward<Args>(args)), ...);
   return results;
 }
 
+template <typename value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+template <typename... Args>
+typename Set<value_type, NodeAlloc, Augment, Compare>::iterator
+Set<value_type, NodeAlloc, Augment, Compare>::emplace_hint(iterator hint,
+                                                           Args &&...args) {
+  auto [node, inserted] = tree_.EmplaceUniqueHint(hint.current(), std::in_place,
+                                                  std::forward<Args>(args)...);
+  if (inserted) {
+    ++size_;
+  }
+  return iterator(node);
+}
+
+// Replaces the contents with a range sorted by key in O(n). Throws
+// std::invalid_argument if the range is not sorted, leaving it empty.
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+template <typename ForwardIt>
+void Set<value_type, NodeAlloc, Augment, Compare>::assign_sorted(
+    ForwardIt first, ForwardIt last) {
+  clear();
+  size_ = tree_.AssignSorted(first, last, true);
+}
+
+// Number of elements with a key less than key
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+typename Set<value_type, NodeAlloc, Augment, Compare>::size_type
+Set<value_type, NodeAlloc, Augment, Compare>::rank(
+    const value_type &key) const {
+  return tree_.Rank(key);
+}
+
+// Element at position k in key order, end() if k >= size()
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+typename Set<value_type, NodeAlloc, Augment, Compare>::iterator
+Set<value_type, NodeAlloc, Augment, Compare>::select(size_type k) const {
+  return iterator(tree_.Select(k));
+}
+
+// Number of elements with a key in [lo, hi)
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+typename Set<value_type, NodeAlloc, Augment, Compare>::size_type
+Set<value_type, NodeAlloc, Augment, Compare>::count_range(
+    const value_type &lo, const value_type &hi) const {
+  return tree_.KeyCompare()(lo, hi) ? tree_.Rank(hi) - tree_.Rank(lo) : 0;
+}
+
+// Returns last, which stays valid
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+typename Set<value_type, NodeAlloc, Augment, Compare>::iterator
+Set<value_type, NodeAlloc, Augment, Compare>::erase(iterator first,
+                                                    iterator last) {
+  size_ -= tree_.EraseRange(first.current(), last.current());
+  return last;
+}
+
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+typename Set<value_type, NodeAlloc, Augment, Compare>::size_type
+Set<value_type, NodeAlloc, Augment, Compare>::erase_range(
+    const value_type &lo, const value_type &hi) {
+  std::size_t erased = tree_.EraseKeyRange(lo, hi);
+  size_ -= erased;
+  return erased;
+}
+
+template <class value_type, template <class> class NodeAlloc, class Augment,
+          class Compare>
+template <typename Fn>
+void Set<value_type, NodeAlloc, Augment, Compare>::for_each_in_range(
+    const value_type &lo, const value_type &hi, Fn fn) const {
+  tree_.ForEachInRange(lo, hi, [&fn](Node<value_type, NoValue, Augment> &node) {
+    fn(node.key);
+  });
+}
+
 }  // namespace s21
 
 #endif  // CPP2_S21_CONTAINERS_2_CONTAINERS_S21_SET_H_
@@ -52,18 +52,19 @@ class vector {
     if (this != &v) {
       myAllocator.deallocate(data_, capacity_);
       size_ = std::exchange(v.size_, 0);
-      if (this->capacity_ < v.capacity_)
-        capacity_ = std::exchange(v.capacity_, 0);
+      capacity_ = std::exchange(v.capacity_, 0);
       data_ = std::exchange(v.data_, nullptr);
     }
     return *this;
   }
 
   vector &operator=(vector &v) {
-    myAllocator.deallocate(data_, capacity_);
+    if (capacity_ < v.size_) {
+      myAllocator.deallocate(data_, capacity_);
+      capacity_ = v.size_;
+      data_ = myAllocator.allocate(capacity_);
+    }
     size_ = v.size_;
-    if (this->capacity_ < v.capacity_) capacity_ = v.capacity_;
-    data_ = myAllocator.allocate(size_);
     std::copy(v.data_, v.data_ + v.size_, data_);
     return *this;
   }
@@ -138,8 +139,11 @@ class vector {
 
   void shrink_to_fit() {
     if (capacity_ != size_) {
+      auto *buf = myAllocator.allocate(size_);
+      for (size_type i = 0; i < size_; i++) buf[i] = std::move(data_[i]);
+      myAllocator.deallocate(data_, capacity_);
+      data_ = buf;
       capacity_ = size_;
-      reserve(size_);
     }
   }
 
@@ -192,11 +196,7 @@ class vector {
   }
 
   void erase(iterator pos) {
-    iterator buff = myAllocator.allocate(size_ - 1);
-    for (size_type i = 0, j = 0; i < size_; i++)
-      if ((this->begin() + i) != pos) buff[j++] = this->data_[i];
-    myAllocator.deallocate(data_, size());
-    data_ = buff;
+    std::move(pos + 1, end(), pos);
     --size_;
   }
 
@@ -1,9 +1,11 @@
 #include <gtest/gtest.h>
 
 #include "./tests/s21_array_test.cc"
+#include "./tests/s21_interval_map_test.cc"
 #include "./tests/s21_list_test.cc"
 #include "./tests/s21_map_test.cc"
 #include "./tests/s21_queue_test.cc"
+#include "./tests/s21_range_set_test.cc"
 #include "./tests/s21_set_multiset_test.cc"
 #include "./tests/s21_stack_test.cc"
 #include "./tests/s21_vector_test.cc"
@@ -13,8 +13,8 @@ void prettyPrint(Node<Key, Value> *node, const std::string &prefix = "",
     std::cout << prefix;
     std::cout << (isLeft ? "\033[31m├──\033[0m" : "\033[32m└──\033[0m");
     std::cout << node->key << " ("
-              << (node->color == Color::Red ? "\033[31mRed\033[0m"
-                                            : "\033[32mBlack\033[0m")
+              << (node->GetColor() == Color::Red ? "\033[31mRed\033[0m"
+                                                 : "\033[32mBlack\033[0m")
               << ")" << std::endl;
     prettyPrint(node->left, prefix + (isLeft ? "\033[34m│   \033[0m" : " "),
                 true);
@@ -2,6 +2,8 @@
 #define CPP2_S21_CONTAINERS_SRC_S21_CONTAINERSPLUS_H_
 
 #include "containers/s21_array.h"
+#include "containers/s21_interval_map.h"
 #include "containers/s21_multiset.h"
+#include "containers/s21_range_set.h"
 
 #endif  // CPP2_S21_CONTAINERS_SRC_S21_CONTAINERSPLUS_H_
\ No newline at end of file
@@ -0,0 +1,178 @@
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "../s21_containersplus.h"
+#include "gtest/gtest.h"
+
+namespace {
+
+using Interval = std::tuple<int, int, int>;
+
+// Intervals of the reference list that overlap [lo, hi), in start order
+std::vector<Interval> ScanOverlaps(const std::vector<Interval> &intervals,
+                                   int lo, int hi) {
+  std::vector<Interval> found;
+  for (const Interval &interval : intervals) {
+    if (std::get<0>(interval) < hi && lo < std::get<1>(interval)) {
+      found.push_back(interval);
+    }
+  }
+  std::sort(found.begin(), found.end());
+  return found;
+}
+
+template <class IntervalMapT>
+std::vector<Interval> Overlaps(const IntervalMapT &map, int lo, int hi) {
+  std::vector<Interval> found;
+  map.for_each_overlap(lo, hi, [&found](int start, int end, int mapped) {
+    found.emplace_back(start, end, mapped);
+  });
+  // Equal starts come in insertion order, the reference sorts them
+  std::sort(found.begin(), found.end());
+  return found;
+}
+
+template <class IntervalMapT>
+std::vector<Interval> Containing(const IntervalMapT &map, int point) {
+  std::vector<Interval> found;
+  int last_start = -1;
+  map.for_each_containing(point, [&](int start, int end, int mapped) {
+    EXPECT_LE(last_start, start);
+    last_start = start;
+    found.emplace_back(start, end, mapped);
+  });
+  std::sort(found.begin(), found.end());
+  return found;
+}
+
+// Random intervals of up to max_length over [0, 1000), queried against a
+// linear scan before and after erasing every other interval
+template <class IntervalMapT>
+void CheckAgainstScan(int max_length) {
+  std::mt19937 rng(static_cast<unsigned>(max_length));
+  std::uniform_int_distribution<int> point(0, 999);
+  std::uniform_int_distribution<int> length(1, max_length);
+  IntervalMapT map;
+  std::vector<Interval> intervals;
+  for (int i = 0; i < 1500; ++i) {
+    int start = point(rng);
+    int end = start + length(rng);
+    map.insert(start, end, i);
+    intervals.emplace_back(start, end, i);
+  }
+  for (int round = 0; round < 2; ++round) {
+    ASSERT_EQ(map.size(), intervals.size());
+    for (int query = 0; query < 200; ++query) {
+      int lo = point(rng);
+      int hi = lo + length(rng) / 4 + 1;
+      std::vector<Interval> expected = ScanOverlaps(intervals, lo, hi);
+      EXPECT_EQ(Overlaps(map, lo, hi), expected);
+      EXPECT_EQ(Containing(map, lo), ScanOverlaps(intervals, lo, lo + 1));
+      auto first = map.find_overlap(lo, hi);
+      ASSERT_EQ(first == map.end(), expected.empty());
+      EXPECT_EQ(map.overlaps(lo, hi), !expected.empty());
+      if (!expected.empty()) {
+        EXPECT_EQ(first->key, std::get<0>(expected.front()));
+        EXPECT_LT(first->key, hi);
+        EXPECT_LT(lo, first->value.end);
+      }
+    }
+    // find may pick any of several equal intervals, drop the one it found
+    std::vector<bool> erased(1500);
+    for (std::size_t i = 0; i < intervals.size(); i += 2) {
+      auto it = map.find(std::get<0>(intervals[i]), std::get<1>(intervals[i]));
+      ASSERT_NE(it, map.end());
+      erased[it->value.mapped] = true;
+      map.erase(it);
+    }
+    std::vector<Interval> kept;
+    for (const Interval &interval : intervals) {
+      if (!erased[std::get<2>(interval)]) {
+        kept.push_back(interval);
+      }
+    }
+    intervals = kept;
+  }
+}
+
+}  // namespace
+
+TEST(IntervalMapTest, InsertFindErase) {
+  s21::IntervalMap<int, std::string> map;
+  EXPECT_TRUE(map.empty());
+  map.insert(5, 10, "b");
+  map.insert(1, 3, "a");
+  map.insert(5, 7, "c");
+  EXPECT_THROW(map.insert(4, 4, "empty"), std::invalid_argument);
+  EXPECT_THROW(map.insert(4, 2, "reversed"), std::invalid_argument);
+  ASSERT_EQ(map.size(), 3U);
+
+  std::vector<int> starts;
+  for (auto it = map.begin(); it != map.end(); ++it) {
+    starts.push_back(it->key);
+  }
+  EXPECT_EQ(starts, (std::vector<int>{1, 5, 5}));
+
+  auto it = map.find(5, 7);
+  ASSERT_NE(it, map.end());
+  EXPECT_EQ(it->value.mapped, "c");
+  EXPECT_EQ(map.find(5, 8), map.end());
+  EXPECT_EQ(map.erase(5, 8), 0U);
+  EXPECT_EQ(map.erase(5, 10), 1U);
+  EXPECT_EQ(map.size(), 2U);
+  EXPECT_EQ(map.find(5, 10), map.end());
+  EXPECT_THROW(map.erase(map.end()), std::out_of_range);
+  map.clear();
+  EXPECT_TRUE(map.empty());
+  EXPECT_FALSE(map.overlaps(0, 100));
+}
+
+TEST(IntervalMapTest, HalfOpenEnds) {
+  s21::IntervalMap<double, int> map;
+  map.insert(1, 3, 0);
+  map.insert(3, 5, 1);
+  EXPECT_FALSE(map.overlaps(0, 1));
+  EXPECT_FALSE(map.overlaps(5, 6));
+  EXPECT_FALSE(map.overlaps(4, 4));
+  EXPECT_EQ(map.find_overlap(2.5, 3.5)->key, 1);
+  EXPECT_EQ(map.find_overlap(3, 3.5)->key, 3);
+  std::vector<int> hits;
+  map.for_each_containing(
+      3, [&hits](double, double, int mapped) { hits.push_back(mapped); });
+  EXPECT_EQ(hits, (std::vector<int>{1}));
+  map.for_each_containing(
+      5, [&hits](double, double, int mapped) { hits.push_back(mapped); });
+  EXPECT_EQ(hits.size(), 1U);
+}
+
+TEST(IntervalMapTest, QueriesMatchScan) {
+  CheckAgainstScan<s21::IntervalMap<int, int>>(20);
+  CheckAgainstScan<s21::IntervalMap<int, int>>(400);
+  CheckAgainstScan<
+      s21::IntervalMap<int, int, s21::HeapNodeAllocator, s21::AVL<>>>(50);
+  CheckAgainstScan<
+      s21::IntervalMap<int, int, s21::HeapNodeAllocator, s21::Splay<>>>(50);
+  CheckAgainstScan<s21::IntervalMap<int, int, s21::IndexPoolAllocator>>(50);
+}
+
+TEST(IntervalMapTest, CopyAndMove) {
+  s21::IntervalMap<int, int, s21::IndexPoolAllocator> map;
+  for (int i = 0; i < 100; ++i) {
+    map.insert(i, i + 1 + i % 7, i);
+  }
+  s21::IntervalMap<int, int, s21::IndexPoolAllocator> copy(map);
+  map.clear();
+  EXPECT_EQ(copy.size(), 100U);
+  EXPECT_EQ(Overlaps(copy, 50, 51).size(), 4U);
+
+  s21::IntervalMap<int, int, s21::IndexPoolAllocator> moved(std::move(copy));
+  EXPECT_TRUE(copy.empty());
+  EXPECT_EQ(Overlaps(moved, 50, 51).size(), 4U);
+  map = moved;
+  EXPECT_EQ(Overlaps(map, 0, 200).size(), 100U);
+  moved = std::move(map);
+  EXPECT_EQ(moved.size(), 100U);
+  EXPECT_TRUE(moved.overlaps(99, 100));
+}
@@ -224,3 +224,68 @@ TEST(ConstIter, test1) {
   list<int>::const_iterator pos_2 = a.end();
   EXPECT_TRUE(pos == pos_2);
 }
+
+TEST(IndexPool, test1) {
+  list<int, s21::IndexPoolAllocator> a;
+  std::list<int> b;
+  for (int i = 0; i < 300; ++i) {
+    if (i % 3 == 0) {
+      a.push_front(i);
+      b.push_front(i);
+    } else {
+      a.push_back(i);
+      b.push_back(i);
+    }
+  }
+  a.insert(++a.begin(), -1);
+  b.insert(++b.begin(), -1);
+  a.erase(--a.end());
+  b.pop_back();
+  a.pop_front();
+  b.pop_front();
+  list<int, s21::IndexPoolAllocator> copy(a);
+  list<int, s21::IndexPoolAllocator> moved(std::move(a));
+  EXPECT_TRUE(a.empty());
+  ASSERT_EQ(copy.size(), b.size());
+  ASSERT_EQ(moved.size(), b.size());
+  auto expected = b.begin();
+  auto it = copy.begin();
+  for (auto m = moved.begin(); m != moved.end(); ++m, ++it, ++expected) {
+    EXPECT_EQ(*m, *expected);
+    EXPECT_EQ(*it, *expected);
+  }
+  EXPECT_EQ(*--copy.end(), b.back());
+}
+
+TEST(IndexPool, test2) {
+  list<int, s21::IndexPoolAllocator> a({1, 2, 3});
+  list<int, s21::IndexPoolAllocator> b({4, 5, 6});
+  a.splice(++a.begin(), b);
+  EXPECT_TRUE(b.empty());
+  list<int, s21::IndexPoolAllocator> c({7, 8});
+  a.merge(c);
+  EXPECT_TRUE(c.empty());
+  a.emplace_back(9);
+  int expected[] = {1, 4, 5, 6, 2, 3, 7, 8, 9};
+  ASSERT_EQ(a.size(), 9u);
+  int i = 0;
+  for (int value : a) EXPECT_EQ(value, expected[i++]);
+}
+
+// The argument refers into the pool that the insert grows
+TEST(IndexPool, test3) {
+  list<int, s21::IndexPoolAllocator> a{1, 2};
+  for (int i = 0; i < 100; ++i) {
+    a.push_back(a.front());
+    a.push_front(a.back());
+    a.insert(++a.begin(), a.front());
+  }
+  ASSERT_EQ(a.size(), 302U);
+  EXPECT_EQ(a.front(), 1);
+  EXPECT_EQ(a.back(), 1);
+  int twos = 0;
+  for (auto it = a.begin(); it != a.end(); ++it) {
+    twos += *it == 2;
+  }
+  EXPECT_EQ(twos, 1);
+}
@@ -135,7 +135,7 @@ TEST(MapTest, BeginAndEnd) {
   EXPECT_EQ((*it).value, "one");
 
   it = map.end();
-  ASSERT_EQ(it, nullptr);
+  ASSERT_FALSE(it);
   ASSERT_THROW(++it, std::out_of_range);
 }
 
@@ -717,3 +717,984 @@ TEST(MapTest, EmplaceSecond) {
   EXPECT_EQ(pair2.second, "two");
   EXPECT_EQ(pair2.first, 2);
 }
+
+TEST(MapTest, SlabAllocatorInsertEraseClear) {
+  s21::Map<int, std::string, s21::SlabNodeAllocator> map;
+  for (int i = 0; i < 1000; ++i) {
+    map.insert(i, std::to_string(i));
+  }
+  EXPECT_EQ(map.size(), 1000);
+  for (int i = 0; i < 1000; i += 2) {
+    map.erase(map.find(i));
+  }
+  EXPECT_EQ(map.size(), 500);
+  // Freed nodes are reused before new slabs are requested
+  for (int i = 0; i < 1000; i += 2) {
+    map.insert(i, "again");
+  }
+  EXPECT_EQ(map.at(10), "again");
+  EXPECT_EQ(map.at(11), "11");
+
+  map.clear();
+  EXPECT_TRUE(map.empty());
+  EXPECT_FALSE(map.contains(11));
+  EXPECT_EQ(map.begin(), map.end());
+  map.insert(1, "one");
+  EXPECT_EQ(map.at(1), "one");
+}
+
+TEST(MapTest, SlabAllocatorSwap) {
+  s21::Map<int, int, s21::SlabNodeAllocator> map1{{1, 10}, {2, 20}};
+  s21::Map<int, int, s21::SlabNodeAllocator> map2{{3, 30}};
+  map1.swap(map2);
+  EXPECT_EQ(map1.size(), 1);
+  EXPECT_EQ(map2.size(), 2);
+  EXPECT_EQ(map1.at(3), 30);
+  EXPECT_EQ(map2.at(2), 20);
+  map2.clear();
+  EXPECT_EQ(map1.at(3), 30);
+}
+
+TEST(MapTest, SlabAllocatorReleasesAllSlabs) {
+  s21::SlabNodeAllocator<s21::Node<int, int>> alloc;
+  EXPECT_EQ(alloc.slab_count(), 0);
+  s21::Node<int, int> *first = alloc.Allocate();
+  EXPECT_EQ(reinterpret_cast<std::uintptr_t>(first) % 64, 0);
+  for (int i = 0; i < 10000; ++i) {
+    alloc.Allocate();
+  }
+  EXPECT_GT(alloc.slab_count(), 1);
+  alloc.Deallocate(first);
+  EXPECT_EQ(alloc.Allocate(), first);
+  alloc.Release();
+  EXPECT_EQ(alloc.slab_count(), 0);
+}
+
+TEST(MapTest, SubscriptInsertsDefault) {
+  s21::Map<std::string, int> map;
+  ++map["a"];
+  ++map["a"];
+  map["b"];
+  EXPECT_EQ(map.size(), 2);
+  EXPECT_EQ(map.at("a"), 2);
+  EXPECT_EQ(map.at("b"), 0);
+}
+
+TEST(MapTest, InsertOrAssignReturnsNode) {
+  s21::Map<int, std::string> map{{1, "one"}};
+  auto [it, inserted] = map.insert_or_assign(1, "uno");
+  EXPECT_FALSE(inserted);
+  EXPECT_EQ(it, map.find(1));
+  EXPECT_EQ(it->value, "uno");
+  EXPECT_EQ(map.size(), 1);
+}
+
+TEST(MapTest, MergeWithItself) {
+  s21::Map<int, int> map{{1, 10}, {2, 20}};
+  map.merge(map);
+  EXPECT_EQ(map.size(), 2);
+  EXPECT_EQ(map.at(2), 20);
+}
+
+TEST(MapTest, InsertWithHint) {
+  s21::Map<int, int> map;
+  for (int i = 0; i < 100; ++i) {
+    map.insert(map.end(), {i, i * 10});
+  }
+  auto hint = map.begin();
+  for (int i = -1; i > -100; --i) {
+    hint = map.emplace_hint(hint, i, i * 10);
+  }
+  auto it = map.insert(map.find(7), {7, 0});
+  EXPECT_EQ(it->value, 70);
+  it = map.insert(map.begin(), {500, 5000});
+  EXPECT_EQ(it, map.find(500));
+  EXPECT_EQ(map.size(), 200);
+  int expected = -99;
+  for (auto item = map.begin(); item != map.end(); ++item) {
+    EXPECT_EQ(item->key, expected);
+    expected = expected == 99 ? 500 : expected + 1;
+  }
+}
+
+TEST(MapTest, RangeConstructor) {
+  std::vector<std::pair<int, std::string>> items{
+      {3, "three"}, {1, "one"}, {2, "two"}, {1, "uno"}};
+  s21::Map<int, std::string> map(items.begin(), items.end());
+  EXPECT_EQ(map.size(), 3);
+  EXPECT_EQ(map.at(1), "one");
+  EXPECT_EQ(map.begin()->key, 1);
+
+  s21::Map<int, std::string> copy(map);
+  EXPECT_EQ(copy.size(), 3);
+  EXPECT_EQ(copy.at(3), "three");
+}
+
+TEST(MapTest, AssignSorted) {
+  s21::Map<int, int> map{{100, 1}};
+  std::vector<std::pair<int, int>> items;
+  for (int i = 0; i < 1000; ++i) {
+    items.push_back({i, i * i});
+  }
+  map.assign_sorted(items.begin(), items.end());
+  EXPECT_EQ(map.size(), 1000);
+  EXPECT_EQ(map.at(100), 10000);
+  EXPECT_EQ(map.at(999), 999 * 999);
+  map.insert(-1, 1);
+  EXPECT_EQ(map.begin()->key, -1);
+}
+
+TEST(MapTest, BoundsMatchStdMap) {
+  s21::Map<int, int> map;
+  std::map<int, int> standart;
+  for (int i = 0; i < 1000; ++i) {
+    int key = (i * 7919) % 3001;
+    map.insert(key, i);
+    standart.insert({key, i});
+  }
+  for (int key = -1; key < 3003; ++key) {
+    auto low = map.lower_bound(key);
+    auto up = map.upper_bound(key);
+    auto range = map.equal_range(key);
+    auto standart_low = standart.lower_bound(key);
+    auto standart_up = standart.upper_bound(key);
+    ASSERT_EQ(low == map.end(), standart_low == standart.end());
+    ASSERT_EQ(up == map.end(), standart_up == standart.end());
+    if (standart_low != standart.end()) {
+      ASSERT_EQ(low->key, standart_low->first);
+      ASSERT_EQ(low->value, standart_low->second);
+    }
+    if (standart_up != standart.end()) {
+      ASSERT_EQ(up->key, standart_up->first);
+    }
+    EXPECT_EQ(range.first.current(), low.current());
+    EXPECT_EQ(range.second.current(), up.current());
+    EXPECT_EQ(map.count(key), standart.count(key));
+  }
+}
+
+TEST(MapTest, RankSelect) {
+  s21::Map<int, std::string, s21::HeapNodeAllocator, s21::OrderStatistic> map;
+  for (int i = 0; i < 100; ++i) {
+    map.insert(i * 10, std::to_string(i));
+  }
+  map.erase(map.find(500));
+  EXPECT_EQ(map.rank(0), 0);
+  EXPECT_EQ(map.rank(505), 50);
+  EXPECT_EQ(map.rank(510), 50);
+  EXPECT_EQ(map.select(50)->value, "51");
+  EXPECT_EQ(map.count_range(100, 600), 49);
+  EXPECT_EQ((map.begin() + 98)->key, 990);
+  EXPECT_EQ(map.select(99), map.end());
+}
+
+TEST(MapTest, ReverseIterationAndDecrementEnd) {
+  s21::Map<int, std::string> map{{2, "two"}, {1, "one"}, {3, "three"}};
+  auto it = map.end();
+  --it;
+  EXPECT_EQ(it->value, "three");
+  std::string order;
+  for (auto rit = map.rbegin(); rit != map.rend(); ++rit) {
+    order += rit->value;
+  }
+  EXPECT_EQ(order, "threetwoone");
+  map.erase(map.find(3));
+  EXPECT_EQ(map.rbegin()->key, 2);
+  map.erase(map.begin());
+  EXPECT_EQ(map.begin()->key, 2);
+}
+
+TEST(MapTest, PackedColorMap) {
+  s21::Map<int, int, s21::HeapNodeAllocator, s21::PackedColor<>> map;
+  std::map<int, int> standart;
+  for (int i = 0; i < 500; ++i) {
+    int key = (i * 37) % 211;
+    map.insert_or_assign(key, i);
+    standart[key] = i;
+  }
+  for (int key = 0; key < 211; key += 3) {
+    map.erase(map.find(key));
+    standart.erase(key);
+  }
+  ASSERT_EQ(map.size(), standart.size());
+  auto expected = standart.begin();
+  for (auto it = map.begin(); it != map.end(); ++it, ++expected) {
+    ASSERT_EQ(it->key, expected->first);
+    ASSERT_EQ(it->value, expected->second);
+  }
+  EXPECT_EQ((--map.end())->key, standart.rbegin()->first);
+}
+
+TEST(MapTest, IndexPoolMap) {
+  s21::Map<int, int, s21::IndexPoolAllocator> map;
+  std::map<int, int> standart;
+  for (int i = 0; i < 2000; ++i) {
+    int key = (i * 37) % 1009;
+    map.insert_or_assign(key, i);
+    standart[key] = i;
+  }
+  for (int key = 0; key < 1009; key += 3) {
+    map.erase(map.find(key));
+    standart.erase(key);
+  }
+  map.insert(5000, 1);
+  standart[5000] = 1;
+  s21::Map<int, int, s21::IndexPoolAllocator> copy(map);
+  map.clear();
+  ASSERT_EQ(copy.size(), standart.size());
+  auto expected = standart.begin();
+  for (auto it = copy.begin(); it != copy.end(); ++it, ++expected) {
+    ASSERT_EQ(it->key, expected->first);
+    ASSERT_EQ(it->value, expected->second);
+  }
+  EXPECT_EQ((--copy.end())->key, 5000);
+  EXPECT_TRUE(map.empty());
+}
+
+TEST(MapTest, ExtractAndInsertNode) {
+  s21::Map<int, std::string> map{{1, "one"}, {2, "two"}, {3, "three"}};
+  s21::Node<int, std::string> *two = map.find(2).current();
+  auto node = map.extract(2);
+  ASSERT_FALSE(node.empty());
+  EXPECT_EQ(map.size(), 2);
+  EXPECT_FALSE(map.contains(2));
+  EXPECT_EQ(node.key(), 2);
+  EXPECT_EQ(node.mapped(), "two");
+  EXPECT_TRUE(map.extract(7).empty());
+
+  node.key() = 5;
+  s21::Map<int, std::string> other{{4, "four"}};
+  auto [it, inserted] = other.insert(std::move(node));
+  EXPECT_TRUE(inserted);
+  EXPECT_TRUE(node.empty());
+  EXPECT_EQ(it.current(), two);
+  EXPECT_EQ(other.size(), 2);
+  EXPECT_EQ(other.at(5), "two");
+  EXPECT_EQ((--other.end())->key, 5);
+
+  auto duplicate = map.extract(map.begin());
+  duplicate.key() = 3;
+  EXPECT_FALSE(map.insert(std::move(duplicate)).second);
+  ASSERT_FALSE(duplicate.empty());
+  EXPECT_EQ(duplicate.mapped(), "one");
+  EXPECT_THROW(map.extract(map.end()), std::out_of_range);
+}
+
+TEST(MapTest, MergeRelinksNodes) {
+  s21::Map<int, int> big, few;
+  for (int i = 0; i < 1000; ++i) {
+    big.insert(i * 2, i);
+  }
+  few.insert(10, -1);
+  few.insert(11, -2);
+  s21::Node<int, int> *ten = few.find(10).current();
+  s21::Node<int, int> *eleven = few.find(11).current();
+  big.merge(few);
+  EXPECT_TRUE(few.empty());
+  EXPECT_EQ(big.size(), 1001);
+  EXPECT_EQ(big.find(10).current(), ten);
+  EXPECT_EQ(big.find(11).current(), eleven);
+  EXPECT_EQ(big.at(10), -1);
+
+  s21::Map<int, int> many;
+  for (int i = 0; i < 1000; ++i) {
+    many.insert(i * 3, -i);
+  }
+  s21::Node<int, int> *last = many.find(2997).current();
+  big.merge(many);
+  EXPECT_TRUE(many.empty());
+  EXPECT_EQ(big.find(2997).current(), last);
+  EXPECT_EQ(big.at(6), -2);
+  std::size_t count = 0;
+  int previous = -1;
+  for (auto it = big.begin(); it != big.end(); ++it, ++count) {
+    ASSERT_LT(previous, it->key);
+    previous = it->key;
+  }
+  EXPECT_EQ(count, big.size());
+  EXPECT_EQ((--big.end())->key, 2997);
+}
+
+TEST(MapTest, SetAlgebraKeepsLhsValues) {
+  s21::Map<int, std::string> lhs{{1, "a"}, {2, "b"}, {3, "c"}, {5, "e"}};
+  s21::Map<int, std::string> rhs{{2, "B"}, {4, "D"}, {5, "E"}, {6, "F"}};
+  auto all = set_union(lhs, rhs);
+  std::vector<std::pair<int, std::string>> expected{
+      {1, "a"}, {2, "b"}, {3, "c"}, {4, "D"}, {5, "e"}, {6, "F"}};
+  ASSERT_EQ(all.size(), expected.size());
+  std::size_t k = 0;
+  for (auto it = all.begin(); it != all.end(); ++it, ++k) {
+    EXPECT_EQ(it->key, expected[k].first);
+    EXPECT_EQ(it->value, expected[k].second);
+  }
+  auto both = set_intersection(lhs, rhs);
+  ASSERT_EQ(both.size(), 2u);
+  EXPECT_EQ(both.at(2), "b");
+  EXPECT_EQ(both.at(5), "e");
+  auto only = set_difference(lhs, rhs);
+  ASSERT_EQ(only.size(), 2u);
+  EXPECT_EQ(only.at(1), "a");
+  EXPECT_EQ(only.at(3), "c");
+  auto either = set_symmetric_difference(std::move(lhs), std::move(rhs));
+  ASSERT_EQ(either.size(), 4u);
+  EXPECT_EQ(either.at(4), "D");
+  EXPECT_EQ(either.at(6), "F");
+  EXPECT_FALSE(either.contains(2));
+}
+
+TEST(MapTest, ParallelMergeTakesTheirValues) {
+  s21::ThreadPool pool(4);
+  s21::Map<int, int> map, other;
+  for (int i = 0; i < 100000; ++i) {
+    map.insert(i * 2, 0);
+    other.insert(i * 3, 1);
+  }
+  map.merge(other, pool);
+  EXPECT_TRUE(other.empty());
+  EXPECT_EQ(map.size(), 100000u + 100000u - 33334u);
+  int previous = -1;
+  for (auto it = map.begin(); it != map.end(); ++it) {
+    ASSERT_LT(previous, it->key);
+    ASSERT_EQ(it->value, it->key % 3 == 0 && it->key < 300000 ? 1 : 0);
+    previous = it->key;
+  }
+}
+
+namespace {
+
+// Counts how often any instance is copied and moved
+struct MoveCounter {
+  static int copies;
+  static int moves;
+  int id{};
+  MoveCounter() = default;
+  explicit MoveCounter(int value) : id(value) {}
+  MoveCounter(const MoveCounter &other) : id(other.id) { ++copies; }
+  MoveCounter(MoveCounter &&other) noexcept : id(other.id) { ++moves; }
+  MoveCounter &operator=(const MoveCounter &other) {
+    id = other.id;
+    ++copies;
+    return *this;
+  }
+  MoveCounter &operator=(MoveCounter &&other) noexcept {
+    id = other.id;
+    ++moves;
+    return *this;
+  }
+  bool operator<(const MoveCounter &other) const { return id < other.id; }
+};
+
+int MoveCounter::copies = 0;
+int MoveCounter::moves = 0;
+
+}  // namespace
+
+TEST(MapTest, EraseRelinksNodes) {
+  s21::Map<int, MoveCounter> map;
+  std::vector<s21::Map<int, MoveCounter>::iterator> its(1000);
+  for (int i = 0; i < 1000; ++i) {
+    int key = i * 7919 % 1000;
+    its[key] = map.insert(key, MoveCounter(i)).first;
+  }
+  MoveCounter::copies = MoveCounter::moves = 0;
+  // Half of the inner nodes go, most of them with two children
+  for (int key = 0; key < 1000; key += 2) {
+    map.erase(its[key]);
+  }
+  EXPECT_EQ(MoveCounter::copies, 0);
+  EXPECT_EQ(MoveCounter::moves, 0);
+  EXPECT_EQ(map.size(), 500u);
+  for (int key = 1; key < 1000; key += 2) {
+    ASSERT_EQ(its[key]->key, key);
+    ASSERT_EQ(its[key]->value.id * 7919 % 1000, key);
+    ASSERT_EQ(map.find(key), its[key]);
+  }
+}
+
+TEST(MapTest, EmplaceBuildsValuesInPlace) {
+  s21::Map<int, MoveCounter> map;
+  MoveCounter::copies = MoveCounter::moves = 0;
+  EXPECT_TRUE(map.try_emplace(1, 10).second);
+  EXPECT_TRUE(map.emplace(std::piecewise_construct, std::forward_as_tuple(2),
+                          std::forward_as_tuple(20))
+                  .second);
+  EXPECT_FALSE(map.emplace(std::piecewise_construct, std::forward_as_tuple(2),
+                           std::forward_as_tuple(21))
+                   .second);
+  map[3].id = 30;
+  EXPECT_EQ(MoveCounter::copies, 0);
+  EXPECT_EQ(MoveCounter::moves, 0);
+
+  // A pair is moved into the node, never copied
+  map.insert(std::make_pair(4, MoveCounter(40)));
+  map.insert(map.end(), std::make_pair(5, MoveCounter(50)));
+  map.insert_or_assign(1, MoveCounter(11));
+  map.emplace_hint(map.end(), 6, MoveCounter(60));
+  EXPECT_EQ(MoveCounter::copies, 0);
+  EXPECT_EQ(map.size(), 6u);
+  EXPECT_EQ(map.at(1).id, 11);
+  EXPECT_EQ(map.at(2).id, 20);
+  EXPECT_EQ(map.at(6).id, 60);
+}
+
+TEST(MapTest, EmplaceBuildsKeysInPlace) {
+  s21::Map<MoveCounter, MoveCounter> map;
+  auto zero = std::make_pair(MoveCounter(0), MoveCounter(0));
+  auto two = std::make_pair(MoveCounter(2), MoveCounter(20));
+  auto four = std::make_pair(MoveCounter(4), MoveCounter(40));
+  auto again = std::make_pair(MoveCounter(4), MoveCounter(41));
+  MoveCounter::copies = MoveCounter::moves = 0;
+  // Every element is one key move and one value move, a pair is split
+  map.emplace(std::move(two), std::move(four));
+  map.emplace_hint(map.end(), MoveCounter(6), MoveCounter(60));
+  map.emplace_hint(map.begin(), std::move(zero));
+  EXPECT_EQ(MoveCounter::copies, 0);
+  EXPECT_EQ(MoveCounter::moves, 8);
+  // A key already present builds the node and destroys it again
+  EXPECT_FALSE(map.emplace(std::move(again))[0].second);
+  auto it = map.emplace_hint(map.end(), MoveCounter(6), MoveCounter(61));
+  EXPECT_EQ(it->value.id, 60);
+  EXPECT_EQ(MoveCounter::copies, 0);
+  EXPECT_EQ(MoveCounter::moves, 12);
+  ASSERT_EQ(map.size(), 4u);
+  int expected = 0;
+  for (auto element = map.begin(); element != map.end(); ++element) {
+    EXPECT_EQ(element->key.id, expected);
+    EXPECT_EQ(element->value.id, expected * 10);
+    expected += 2;
+  }
+}
+
+TEST(MapTest, MoveOnlyValues) {
+  s21::Map<std::string, std::unique_ptr<int>> map;
+  auto [it, inserted] = map.try_emplace("one", std::make_unique<int>(1));
+  EXPECT_TRUE(inserted);
+  EXPECT_EQ(*it->value, 1);
+  auto two = std::make_unique<int>(2);
+  EXPECT_FALSE(map.try_emplace("one", std::move(two)).second);
+  ASSERT_NE(two, nullptr);
+  map.insert_or_assign("two", std::move(two));
+  EXPECT_EQ(two, nullptr);
+  map.insert_or_assign("one", std::make_unique<int>(11));
+  map["three"] = std::make_unique<int>(3);
+  std::string key = "four";
+  map[std::move(key)] = std::make_unique<int>(4);
+  map.insert({"five", std::make_unique<int>(5)});
+  EXPECT_EQ(map.size(), 5u);
+  EXPECT_EQ(*map.at("one"), 11);
+  EXPECT_EQ(*map.at("four"), 4);
+  map.erase(map.find("two"));
+  auto node = map.extract("three");
+  EXPECT_EQ(*node.mapped(), 3);
+  s21::Map<std::string, std::unique_ptr<int>> other;
+  other.insert(std::move(node));
+  other.merge(map);
+  EXPECT_EQ(other.size(), 4u);
+  EXPECT_EQ(*other.at("five"), 5);
+}
+
+namespace {
+
+// Key that counts how many were built, looked up by its plain int
+struct CountedKey {
+  static int built;
+  int id;
+  CountedKey(int value) : id(value) { ++built; }
+  CountedKey(const CountedKey &other) : id(other.id) { ++built; }
+};
+
+int CountedKey::built = 0;
+
+// Transparent ordering of CountedKeys and ints that counts its calls
+struct CountingLess {
+  using is_transparent = void;
+  static long calls;
+  static int Id(const CountedKey &key) { return key.id; }
+  static int Id(int id) { return id; }
+  template <class A, class B>
+  bool operator()(const A &lhs, const B &rhs) const {
+    ++calls;
+    return Id(lhs) < Id(rhs);
+  }
+};
+
+long CountingLess::calls = 0;
+
+// Orders ints by their remainder, has no default constructor
+struct ModuloLess {
+  explicit ModuloLess(int divisor) : divisor(divisor) {}
+  bool operator()(int lhs, int rhs) const {
+    return lhs % divisor < rhs % divisor;
+  }
+  int divisor;
+};
+
+}  // namespace
+
+TEST(MapTest, CustomComparatorOrdersKeys) {
+  using Descending = s21::Map<int, int, s21::HeapNodeAllocator, s21::NoAugment,
+                              std::greater<int>>;
+  Descending map{{1, 10}, {3, 30}, {2, 20}, {5, 50}};
+  std::vector<int> keys;
+  for (auto it = map.begin(); it != map.end(); ++it) {
+    keys.push_back(it->key);
+  }
+  EXPECT_EQ(keys, (std::vector<int>{5, 3, 2, 1}));
+  EXPECT_EQ(map.lower_bound(4)->key, 3);
+  EXPECT_EQ(map.upper_bound(3)->key, 2);
+  EXPECT_EQ(map.find(2)->value, 20);
+  EXPECT_EQ(map.find(4), map.end());
+  EXPECT_FALSE(map.insert(3, 31).second);
+  map.insert(4, 40);
+  Descending other{{0, 0}, {4, 41}, {6, 60}};
+  map.merge(other);
+  keys.clear();
+  for (auto it = map.begin(); it != map.end(); ++it) {
+    keys.push_back(it->key);
+  }
+  EXPECT_EQ(keys, (std::vector<int>{6, 5, 4, 3, 2, 1, 0}));
+  EXPECT_EQ(map.at(4), 41);
+  Descending copy(map);
+  EXPECT_EQ(copy.begin()->key, 6);
+  Descending odd = set_difference(std::move(copy),
+                                  Descending{{0, 0}, {2, 0}, {4, 0}, {6, 0}});
+  EXPECT_EQ(odd.size(), 3u);
+  EXPECT_EQ(odd.begin()->key, 5);
+}
+
+TEST(MapTest, StatefulComparator) {
+  s21::Map<int, int, s21::HeapNodeAllocator, s21::NoAugment, ModuloLess> map(
+      ModuloLess(10));
+  map.insert(21, 1);
+  map.insert(13, 2);
+  EXPECT_FALSE(map.insert(31, 3).second);
+  EXPECT_TRUE(map.contains(1));
+  EXPECT_EQ(map.begin()->key, 21);
+  EXPECT_TRUE(map.key_comp()(21, 13));
+  auto copy = map;
+  EXPECT_EQ(copy.find(3)->key, 13);
+  auto moved = std::move(copy);
+  EXPECT_EQ(moved.key_comp().divisor, 10);
+  EXPECT_EQ(moved.find(1)->value, 1);
+}
+
+TEST(MapTest, TransparentLookupBuildsNoKey) {
+  s21::Map<CountedKey, int, s21::HeapNodeAllocator, s21::NoAugment,
+           CountingLess>
+      map;
+  for (int i = 0; i < 100; i += 2) {
+    map.insert(i, i);
+  }
+  CountedKey::built = 0;
+  EXPECT_EQ(map.find(42)->value, 42);
+  EXPECT_EQ(map.find(43), map.end());
+  EXPECT_TRUE(map.contains(0));
+  EXPECT_EQ(map.count(98), 1u);
+  EXPECT_EQ(map.count(99), 0u);
+  EXPECT_EQ(map.lower_bound(43)->value, 44);
+  EXPECT_EQ(map.upper_bound(44)->value, 46);
+  auto [lower, upper] = map.equal_range(50);
+  EXPECT_EQ(lower->value, 50);
+  EXPECT_EQ(upper->value, 52);
+  EXPECT_EQ(CountedKey::built, 0);
+
+  s21::Map<std::string, int, s21::HeapNodeAllocator, s21::NoAugment,
+           std::less<>>
+      words{{"apple", 1}, {"pear", 2}};
+  EXPECT_EQ(words.find("pear")->value, 2);
+  EXPECT_TRUE(words.contains(std::string_view("apple")));
+  EXPECT_EQ(words.lower_bound("b")->key, "pear");
+}
+
+TEST(MapTest, OneComparisonPerLevel) {
+  s21::Map<CountedKey, int, s21::HeapNodeAllocator, s21::NoAugment,
+           CountingLess>
+      map;
+  for (int i = 0; i < 1023; ++i) {
+    map.insert(i * 7919 % 1023, i);
+  }
+  // A red-black tree of 1023 nodes is at most 20 levels deep; every search
+  // compares once per level and once more to detect the equal key
+  for (int i = 0; i < 1023; ++i) {
+    CountingLess::calls = 0;
+    ASSERT_FALSE(map.insert(i, 0).second);
+    ASSERT_LE(CountingLess::calls, 21);
+    CountingLess::calls = 0;
+    ASSERT_NE(map.find(i), map.end());
+    ASSERT_LE(CountingLess::calls, 21);
+  }
+}
+
+TEST(MapTest, FindBatchMatchesFind) {
+  s21::Map<int, int> map;
+  for (int i = 0; i < 5000; ++i) {
+    map.insert(i * 7919 % 10007, i);
+  }
+  std::vector<int> keys;
+  for (int i = 0; i < 1000; ++i) {
+    keys.push_back(i * 31 % 10007 - 5);
+  }
+  std::vector<s21::Map<int, int>::iterator> found;
+  map.find_batch(keys.begin(), keys.end(), std::back_inserter(found));
+  std::vector<bool> present(keys.size());
+  EXPECT_EQ(map.contains_batch(keys.begin(), keys.end(), present.begin()),
+            present.end());
+  ASSERT_EQ(found.size(), keys.size());
+  for (std::size_t i = 0; i < keys.size(); ++i) {
+    ASSERT_EQ(found[i], map.find(keys[i]));
+    ASSERT_EQ(present[i], map.contains(keys[i]));
+  }
+
+  s21::Map<int, int> empty;
+  bool none[3] = {true, true, true};
+  empty.contains_batch(keys.begin(), keys.begin() + 3, none);
+  EXPECT_FALSE(none[0] || none[1] || none[2]);
+  EXPECT_EQ(map.find_batch(keys.begin(), keys.begin(), found.begin()),
+            found.begin());
+}
+
+TEST(MapTest, FindBatchTransparentKeys) {
+  s21::Map<std::string, int, s21::HeapNodeAllocator, s21::NoAugment,
+           std::less<>>
+      map{{"a", 1}, {"c", 3}};
+  const char *keys[] = {"c", "b", "a"};
+  bool present[3];
+  map.contains_batch(std::begin(keys), std::end(keys), present);
+  EXPECT_TRUE(present[0]);
+  EXPECT_FALSE(present[1]);
+  EXPECT_TRUE(present[2]);
+}
+
+TEST(MapTest, CursorMatchesFind) {
+  s21::Map<int, int> map;
+  for (int i = 0; i < 2000; i += 2) {
+    map.insert(i * 7919 % 2000, i);
+  }
+  s21::Map<int, int>::cursor cursor(map);
+  EXPECT_EQ(cursor.position(), map.end());
+  // Local walk with jumps back and forth, hits and misses
+  int key = 1000;
+  for (int step = 0; step < 3000; ++step) {
+    key = (key + (step % 7) * (step % 2 ? 1 : -1) + 2001) % 2001;
+    ASSERT_EQ(cursor.find(key), map.find(key)) << key;
+    ASSERT_EQ(cursor.lower_bound(key - 1), map.lower_bound(key - 1));
+  }
+  EXPECT_EQ(cursor.find(5000), map.end());
+  EXPECT_EQ(cursor.lower_bound(-5), map.begin());
+  EXPECT_EQ(cursor.position(), map.begin());
+  // Fill in the odd keys around the finger
+  for (int i = 1999; i > 0; i -= 2) {
+    EXPECT_TRUE(cursor.insert(i, -i).second);
+    EXPECT_EQ(cursor.position()->key, i);
+  }
+  EXPECT_FALSE(cursor.insert({10, 0}).second);
+  EXPECT_EQ(map.size(), 2000u);
+  int expected = 0;
+  for (auto it = map.begin(); it != map.end(); ++it, ++expected) {
+    ASSERT_EQ(it->key, expected);
+  }
+  cursor.reset();
+  EXPECT_EQ(cursor.position(), map.end());
+}
+
+TEST(MapTest, CursorSearchesNearTheFinger) {
+  s21::Map<CountedKey, int, s21::HeapNodeAllocator, s21::NoAugment,
+           CountingLess>
+      map;
+  s21::Map<CountedKey, int, s21::HeapNodeAllocator, s21::NoAugment,
+           CountingLess>::cursor cursor(map);
+  for (int i = 0; i < 1 << 16; ++i) {
+    cursor.insert(i, i);
+  }
+  CountingLess::calls = 0;
+  for (int i = 0; i < 1 << 16; ++i) {
+    ASSERT_EQ(map.find(i)->value, i);
+  }
+  long plain = CountingLess::calls;
+  CountingLess::calls = 0;
+  for (int i = 0; i < 1 << 16; ++i) {
+    ASSERT_EQ(cursor.find(i)->value, i);
+  }
+  // A plain find compares about 17 times, a step to the next key about 6
+  EXPECT_LT(CountingLess::calls * 2, plain);
+}
+
+TEST(MapTest, CursorOnIndexPool) {
+  s21::Map<int, int, s21::IndexPoolAllocator> map;
+  s21::Map<int, int, s21::IndexPoolAllocator>::cursor cursor(map);
+  // The pool grows and moves the finger along with the nodes
+  for (int i = 0; i < 10000; ++i) {
+    ASSERT_TRUE(cursor.insert(i, i * 2).second);
+    ASSERT_EQ(cursor.position()->value, i * 2);
+  }
+  EXPECT_EQ(map.size(), 10000u);
+  EXPECT_EQ(cursor.find(4321)->value, 8642);
+}
+
+TEST(MapTest, BalancePolicies) {
+  s21::Map<int, std::string, s21::HeapNodeAllocator, s21::AVL<>> avl;
+  s21::Map<int, std::string, s21::HeapNodeAllocator, s21::Splay<>> splay;
+  std::map<int, std::string> standart;
+  std::srand(23);
+  for (int i = 0; i < 2000; ++i) {
+    int key = std::rand() % 500;
+    if (i % 3 == 0 && standart.count(key) != 0) {
+      avl.erase(avl.find(key));
+      splay.erase(splay.find(key));
+      standart.erase(key);
+    } else {
+      avl[key] = std::to_string(i);
+      splay.insert_or_assign(key, std::to_string(i));
+      standart[key] = std::to_string(i);
+    }
+  }
+  ASSERT_EQ(avl.size(), standart.size());
+  ASSERT_EQ(splay.size(), standart.size());
+  auto avl_it = avl.begin();
+  auto splay_it = splay.begin();
+  for (const auto &[key, value] : standart) {
+    EXPECT_EQ(avl_it->key, key);
+    EXPECT_EQ(splay_it->value, value);
+    EXPECT_EQ(splay.at(key), value);
+    ++avl_it;
+    ++splay_it;
+  }
+  // Nodes move between trees of the same policy
+  auto node = avl.extract(avl.begin());
+  s21::Map<int, std::string, s21::HeapNodeAllocator, s21::AVL<>> other;
+  EXPECT_TRUE(other.insert(std::move(node)).second);
+  other.merge(avl);
+  EXPECT_EQ(other.size(), standart.size());
+  EXPECT_TRUE(avl.empty());
+}
+
+TEST(MapTest, Threaded) {
+  using ThreadedMap =
+      s21::Map<int, int, s21::HeapNodeAllocator, s21::Threaded<>>;
+  ThreadedMap map, other;
+  std::map<int, int> standart;
+  for (int i = 0; i < 500; ++i) {
+    int key = i * 37 % 500;
+    map.insert(key, i);
+    standart[key] = i;
+    if (i % 4 == 0 && standart.count(key / 2) != 0) {
+      map.erase(map.find(key / 2));
+      standart.erase(key / 2);
+    }
+  }
+  other.insert(-1, -1);
+  map.swap(other);
+  ASSERT_EQ(map.size(), 1);
+  EXPECT_EQ((--map.end())->key, -1);
+  ThreadedMap moved(std::move(other));
+  ASSERT_EQ(moved.size(), standart.size());
+  auto it = moved.begin();
+  for (const auto &[key, value] : standart) {
+    EXPECT_EQ(it->key, key);
+    EXPECT_EQ(it->value, value);
+    ++it;
+  }
+  EXPECT_EQ(it, moved.end());
+  auto back = moved.end();
+  for (auto pair = standart.rbegin(); pair != standart.rend(); ++pair) {
+    --back;
+    EXPECT_EQ(back->key, pair->first);
+  }
+  EXPECT_EQ(back, moved.begin());
+  EXPECT_EQ(moved.lower_bound(250)->key, standart.lower_bound(250)->first);
+  // A small merge relinks the nodes one by one and replaces equal keys
+  ThreadedMap small;
+  for (int key = 0; key < 500; key += 50) {
+    small.insert(key, -key);
+    standart[key] = -key;
+  }
+  moved.merge(small);
+  it = moved.begin();
+  for (const auto &[key, value] : standart) {
+    EXPECT_EQ(it->key, key);
+    EXPECT_EQ(it->value, value);
+    ++it;
+  }
+  EXPECT_EQ(it, moved.end());
+  EXPECT_EQ((--moved.end())->key, standart.rbegin()->first);
+  ThreadedMap copy(moved);
+  EXPECT_EQ(copy.size(), moved.size());
+  EXPECT_EQ((--copy.end())->key, standart.rbegin()->first);
+}
+
+TEST(MapTest, RangeErase) {
+  std::map<int, int> standart;
+  s21::Map<int, int> map;
+  s21::Map<int, int, s21::HeapNodeAllocator, s21::AVL<>> avl;
+  for (int i = 0; i < 2000; ++i) {
+    map.insert(i, -i);
+    avl.insert(i, -i);
+    standart[i] = -i;
+  }
+  // Short ranges go node by node, long ones are split off
+  const std::pair<int, int> ranges[] = {{10, 15},     {100, 400}, {-5, 3},
+                                        {1990, 5000}, {600, 600}, {800, 700}};
+  for (auto [lo, hi] : ranges) {
+    std::size_t expected = 0;
+    if (lo < hi) {
+      auto first = standart.lower_bound(lo), last = standart.lower_bound(hi);
+      expected = std::distance(first, last);
+      standart.erase(first, last);
+    }
+    EXPECT_EQ(map.erase_range(lo, hi), expected);
+    EXPECT_EQ(avl.erase_range(lo, hi), expected);
+    ASSERT_EQ(map.size(), standart.size());
+    ASSERT_EQ(avl.size(), standart.size());
+  }
+  auto last = map.erase(map.find(1000), map.find(1500));
+  EXPECT_EQ(last->key, 1500);
+  standart.erase(standart.find(1000), standart.find(1500));
+  ASSERT_EQ(map.size(), standart.size());
+  auto it = map.begin();
+  for (const auto &[key, value] : standart) {
+    EXPECT_EQ(it->key, key);
+    EXPECT_EQ(it->value, value);
+    ++it;
+  }
+  EXPECT_EQ(it, map.end());
+  EXPECT_EQ((--map.end())->key, standart.rbegin()->first);
+  // Erase on from a found element to the end, then everything
+  map.erase(map.find(1800), map.end());
+  EXPECT_EQ((--map.end())->key, 1799);
+  map.insert(3000, 0);
+  EXPECT_EQ(map.erase(map.begin(), map.end()), map.end());
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(map.begin(), map.end());
+  map.insert(1, 1);
+  EXPECT_EQ(map.size(), 1);
+}
+
+TEST(MapTest, ForEachInRange) {
+  s21::Map<int, std::string> map;
+  for (int i = 0; i < 100; i += 3) {
+    map.insert(i, std::to_string(i));
+  }
+  std::vector<int> keys;
+  std::string values;
+  map.for_each_in_range(10, 22, [&](const int &key, std::string &value) {
+    keys.push_back(key);
+    values += value;
+    value += "!";
+  });
+  EXPECT_EQ(keys, (std::vector<int>{12, 15, 18, 21}));
+  EXPECT_EQ(values, "12151821");
+  EXPECT_EQ(map.at(12), "12!");
+  EXPECT_EQ(map.at(9), "9");
+  int calls = 0;
+  map.for_each_in_range(22, 10, [&](const int &, std::string &) { ++calls; });
+  map.for_each_in_range(100, 200, [&](const int &, std::string &) { ++calls; });
+  EXPECT_EQ(calls, 0);
+}
+
+// Composition of the maps x -> a * x + b in key order, which does not
+// commute: (a, b) then (c, d) is x -> c * (a * x + b) + d
+struct AffineOf {
+  using type = std::pair<std::uint64_t, std::uint64_t>;
+  static type Identity() noexcept { return {1, 0}; }
+  static type Combine(const type &first, const type &second) noexcept {
+    return {second.first * first.first,
+            second.first * first.second + second.second};
+  }
+  template <class NodeT>
+  static type Lift(const NodeT &node) noexcept {
+    return {static_cast<std::uint64_t>(node.value),
+            static_cast<std::uint64_t>(node.key)};
+  }
+};
+
+TEST(MapTest, Aggregate) {
+  s21::Map<int, long, s21::IndexPoolAllocator,
+           s21::IndexLinked<s21::SubtreeAggregate<s21::SumOf<long>>>>
+      sums;
+  s21::Map<int, double, s21::HeapNodeAllocator,
+           s21::SubtreeAggregate<s21::MinOf<double>, s21::OrderStatistic>>
+      mins;
+  s21::Map<int, int, s21::HeapNodeAllocator, s21::SubtreeAggregate<AffineOf>>
+      affine;
+  std::map<int, long> standart;
+  std::srand(31);
+  for (int i = 0; i < 3000; ++i) {
+    int key = std::rand() % 1000;
+    long value = std::rand() % 100 - 50;
+    if (i % 4 == 0 && standart.count(key) != 0) {
+      sums.erase(sums.find(key));
+      mins.erase(mins.find(key));
+      affine.erase(affine.find(key));
+      standart.erase(key);
+    } else {
+      sums.insert_or_assign(key, value);
+      mins.insert_or_assign(key, static_cast<double>(value));
+      affine.insert_or_assign(key, static_cast<int>(value));
+      standart[key] = value;
+    }
+  }
+  for (int i = 0; i < 300; ++i) {
+    int lo = std::rand() % 1100 - 50, hi = std::rand() % 1100 - 50;
+    long sum = 0;
+    double min = std::numeric_limits<double>::infinity();
+    AffineOf::type composed = AffineOf::Identity();
+    for (auto it = standart.lower_bound(lo);
+         it != standart.end() && lo < hi && it->first < hi; ++it) {
+      sum += it->second;
+      min = std::min(min, static_cast<double>(it->second));
+      composed =
+          AffineOf::Combine(composed, {static_cast<std::uint64_t>(it->second),
+                                       static_cast<std::uint64_t>(it->first)});
+    }
+    ASSERT_EQ(sums.aggregate(lo, hi), sum) << lo << " " << hi;
+    ASSERT_EQ(mins.aggregate(lo, hi), min);
+    ASSERT_EQ(affine.aggregate(lo, hi), composed);
+  }
+  EXPECT_EQ(sums.aggregate(5, 5), 0);
+  EXPECT_EQ(mins.aggregate(2000, 3000),
+            std::numeric_limits<double>::infinity());
+}
+
+TEST(MapTest, AggregateAfterChanges) {
+  using SumMap = s21::Map<int, long, s21::HeapNodeAllocator,
+                          s21::SubtreeAggregate<s21::SumOf<long>>>;
+  SumMap map, other;
+  for (int i = 0; i < 1000; ++i) {
+    map.insert(i, i);
+  }
+  EXPECT_EQ(map.aggregate(0, 1000), 999 * 1000 / 2);
+  // Writes in place count once refreshed
+  map[10] = 1010;
+  map.refresh(map.find(10));
+  map.at(20) = 1020;
+  map.refresh(map.find(20));
+  EXPECT_EQ(map.aggregate(0, 1000), 999 * 1000 / 2 + 2000);
+  EXPECT_EQ(map.aggregate(10, 11), 1010);
+  EXPECT_THROW(map.refresh(map.end()), std::out_of_range);
+  map.erase_range(100, 200);
+  EXPECT_EQ(map.aggregate(0, 1000), 999 * 1000 / 2 + 2000 - 14950);
+  EXPECT_EQ(map.aggregate(90, 210), 90 + 91 + 92 + 93 + 94 + 95 + 96 + 97 + 98 +
+                                        99 + 200 + 201 + 202 + 203 + 204 + 205 +
+                                        206 + 207 + 208 + 209);
+  // Merges replace the values of equal keys
+  for (int i = 0; i < 50; ++i) {
+    other.insert(2 * i, 1);
+  }
+  map.merge(other);
+  long expected = 0;
+  for (auto it = map.begin(); it != map.end(); ++it) {
+    expected += it->value;
+  }
+  EXPECT_EQ(map.aggregate(-1, 1000), expected);
+  // Set algebra splits and joins the trees
+  SumMap evens, odds;
+  for (int i = 0; i < 500; ++i) {
+    evens.insert(2 * i, 2 * i);
+    odds.insert(2 * i + 1, 2 * i + 1);
+  }
+  SumMap all = set_union(std::move(evens), std::move(odds));
+  EXPECT_EQ(all.aggregate(0, 1000), 999 * 1000 / 2);
+  EXPECT_EQ(all.aggregate(250, 750), (250 + 749) * 500 / 2);
+  SumMap copy(all);
+  EXPECT_EQ(copy.aggregate(250, 750), (250 + 749) * 500 / 2);
+}
@@ -0,0 +1,155 @@
+#include <cstdint>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "../s21_containersplus.h"
+#include "gtest/gtest.h"
+
+namespace {
+
+// Maximal runs of consecutive values of a reference set
+std::vector<std::pair<int, int>> Runs(const std::set<int> &values) {
+  std::vector<std::pair<int, int>> runs;
+  for (int value : values) {
+    if (!runs.empty() && runs.back().second + 1 == value) {
+      runs.back().second = value;
+    } else {
+      runs.emplace_back(value, value);
+    }
+  }
+  return runs;
+}
+
+template <class RangeSetT>
+void ExpectMatches(const RangeSetT &ranges, const std::set<int> &values,
+                   int domain) {
+  std::vector<std::pair<int, int>> stored;
+  for (auto it = ranges.begin(); it != ranges.end(); ++it) {
+    stored.emplace_back(it->key, it->value);
+  }
+  ASSERT_EQ(stored, Runs(values));
+  EXPECT_EQ(ranges.size(), stored.size());
+  for (int value = -1; value <= domain; ++value) {
+    EXPECT_EQ(ranges.contains(value), values.count(value) != 0);
+    int free = value;
+    while (values.count(free) != 0) {
+      ++free;
+    }
+    EXPECT_EQ(ranges.next_free(value), free);
+  }
+}
+
+// Random inserts and erases of short and long ranges over [0, domain),
+// checked against a set of single values after every operation
+template <class RangeSetT>
+void CheckAgainstValues(unsigned seed) {
+  constexpr int kDomain = 200;
+  std::mt19937 rng(seed);
+  std::uniform_int_distribution<int> point(0, kDomain - 1);
+  std::uniform_int_distribution<int> length(0, 30);
+  RangeSetT ranges;
+  std::set<int> values;
+  for (int step = 0; step < 300; ++step) {
+    int first = point(rng);
+    int last = std::min(first + length(rng), kDomain - 1);
+    if (rng() % 3 != 0) {
+      auto it = ranges.insert(first, last);
+      for (int value = first; value <= last; ++value) {
+        values.insert(value);
+      }
+      EXPECT_LE(it->key, first);
+      EXPECT_GE(it->value, last);
+    } else {
+      ranges.erase(first, last);
+      for (int value = first; value <= last; ++value) {
+        values.erase(value);
+      }
+    }
+    ExpectMatches(ranges, values, kDomain);
+    EXPECT_EQ(ranges.contains(first, last),
+              ranges.find(first) != ranges.end() &&
+                  ranges.find(first) == ranges.find(last));
+  }
+}
+
+}  // namespace
+
+TEST(RangeSetTest, CoalescesAndSplits) {
+  s21::RangeSet<int> ranges;
+  EXPECT_TRUE(ranges.empty());
+  ranges.insert(10, 19);
+  ranges.insert(30, 39);
+  ranges.insert(20, 29);  // touches both neighbours
+  ASSERT_EQ(ranges.size(), 1U);
+  EXPECT_EQ(ranges.begin()->key, 10);
+  EXPECT_EQ(ranges.begin()->value, 39);
+
+  ranges.erase(15, 24);
+  ASSERT_EQ(ranges.size(), 2U);
+  EXPECT_TRUE(ranges.contains(14));
+  EXPECT_FALSE(ranges.contains(15));
+  EXPECT_FALSE(ranges.contains(24));
+  EXPECT_TRUE(ranges.contains(25));
+  EXPECT_TRUE(ranges.contains(25, 39));
+  EXPECT_FALSE(ranges.contains(10, 25));
+  EXPECT_EQ(ranges.next_free(10), 15);
+  EXPECT_EQ(ranges.next_free(20), 20);
+  EXPECT_EQ(ranges.next_free(30), 40);
+
+  ranges.insert(0, 100);  // swallows everything
+  ASSERT_EQ(ranges.size(), 1U);
+  ranges.erase(0, 100);
+  EXPECT_TRUE(ranges.empty());
+  EXPECT_THROW(ranges.insert(5, 4), std::invalid_argument);
+  EXPECT_THROW(ranges.erase(5, 4), std::invalid_argument);
+}
+
+TEST(RangeSetTest, EndsOfTheType) {
+  s21::RangeSet<std::uint8_t> ranges;
+  ranges.insert(0, 254);
+  ranges.insert(255);
+  ASSERT_EQ(ranges.size(), 1U);
+  EXPECT_TRUE(ranges.contains(0, 255));
+  EXPECT_THROW(ranges.next_free(7), std::out_of_range);
+  ranges.erase(0);
+  ranges.erase(255);
+  EXPECT_EQ(ranges.next_free(0), 0);
+  EXPECT_EQ(ranges.next_free(200), 255);
+  ranges.erase(100, 100);
+  ASSERT_EQ(ranges.size(), 2U);
+  EXPECT_EQ(ranges.next_free(1), 100);
+
+  s21::RangeSet<std::int64_t> wide;
+  wide.insert(std::numeric_limits<std::int64_t>::min(), -1);
+  wide.insert(0, std::numeric_limits<std::int64_t>::max());
+  ASSERT_EQ(wide.size(), 1U);
+  wide.erase(std::numeric_limits<std::int64_t>::max());
+  EXPECT_EQ(wide.next_free(0), std::numeric_limits<std::int64_t>::max());
+}
+
+TEST(RangeSetTest, MatchesValueSet) {
+  CheckAgainstValues<s21::RangeSet<int>>(1);
+  CheckAgainstValues<s21::RangeSet<int>>(2);
+  CheckAgainstValues<s21::RangeSet<int, s21::HeapNodeAllocator, s21::AVL<>>>(3);
+  CheckAgainstValues<s21::RangeSet<int, s21::IndexPoolAllocator>>(4);
+}
+
+TEST(RangeSetTest, LongRuns) {
+  // Every other value, then the gaps: one insert swallows 1000 ranges
+  s21::RangeSet<unsigned> ranges;
+  for (unsigned value = 0; value < 2000; value += 2) {
+    ranges.insert(value);
+  }
+  ASSERT_EQ(ranges.size(), 1000U);
+  s21::RangeSet<unsigned> copy(ranges);
+  ranges.insert(1, 1997);
+  ASSERT_EQ(ranges.size(), 1U);
+  EXPECT_EQ(ranges.begin()->value, 1998U);
+  copy.erase(100, 1899);
+  EXPECT_EQ(copy.size(), 100U);
+  EXPECT_EQ(copy.next_free(98), 99U);
+  EXPECT_EQ(copy.next_free(100), 100U);
+  ranges = std::move(copy);
+  EXPECT_EQ(ranges.size(), 100U);
+}
@@ -0,0 +1,181 @@
+#ifndef CPP2_S21_CONTAINERS_2_TESTS_S21_RBTREE_CHECK_H_
+#define CPP2_S21_CONTAINERS_2_TESTS_S21_RBTREE_CHECK_H_
+
+#include <algorithm>
+
+#include "../containers/NodeTree.h"
+
+// Returns the black height of the subtree or -1 if the subtree breaks a
+// red-black or binary search tree property (or has a wrong parent link)
+template <class NodeT>
+int RBTreeBlackHeight(const NodeT *node, const NodeT *parent = nullptr) {
+  if (node == nullptr) {
+    return 1;
+  }
+  // The root hangs off the header sentinel of the tree
+  if (parent == nullptr
+          ? node->GetParent() == nullptr || !node->GetParent()->IsHeader()
+          : node->GetParent() != parent) {
+    return -1;
+  }
+  if (parent == nullptr && node->GetColor() != s21::Color::Black) {
+    return -1;
+  }
+  if (node->GetColor() == s21::Color::Red &&
+      ((node->left && node->left->GetColor() == s21::Color::Red) ||
+       (node->right && node->right->GetColor() == s21::Color::Red))) {
+    return -1;
+  }
+  if ((node->left && node->key < node->left->key) ||
+      (node->right && node->right->key < node->key)) {
+    return -1;
+  }
+  int left = RBTreeBlackHeight<NodeT>(node->left, node);
+  int right = RBTreeBlackHeight<NodeT>(node->right, node);
+  if (left < 0 || left != right) {
+    return -1;
+  }
+  return left + (node->GetColor() == s21::Color::Black ? 1 : 0);
+}
+
+// Returns the number of nodes in the subtree or -1 if a stored subtree size
+// of the OrderStatistic policy is wrong
+template <class NodeT>
+long RBTreeSubtreeSize(const NodeT *node) {
+  if (node == nullptr) {
+    return 0;
+  }
+  long left = RBTreeSubtreeSize<NodeT>(node->left);
+  long right = RBTreeSubtreeSize<NodeT>(node->right);
+  if (left < 0 || right < 0 ||
+      static_cast<long>(node->subtree_size) != left + right + 1) {
+    return -1;
+  }
+  return left + right + 1;
+}
+
+// True if the children of node link back to it and keep the key order
+template <class NodeT>
+bool SearchTreeLinksOk(const NodeT *node) {
+  return (node->left == nullptr || (node->left->GetParent() == node &&
+                                    !(node->key < node->left->key))) &&
+         (node->right == nullptr || (node->right->GetParent() == node &&
+                                     !(node->right->key < node->key)));
+}
+
+// Returns the number of nodes in the subtree or -1 if the subtree is not a
+// binary search tree with right parent links; the check for splay trees
+template <class NodeT>
+long SearchTreeSize(const NodeT *node) {
+  if (node == nullptr) {
+    return 0;
+  }
+  long left = SearchTreeSize<NodeT>(node->left);
+  long right = SearchTreeSize<NodeT>(node->right);
+  if (left < 0 || right < 0 || !SearchTreeLinksOk(node)) {
+    return -1;
+  }
+  return left + right + 1;
+}
+
+// Returns the number of levels of the subtree or -1 if the subtree breaks an
+// AVL or binary search tree property or a stored height is wrong
+template <class NodeT>
+int AVLTreeLevels(const NodeT *node) {
+  if (node == nullptr) {
+    return 0;
+  }
+  int left = AVLTreeLevels<NodeT>(node->left);
+  int right = AVLTreeLevels<NodeT>(node->right);
+  if (left < 0 || right < 0 || left - right > 1 || right - left > 1 ||
+      node->height != std::max(left, right) || !SearchTreeLinksOk(node)) {
+    return -1;
+  }
+  return std::max(left, right) + 1;
+}
+
+// Returns the rank of the subtree root plus one, 0 for an empty subtree, or
+// -1 if the subtree breaks a WAVL rank rule or the search tree properties
+template <class NodeT>
+int WAVLTreeRank(const NodeT *node) {
+  if (node == nullptr) {
+    return 0;
+  }
+  int left = WAVLTreeRank<NodeT>(node->left);
+  int right = WAVLTreeRank<NodeT>(node->right);
+  int rank = node->rank + 1;
+  bool leaf = node->left == nullptr && node->right == nullptr;
+  if (left < 0 || right < 0 || rank - left < 1 || rank - left > 2 ||
+      rank - right < 1 || rank - right > 2 || (leaf && node->rank != 0) ||
+      !SearchTreeLinksOk(node)) {
+    return -1;
+  }
+  return rank;
+}
+
+// Returns the number of nodes in the subtree or -1 if a child has a higher
+// priority than its parent or the search tree properties break
+template <class NodeT>
+long TreapSize(const NodeT *node) {
+  if (node == nullptr) {
+    return 0;
+  }
+  long left = TreapSize<NodeT>(node->left);
+  long right = TreapSize<NodeT>(node->right);
+  if (left < 0 || right < 0 || !SearchTreeLinksOk(node) ||
+      (node->left != nullptr && node->left->priority > node->priority) ||
+      (node->right != nullptr && node->right->priority > node->priority)) {
+    return -1;
+  }
+  return left + right + 1;
+}
+
+// True if every node of the subtree caches the aggregate of its subtree,
+// with Monoid the one of the SubtreeAggregate policy
+template <class Monoid, class NodeT>
+bool AggregatesOk(const NodeT *node, typename Monoid::type &aggregate) {
+  if (node == nullptr) {
+    aggregate = Monoid::Identity();
+    return true;
+  }
+  typename Monoid::type left, right;
+  if (!AggregatesOk<Monoid, NodeT>(node->left, left) ||
+      !AggregatesOk<Monoid, NodeT>(node->right, right)) {
+    return false;
+  }
+  aggregate =
+      Monoid::Combine(Monoid::Combine(left, Monoid::Lift(*node)), right);
+  return node->subtree_aggregate == aggregate;
+}
+
+// Walks the subtree in key order and checks that each node is threaded
+// between prev and its successor; prev ends on the last node
+template <class NodeT>
+bool ThreadsFollowTree(const NodeT *node, const NodeT *&prev) {
+  if (node == nullptr) {
+    return true;
+  }
+  if (!ThreadsFollowTree<NodeT>(node->left, prev)) {
+    return false;
+  }
+  const NodeT *before = node->prev;
+  if (before != prev || static_cast<const NodeT *>(prev->next) != node) {
+    return false;
+  }
+  prev = node;
+  return ThreadsFollowTree<NodeT>(node->right, prev);
+}
+
+// True if the threads of a Threaded tree form the circular list of the
+// nodes in key order through the header
+template <class NodeT>
+bool ThreadsOk(const NodeT *header) {
+  const NodeT *last = header;
+  if (!ThreadsFollowTree<NodeT>(header->left, last)) {
+    return false;
+  }
+  const NodeT *before = header->prev;
+  return before == last && static_cast<const NodeT *>(last->next) == header;
+}
+
+#endif  // CPP2_S21_CONTAINERS_2_TESTS_S21_RBTREE_CHECK_H_
@@ -1,6 +1,7 @@
 #include "../containers/s21_IteratorTree.h"
 #include "../containers/s21_set.h"
 #include "../s21_containersplus.h"
+#include "s21_rbtree_check.h"
 #include "gtest/gtest.h"
 
 TEST(MultisetTest, Insert) {
@@ -64,7 +65,7 @@ TEST(MultisetTest, Iterator) {
 
   auto it = ms.begin();
   EXPECT_EQ((*it).key, 1);
-  EXPECT_EQ(it->value, 1);
+  EXPECT_EQ(*it, 1);
 
   ++it;
   EXPECT_EQ(it->key, 2);
@@ -87,7 +88,7 @@ TEST(MultisetTest, IteratorConstructor) {
   set.insert(2);
   set.insert(4);
 
-  s21::RBTreeIterator<int, int> it = set.begin();
+  s21::Multiset<int>::iterator it = set.begin();
   EXPECT_EQ((*it).key, 1);
 }
 
@@ -98,7 +99,7 @@ TEST(MultisetTest, IteratorPrefixIncrement) {
   set.insert(1);
   set.insert(5);
 
-  s21::RBTreeIterator<int, int> it = set.begin();
+  s21::Multiset<int>::iterator it = set.begin();
   ++it;
   ++it;
   EXPECT_EQ(it->key, 5);
@@ -117,18 +118,18 @@ TEST(MultisetTest, SetIteratorBeginTest) {
 TEST(RBTreeIteratorTest, PreIncrement) {
   s21::Multiset<int> mset;
   mset.insert(3);
-  s21::RBTreeIterator<int, int> it = mset.begin();
+  s21::Multiset<int>::iterator it = mset.begin();
   EXPECT_EQ(it.current()->key, 3);
   ++it;
-  EXPECT_EQ(it.current(), nullptr);
+  EXPECT_EQ(it, mset.end());
 }
 
 TEST(RBTreeIteratorTest, PostIncrement) {
   s21::Multiset<int> mset;
   mset.insert(3);
-  s21::RBTreeIterator<int, int> it = mset.begin();
+  s21::Multiset<int>::iterator it = mset.begin();
   EXPECT_EQ((it++).current()->key, 3);
-  EXPECT_EQ(it.current(), nullptr);
+  EXPECT_EQ(it, mset.end());
 }
 
 TEST(RBTreeIteratorTest, Leftmostplusplus) {
@@ -158,7 +159,7 @@ TEST(RBTreeIteratorTest, Leftmostplusplus) {
   EXPECT_EQ(iter.current()->key, 7);
 
   ++iter;
-  EXPECT_EQ(nullptr, iter.current());
+  EXPECT_EQ(tree.End(), iter.current());
 }
 
 TEST(RBTreeIteratorTest, OperatorBool) {
@@ -265,8 +266,10 @@ TEST(MultisetTest, BeginAndEnd) {
 TEST(MultisetTest, CurrentIsNullptrTest) {
   s21::Multiset<int> ms;
 
-  auto it = ms.begin();  // hit this line  if (current_ == nullptr)
+  s21::Multiset<int>::iterator it;  // hit this line  if (current_ == nullptr)
   EXPECT_FALSE(--it);
+  auto end = ms.begin();
+  EXPECT_THROW(--end, std::out_of_range);
 }
 
 TEST(MultisetTest, DefaultConstructor) {
@@ -343,7 +346,8 @@ TEST(MultisetTest, FindExistingKey) {
 
 TEST(MultisetTest, FindNonExistingKey) {
   s21::Multiset<int> ms{1, 2, 3, 3, 4};
-  EXPECT_THROW(ms.find(5), std::out_of_range);
+  EXPECT_TRUE(ms.find(5) == ms.end());
+  EXPECT_TRUE(ms.find(0) == ms.end());
 }
 
 TEST(MultisetTest, EraseExistingElement) {
@@ -354,8 +358,10 @@ TEST(MultisetTest, EraseExistingElement) {
 
 TEST(MultisetTest, EraseNonExistingElement) {
   s21::Multiset<int> multiset{1, 2, 3};
-  EXPECT_THROW(multiset.erase(4), std::out_of_range);
-  ASSERT_EQ(multiset.size(), 3);
+  EXPECT_EQ(multiset.erase(4), 0u);
+  EXPECT_EQ(multiset.erase(3), 1u);
+  EXPECT_EQ(multiset.erase(3), 0u);
+  ASSERT_EQ(multiset.size(), 2);
 }
 
 TEST(MultisetTest, EraseAllElements) {
@@ -799,7 +805,7 @@ TEST(MultisetTest, Emplace1) {
 
   auto res4 = ms.emplace(3);
   EXPECT_EQ((int)res4.size(), 1);
-  EXPECT_EQ(res4[0].first, ++ms.begin());
+  EXPECT_EQ(res4[0].first, ++ ++ms.begin());
   EXPECT_EQ(res4[0].second, true);
 
   auto res5 = ms.emplace();
@@ -807,7 +813,8 @@ TEST(MultisetTest, Emplace1) {
 
   auto res6 = ms.emplace(5);
   EXPECT_EQ((int)res6.size(), 1);
-  EXPECT_EQ(res6[0].first, ms.find(5));
+  EXPECT_EQ(*res6[0].first, 5);
+  EXPECT_EQ(ms.count(5), 2);
   EXPECT_EQ(res6[0].second, true);
 
   auto res7 = ms.emplace(1);
@@ -1131,3 +1138,1310 @@ TEST(Set, Emplace3) {
   EXPECT_EQ(result[0].first, set.begin());
   EXPECT_EQ(result[0].second, true);
 }
+
+namespace {
+
+// Counts how often any key is copied and moved
+struct KeyCounter {
+  static int copies;
+  static int moves;
+  int id{};
+  explicit KeyCounter(int value) : id(value) {}
+  KeyCounter(const KeyCounter &other) : id(other.id) { ++copies; }
+  KeyCounter(KeyCounter &&other) noexcept : id(other.id) { ++moves; }
+  KeyCounter &operator=(const KeyCounter &) = delete;
+  bool operator<(const KeyCounter &other) const { return id < other.id; }
+};
+
+int KeyCounter::copies = 0;
+int KeyCounter::moves = 0;
+
+}  // namespace
+
+TEST(Set, EmplaceBuildsKeysInPlace) {
+  s21::Set<KeyCounter> set;
+  KeyCounter::copies = KeyCounter::moves = 0;
+  set.emplace(KeyCounter(2), KeyCounter(4));
+  EXPECT_EQ(KeyCounter::moves, 2);
+  set.emplace_hint(set.end(), 6);
+  set.emplace_hint(set.begin(), 0);
+  EXPECT_FALSE(set.emplace(4)[0].second);
+  EXPECT_EQ(set.emplace_hint(set.find(KeyCounter(2)), 2),
+            set.find(KeyCounter(2)));
+  EXPECT_EQ(KeyCounter::copies, 0);
+  EXPECT_EQ(KeyCounter::moves, 2);
+  ASSERT_EQ(set.size(), 4);
+  int expected = 0;
+  for (auto it = set.begin(); it != set.end(); ++it) {
+    EXPECT_EQ(it->key.id, expected);
+    expected += 2;
+  }
+}
+
+TEST(MultisetTest, EmplaceBuildsKeysInPlace) {
+  s21::Multiset<KeyCounter> ms;
+  KeyCounter::copies = KeyCounter::moves = 0;
+  ms.emplace(KeyCounter(1), KeyCounter(1));
+  EXPECT_EQ(KeyCounter::moves, 2);
+  auto it = ms.emplace_hint(ms.end(), 1);
+  EXPECT_EQ(it, --ms.end());
+  ms.emplace_hint(ms.begin(), 0);
+  ms.emplace(3);
+  EXPECT_EQ(KeyCounter::copies, 0);
+  EXPECT_EQ(KeyCounter::moves, 2);
+  ASSERT_EQ(ms.size(), 5);
+  EXPECT_EQ(ms.begin()->key.id, 0);
+  EXPECT_EQ((--ms.end())->key.id, 3);
+}
+
+TEST(Set, SlabAllocator) {
+  s21::Set<std::string, s21::SlabNodeAllocator> set{"b", "a", "c"};
+  EXPECT_EQ(set.size(), 3);
+  set.erase("a");
+  EXPECT_FALSE(set.contains("a"));
+  set.insert("d");
+  EXPECT_EQ(set.begin()->key, "b");
+  set.clear();
+  EXPECT_TRUE(set.empty());
+  EXPECT_FALSE(set.contains("b"));
+}
+
+TEST(MultisetTest, SlabAllocator) {
+  s21::Multiset<int, s21::SlabNodeAllocator> ms;
+  for (int i = 0; i < 5000; ++i) {
+    ms.insert(i % 10);
+  }
+  EXPECT_EQ(ms.size(), 5000);
+  EXPECT_EQ(ms.count(3), 500);
+  ms.clear();
+  EXPECT_TRUE(ms.empty());
+  EXPECT_EQ(ms.begin(), ms.end());
+}
+
+TEST(RBTreeTest, InsertUniqueSingleDescent) {
+  s21::RBTree<int, int> tree;
+  for (int i = 0; i < 100; ++i) {
+    auto [node, inserted] = tree.InsertUnique((i * 37) % 100, i);
+    EXPECT_TRUE(inserted);
+    EXPECT_EQ(node->key, (i * 37) % 100);
+  }
+  auto [node, inserted] = tree.InsertUnique(42, -1);
+  EXPECT_FALSE(inserted);
+  EXPECT_EQ(node->key, 42);
+  EXPECT_NE(node->value, -1);
+  EXPECT_GT(RBTreeBlackHeight(tree.GetRoot()), 0);
+}
+
+TEST(RBTreeTest, InsertEqualKeepsDuplicates) {
+  s21::RBTree<int, int> tree;
+  for (int i = 0; i < 50; ++i) {
+    tree.InsertEqual(i % 5, i);
+  }
+  EXPECT_GT(RBTreeBlackHeight(tree.GetRoot()), 0);
+  int previous = -1;
+  int count = 0;
+  s21::Node<int, int> *node = tree.GetRoot();
+  while (node->left) node = node->left;
+  for (s21::RBTreeIterator<int, int> it(node); it.current() != tree.End();
+       ++it) {
+    EXPECT_LE(previous, it->key);
+    previous = it->key;
+    ++count;
+  }
+  EXPECT_EQ(count, 50);
+}
+
+TEST(MultisetTest, InsertReturnsInsertedNode) {
+  s21::Multiset<int> ms{5, 5, 5};
+  auto it = ms.insert(5);
+  EXPECT_EQ(*it, 5);
+  // Duplicates are appended after the existing equal keys
+  ++it;
+  EXPECT_EQ(it, ms.end());
+}
+
+TEST(Set, InsertDuplicateReturnsExisting) {
+  s21::Set<int> set{1, 2, 3};
+  auto [it, inserted] = set.insert(2);
+  EXPECT_FALSE(inserted);
+  EXPECT_EQ(it, set.find(2));
+  EXPECT_EQ(set.size(), 3);
+}
+
+TEST(Set, InsertWithHint) {
+  s21::Set<int> set;
+  for (int i = 0; i < 200; ++i) {
+    set.insert(set.end(), i);
+  }
+  auto hint = set.find(100);
+  for (int i = 1000; i >= 200; --i) {
+    hint = set.insert(hint, i);  // wrong hint, falls back to a descent
+  }
+  hint = set.begin();
+  for (int i = -1; i > -100; --i) {
+    hint = set.insert(hint, i);
+    EXPECT_EQ(hint, set.begin());
+  }
+  EXPECT_EQ(set.insert(set.find(5), 5), set.find(5));
+  EXPECT_EQ(set.size(), 1100);
+  int expected = -99;
+  for (auto it = set.begin(); it != set.end(); ++it) {
+    EXPECT_EQ(it->key, expected++);
+  }
+  s21::Set<int> other;
+  for (int key : {50, 10, 30, 20, 40}) {
+    other.emplace_hint(other.begin(), key);
+  }
+  EXPECT_EQ(other.size(), 5);
+}
+
+TEST(MultisetTest, InsertWithHint) {
+  s21::Multiset<int> ms{1, 3, 3, 5};
+  auto it = ms.insert(ms.find(3), 3);
+  EXPECT_EQ(*it, 3);
+  ms.insert(ms.end(), 5);
+  ms.insert(ms.end(), 0);    // wrong hint
+  ms.insert(ms.begin(), 7);  // wrong hint
+  ms.emplace_hint(ms.begin(), 0);
+  EXPECT_EQ(ms.size(), 9);
+  EXPECT_EQ(ms.count(3), 3);
+  EXPECT_EQ(ms.count(0), 2);
+  int previous = -1;
+  for (auto item = ms.begin(); item != ms.end(); ++item) {
+    EXPECT_LE(previous, item->key);
+    previous = item->key;
+  }
+}
+
+TEST(RBTreeTest, AssignSortedBuildsValidTree) {
+  for (int n = 0; n < 300; ++n) {
+    std::vector<int> keys(n);
+    for (int i = 0; i < n; ++i) {
+      keys[i] = i;
+    }
+    s21::RBTree<int, int> tree;
+    EXPECT_EQ(tree.AssignSorted(keys.begin(), keys.end(), true), n);
+    EXPECT_GT(RBTreeBlackHeight(tree.GetRoot()), 0) << n;
+    // The built tree keeps working with ordinary inserts and erases
+    tree.Insert(n / 2, 0);
+    if (n > 0) tree.Erase(tree.Find(tree.GetRoot(), 0));
+    EXPECT_GT(RBTreeBlackHeight(tree.GetRoot()), 0) << n;
+  }
+}
+
+TEST(RBTreeTest, AssignSortedRejectsUnsorted) {
+  std::vector<int> keys{1, 3, 2};
+  s21::RBTree<int, int> tree;
+  EXPECT_THROW(tree.AssignSorted(keys.begin(), keys.end(), true),
+               std::invalid_argument);
+}
+
+TEST(Set, RangeConstructor) {
+  std::vector<int> sorted{1, 2, 2, 3, 5, 8, 8, 8};
+  s21::Set<int> from_sorted(sorted.begin(), sorted.end());
+  EXPECT_EQ(from_sorted.size(), 5);
+
+  std::vector<int> unsorted{8, 3, 1, 8, 5, 2, 2};
+  s21::Set<int> from_unsorted(unsorted.begin(), unsorted.end());
+  EXPECT_EQ(from_unsorted.size(), 5);
+  auto expected = from_sorted.begin();
+  for (auto it = from_unsorted.begin(); it != from_unsorted.end(); ++it) {
+    EXPECT_EQ(it->key, (expected++)->key);
+  }
+}
+
+TEST(Set, AssignSorted) {
+  s21::Set<std::string> set{"x", "y"};
+  std::vector<std::string> words{"a", "b", "c", "c", "d"};
+  set.assign_sorted(words.begin(), words.end());
+  EXPECT_EQ(set.size(), 4);
+  EXPECT_FALSE(set.contains("x"));
+  EXPECT_TRUE(set.contains("c"));
+  std::vector<std::string> unsorted{"b", "a"};
+  EXPECT_THROW(set.assign_sorted(unsorted.begin(), unsorted.end()),
+               std::invalid_argument);
+  EXPECT_TRUE(set.empty());
+}
+
+TEST(Set, MergeRebuildsLargeSets) {
+  s21::Set<int> evens, odds;
+  for (int i = 0; i < 1000; i += 2) {
+    evens.insert(i);
+    odds.insert(i + 1);
+  }
+  odds.insert(0);
+  evens.merge(odds);
+  EXPECT_EQ(evens.size(), 1000);
+  EXPECT_TRUE(odds.empty());
+  int expected = 0;
+  for (auto it = evens.begin(); it != evens.end(); ++it) {
+    EXPECT_EQ(it->key, expected++);
+  }
+}
+
+TEST(MultisetTest, RangeConstructorAndMerge) {
+  std::vector<int> values{5, 1, 3, 3, 1, 5, 5};
+  s21::Multiset<int> ms(values.begin(), values.end());
+  EXPECT_EQ(ms.size(), 7);
+  EXPECT_EQ(ms.count(5), 3);
+  s21::Multiset<int> copy(ms);
+  EXPECT_EQ(copy.size(), 7);
+  copy.merge(ms);
+  EXPECT_EQ(copy.size(), 14);
+  EXPECT_EQ(copy.count(1), 4);
+  EXPECT_EQ(copy.count(3), 4);
+  EXPECT_TRUE(ms.empty());
+  int previous = 0;
+  for (auto it = copy.begin(); it != copy.end(); ++it) {
+    EXPECT_LE(previous, it->key);
+    previous = it->key;
+  }
+  std::vector<int> sorted{1, 1, 2};
+  copy.assign_sorted(sorted.begin(), sorted.end());
+  EXPECT_EQ(copy.size(), 3);
+  EXPECT_EQ(copy.count(1), 2);
+}
+
+TEST(MultisetTest, BoundsMatchStdMultiset) {
+  s21::Multiset<int> ms;
+  std::multiset<int> standart;
+  std::srand(7);
+  for (int i = 0; i < 2000; ++i) {
+    int value = std::rand() % 500;
+    ms.insert(value);
+    standart.insert(value);
+  }
+  for (int key = -2; key < 503; ++key) {
+    auto low = ms.lower_bound(key);
+    auto up = ms.upper_bound(key);
+    auto range = ms.equal_range(key);
+    auto standart_low = standart.lower_bound(key);
+    auto standart_up = standart.upper_bound(key);
+    ASSERT_EQ(low == ms.end(), standart_low == standart.end());
+    ASSERT_EQ(up == ms.end(), standart_up == standart.end());
+    if (standart_low != standart.end()) {
+      ASSERT_EQ(low->key, *standart_low);
+    }
+    if (standart_up != standart.end()) {
+      ASSERT_EQ(up->key, *standart_up);
+    }
+    EXPECT_EQ(range.first.current(), low.current());
+    EXPECT_EQ(range.second.current(), up.current());
+    EXPECT_EQ(ms.count(key), static_cast<int>(standart.count(key)));
+  }
+}
+
+TEST(MultisetTest, EqualRangeSpansAllDuplicates) {
+  s21::Multiset<int> ms;
+  for (int i = 0; i < 100; ++i) {
+    ms.insert(i % 3 == 0 ? 42 : i);
+  }
+  auto range = ms.equal_range(42);
+  int count = 0;
+  for (auto it = range.first; it.current() != range.second.current(); ++it) {
+    EXPECT_EQ(it->key, 42);
+    ++count;
+  }
+  EXPECT_EQ(count, 34);
+  EXPECT_EQ(ms.count(42), 34);
+  EXPECT_EQ(range.second->key, 43);
+}
+
+TEST(RBTreeTest, OrderStatisticIsOptIn) {
+  EXPECT_EQ(sizeof(s21::Node<int, int>), 5 * sizeof(void *));
+  EXPECT_EQ(sizeof(s21::Node<int, int, s21::OrderStatistic>),
+            sizeof(s21::Node<int, int>) + sizeof(std::size_t));
+  EXPECT_EQ(sizeof(s21::Node<int, int, s21::Threaded<>>),
+            sizeof(s21::Node<int, int>) + 2 * sizeof(void *));
+}
+
+TEST(RBTreeTest, OrderStatisticSizesSurviveInsertAndErase) {
+  s21::RBTree<int, int, s21::HeapNodeAllocator, s21::OrderStatistic> tree;
+  std::vector<int> keys;
+  std::srand(11);
+  for (int i = 0; i < 1000; ++i) {
+    int key = std::rand() % 300;
+    tree.InsertEqual(key, i);
+    keys.push_back(key);
+  }
+  ASSERT_EQ(RBTreeSubtreeSize(tree.GetRoot()), 1000);
+  for (int i = 0; i < 600; ++i) {
+    tree.Erase(tree.Find(tree.GetRoot(), keys[i]));
+    ASSERT_GT(RBTreeBlackHeight(tree.GetRoot()), 0);
+    ASSERT_EQ(RBTreeSubtreeSize(tree.GetRoot()), 1000 - i - 1);
+  }
+  std::vector<int> rest(keys.begin() + 600, keys.end());
+  std::sort(rest.begin(), rest.end());
+  for (std::size_t k = 0; k < rest.size(); ++k) {
+    ASSERT_EQ(tree.Select(k)->key, rest[k]);
+  }
+  EXPECT_EQ(tree.Select(rest.size()), tree.End());
+}
+
+TEST(MultisetTest, RankSelectCountRange) {
+  s21::Multiset<int, s21::HeapNodeAllocator, s21::OrderStatistic> samples;
+  std::vector<int> sorted;
+  std::srand(5);
+  for (int i = 0; i < 5000; ++i) {
+    int latency = std::rand() % 1000;
+    samples.insert(latency);
+    sorted.push_back(latency);
+  }
+  std::sort(sorted.begin(), sorted.end());
+  // 99th percentile
+  EXPECT_EQ(samples.select(sorted.size() * 99 / 100)->key,
+            sorted[sorted.size() * 99 / 100]);
+  for (int key = -1; key <= 1001; key += 7) {
+    std::size_t below =
+        std::lower_bound(sorted.begin(), sorted.end(), key) - sorted.begin();
+    EXPECT_EQ(samples.rank(key), below);
+    EXPECT_EQ(samples.count(key),
+              std::upper_bound(sorted.begin(), sorted.end(), key) -
+                  std::lower_bound(sorted.begin(), sorted.end(), key));
+  }
+  EXPECT_EQ(samples.count_range(100, 200),
+            std::lower_bound(sorted.begin(), sorted.end(), 200) -
+                std::lower_bound(sorted.begin(), sorted.end(), 100));
+  EXPECT_EQ(samples.count_range(200, 100), 0);
+  EXPECT_EQ(samples.select(sorted.size()), samples.end());
+}
+
+TEST(MultisetTest, IteratorAdvanceByN) {
+  s21::Multiset<int, s21::SlabNodeAllocator, s21::OrderStatistic> ms;
+  std::vector<int> values(100);
+  for (int i = 0; i < 100; ++i) {
+    values[i] = i * 2;
+  }
+  ms.assign_sorted(values.begin(), values.end());
+  auto it = ms.begin();
+  it += 10;
+  EXPECT_EQ(it->key, 20);
+  it = it + 85;
+  EXPECT_EQ(it->key, 190);
+  it -= 95;
+  EXPECT_EQ(it, ms.begin());
+  EXPECT_EQ(it + 100, ms.end());
+  EXPECT_THROW(it + 101, std::out_of_range);
+  EXPECT_THROW(it - 1, std::out_of_range);
+  ms.erase(40);
+  EXPECT_EQ((ms.begin() + 20)->key, 42);
+  EXPECT_EQ(ms.rank(42), 20);
+}
+
+TEST(SetTest, RankSelect) {
+  s21::Set<int, s21::HeapNodeAllocator, s21::OrderStatistic> set{5, 1, 9, 3};
+  EXPECT_EQ(set.rank(4), 2);
+  EXPECT_EQ(set.select(3)->key, 9);
+  EXPECT_EQ(set.count_range(1, 9), 3);
+}
+
+TEST(RBTreeTest, HeaderCachesFirstAndLast) {
+  s21::RBTree<int, int> tree;
+  EXPECT_EQ(tree.Begin(), tree.End());
+  std::srand(3);
+  std::multiset<int> standart;
+  for (int i = 0; i < 500; ++i) {
+    int key = std::rand() % 100;
+    tree.InsertEqual(key, i);
+    standart.insert(key);
+    ASSERT_EQ(tree.Begin()->key, *standart.begin());
+    ASSERT_EQ((--s21::RBTreeIterator<int, int>(tree.End()))->key,
+              *standart.rbegin());
+  }
+  while (!standart.empty()) {
+    int key = std::rand() % 100;
+    if (standart.count(key) == 0) {
+      continue;
+    }
+    tree.Erase(tree.Find(tree.GetRoot(), key));
+    standart.erase(standart.find(key));
+    ASSERT_GT(RBTreeBlackHeight(tree.GetRoot()), 0);
+    if (!standart.empty()) {
+      ASSERT_EQ(tree.Begin()->key, *standart.begin());
+      ASSERT_EQ((--s21::RBTreeIterator<int, int>(tree.End()))->key,
+                *standart.rbegin());
+    }
+  }
+  EXPECT_EQ(tree.Begin(), tree.End());
+  EXPECT_EQ(tree.GetRoot(), nullptr);
+}
+
+TEST(MultisetTest, ReverseIteration) {
+  s21::Multiset<int> ms{4, 1, 3, 3, 9, 0};
+  std::vector<int> reversed;
+  for (auto it = ms.rbegin(); it != ms.rend(); ++it) {
+    reversed.push_back(it->key);
+  }
+  EXPECT_EQ(reversed, (std::vector<int>{9, 4, 3, 3, 1, 0}));
+  auto last = ms.end();
+  --last;
+  EXPECT_EQ(last->key, 9);
+  EXPECT_EQ(ms.rbegin()->key, 9);
+  s21::Multiset<int> empty;
+  EXPECT_EQ(empty.rbegin(), empty.rend());
+}
+
+TEST(MultisetTest, IteratorsCompareByNode) {
+  s21::Multiset<int> ms{7, 7};
+  auto first = ms.begin();
+  auto second = first;
+  ++second;
+  EXPECT_EQ(first->key, second->key);
+  EXPECT_NE(first, second);
+  s21::Multiset<int> other{7};
+  EXPECT_NE(ms.begin(), other.begin());
+}
+
+TEST(SetTest, EndSurvivesSwapAndMove) {
+  s21::Set<int> a{1, 2, 3};
+  s21::Set<int> b;
+  a.swap(b);
+  EXPECT_EQ(a.begin(), a.end());
+  EXPECT_EQ((--b.end())->key, 3);
+  int sum = 0;
+  for (auto it = b.begin(); it != b.end(); ++it) {
+    sum += it->key;
+  }
+  EXPECT_EQ(sum, 6);
+  s21::Set<int> c(std::move(b));
+  EXPECT_EQ(c.begin()->key, 1);
+  EXPECT_EQ((--c.end())->key, 3);
+  EXPECT_EQ(b.begin(), b.end());
+  b.insert(10);
+  EXPECT_EQ(b.begin()->key, 10);
+  EXPECT_EQ(b.rbegin()->key, 10);
+}
+
+TEST(SetTest, KeyOnlyNodes) {
+  EXPECT_LT(sizeof(s21::Node<std::string, s21::NoValue>),
+            sizeof(s21::Node<std::string, std::string>));
+  s21::Multiset<std::string> words{"pear", "fig", "apple", "fig"};
+  EXPECT_EQ(words.count("fig"), 2u);
+  words.erase("fig");
+  words.erase("apple");
+  EXPECT_EQ(words.begin()->key, "fig");
+  EXPECT_EQ(words.rbegin()->key, "pear");
+  EXPECT_EQ(words.size(), 2u);
+}
+
+TEST(RBTreeTest, PackedColorDropsColorWord) {
+  EXPECT_EQ(sizeof(s21::Node<int, int, s21::PackedColor<>>),
+            4 * sizeof(void *));
+  EXPECT_EQ(sizeof(s21::Node<long, s21::NoValue, s21::PackedColor<>>),
+            sizeof(s21::Node<long, s21::NoValue>) - sizeof(void *));
+  s21::Node<int, int, s21::PackedColor<>> node(1, 2);
+  s21::Node<int, int, s21::PackedColor<>> parent(0, 0);
+  EXPECT_EQ(node.GetColor(), s21::Color::Red);
+  EXPECT_TRUE(node.IsHeader());
+  node.SetColor(s21::Color::Black);
+  node.SetParent(&parent);
+  EXPECT_EQ(node.GetParent(), &parent);
+  EXPECT_EQ(node.GetColor(), s21::Color::Black);
+  node.SetColor(s21::Color::Red);
+  EXPECT_EQ(node.GetParent(), &parent);
+  EXPECT_FALSE(node.IsHeader());
+}
+
+TEST(RBTreeTest, PackedColorKeepsInvariants) {
+  s21::RBTree<int, int, s21::HeapNodeAllocator,
+              s21::PackedColor<s21::OrderStatistic>>
+      tree;
+  std::vector<int> keys;
+  std::srand(5);
+  for (int i = 0; i < 1000; ++i) {
+    int key = std::rand() % 400;
+    tree.InsertEqual(key, i);
+    keys.push_back(key);
+  }
+  ASSERT_GT(RBTreeBlackHeight(tree.GetRoot()), 0);
+  ASSERT_EQ(RBTreeSubtreeSize(tree.GetRoot()), 1000);
+  for (int i = 0; i < 700; ++i) {
+    tree.Erase(tree.Find(tree.GetRoot(), keys[i]));
+    ASSERT_GT(RBTreeBlackHeight(tree.GetRoot()), 0);
+  }
+  std::vector<int> rest(keys.begin() + 700, keys.end());
+  std::sort(rest.begin(), rest.end());
+  for (std::size_t k = 0; k < rest.size(); ++k) {
+    ASSERT_EQ(tree.Select(k)->key, rest[k]);
+  }
+  EXPECT_EQ(tree.Select(rest.size()), tree.End());
+}
+
+TEST(SetTest, PackedColorSet) {
+  s21::Set<int, s21::SlabNodeAllocator, s21::PackedColor<>> set{5, 1, 4, 2, 3};
+  set.erase(4);
+  std::vector<int> seen;
+  for (auto it = set.rbegin(); it != set.rend(); ++it) {
+    seen.push_back(it->key);
+  }
+  EXPECT_EQ(seen, std::vector<int>({5, 3, 2, 1}));
+}
+
+TEST(RBTreeTest, IndexLinkedNodeSize) {
+  EXPECT_EQ(sizeof(s21::Node<int, int, s21::IndexLinked<>>), 24u);
+  EXPECT_LT(sizeof(s21::Node<int, int, s21::IndexLinked<>>),
+            sizeof(s21::Node<int, int>));
+}
+
+TEST(MultisetTest, IndexPoolOrderStatistic) {
+  s21::Multiset<int, s21::IndexPoolAllocator,
+                s21::IndexLinked<s21::OrderStatistic>>
+      ms;
+  std::vector<int> keys;
+  std::srand(11);
+  for (int i = 0; i < 1500; ++i) {
+    int key = std::rand() % 300;
+    ms.insert(key);
+    keys.push_back(key);
+  }
+  for (int i = 0; i < 500; ++i) {
+    ms.erase(keys[i]);
+  }
+  std::vector<int> rest(keys.begin() + 500, keys.end());
+  std::sort(rest.begin(), rest.end());
+  s21::Multiset<int, s21::IndexPoolAllocator,
+                s21::IndexLinked<s21::OrderStatistic>>
+      copy(ms);
+  ASSERT_EQ(copy.size(), rest.size());
+  std::size_t k = 0;
+  for (auto it = copy.begin(); it != copy.end(); ++it, ++k) {
+    ASSERT_EQ(it->key, rest[k]);
+  }
+}
+
+// The argument refers into the pool that the insert grows
+TEST(MultisetTest, IndexPoolInsertsAliasedKey) {
+  s21::Multiset<int, s21::IndexPoolAllocator> ms;
+  s21::Set<int, s21::IndexPoolAllocator> s;
+  ms.insert(7);
+  s.insert(7);
+  for (int i = 0; i < 200; ++i) {
+    ms.insert(ms.begin()->key);
+    ms.insert(ms.end(), (--ms.end())->key);
+    s.insert(s.begin()->key);
+    s.insert(s.end(), (--s.end())->key);
+    s.insert(i + 8);
+  }
+  EXPECT_EQ(ms.size(), 401U);
+  EXPECT_EQ(ms.count(7), 401);
+  ASSERT_EQ(s.size(), 201U);
+  int expected = 7;
+  for (auto it = s.begin(); it != s.end(); ++it) {
+    EXPECT_EQ(it->key, expected++);
+  }
+}
+
+// An empty pool holds no cells; the tree keeps its header until the first
+// insert, and again after clear()
+TEST(MultisetTest, IndexPoolEmptyTrees) {
+  using PooledSet = s21::Set<int, s21::IndexPoolAllocator>;
+  PooledSet empty;
+  EXPECT_TRUE(empty.begin() == empty.end());
+  PooledSet full{3, 1, 2};
+  PooledSet copy(empty);
+  EXPECT_TRUE(copy.empty());
+  copy.swap(full);
+  ASSERT_EQ(copy.size(), 3U);
+  EXPECT_TRUE(full.begin() == full.end());
+  EXPECT_EQ(copy.begin()->key, 1);
+  full.insert(5);
+  EXPECT_EQ(full.begin()->key, 5);
+  PooledSet moved(std::move(copy));
+  EXPECT_TRUE(copy.empty());
+  copy.insert(4);
+  ASSERT_EQ(moved.size(), 3U);
+  EXPECT_EQ((--moved.end())->key, 3);
+  moved.clear();
+  EXPECT_TRUE(moved.begin() == moved.end());
+  moved.insert(moved.end(), 8);
+  moved.insert(moved.end(), 9);
+  EXPECT_EQ(moved.begin()->key, 8);
+  EXPECT_EQ(copy.begin()->key, 4);
+}
+
+TEST(RBTreeTest, ExtractKeepsInvariants) {
+  s21::RBTree<int, int, s21::HeapNodeAllocator, s21::OrderStatistic> tree;
+  std::vector<int> keys;
+  std::srand(7);
+  for (int i = 0; i < 1000; ++i) {
+    int key = std::rand() % 5000;
+    if (tree.InsertUnique(key, i).second) {
+      keys.push_back(key);
+    }
+  }
+  std::vector<s21::Node<int, int, s21::OrderStatistic> *> kept;
+  for (std::size_t i = 0; i < keys.size(); ++i) {
+    auto *node = tree.Find(tree.GetRoot(), keys[i]);
+    if (i % 3 == 0) {
+      auto handle = tree.Extract(node);
+      ASSERT_EQ(handle.key(), keys[i]);
+      ASSERT_GT(RBTreeBlackHeight(tree.GetRoot()), 0);
+    } else {
+      kept.push_back(node);
+    }
+  }
+  ASSERT_EQ(RBTreeSubtreeSize(tree.GetRoot()), static_cast<long>(kept.size()));
+  std::sort(kept.begin(), kept.end(),
+            [](auto *lhs, auto *rhs) { return lhs->key < rhs->key; });
+  for (std::size_t k = 0; k < kept.size(); ++k) {
+    ASSERT_EQ(tree.Select(k), kept[k]);
+  }
+}
+
+TEST(SetTest, ExtractAndInsertNode) {
+  s21::Set<std::string> set{"pear", "apple", "fig"};
+  auto node = set.extract(std::string("fig"));
+  ASSERT_FALSE(node.empty());
+  EXPECT_EQ(node.key(), "fig");
+  EXPECT_EQ(set.size(), 2);
+  EXPECT_TRUE(set.extract(std::string("kiwi")).empty());
+  node.key() = "apple";
+  EXPECT_FALSE(set.insert(std::move(node)).second);
+  node.key() = "plum";
+  auto [it, inserted] = set.insert(std::move(node));
+  EXPECT_TRUE(inserted);
+  EXPECT_EQ(it->key, "plum");
+  EXPECT_EQ(set.rbegin()->key, "plum");
+  EXPECT_EQ(set.size(), 3);
+}
+
+TEST(MultisetTest, ExtractAndMergeRelink) {
+  s21::Multiset<int, s21::HeapNodeAllocator, s21::OrderStatistic> ms{1, 2, 2, 3,
+                                                                     5};
+  auto node = ms.extract(2);
+  EXPECT_EQ(ms.count(2), 1);
+  EXPECT_EQ(ms.size(), 4);
+  s21::Multiset<int, s21::HeapNodeAllocator, s21::OrderStatistic> other{2, 4};
+  s21::Node<int, s21::NoValue, s21::OrderStatistic> *four =
+      other.find(4).current();
+  auto it = other.insert(std::move(node));
+  EXPECT_EQ(it->key, 2);
+  EXPECT_EQ(other.count(2), 2);
+  ms.merge(other);
+  EXPECT_TRUE(other.empty());
+  EXPECT_EQ(ms.size(), 7);
+  EXPECT_EQ(ms.count(2), 3);
+  EXPECT_EQ(ms.find(4).current(), four);
+  EXPECT_EQ(ms.rank(4), 5u);
+  EXPECT_EQ(ms.select(6)->key, 5);
+}
+
+TEST(RBTreeTest, SplitAndJoin) {
+  using Tree =
+      s21::RBTree<int, int, s21::HeapNodeAllocator, s21::OrderStatistic>;
+  Tree tree, equal, greater;
+  // 7919 is prime, so the keys run through 0..999 in a scattered order
+  for (int i = 0; i < 1000; ++i) {
+    tree.InsertUnique(i * 7919 % 1000, -i);
+  }
+  tree.Split(500, equal, greater);
+  ASSERT_GT(RBTreeBlackHeight(tree.GetRoot()), 0);
+  ASSERT_GT(RBTreeBlackHeight(greater.GetRoot()), 0);
+  ASSERT_EQ(RBTreeSubtreeSize(tree.GetRoot()), 500);
+  ASSERT_EQ(RBTreeSubtreeSize(equal.GetRoot()), 1);
+  ASSERT_EQ(RBTreeSubtreeSize(greater.GetRoot()), 499);
+  EXPECT_EQ(tree.Select(499), tree.End()->right);
+  EXPECT_EQ(tree.Select(499)->key, 499);
+  EXPECT_EQ(greater.Begin()->key, 501);
+
+  auto pivot = equal.Extract(equal.Begin());
+  EXPECT_THROW(greater.Join(pivot, tree), std::invalid_argument);
+  tree.Join(pivot, greater);
+  EXPECT_TRUE(pivot.empty());
+  EXPECT_EQ(greater.GetRoot(), nullptr);
+  ASSERT_GT(RBTreeBlackHeight(tree.GetRoot()), 0);
+  ASSERT_EQ(RBTreeSubtreeSize(tree.GetRoot()), 1000);
+  for (int k = 0; k < 1000; ++k) {
+    ASSERT_EQ(tree.Select(k)->key, k);
+  }
+
+  // Uneven pieces: a few keys at the front, most of them at the back
+  tree.Split(3, equal, greater);
+  EXPECT_THROW(tree.Join(tree), std::invalid_argument);
+  EXPECT_THROW(greater.Join(tree), std::invalid_argument);
+  tree.Join(equal);
+  tree.Join(greater);
+  ASSERT_GT(RBTreeBlackHeight(tree.GetRoot()), 0);
+  ASSERT_EQ(RBTreeSubtreeSize(tree.GetRoot()), 1000);
+  EXPECT_EQ(tree.Begin()->key, 0);
+}
+
+TEST(RBTreeTest, SplitKeepsEqualKeysTogether) {
+  s21::RBTree<int, int, s21::HeapNodeAllocator, s21::OrderStatistic> tree,
+      equal, greater;
+  std::srand(5);
+  for (int i = 0; i < 2000; ++i) {
+    tree.InsertEqual(std::rand() % 20, i);
+  }
+  tree.Split(7, equal, greater);
+  for (auto *node : {tree.GetRoot(), equal.GetRoot(), greater.GetRoot()}) {
+    ASSERT_GT(RBTreeBlackHeight(node), 0);
+    ASSERT_GE(RBTreeSubtreeSize(node), 0);
+  }
+  EXPECT_LT(tree.Select(tree.GetRoot()->subtree_size - 1)->key, 7);
+  EXPECT_EQ(equal.Begin()->key, 7);
+  EXPECT_EQ(equal.Select(equal.GetRoot()->subtree_size - 1)->key, 7);
+  EXPECT_EQ(greater.Begin()->key, 8);
+  EXPECT_EQ(RBTreeSubtreeSize(tree.GetRoot()) +
+                RBTreeSubtreeSize(equal.GetRoot()) +
+                RBTreeSubtreeSize(greater.GetRoot()),
+            2000);
+}
+
+// Checks the four set operations of Container against the std algorithms
+// on sorted vectors, for operand sizes from empty to far apart
+template <class Container>
+void CheckSetAlgebra(int key_range) {
+  const std::size_t sizes[] = {0, 1, 7, 100, 3000};
+  std::srand(31);
+  for (std::size_t lhs_size : sizes) {
+    for (std::size_t rhs_size : sizes) {
+      std::vector<int> lhs_keys, rhs_keys;
+      for (std::size_t i = 0; i < lhs_size; ++i) {
+        lhs_keys.push_back(std::rand() % key_range);
+      }
+      for (std::size_t i = 0; i < rhs_size; ++i) {
+        rhs_keys.push_back(std::rand() % key_range);
+      }
+      Container lhs(lhs_keys.begin(), lhs_keys.end());
+      Container rhs(rhs_keys.begin(), rhs_keys.end());
+      std::vector<int> lhs_sorted, rhs_sorted;
+      for (auto it = lhs.begin(); it != lhs.end(); ++it) {
+        lhs_sorted.push_back(it->key);
+      }
+      for (auto it = rhs.begin(); it != rhs.end(); ++it) {
+        rhs_sorted.push_back(it->key);
+      }
+      for (int op = 0; op < 4; ++op) {
+        std::vector<int> expected;
+        auto out = std::back_inserter(expected);
+        Container result;
+        if (op == 0) {
+          std::set_union(lhs_sorted.begin(), lhs_sorted.end(),
+                         rhs_sorted.begin(), rhs_sorted.end(), out);
+          result = set_union(lhs, rhs);
+        } else if (op == 1) {
+          std::set_intersection(lhs_sorted.begin(), lhs_sorted.end(),
+                                rhs_sorted.begin(), rhs_sorted.end(), out);
+          result = set_intersection(lhs, rhs);
+        } else if (op == 2) {
+          std::set_difference(lhs_sorted.begin(), lhs_sorted.end(),
+                              rhs_sorted.begin(), rhs_sorted.end(), out);
+          result = set_difference(lhs, rhs);
+        } else {
+          std::set_symmetric_difference(lhs_sorted.begin(), lhs_sorted.end(),
+                                        rhs_sorted.begin(), rhs_sorted.end(),
+                                        out);
+          result = set_symmetric_difference(lhs, rhs);
+        }
+        ASSERT_EQ(result.size(), static_cast<int>(expected.size()))
+            << op << " " << lhs_size << " " << rhs_size;
+        std::size_t k = 0;
+        for (auto it = result.begin(); it != result.end(); ++it, ++k) {
+          ASSERT_EQ(it->key, expected[k]);
+        }
+        ASSERT_EQ(k, expected.size());
+        if (!expected.empty()) {
+          ASSERT_EQ(result.rbegin()->key, expected.back());
+        }
+      }
+      ASSERT_EQ(lhs.size(), static_cast<int>(lhs_sorted.size()));
+      ASSERT_EQ(rhs.size(), static_cast<int>(rhs_sorted.size()));
+    }
+  }
+}
+
+TEST(SetTest, SetAlgebra) {
+  CheckSetAlgebra<s21::Set<int>>(5000);
+  CheckSetAlgebra<s21::Set<int, s21::SlabNodeAllocator>>(5000);
+}
+
+TEST(MultisetTest, SetAlgebraCountsEqualElements) {
+  CheckSetAlgebra<s21::Multiset<int>>(50);
+  CheckSetAlgebra<s21::Multiset<int, s21::IndexPoolAllocator,
+                                s21::IndexLinked<s21::OrderStatistic>>>(50);
+}
+
+TEST(SetTest, SetAlgebraReusesNodes) {
+  s21::Set<int, s21::HeapNodeAllocator, s21::OrderStatistic> evens, few;
+  for (int i = 0; i < 1000; ++i) {
+    evens.insert(i * 2);
+  }
+  few.insert(11);
+  few.insert(12);
+  s21::Node<int, s21::NoValue, s21::OrderStatistic> *eleven =
+      few.find(11).current();
+  s21::Node<int, s21::NoValue, s21::OrderStatistic> *twelve =
+      evens.find(12).current();
+  auto all = set_union(std::move(evens), std::move(few));
+  EXPECT_EQ(all.size(), 1001);
+  EXPECT_EQ(all.find(11).current(), eleven);
+  EXPECT_EQ(all.find(12).current(), twelve);
+  EXPECT_EQ(all.rank(13), 8u);
+  EXPECT_EQ(all.select(1000)->key, 1998);
+
+  s21::Set<int, s21::HeapNodeAllocator, s21::OrderStatistic> odd{11, 13};
+  auto rest = set_difference(std::move(all), std::move(odd));
+  EXPECT_EQ(rest.size(), 1000);
+  EXPECT_FALSE(rest.contains(11));
+  EXPECT_EQ(rest.find(12).current(), twelve);
+  EXPECT_EQ(rest.select(6)->key, 12);
+  auto none = set_symmetric_difference(rest, rest);
+  EXPECT_TRUE(none.empty());
+}
+
+// The parallel operations must give exactly the sequential results
+template <class Container>
+void CheckParallelSetAlgebra(int key_range) {
+  s21::ThreadPool pool(4);
+  std::vector<int> lhs_keys, rhs_keys;
+  std::srand(17);
+  for (int i = 0; i < 200000; ++i) {
+    lhs_keys.push_back(std::rand() % key_range);
+    rhs_keys.push_back(std::rand() % key_range);
+  }
+  const Container lhs(lhs_keys.begin(), lhs_keys.end());
+  const Container rhs(rhs_keys.begin(), rhs_keys.end());
+  for (int op = 0; op < 4; ++op) {
+    Container expected, result;
+    if (op == 0) {
+      expected = set_union(lhs, rhs);
+      result = set_union(lhs, rhs, &pool);
+    } else if (op == 1) {
+      expected = set_intersection(lhs, rhs);
+      result = set_intersection(lhs, rhs, &pool);
+    } else if (op == 2) {
+      expected = set_difference(lhs, rhs);
+      result = set_difference(lhs, rhs, &pool);
+    } else {
+      expected = set_symmetric_difference(lhs, rhs);
+      result = set_symmetric_difference(lhs, rhs, &pool);
+    }
+    ASSERT_EQ(result.size(), expected.size()) << op;
+    for (auto it = result.begin(), jt = expected.begin(); it != result.end();
+         ++it, ++jt) {
+      ASSERT_EQ(it->key, jt->key);
+    }
+    ASSERT_EQ(result.rank(key_range / 2), expected.rank(key_range / 2));
+  }
+}
+
+TEST(SetTest, ParallelSetAlgebra) {
+  CheckParallelSetAlgebra<
+      s21::Set<int, s21::HeapNodeAllocator, s21::OrderStatistic>>(300000);
+}
+
+TEST(MultisetTest, ParallelSetAlgebra) {
+  CheckParallelSetAlgebra<
+      s21::Multiset<int, s21::HeapNodeAllocator, s21::OrderStatistic>>(50000);
+}
+
+TEST(ThreadPoolTest, InvokeRunsBothAndRethrows) {
+  s21::ThreadPool pool(3);
+  EXPECT_EQ(pool.size(), 3u);
+  std::atomic<int> calls{0};
+  std::function<void(int)> fork = [&](int depth) {
+    ++calls;
+    if (depth > 0) {
+      pool.Invoke([&] { fork(depth - 1); }, [&] { fork(depth - 1); });
+    }
+  };
+  fork(8);
+  EXPECT_EQ(calls, 511);
+  EXPECT_THROW(pool.Invoke([] {}, [] { throw std::runtime_error("second"); }),
+               std::runtime_error);
+  int done = 0;
+  s21::ThreadPool inline_pool(1);
+  inline_pool.Invoke([&] { ++done; }, [&] { ++done; });
+  EXPECT_EQ(done, 2);
+}
+
+TEST(SetTest, MissesReturnEnd) {
+  s21::Set<std::string> set{"fig", "kiwi", "pear"};
+  EXPECT_TRUE(set.find("apple") == set.end());
+  EXPECT_TRUE(set.find("lime") == set.end());
+  EXPECT_TRUE(set.find("zucchini") == set.end());
+  EXPECT_EQ(set.find("kiwi")->key, "kiwi");
+  EXPECT_EQ(set.erase("lime"), 0u);
+  EXPECT_EQ(set.erase("kiwi"), 1u);
+  EXPECT_EQ(set.size(), 2);
+  s21::Set<std::string> empty;
+  EXPECT_TRUE(empty.find("fig") == empty.end());
+  EXPECT_EQ(empty.erase("fig"), 0u);
+}
+
+TEST(MultisetTest, FindReturnsFirstEqual) {
+  s21::Multiset<int, s21::HeapNodeAllocator, s21::OrderStatistic> ms;
+  for (int i = 0; i < 100; ++i) {
+    ms.insert(i % 10);
+  }
+  EXPECT_TRUE(ms.find(7) == ms.select(70));
+  EXPECT_TRUE(ms.find(7) == ms.lower_bound(7));
+}
+
+TEST(SetTest, MoveOnlyKeys) {
+  s21::Set<std::unique_ptr<int>> set;
+  auto first = std::make_unique<int>(1);
+  int *address = first.get();
+  auto [it, inserted] = set.insert(std::move(first));
+  EXPECT_TRUE(inserted);
+  EXPECT_EQ(first, nullptr);
+  EXPECT_EQ(it->key.get(), address);
+  set.insert(set.end(), std::make_unique<int>(2));
+  set.emplace(std::make_unique<int>(3), std::make_unique<int>(4));
+  EXPECT_EQ(set.size(), 4);
+
+  s21::Multiset<std::unique_ptr<int>> ms;
+  ms.insert(std::make_unique<int>(5));
+  ms.insert(ms.begin(), std::make_unique<int>(6));
+  ms.emplace(std::unique_ptr<int>());
+  ms.emplace(std::unique_ptr<int>());
+  EXPECT_EQ(ms.size(), 4);
+  EXPECT_EQ(ms.count(nullptr), 2);
+}
+
+TEST(SetTest, CustomComparator) {
+  s21::Set<int, s21::HeapNodeAllocator, s21::NoAugment, std::greater<int>> set{
+      4, 1, 3, 2};
+  std::vector<int> keys;
+  for (auto it = set.begin(); it != set.end(); ++it) {
+    keys.push_back(it->key);
+  }
+  EXPECT_EQ(keys, (std::vector<int>{4, 3, 2, 1}));
+  EXPECT_FALSE(set.insert(3).second);
+  EXPECT_EQ(set.erase(2), 1u);
+  EXPECT_EQ(set.extract(4).key(), 4);
+  EXPECT_EQ(set.begin()->key, 3);
+  set.insert(set.end(), 0);
+  EXPECT_EQ(set.rbegin()->key, 0);
+}
+
+TEST(MultisetTest, TransparentLookup) {
+  s21::Multiset<std::string, s21::HeapNodeAllocator, s21::OrderStatistic,
+                std::less<>>
+      words{"b", "a", "b", "c", "b"};
+  std::string_view b = "b";
+  EXPECT_EQ(words.count(b), 3);
+  EXPECT_EQ(words.count("d"), 0);
+  EXPECT_TRUE(words.contains("c"));
+  EXPECT_EQ(words.find(b)->key, "b");
+  EXPECT_EQ(words.lower_bound("bb")->key, "c");
+  EXPECT_EQ(words.upper_bound("a")->key, "b");
+  auto [lower, upper] = words.equal_range(b);
+  EXPECT_EQ(std::distance(lower, upper), 3);
+
+  s21::Set<std::string, s21::HeapNodeAllocator, s21::NoAugment, std::less<>>
+      set{"x", "y"};
+  EXPECT_TRUE(set.contains(std::string_view("y")));
+  EXPECT_EQ(set.find("z"), set.end());
+}
+
+TEST(SetTest, ContainsBatch) {
+  s21::Set<int, s21::IndexPoolAllocator> set;
+  for (int i = 0; i < 3000; i += 3) {
+    set.insert(i);
+  }
+  std::vector<int> keys;
+  for (int key = -50; key < 50; ++key) {
+    keys.push_back(key);
+  }
+  std::vector<char> present;
+  set.contains_batch(keys.begin(), keys.end(), std::back_inserter(present));
+  std::vector<s21::Set<int, s21::IndexPoolAllocator>::iterator> found(100);
+  set.find_batch(keys.begin(), keys.end(), found.begin());
+  for (std::size_t i = 0; i < keys.size(); ++i) {
+    EXPECT_EQ(present[i] != 0, keys[i] >= 0 && keys[i] % 3 == 0);
+    EXPECT_EQ(found[i], set.find(keys[i]));
+  }
+}
+
+// Random inserts, erases and lookups on a tree bulk built from the even keys
+// below 200, compared with std::multiset; check validates the shape of the
+// tree after every step
+template <class Tree, class Check>
+void ChurnBalancedTree(Check check) {
+  Tree tree;
+  std::vector<std::pair<int, int>> initial;
+  std::multiset<int> standart;
+  for (int key = 0; key < 200; key += 2) {
+    initial.push_back({key, key});
+    standart.insert(key);
+  }
+  tree.AssignSorted(initial.begin(), initial.end(), true);
+  ASSERT_TRUE(check(tree.GetRoot()));
+  std::srand(17);
+  for (int i = 0; i < 3000; ++i) {
+    int key = std::rand() % 400;
+    int action = std::rand() % 3;
+    if (action == 0 && standart.count(key) != 0) {
+      tree.Erase(tree.FindKey(key));
+      standart.erase(standart.find(key));
+    } else if (action == 1) {
+      bool inserted = tree.InsertUnique(key, i).second;
+      ASSERT_EQ(inserted, standart.count(key) == 0);
+      if (inserted) {
+        standart.insert(key);
+      }
+    } else {
+      tree.InsertEqual(key, i);
+      standart.insert(key);
+    }
+    ASSERT_EQ(tree.Contains(key + 1), standart.count(key + 1) != 0);
+    ASSERT_TRUE(check(tree.GetRoot())) << i;
+  }
+  std::vector<int> keys;
+  for (typename Tree::iterator it(tree.Begin()); it.current() != tree.End();
+       ++it) {
+    keys.push_back(it->key);
+  }
+  EXPECT_EQ(keys, std::vector<int>(standart.begin(), standart.end()));
+  while (tree.GetRoot() != nullptr) {
+    tree.Erase(tree.GetRoot());
+    ASSERT_TRUE(check(tree.GetRoot()));
+  }
+  EXPECT_EQ(tree.Begin(), tree.End());
+}
+
+TEST(RBTreeTest, AVLKeepsInvariants) {
+  ChurnBalancedTree<s21::RBTree<int, int, s21::HeapNodeAllocator,
+                                s21::AVL<s21::OrderStatistic>>>(
+      [](const auto *root) {
+        return AVLTreeLevels(root) >= 0 && RBTreeSubtreeSize(root) >= 0;
+      });
+}
+
+TEST(RBTreeTest, WAVLKeepsInvariants) {
+  ChurnBalancedTree<s21::RBTree<int, int, s21::IndexPoolAllocator,
+                                s21::IndexLinked<s21::WAVL<>>>>(
+      [](const auto *root) { return WAVLTreeRank(root) >= 0; });
+}
+
+TEST(RBTreeTest, TreapKeepsInvariants) {
+  ChurnBalancedTree<
+      s21::RBTree<int, int, s21::SlabNodeAllocator, s21::Treap<>>>(
+      [](const auto *root) { return TreapSize(root) >= 0; });
+}
+
+TEST(RBTreeTest, SplayKeepsInvariants) {
+  ChurnBalancedTree<s21::RBTree<int, int, s21::HeapNodeAllocator,
+                                s21::Splay<s21::OrderStatistic>>>(
+      [](const auto *root) {
+        return SearchTreeSize(root) >= 0 && RBTreeSubtreeSize(root) >= 0;
+      });
+}
+
+TEST(RBTreeTest, ThreadsFollowInsertsAndErases) {
+  using Tree = s21::RBTree<int, int, s21::HeapNodeAllocator, s21::Threaded<>>;
+  // An empty tree threads the header to itself
+  Tree tree;
+  EXPECT_TRUE(ThreadsOk(tree.End()));
+  ChurnBalancedTree<Tree>([](const auto *root) {
+    return RBTreeBlackHeight(root) >= 0 &&
+           (root == nullptr || ThreadsOk(root->GetParent()));
+  });
+  ChurnBalancedTree<
+      s21::RBTree<int, int, s21::HeapNodeAllocator, s21::Threaded<s21::AVL<>>>>(
+      [](const auto *root) {
+        return AVLTreeLevels(root) >= 0 &&
+               (root == nullptr || ThreadsOk(root->GetParent()));
+      });
+  ChurnBalancedTree<s21::RBTree<int, int, s21::IndexPoolAllocator,
+                                s21::IndexLinked<s21::Threaded<>>>>(
+      [](const auto *root) {
+        return root == nullptr || ThreadsOk(root->GetParent());
+      });
+  ChurnBalancedTree<s21::RBTree<int, int, s21::HeapNodeAllocator,
+                                s21::Splay<s21::Threaded<>>>>(
+      [](const auto *root) {
+        return root == nullptr || ThreadsOk(root->GetParent());
+      });
+}
+
+TEST(RBTreeTest, ThreadsFollowSplitAndJoin) {
+  using Tree = s21::RBTree<int, int, s21::HeapNodeAllocator,
+                           s21::Threaded<s21::OrderStatistic>>;
+  Tree tree, equal, greater;
+  for (int i = 0; i < 1000; ++i) {
+    tree.InsertUnique(i * 7919 % 1000, i);
+  }
+  tree.Split(500, equal, greater);
+  EXPECT_TRUE(ThreadsOk(tree.End()));
+  EXPECT_TRUE(ThreadsOk(equal.End()));
+  EXPECT_TRUE(ThreadsOk(greater.End()));
+  auto pivot = equal.Extract(equal.Begin());
+  EXPECT_TRUE(ThreadsOk(equal.End()));
+  tree.Join(pivot, greater);
+  EXPECT_TRUE(ThreadsOk(tree.End()));
+  EXPECT_TRUE(ThreadsOk(greater.End()));
+  tree.Split(0, equal, greater);
+  tree.Join(equal);
+  tree.Join(greater);
+  EXPECT_TRUE(ThreadsOk(tree.End()));
+  EXPECT_TRUE(ThreadsOk(equal.End()));
+  EXPECT_EQ(RBTreeSubtreeSize(tree.GetRoot()), 1000);
+  // Stepping off either end throws as without threads
+  Tree::iterator it(tree.End());
+  --it;
+  EXPECT_EQ(it->key, 999);
+  ++it;
+  EXPECT_THROW(++it, std::out_of_range);
+  Tree::iterator first(tree.Begin());
+  EXPECT_THROW(--first, std::out_of_range);
+  EXPECT_EQ(first->key, 0);
+}
+
+TEST(RBTreeTest, EraseRangeKeepsInvariants) {
+  using Tree = s21::RBTree<int, int, s21::HeapNodeAllocator,
+                           s21::Threaded<s21::OrderStatistic>>;
+  Tree tree;
+  std::multiset<int> standart;
+  for (int i = 0; i < 3000; ++i) {
+    tree.InsertEqual(i / 3, i);
+    standart.insert(i / 3);
+  }
+  std::srand(29);
+  while (!standart.empty()) {
+    // Ranges between two positions, often inside runs of equal keys
+    std::size_t from = std::rand() % standart.size();
+    std::size_t length =
+        std::rand() % 2 == 0 ? std::rand() % 40 : std::rand() % 400;
+    length = std::min(length, standart.size() - from);
+    auto first = std::next(standart.begin(), from);
+    standart.erase(first, std::next(first, length));
+    Tree::iterator lo(tree.Select(from));
+    Tree::iterator hi = lo;
+    for (std::size_t i = 0; i < length; ++i) {
+      ++hi;
+    }
+    ASSERT_EQ(tree.EraseRange(lo.current(), hi.current()), length);
+    ASSERT_GT(RBTreeBlackHeight(tree.GetRoot()), -1);
+    ASSERT_EQ(RBTreeSubtreeSize(tree.GetRoot()),
+              static_cast<long>(standart.size()));
+    ASSERT_TRUE(ThreadsOk(tree.End()));
+    std::vector<int> keys;
+    for (Tree::iterator it(tree.Begin()); it.current() != tree.End(); ++it) {
+      keys.push_back(it->key);
+    }
+    ASSERT_EQ(keys, std::vector<int>(standart.begin(), standart.end()));
+  }
+  EXPECT_EQ(tree.GetRoot(), nullptr);
+}
+
+TEST(RBTreeTest, AggregatesFollowRebalancing) {
+  using Sum = s21::SumOf<long>;
+  auto check = [](const auto *root) {
+    long sum;
+    return AggregatesOk<Sum>(root, sum);
+  };
+  ChurnBalancedTree<s21::RBTree<int, int, s21::HeapNodeAllocator,
+                                s21::SubtreeAggregate<Sum>>>(
+      [&check](const auto *root) {
+        return RBTreeBlackHeight(root) >= 0 && check(root);
+      });
+  ChurnBalancedTree<s21::RBTree<int, int, s21::HeapNodeAllocator,
+                                s21::AVL<s21::SubtreeAggregate<Sum>>>>(check);
+  ChurnBalancedTree<
+      s21::RBTree<int, int, s21::IndexPoolAllocator,
+                  s21::IndexLinked<s21::Treap<s21::SubtreeAggregate<Sum>>>>>(
+      check);
+  ChurnBalancedTree<s21::RBTree<int, int, s21::HeapNodeAllocator,
+                                s21::Splay<s21::SubtreeAggregate<Sum>>>>(check);
+}
+
+TEST(RBTreeTest, BalancePoliciesOnSortedInserts) {
+  s21::RBTree<int, int, s21::HeapNodeAllocator, s21::AVL<>> avl;
+  s21::RBTree<int, int, s21::HeapNodeAllocator, s21::WAVL<>> wavl;
+  s21::RBTree<int, int, s21::HeapNodeAllocator, s21::Splay<>> splay;
+  for (int i = 0; i < 4095; ++i) {
+    avl.InsertUnique(i, i);
+    wavl.InsertUnique(i, i);
+    splay.InsertUnique(i, i);
+  }
+  // Sorted inserts fill an AVL tree level by level; WAVL trees grown by
+  // inserts alone are AVL trees
+  EXPECT_EQ(AVLTreeLevels(avl.GetRoot()), 12);
+  EXPECT_EQ(WAVLTreeRank(wavl.GetRoot()), 12);
+  EXPECT_EQ(splay.GetRoot()->key, 4094);
+  splay.FindKey(7);
+  EXPECT_EQ(splay.GetRoot()->key, 7);
+  EXPECT_EQ(SearchTreeSize(splay.GetRoot()), 4095);
+}
+
+TEST(SetTest, BalancePolicies) {
+  CheckSetAlgebra<s21::Set<int, s21::HeapNodeAllocator, s21::AVL<>>>(5000);
+  CheckSetAlgebra<
+      s21::Set<int, s21::IndexPoolAllocator, s21::IndexLinked<s21::WAVL<>>>>(
+      5000);
+  CheckSetAlgebra<s21::Multiset<int, s21::HeapNodeAllocator, s21::Treap<>>>(50);
+  CheckSetAlgebra<s21::Multiset<int, s21::SlabNodeAllocator, s21::Splay<>>>(50);
+}
+
+TEST(SetTest, Threaded) {
+  CheckSetAlgebra<s21::Set<int, s21::HeapNodeAllocator, s21::Threaded<>>>(5000);
+  CheckSetAlgebra<s21::Multiset<int, s21::IndexPoolAllocator,
+                                s21::IndexLinked<s21::Threaded<>>>>(50);
+  CheckSetAlgebra<
+      s21::Multiset<int, s21::SlabNodeAllocator, s21::Threaded<s21::AVL<>>>>(
+      50);
+}
+
+TEST(SetTest, RangeErase) {
+  s21::Set<int, s21::IndexPoolAllocator> set;
+  for (int i = 0; i < 1000; ++i) {
+    set.insert(i);
+  }
+  EXPECT_EQ(set.erase_range(100, 900), 800);
+  EXPECT_EQ(set.erase_range(5, 10), 5);
+  EXPECT_EQ(set.erase_range(50, 40), 0);
+  EXPECT_EQ(set.size(), 195);
+  std::vector<int> visited;
+  set.for_each_in_range(0, 1000, [&](const int &key) {
+    if (key % 2 == 0) {
+      visited.push_back(key);
+    }
+  });
+  EXPECT_EQ(visited.size(), 98);
+  EXPECT_EQ(visited[2], 4);
+  EXPECT_EQ(visited[3], 10);
+  EXPECT_EQ(*set.erase(set.find(3), set.find(950)), 950);
+  EXPECT_EQ(set.size(), 53);
+  EXPECT_FALSE(set.contains(99));
+  EXPECT_TRUE(set.contains(2));
+}
+
+TEST(MultisetTest, RangeErase) {
+  s21::Multiset<int> set;
+  for (int i = 0; i < 600; ++i) {
+    set.insert(i % 100);
+  }
+  // Every key is there six times; erase from the middle of one run into
+  // the middle of another
+  auto first = set.lower_bound(20);
+  for (int i = 0; i < 3; ++i) {
+    ++first;
+  }
+  auto last = set.lower_bound(70);
+  ++last;
+  EXPECT_EQ(*set.erase(first, last), 70);
+  EXPECT_EQ(set.size(), 600 - (3 + 49 * 6 + 1));
+  EXPECT_EQ(set.count(20), 3);
+  EXPECT_EQ(set.count(50), 0);
+  EXPECT_EQ(set.count(70), 5);
+  EXPECT_EQ(set.erase_range(0, 10), 60);
+  int sum = 0;
+  set.for_each_in_range(80, 82, [&sum](const int &key) { sum += key; });
+  EXPECT_EQ(sum, 6 * (80 + 81));
+}
+
+TEST(SetTest, SplayClearsDegenerateTree) {
+  // Sorted inserts leave a splay tree one long path
+  s21::Set<int, s21::HeapNodeAllocator, s21::Splay<>> set;
+  for (int i = 0; i < 300000; ++i) {
+    set.insert(i);
+  }
+  s21::Set<int, s21::HeapNodeAllocator, s21::Splay<>> copy(set);
+  EXPECT_EQ(copy.size(), 300000);
+  EXPECT_TRUE(set.contains(0));
+  set.clear();
+  EXPECT_TRUE(set.empty());
+}